@@ -41,6 +41,7 @@
 
 #include <tesseract_collision/bullet/bullet_utils.h>
 #include <tesseract_core/continuous_contact_manager_base.h>
+#include <atomic>
 
 #ifndef TESSERACT_COLLISION_BULLET_CAST_MANAGERS_H
 #define TESSERACT_COLLISION_BULLET_CAST_MANAGERS_H
@@ -70,6 +71,10 @@ public:
 
   bool disableCollisionObject(const std::string& name) override;
 
+  bool updateCollisionObjectOcTree(const std::string& name,
+                                   const VectorVector3d& occupied_voxels,
+                                   const VectorVector3d& free_voxels) override;
+
   void setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose) override;
 
   void setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -87,12 +92,48 @@ public:
 
   void setCollisionObjectsTransform(const TransformMap& pose1, const TransformMap& pose2) override;
 
+  void setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsTransform(const VectorIsometry3d& link_transforms) override;
+
+  void setCollisionObjectsTransform(int link_id,
+                                    const Eigen::Isometry3d& pose1,
+                                    const Eigen::Isometry3d& pose2) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                    const VectorIsometry3d& pose1,
+                                    const VectorIsometry3d& pose2) override;
+
+  void setCollisionObjectsSweptTransform(const std::string& name, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsSweptTransform(int link_id, const VectorIsometry3d& poses) override;
+
   void setContactRequest(const ContactRequest& req) override;
 
   const ContactRequest& getContactRequest() const override;
 
   void contactTest(ContactResultMap& collisions) override;
 
+  void contactTest(ContactResultIdMap& collisions) override;
+
+  void contactTest(ContactResultBuffer& collisions) override;
+
+  bool isCollisionFree() override;
+
+  void setStatisticsEnabled(bool enabled) override;
+
+  bool isStatisticsEnabled() const override;
+
+  const ContactTestStatistics& getStatistics() const override;
+
+  void clearStatistics() override;
+
+  void setLinkRegistry(NameRegistryPtr registry) override;
+
+  NameRegistryConstPtr getLinkRegistry() const override { return link_registry_; }
+
   /**
    * @brief A a bullet collision object to the manager
    * @param cow The tesseract bullet collision object
@@ -108,6 +149,26 @@ private:
   Link2Cow link2cow_;        /**< @brief A map of all (static and active) collision objects being managed */
   std::vector<COWPtr> cows_; /**< @brief A vector of collision objects (active followed by static) */
   Link2Cow link2castcow_;    /**< @brief A map of cast (active) collision objects being managed. */
+  NameRegistryPtr link_registry_;  /**< @brief Assigns the link ids of the collision objects */
+  std::vector<COWPtr> id2cow_;     /**< @brief The collision objects indexed by link id (nullptr if not managed) */
+  std::vector<COWPtr> id2castcow_; /**< @brief The cast collision objects indexed by link id (nullptr if not active) */
+  ContactTestStatistics stats_;    /**< @brief The statistics collected during contact tests */
+  bool stats_enabled_;             /**< @brief Indicate if statistics are collected during contact tests */
+  mutable std::atomic<std::uint64_t> owner_tag_; /**< @brief Replaced by clone(), see COW::isOwnedBy() */
+
+  /**
+   * @brief Perform a contact test for all objects, storing the results in the container provided by cdata
+   * @param cdata The contact query data
+   */
+  void contactTest(ContactDistanceData& cdata);
+
+  /**
+   * @brief Get a collision object to modify it, it is copied first if it is still shared with a clone
+   * @param cow The collision object or cast collision object, it is replaced in the containers of the manager by its
+   *            copy
+   * @return The collision object which may be modified
+   */
+  COW& getWritableCollisionObject(const COWPtr& cow);
 };
 typedef std::shared_ptr<BulletCastSimpleManager> BulletCastSimpleManagerPtr;
 
@@ -148,7 +209,7 @@ struct CastCollisionCollector : public btCollisionWorld::ContactResultCallback
   {
     return !collisions_.done && needsCollisionCheck(*cow_,
                                                     *(static_cast<CollisionObjectWrapper*>(proxy0->m_clientObject)),
-                                                    collisions_.req->isContactAllowed,
+                                                    collisions_,
                                                     verbose_);
   }
 };
@@ -158,7 +219,6 @@ class BulletCastBVHManager : public ContinuousContactManagerBase
 {
 public:
   BulletCastBVHManager();
-  ~BulletCastBVHManager();
 
   ContinuousContactManagerBasePtr clone() const override;
 
@@ -177,6 +237,10 @@ public:
 
   bool disableCollisionObject(const std::string& name) override;
 
+  bool updateCollisionObjectOcTree(const std::string& name,
+                                   const VectorVector3d& occupied_voxels,
+                                   const VectorVector3d& free_voxels) override;
+
   void setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose) override;
 
   void setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -194,12 +258,48 @@ public:
 
   void setCollisionObjectsTransform(const TransformMap& pose1, const TransformMap& pose2) override;
 
+  void setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsTransform(const VectorIsometry3d& link_transforms) override;
+
+  void setCollisionObjectsTransform(int link_id,
+                                    const Eigen::Isometry3d& pose1,
+                                    const Eigen::Isometry3d& pose2) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                    const VectorIsometry3d& pose1,
+                                    const VectorIsometry3d& pose2) override;
+
+  void setCollisionObjectsSweptTransform(const std::string& name, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsSweptTransform(int link_id, const VectorIsometry3d& poses) override;
+
   void setContactRequest(const ContactRequest& req) override;
 
   const ContactRequest& getContactRequest() const override;
 
   void contactTest(ContactResultMap& collisions) override;
 
+  void contactTest(ContactResultIdMap& collisions) override;
+
+  void contactTest(ContactResultBuffer& collisions) override;
+
+  bool isCollisionFree() override;
+
+  void setStatisticsEnabled(bool enabled) override;
+
+  bool isStatisticsEnabled() const override;
+
+  const ContactTestStatistics& getStatistics() const override;
+
+  void clearStatistics() override;
+
+  void setLinkRegistry(NameRegistryPtr registry) override;
+
+  NameRegistryConstPtr getLinkRegistry() const override { return link_registry_; }
+
   /**
    * @brief A a bullet collision object to the manager
    * @param cow The tesseract bullet collision object
@@ -212,16 +312,30 @@ private:
                                                          object to object collison algorithm */
   btDispatcherInfo dispatch_info_;              /**< @brief The bullet collision dispatcher configuration information */
   btDefaultCollisionConfiguration coll_config_; /**< @brief The bullet collision configuration */
-  std::unique_ptr<btBroadphaseInterface> broadphase_; /**< @brief The bullet broadphase interface */
-  Link2Cow link2cow_;                                 /**< @brief A map of all collision objects being managed */
-  Link2Cow link2castcow_;                             /**< @brief A map of cast collision objects being managed. */
+  std::unique_ptr<NarrowphasePairCache> pair_cache_; /**< @brief The narrowphase state kept between contact tests */
+  StaticWorldBroadphase broadphase_; /**< @brief The BVHs of the static and the active (cast) objects */
+  Link2Cow link2cow_;                /**< @brief A map of all collision objects being managed */
+  Link2Cow link2castcow_;            /**< @brief A map of cast collision objects being managed. */
+  NameRegistryPtr link_registry_;  /**< @brief Assigns the link ids of the collision objects */
+  std::vector<COWPtr> id2cow_;     /**< @brief The collision objects indexed by link id (nullptr if not managed) */
+  std::vector<COWPtr> id2castcow_; /**< @brief The cast collision objects indexed by link id (nullptr if not active) */
+  ContactTestStatistics stats_;    /**< @brief The statistics collected during contact tests */
+  bool stats_enabled_;             /**< @brief Indicate if statistics are collected during contact tests */
+  mutable std::atomic<std::uint64_t> owner_tag_; /**< @brief Replaced by clone(), see COW::isOwnedBy() */
+
+  /**
+   * @brief Perform a contact test for all objects, storing the results in the container provided by cdata
+   * @param cdata The contact query data
+   */
+  void contactTest(ContactDistanceData& cdata);
 
   /**
-   * @brief Perform a contact test for the provided object which is not part of the manager
-   * @param cow The Collision object
-   * @param collisions The collision results
+   * @brief Get a collision object to modify it, it is copied first if it is still shared with a clone
+   * @param cow The collision object or cast collision object, it is replaced in the containers of the manager and
+   *            in the broadphase by its copy
+   * @return The collision object which may be modified
    */
-  void contactTest(const COWPtr& cow, ContactDistanceData& collisions);
+  COW& getWritableCollisionObject(const COWPtr& cow);
 };
 typedef std::shared_ptr<BulletCastBVHManager> BulletCastBVHManagerPtr;
 
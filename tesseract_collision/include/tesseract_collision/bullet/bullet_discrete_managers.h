@@ -43,9 +43,15 @@
 
 #include <tesseract_collision/bullet/bullet_utils.h>
 #include <tesseract_core/discrete_contact_manager_base.h>
+#include <tesseract_core/worker_threads.h>
+#include <atomic>
 namespace tesseract
 {
-/** @brief A simple implementaiton of a bullet manager which does not use BHV */
+/**
+ * @brief A simple implementaiton of a bullet manager which does not use BHV
+ *
+ * Clones share the collision objects, an object is only copied by the first manager modifying it.
+ */
 class BulletDiscreteSimpleManager : public DiscreteContactManagerBase
 {
 public:
@@ -68,6 +74,10 @@ public:
 
   bool disableCollisionObject(const std::string& name) override;
 
+  bool updateCollisionObjectOcTree(const std::string& name,
+                                   const VectorVector3d& occupied_voxels,
+                                   const VectorVector3d& free_voxels) override;
+
   void setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose) override;
 
   void setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -75,15 +85,39 @@ public:
 
   void setCollisionObjectsTransform(const TransformMap& transforms) override;
 
+  void setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsTransform(const VectorIsometry3d& link_transforms) override;
+
   void contactTest(ContactResultMap& collisions) override;
 
+  void contactTest(ContactResultIdMap& collisions) override;
+
+  void contactTest(ContactResultBuffer& collisions) override;
+
+  bool isCollisionFree() override;
+
+  void setStatisticsEnabled(bool enabled) override;
+
+  bool isStatisticsEnabled() const override;
+
+  const ContactTestStatistics& getStatistics() const override;
+
+  void clearStatistics() override;
+
   void setContactRequest(const ContactRequest& req) override;
 
   const ContactRequest& getContactRequest() const override;
 
+  void setLinkRegistry(NameRegistryPtr registry) override;
+
+  NameRegistryConstPtr getLinkRegistry() const override { return link_registry_; }
+
   /**
    * @brief A a bullet collision object to the manager
-   * @param cow The tesseract bullet collision object
+   * @param cow The tesseract bullet collision object, the manager takes ownership of it and may modify it
    */
   void addCollisionObject(const COWPtr& cow);
 
@@ -99,8 +133,28 @@ private:
                                                          object to object collison algorithm */
   btDispatcherInfo dispatch_info_;              /**< @brief The bullet collision dispatcher configuration information */
   btDefaultCollisionConfiguration coll_config_; /**< @brief The bullet collision configuration */
+  std::unique_ptr<NarrowphasePairCache> pair_cache_; /**< @brief The narrowphase state kept between contact tests */
   Link2Cow link2cow_;        /**< @brief A map of all (static and active) collision objects being managed */
   std::vector<COWPtr> cows_; /**< @brief A vector of collision objects (active followed by static) */
+  SweepAndPrune sap_;        /**< @brief The broadphase used to find the overlapping pairs of cows_ */
+  NameRegistryPtr link_registry_; /**< @brief Assigns the link ids of the collision objects */
+  std::vector<COWPtr> id2cow_;    /**< @brief The collision objects indexed by link id (nullptr if not managed) */
+  ContactTestStatistics stats_;   /**< @brief The statistics collected during contact tests */
+  bool stats_enabled_;            /**< @brief Indicate if statistics are collected during contact tests */
+  mutable std::atomic<std::uint64_t> owner_tag_; /**< @brief Replaced by clone(), see COW::isOwnedBy() */
+
+  /**
+   * @brief Perform a contact test for all objects, storing the results in the container provided by cdata
+   * @param cdata The contact query data
+   */
+  void contactTest(ContactDistanceData& cdata);
+
+  /**
+   * @brief Get a collision object to modify it, it is copied first if it is still shared with a clone
+   * @param cow The collision object, it is replaced in the containers of the manager by its copy
+   * @return The collision object which may be modified
+   */
+  COW& getWritableCollisionObject(const COWPtr& cow);
 };
 typedef std::shared_ptr<BulletDiscreteSimpleManager> BulletDiscreteSimpleManagerPtr;
 
@@ -140,17 +194,23 @@ struct DiscreteCollisionCollector : public btCollisionWorld::ContactResultCallba
   {
     return !collisions_.done && needsCollisionCheck(*cow_,
                                                     *(static_cast<CollisionObjectWrapper*>(proxy0->m_clientObject)),
-                                                    collisions_.req->isContactAllowed,
+                                                    collisions_,
                                                     verbose_);
   }
 };
 
-/** @brief A BVH implementaiton of a bullet manager */
+/**
+ * @brief A BVH implementaiton of a bullet manager
+ *
+ * The static objects (not in the link names of the contact request) are kept in a BVH of their own which is only
+ * rebuilt when objects are added or removed, moving static objects update their leaf in place. The BVH of the
+ * kinematic objects is refit as they move. Clones share the collision
+ * objects and a copy of both BVHs, an object is only copied by the first manager modifying it.
+ */
 class BulletDiscreteBVHManager : public DiscreteContactManagerBase
 {
 public:
   BulletDiscreteBVHManager();
-  ~BulletDiscreteBVHManager();
 
   DiscreteContactManagerBasePtr clone() const override;
 
@@ -169,6 +229,10 @@ public:
 
   bool disableCollisionObject(const std::string& name) override;
 
+  bool updateCollisionObjectOcTree(const std::string& name,
+                                   const VectorVector3d& occupied_voxels,
+                                   const VectorVector3d& free_voxels) override;
+
   void setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose) override;
 
   void setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -176,15 +240,39 @@ public:
 
   void setCollisionObjectsTransform(const TransformMap& transforms) override;
 
+  void setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsTransform(const VectorIsometry3d& link_transforms) override;
+
   void contactTest(ContactResultMap& collisions) override;
 
+  void contactTest(ContactResultIdMap& collisions) override;
+
+  void contactTest(ContactResultBuffer& collisions) override;
+
+  bool isCollisionFree() override;
+
+  void setStatisticsEnabled(bool enabled) override;
+
+  bool isStatisticsEnabled() const override;
+
+  const ContactTestStatistics& getStatistics() const override;
+
+  void clearStatistics() override;
+
   void setContactRequest(const ContactRequest& req) override;
 
   const ContactRequest& getContactRequest() const override;
 
+  void setLinkRegistry(NameRegistryPtr registry) override;
+
+  NameRegistryConstPtr getLinkRegistry() const override { return link_registry_; }
+
   /**
    * @brief A a bullet collision object to the manager
-   * @param cow The tesseract bullet collision object
+   * @param cow The tesseract bullet collision object, the manager takes ownership of it and may modify it
    */
   void addCollisionObject(const COWPtr& cow);
 
@@ -194,21 +282,67 @@ public:
    */
   const Link2Cow& getCollisionObjects() const;
 
+  /**
+   * @brief Set the number of threads checking the pairs found by the broadphase
+   *
+   * The overlapping pairs are checked in parallel by threads which the manager keeps alive between queries, each
+   * with its own dispatcher. A pair is always assigned to the same thread by a hash of its objects, so its cached
+   * narrowphase state stays warm, and the contacts are merged in thread order. Queries with fewer than
+   * BULLET_NARROWPHASE_MIN_PAIRS_PER_THREAD pairs per thread are checked on the calling thread. The contact allowed
+   * function of the request must be thread safe.
+   *
+   * Each pair is checked by a single thread, so CLOSEST, ALL and LIMITED requests store the same contacts for each
+   * pair as a serial query, except when max_total_contacts of a LIMITED request is reached, which may keep different
+   * pairs. A FIRST request and isCollisionFree() stop all threads at the first contact found by any of them, so the
+   * contact reported depends on the thread timing and is not deterministic.
+   *
+   * @param num_threads The number of threads, one (the default) checks all pairs on the calling thread and zero uses
+   *                    the number of hardware threads
+   */
+  void setNarrowphaseThreads(unsigned num_threads);
+
+  /** @brief Get the number of threads checking the pairs found by the broadphase */
+  unsigned getNarrowphaseThreads() const;
+
 private:
   ContactRequest request_;                            /**< @brief The active contact request message */
   std::unique_ptr<btCollisionDispatcher> dispatcher_; /**< @brief The bullet collision dispatcher used for getting
                                                          object to object collison algorithm */
   btDispatcherInfo dispatch_info_;              /**< @brief The bullet collision dispatcher configuration information */
   btDefaultCollisionConfiguration coll_config_; /**< @brief The bullet collision configuration */
-  std::unique_ptr<btBroadphaseInterface> broadphase_; /**< @brief The bullet broadphase interface */
+  std::unique_ptr<NarrowphasePairCache> pair_cache_; /**< @brief The narrowphase state kept between contact tests */
+  StaticWorldBroadphase broadphase_;                 /**< @brief The BVHs of the static and the kinematic objects */
+  std::vector<std::pair<const COW*, const COW*>> pairs_; /**< @brief The overlapping pairs of the last contact test */
+  std::vector<std::unique_ptr<NarrowphaseWorker>> workers_; /**< @brief The state of the narrowphase threads */
+  std::vector<std::vector<std::size_t>> worker_pairs_; /**< @brief The index of the pairs assigned to each thread */
+  std::unique_ptr<WorkerThreadPool> thread_pool_; /**< @brief The narrowphase threads, created by the first query */
+  unsigned narrowphase_threads_; /**< @brief The number of narrowphase threads, zero uses the hardware threads */
   Link2Cow link2cow_; /**< @brief A map of all (static and active) collision objects being managed */
+  NameRegistryPtr link_registry_; /**< @brief Assigns the link ids of the collision objects */
+  std::vector<COWPtr> id2cow_;    /**< @brief The collision objects indexed by link id (nullptr if not managed) */
+  ContactTestStatistics stats_;   /**< @brief The statistics collected during contact tests */
+  bool stats_enabled_;            /**< @brief Indicate if statistics are collected during contact tests */
+  mutable std::atomic<std::uint64_t> owner_tag_; /**< @brief Replaced by clone(), see COW::isOwnedBy() */
+
+  /**
+   * @brief Perform a contact test for all objects, storing the results in the container provided by cdata
+   * @param cdata The contact query data
+   */
+  void contactTest(ContactDistanceData& cdata);
+
+  /**
+   * @brief Check the overlapping pairs of the broadphase on multiple threads
+   * @param cdata The contact query data
+   * @param num_workers The number of threads
+   */
+  void contactTestParallel(ContactDistanceData& cdata, long num_workers);
 
   /**
-   * @brief Perform a contact test for the provided object which is not part of the manager
-   * @param cow The Collision object
-   * @param collisions The collision results
+   * @brief Get a collision object to modify it, it is copied first if it is still shared with a clone
+   * @param cow The collision object, it is replaced in the containers of the manager by its copy
+   * @return The collision object which may be modified
    */
-  void contactTest(const COWPtr& cow, ContactDistanceData& collisions);
+  COW& getWritableCollisionObject(const COWPtr& cow);
 };
 
 typedef std::shared_ptr<BulletDiscreteBVHManager> BulletDiscreteBVHManagerPtr;
@@ -47,11 +47,17 @@
 #pragma GCC diagnostic ignored "-Wall"
 #pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
 #include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionDispatch/btActivatingCollisionAlgorithm.h>
+#include <BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h>
+#include <BulletCollision/NarrowPhaseCollision/btGjkPairDetector.h>
+#include <BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h>
 #pragma GCC diagnostic pop
 
 #include <tesseract_core/basic_types.h>
 #include <tesseract_collision/contact_checker_common.h>
+#include <tesseract_collision/signed_distance_field.h>
 #include <geometric_shapes/mesh_operations.h>
+#include <octomap/OcTree.h>
 #include <ros/console.h>
 
 namespace tesseract
@@ -64,13 +70,31 @@ const float BULLET_LENGTH_TOLERANCE = .001 METERS;
 const float BULLET_EPSILON = 1e-3;
 const double BULLET_DEFAULT_CONTACT_DISTANCE = 0.05;
 const bool BULLET_COMPOUND_USE_DYNAMIC_AABB = true;
+const int BULLET_NARROWPHASE_MIN_PAIRS_PER_THREAD = 64;
+const int BULLET_COLLISION_POOL_SIZE = 64;
+
+// Bullet may be built in single precision (see the bullet float plugin), the tesseract API is always double
+inline btVector3 convertEigenToBt(const Eigen::Vector3d& v)
+{
+  const Eigen::Matrix<btScalar, 3, 1> s = v.cast<btScalar>();
+  return btVector3(s[0], s[1], s[2]);
+}
+
+inline Eigen::Vector3d convertBtToEigen(const btVector3& v)
+{
+  return Eigen::Vector3d(static_cast<double>(v.x()), static_cast<double>(v.y()), static_cast<double>(v.z()));
+}
+
+inline btQuaternion convertEigenToBt(const Eigen::Quaterniond& q)
+{
+  const Eigen::Quaternion<btScalar> s = q.cast<btScalar>();
+  return btQuaternion(s.x(), s.y(), s.z(), s.w());
+}
 
-inline btVector3 convertEigenToBt(const Eigen::Vector3d& v) { return btVector3(v[0], v[1], v[2]); }
-inline Eigen::Vector3d convertBtToEigen(const btVector3& v) { return Eigen::Vector3d(v.x(), v.y(), v.z()); }
-inline btQuaternion convertEigenToBt(const Eigen::Quaterniond& q) { return btQuaternion(q.x(), q.y(), q.z(), q.w()); }
 inline btMatrix3x3 convertEigenToBt(const Eigen::Matrix3d& r)
 {
-  return btMatrix3x3(r(0, 0), r(0, 1), r(0, 2), r(1, 0), r(1, 1), r(1, 2), r(2, 0), r(2, 1), r(2, 2));
+  const Eigen::Matrix<btScalar, 3, 3> s = r.cast<btScalar>();
+  return btMatrix3x3(s(0, 0), s(0, 1), s(0, 2), s(1, 0), s(1, 1), s(1, 2), s(2, 0), s(2, 1), s(2, 2));
 }
 
 inline btTransform convertEigenToBt(const Eigen::Isometry3d& t)
@@ -81,6 +105,17 @@ inline btTransform convertEigenToBt(const Eigen::Isometry3d& t)
   return btTransform(convertEigenToBt(rot), convertEigenToBt(tran));
 }
 
+inline Eigen::Isometry3d convertBtToEigen(const btTransform& t)
+{
+  const btMatrix3x3& rot = t.getBasis();
+  Eigen::Isometry3d s = Eigen::Isometry3d::Identity();
+  for (int i = 0; i < 3; ++i)
+    s.linear().row(i) = convertBtToEigen(rot[i]).transpose();
+
+  s.translation() = convertBtToEigen(t.getOrigin());
+  return s;
+}
+
 /**
  * @brief This is a tesseract bullet collsion object.
  *
@@ -104,6 +139,24 @@ public:
   const std::string& getName() const { return m_name; }
   /** @brief Get a user defined type */
   const int& getTypeID() const { return m_type_id; }
+  /** @brief Get the link id assigned by the managers link registry (-1 if not assigned) */
+  int getLinkId() const { return m_link_id; }
+  /** @brief Set the link id assigned by the managers link registry */
+  void setLinkId(int link_id) { m_link_id = link_id; }
+
+  /**
+   * @brief Check if a manager may modify the object in place
+   *
+   * Clones of a manager share its collision objects. Cloning gives the source manager a new owner tag, so objects
+   * tagged before are copied by the first manager modifying them. Copies made by clone() have no owner.
+   *
+   * @param owner_tag The owner tag of the manager, see createOwnerTag()
+   */
+  bool isOwnedBy(std::uint64_t owner_tag) const { return m_owner != 0 && m_owner == owner_tag; }
+
+  /** @brief Tag the object as owned by a manager, it must not be shared with other managers */
+  void setOwner(std::uint64_t owner_tag) { m_owner = owner_tag; }
+
   /** \brief Check if two CollisionObjectWrapper objects point to the same source object */
   bool sameObject(const CollisionObjectWrapper& other) const
   {
@@ -127,6 +180,8 @@ public:
     clone_cow->m_collisionFilterGroup = m_collisionFilterGroup;
     clone_cow->m_collisionFilterMask = m_collisionFilterMask;
     clone_cow->m_enabled = m_enabled;
+    clone_cow->m_link_id = m_link_id;
+    clone_cow->setContactProcessingThreshold(getContactProcessingThreshold());
     return clone_cow;
   }
 
@@ -141,6 +196,25 @@ public:
     m_data.push_back(t);
   }
 
+  /**
+   * @brief Replace a managed object, which is released once no clone uses it anymore
+   * @param old_object The object to replace, the new object is only added if it is not managed
+   * @param t The new object
+   */
+  template <class T>
+  void replaceManaged(const void* old_object, std::shared_ptr<T> t)
+  {
+    for (auto& data : m_data)
+    {
+      if (data.get() == old_object)
+      {
+        data = t;
+        return;
+      }
+    }
+    m_data.push_back(t);
+  }
+
 protected:
   /** @brief This is a special constructor used by the clone method */
   CollisionObjectWrapper(const std::string& name,
@@ -152,9 +226,11 @@ protected:
 
   std::string m_name;                                 /**< @brief The name of the collision object */
   int m_type_id;                                      /**< @brief A user defined type id */
+  int m_link_id;                                      /**< @brief The link id assigned by the managers link registry */
   std::vector<shapes::ShapeConstPtr> m_shapes;        /**< @brief The shapes that define the collison object */
   VectorIsometry3d m_shape_poses;                     /**< @brief The shpaes poses information */
   CollisionObjectTypeVector m_collision_object_types; /**< @brief The shape collision object type to be used */
+  std::uint64_t m_owner;                              /**< @brief The owner tag of the manager which may modify the object */
 
   std::vector<std::shared_ptr<void>>
       m_data; /**< @brief This manages the collision shape pointer so they get destroyed */
@@ -166,24 +242,54 @@ typedef std::shared_ptr<const CollisionObjectWrapper> COWConstPtr;
 typedef std::map<std::string, COWPtr> Link2Cow;
 typedef std::map<std::string, COWConstPtr> Link2ConstCow;
 
-/** @brief This is a casted collision shape used for checking if an object is collision free between two transforms */
+/**
+ * @brief This is a casted collision shape used for checking if an object is collision free between two transforms
+ *
+ * It may also be swept over a window of several consecutive transforms, then it is the convex hull of the shape at
+ * all of them which contains the casts between each consecutive pair.
+ */
 struct CastHullShape : public btConvexShape
 {
 public:
   btConvexShape* m_shape;
   btTransform m_t01;
+  btAlignedObjectArray<btTransform> m_waypoints; /**< @brief The transforms between the first one and m_t01 relative
+                                                      to the first one, empty unless swept over a window */
 
   CastHullShape(btConvexShape* shape, const btTransform& t01) : m_shape(shape), m_t01(t01)
   {
     m_shapeType = CUSTOM_CONVEX_SHAPE_TYPE;
   }
 
-  void updateCastTransform(const btTransform& t01) { m_t01 = t01; }
+  void updateCastTransform(const btTransform& t01)
+  {
+    m_t01 = t01;
+    m_waypoints.resize(0);
+  }
+
+  /**
+   * @brief Sweep the shape over a window of transforms
+   * @param waypoints The transforms between the first and the last one relative to the first one
+   * @param t01 The last transform relative to the first one
+   */
+  void updateCastTransforms(const btAlignedObjectArray<btTransform>& waypoints, const btTransform& t01)
+  {
+    m_t01 = t01;
+    m_waypoints = waypoints;
+  }
+
   btVector3 localGetSupportingVertex(const btVector3& vec) const override
   {
     btVector3 sv0 = m_shape->localGetSupportingVertex(vec);
     btVector3 sv1 = m_t01 * m_shape->localGetSupportingVertex(vec * m_t01.getBasis());
-    return (vec.dot(sv0) > vec.dot(sv1)) ? sv0 : sv1;
+    btVector3 sv = (vec.dot(sv0) > vec.dot(sv1)) ? sv0 : sv1;
+    for (int i = 0; i < m_waypoints.size(); ++i)
+    {
+      btVector3 svi = m_waypoints[i] * m_shape->localGetSupportingVertex(vec * m_waypoints[i].getBasis());
+      if (vec.dot(svi) > vec.dot(sv))
+        sv = svi;
+    }
+    return sv;
   }
 
   // notice that the vectors should be unit length
@@ -202,6 +308,12 @@ public:
     m_shape->getAabb(t_w0 * m_t01, min1, max1);
     aabbMin.setMin(min1);
     aabbMax.setMax(max1);
+    for (int i = 0; i < m_waypoints.size(); ++i)
+    {
+      m_shape->getAabb(t_w0 * m_waypoints[i], min1, max1);
+      aabbMin.setMin(min1);
+      aabbMax.setMax(max1);
+    }
   }
 
   virtual void getAabbSlow(const btTransform& /*t*/, btVector3& /*aabbMin*/, btVector3& /*aabbMax*/) const override
@@ -232,6 +344,414 @@ public:
   }
 };
 
+/**
+ * @brief A collision shape for a signed distance field
+ *
+ * It only collides with convex shapes and compound shapes of convex shapes using the
+ * SignedDistanceFieldCollisionAlgorithm, which must be registered with registerCustomCollisionAlgorithms().
+ */
+class SignedDistanceFieldShape : public btConcaveShape
+{
+public:
+  SignedDistanceFieldShape(SignedDistanceFieldConstPtr sdf) : m_sdf(std::move(sdf))
+  {
+    m_shapeType = CUSTOM_CONCAVE_SHAPE_TYPE;
+  }
+
+  /** @brief Get the signed distance field */
+  const SignedDistanceField& getField() const { return *m_sdf; }
+
+  void getAabb(const btTransform& t, btVector3& aabbMin, btVector3& aabbMax) const override
+  {
+    Eigen::Vector3d field_min, field_max;
+    m_sdf->getAABB(field_min, field_max);
+    btTransformAabb(convertEigenToBt(field_min), convertEigenToBt(field_max), getMargin(), t, aabbMin, aabbMax);
+  }
+
+  void processAllTriangles(btTriangleCallback* /*callback*/,
+                           const btVector3& /*aabbMin*/,
+                           const btVector3& /*aabbMax*/) const override
+  {
+  }
+
+  void setLocalScaling(const btVector3& /*scaling*/) override {}
+  const btVector3& getLocalScaling() const override
+  {
+    static btVector3 out(1, 1, 1);
+    return out;
+  }
+
+  void calculateLocalInertia(btScalar /*mass*/, btVector3& inertia) const override { inertia.setZero(); }
+  const char* getName() const override { return "SignedDistanceField"; }
+
+private:
+  SignedDistanceFieldConstPtr m_sdf;
+};
+
+/**
+ * @brief The collision algorithm between a signed distance field and a convex shape or triangle mesh
+ *
+ * The surface of the shape is covered by sample spheres at the resolution of the field, see
+ * addSignedDistanceFieldSamples(), whose distances are looked up in the field. The closest sample is reported as
+ * the single contact of the pair. The cost grows with the area of the surface within the contact distance of the
+ * field divided by the square of its resolution. Cast shapes are sampled at their transforms but not in between.
+ * Other signed distance fields and octomaps are not supported, a warning is printed and no contact is reported.
+ */
+class SignedDistanceFieldCollisionAlgorithm : public btActivatingCollisionAlgorithm
+{
+public:
+  SignedDistanceFieldCollisionAlgorithm(btPersistentManifold* mf,
+                                        const btCollisionAlgorithmConstructionInfo& ci,
+                                        const btCollisionObjectWrapper* body0Wrap,
+                                        const btCollisionObjectWrapper* body1Wrap,
+                                        bool isSwapped);
+
+  ~SignedDistanceFieldCollisionAlgorithm() override;
+
+  void processCollision(const btCollisionObjectWrapper* body0Wrap,
+                        const btCollisionObjectWrapper* body1Wrap,
+                        const btDispatcherInfo& dispatchInfo,
+                        btManifoldResult* resultOut) override;
+
+  btScalar calculateTimeOfImpact(btCollisionObject* /*body0*/,
+                                 btCollisionObject* /*body1*/,
+                                 const btDispatcherInfo& /*dispatchInfo*/,
+                                 btManifoldResult* /*resultOut*/) override
+  {
+    return btScalar(1.);
+  }
+
+  void getAllContactManifolds(btManifoldArray& manifoldArray) override
+  {
+    if (m_manifoldPtr && m_ownManifold)
+      manifoldArray.push_back(m_manifoldPtr);
+  }
+
+  struct CreateFunc : public btCollisionAlgorithmCreateFunc
+  {
+    CreateFunc(bool swapped) { m_swapped = swapped; }
+
+    btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci,
+                                                   const btCollisionObjectWrapper* body0Wrap,
+                                                   const btCollisionObjectWrapper* body1Wrap) override
+    {
+      void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(SignedDistanceFieldCollisionAlgorithm));
+      return new (mem) SignedDistanceFieldCollisionAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap, m_swapped);
+    }
+  };
+
+private:
+  bool m_ownManifold;                   /**< @brief True if the manifold was created by this algorithm */
+  btPersistentManifold* m_manifoldPtr;  /**< @brief The manifold of the pair */
+  bool m_isSwapped;                     /**< @brief True if the field is the second object */
+  VectorVector3d m_centers;             /**< @brief The centers of the sample spheres in the frame of the field */
+  std::vector<double> m_radii;          /**< @brief The radii of the sample spheres */
+  const btCollisionShape* m_shape;      /**< @brief The shape of the surface, it is only rebuilt if this changes */
+  bool m_surfaceSupported;              /**< @brief False if the surface of the shape can not be sampled */
+  SignedDistanceFieldSurface m_surface; /**< @brief The surface of the other shape in its own frame */
+};
+
+/**
+ * @brief A collision shape for an octomap which is traversed directly instead of storing a shape per voxel
+ *
+ * Every occupied leaf of the octomap is a box, or a sphere enclosing the box if spheres are used. Inner nodes store
+ * the maximum occupancy of their children (the octomap default), so free subtrees are skipped as a whole and the
+ * leaves are only visited where the bounds of a node overlap the query. It collides with all other shapes using the
+ * OcTreeCollisionAlgorithm, which must be registered with registerCustomCollisionAlgorithms().
+ */
+class OcTreeShape : public btConcaveShape
+{
+public:
+  OcTreeShape(std::shared_ptr<const octomap::OcTree> octree, bool use_spheres)
+    : m_octree(std::move(octree))
+    , m_use_spheres(use_spheres)
+    , m_occupancy_threshold(m_octree->getOccupancyThres())
+    , m_root_size(m_octree->getNodeSize(0))
+  {
+    m_shapeType = CUSTOM_CONCAVE_SHAPE_TYPE;
+    computeAabb();
+  }
+
+  /** @brief Get the octomap, it is never modified */
+  const octomap::OcTree& getOcTree() const { return *m_octree; }
+
+  /** @brief True if the leaves are represented by spheres instead of boxes */
+  bool usesSpheres() const { return m_use_spheres; }
+
+  /**
+   * @brief Get the half extent of the bounds of a leaf
+   * @param size The edge length of the leaf
+   */
+  btScalar getLeafHalfExtent(btScalar size) const
+  {
+    return m_use_spheres ? std::sqrt(2 * ((size / 2) * (size / 2))) : size / 2;
+  }
+
+  /**
+   * @brief Find the leaf containing a voxel
+   * @param key The key of the voxel
+   * @param center (Output) The center of the leaf
+   * @param size (Output) The edge length of the leaf
+   * @return True if the leaf is occupied
+   */
+  bool getLeaf(const octomap::OcTreeKey& key, btVector3& center, btScalar& size) const
+  {
+    const octomap::OcTreeNode* node = m_octree->getRoot();
+    if (node == nullptr)
+      return false;
+
+    unsigned int tree_depth = m_octree->getTreeDepth();
+    unsigned int depth = 0;
+    for (; depth < tree_depth && m_octree->nodeHasChildren(node); ++depth)
+    {
+      unsigned int i = octomap::computeChildIdx(key, static_cast<int>(tree_depth - depth - 1));
+      if (!m_octree->nodeChildExists(node, i))
+        return false;
+
+      node = m_octree->getNodeChild(node, i);
+    }
+
+    octomap::point3d point = m_octree->keyToCoord(key, depth);
+    center.setValue(point.x(), point.y(), point.z());
+    size = static_cast<btScalar>(m_octree->getNodeSize(depth));
+    return node->getOccupancy() >= m_occupancy_threshold;
+  }
+
+  /**
+   * @brief Replace the octomap by a copy in which voxels changed, see createUpdatedOcTree()
+   *
+   * The bounds grow to include inserted voxels. They are only recomputed from all leaves if a cleared voxel was on
+   * the boundary. The shape must not be shared with other collision objects.
+   *
+   * @param octree The updated octomap, it must have the resolution and depth of the current one
+   * @param changed_voxels The centers of the voxels which were inserted or cleared, in the frame of the octomap
+   */
+  void updateOcTree(std::shared_ptr<const octomap::OcTree> octree, const VectorVector3d& changed_voxels)
+  {
+    m_octree = std::move(octree);
+    m_occupancy_threshold = m_octree->getOccupancyThres();
+
+    bool recompute = false;
+    for (const auto& voxel : changed_voxels)
+    {
+      octomap::OcTreeKey key;
+      if (!m_octree->coordToKeyChecked(voxel[0], voxel[1], voxel[2], key))
+        continue;
+
+      btVector3 center;
+      btScalar size;
+      if (getLeaf(key, center, size))
+      {
+        addLeafToAabb(center, size);
+        continue;
+      }
+
+      // Only the bounds of a cleared voxel on the boundary shrink
+      octomap::point3d point = m_octree->keyToCoord(key);
+      btScalar half_extent = getLeafHalfExtent(static_cast<btScalar>(m_octree->getResolution()));
+      btVector3 half_extents(half_extent, half_extent, half_extent);
+      btVector3 voxel_min = btVector3(point.x(), point.y(), point.z()) - half_extents;
+      btVector3 voxel_max = btVector3(point.x(), point.y(), point.z()) + half_extents;
+      for (int a = 0; a < 3; ++a)
+        recompute = recompute || voxel_min[a] <= m_aabb_min[a] + SIMD_EPSILON ||
+                    voxel_max[a] >= m_aabb_max[a] - SIMD_EPSILON;
+    }
+
+    if (recompute)
+      computeAabb();
+  }
+
+  /**
+   * @brief Call a function for every occupied leaf whose bounds overlap an AABB
+   * @param callback The function called with the center, the edge length and the index of the leaf
+   * @param aabbMin The minimum of the AABB in the frame of the shape
+   * @param aabbMax The maximum of the AABB in the frame of the shape
+   */
+  template <class T>
+  void processAllLeaves(T&& callback, const btVector3& aabbMin, const btVector3& aabbMax) const
+  {
+    int index = 0;
+    const octomap::OcTreeNode* root = m_octree->getRoot();
+    if (root != nullptr)
+      processLeaves(callback, root, btVector3(0, 0, 0), m_root_size, aabbMin, aabbMax, index);
+  }
+
+  void getAabb(const btTransform& t, btVector3& aabbMin, btVector3& aabbMax) const override
+  {
+    btTransformAabb(m_aabb_min, m_aabb_max, getMargin(), t, aabbMin, aabbMax);
+  }
+
+  void processAllTriangles(btTriangleCallback* /*callback*/,
+                           const btVector3& /*aabbMin*/,
+                           const btVector3& /*aabbMax*/) const override
+  {
+  }
+
+  void setLocalScaling(const btVector3& /*scaling*/) override {}
+  const btVector3& getLocalScaling() const override
+  {
+    static btVector3 out(1, 1, 1);
+    return out;
+  }
+
+  void calculateLocalInertia(btScalar /*mass*/, btVector3& inertia) const override { inertia.setZero(); }
+  const char* getName() const override { return "OcTree"; }
+
+private:
+  std::shared_ptr<const octomap::OcTree> m_octree; /**< @brief The octomap */
+  bool m_use_spheres;                              /**< @brief True if the leaves are represented by spheres */
+  double m_occupancy_threshold;                    /**< @brief The occupancy of occupied nodes */
+  btScalar m_root_size;                            /**< @brief The edge length of the root node */
+  btVector3 m_aabb_min;                            /**< @brief The minimum of the occupied leaves bounds */
+  btVector3 m_aabb_max;                            /**< @brief The maximum of the occupied leaves bounds */
+  bool m_empty;                                    /**< @brief True if no leaf is occupied */
+
+  /** @brief Compute the bounds of all occupied leaves */
+  void computeAabb()
+  {
+    m_aabb_min.setZero();
+    m_aabb_max.setZero();
+    m_empty = true;
+
+    btVector3 infinity(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+    processAllLeaves(
+        [this](const btVector3& center, btScalar size, int /*index*/) { addLeafToAabb(center, size); },
+        -infinity,
+        infinity);
+  }
+
+  /** @brief Extend the bounds to include a leaf */
+  void addLeafToAabb(const btVector3& center, btScalar size)
+  {
+    btScalar half_extent = getLeafHalfExtent(size);
+    btVector3 half_extents(half_extent, half_extent, half_extent);
+    if (m_empty)
+    {
+      m_aabb_min = center - half_extents;
+      m_aabb_max = center + half_extents;
+      m_empty = false;
+      return;
+    }
+
+    m_aabb_min.setMin(center - half_extents);
+    m_aabb_max.setMax(center + half_extents);
+  }
+
+  template <class T>
+  void processLeaves(T& callback,
+                     const octomap::OcTreeNode* node,
+                     const btVector3& center,
+                     btScalar size,
+                     const btVector3& aabbMin,
+                     const btVector3& aabbMax,
+                     int& index) const
+  {
+    if (node->getOccupancy() < m_occupancy_threshold)
+      return;
+
+    btScalar half_extent = getLeafHalfExtent(size);
+    btVector3 half_extents(half_extent, half_extent, half_extent);
+    if (!TestAabbAgainstAabb2(center - half_extents, center + half_extents, aabbMin, aabbMax))
+      return;
+
+    if (!m_octree->nodeHasChildren(node))
+    {
+      callback(center, size, index++);
+      return;
+    }
+
+    // Bit 0, 1 and 2 of the child index select the positive half along x, y and z
+    btScalar offset = size / 4;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+      if (!m_octree->nodeChildExists(node, i))
+        continue;
+
+      btVector3 child_center = center + btVector3((i & 1) ? offset : -offset,
+                                                  (i & 2) ? offset : -offset,
+                                                  (i & 4) ? offset : -offset);
+      processLeaves(callback, m_octree->getNodeChild(node, i), child_center, size / 2, aabbMin, aabbMax, index);
+    }
+  }
+};
+
+/**
+ * @brief The collision algorithm between an octomap and any other shape
+ *
+ * The octomap is descended where it overlaps the AABB of the other shape (expanded by the contact distance) and the
+ * algorithm found by the dispatcher is run for every leaf, like the children of a compound shape.
+ */
+class OcTreeCollisionAlgorithm : public btActivatingCollisionAlgorithm
+{
+public:
+  OcTreeCollisionAlgorithm(const btCollisionAlgorithmConstructionInfo& ci,
+                           const btCollisionObjectWrapper* body0Wrap,
+                           const btCollisionObjectWrapper* body1Wrap,
+                           bool isSwapped);
+
+  ~OcTreeCollisionAlgorithm() override;
+
+  void processCollision(const btCollisionObjectWrapper* body0Wrap,
+                        const btCollisionObjectWrapper* body1Wrap,
+                        const btDispatcherInfo& dispatchInfo,
+                        btManifoldResult* resultOut) override;
+
+  btScalar calculateTimeOfImpact(btCollisionObject* /*body0*/,
+                                 btCollisionObject* /*body1*/,
+                                 const btDispatcherInfo& /*dispatchInfo*/,
+                                 btManifoldResult* /*resultOut*/) override
+  {
+    return btScalar(1.);
+  }
+
+  void getAllContactManifolds(btManifoldArray& manifoldArray) override
+  {
+    if (m_manifoldPtr)
+      manifoldArray.push_back(m_manifoldPtr);
+  }
+
+  struct CreateFunc : public btCollisionAlgorithmCreateFunc
+  {
+    CreateFunc(bool swapped) { m_swapped = swapped; }
+
+    btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci,
+                                                   const btCollisionObjectWrapper* body0Wrap,
+                                                   const btCollisionObjectWrapper* body1Wrap) override
+    {
+      void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(OcTreeCollisionAlgorithm));
+      return new (mem) OcTreeCollisionAlgorithm(ci, body0Wrap, body1Wrap, m_swapped);
+    }
+  };
+
+private:
+  btPersistentManifold* m_manifoldPtr; /**< @brief The manifold shared by the leaf algorithms, octomap first */
+  bool m_isSwapped;                    /**< @brief True if the octomap is the second object */
+};
+
+/**
+ * @brief Register the collision algorithms of the custom concave shapes with a dispatcher
+ *
+ * This is done by every bullet contact manager so SignedDistanceFieldShape and OcTreeShape can be used.
+ *
+ * @param dispatcher The collision dispatcher
+ */
+void registerCustomCollisionAlgorithms(btCollisionDispatcher* dispatcher);
+
+/**
+ * @brief Get the construction info of the collision configurations of the bullet contact managers
+ *
+ * The default configuration preallocates pools of thousands of manifolds and collision algorithms, which dominates
+ * the time to create or clone a manager. The pools are kept small instead, the dispatcher allocates from the heap
+ * once a pool is exhausted.
+ */
+inline btDefaultCollisionConstructionInfo getCollisionConstructionInfo()
+{
+  btDefaultCollisionConstructionInfo info;
+  info.m_defaultMaxPersistentManifoldPoolSize = BULLET_COLLISION_POOL_SIZE;
+  info.m_defaultMaxCollisionAlgorithmPoolSize = BULLET_COLLISION_POOL_SIZE;
+  return info;
+}
+
 inline void
 GetAverageSupport(const btConvexShape* shape, const btVector3& localNormal, float& outsupport, btVector3& outpt)
 {
@@ -279,15 +799,49 @@ GetAverageSupport(const btConvexShape* shape, const btVector3& localNormal, floa
  * @brief This is used to check if a collision check is required between the provided two collision objects
  * @param cow1 The first collision object
  * @param cow2 The second collision object
- * @param acm  The contact allowed function pointer
+ * @param req  The contact request providing the allowed collision matrix or contact allowed function
  * @param verbose Indicate if verbose information should be printed to the terminal
  * @return True if the two collision objects should be checked for collision, otherwise false
  */
-inline bool needsCollisionCheck(const COW& cow1, const COW& cow2, const IsContactAllowedFn acm, bool verbose = false)
+inline bool needsCollisionCheck(const COW& cow1, const COW& cow2, const ContactRequest& req, bool verbose = false)
 {
   return cow1.m_enabled && cow2.m_enabled && (cow2.m_collisionFilterGroup & cow1.m_collisionFilterMask) &&
          (cow1.m_collisionFilterGroup & cow2.m_collisionFilterMask) &&
-         !isContactAllowed(cow1.getName(), cow2.getName(), acm, verbose);
+         !isContactAllowed(cow1.getName(), cow2.getName(), cow1.getLinkId(), cow2.getLinkId(), req, verbose);
+}
+
+/**
+ * @brief Same as above but also skips pairs which already have the maximum number of contacts of a LIMITED request
+ *
+ * This also updates the statistics of the query if they are collected.
+ *
+ * @param cow1 The first collision object
+ * @param cow2 The second collision object
+ * @param cdata The contact query data
+ * @param verbose Indicate if verbose information should be printed to the terminal
+ * @return True if the two collision objects should be checked for collision, otherwise false
+ */
+inline bool needsCollisionCheck(const COW& cow1, const COW& cow2, ContactDistanceData& cdata, bool verbose = false)
+{
+  if (cdata.stats == nullptr)
+    return needsCollisionCheck(cow1, cow2, *cdata.req, verbose) &&
+           !isPairContactLimitReached(cdata, cow1.getName(), cow2.getName(), cow1.getLinkId(), cow2.getLinkId());
+
+  ++cdata.stats->num_broadphase_pairs;
+  if (!(cow1.m_enabled && cow2.m_enabled && (cow2.m_collisionFilterGroup & cow1.m_collisionFilterMask) &&
+        (cow1.m_collisionFilterGroup & cow2.m_collisionFilterMask)))
+  {
+    ++cdata.stats->num_filter_rejected;
+    return false;
+  }
+
+  if (isContactAllowed(cow1.getName(), cow2.getName(), cow1.getLinkId(), cow2.getLinkId(), *cdata.req, verbose))
+  {
+    ++cdata.stats->num_acm_rejected;
+    return false;
+  }
+
+  return !isPairContactLimitReached(cdata, cow1.getName(), cow2.getName(), cow1.getLinkId(), cow2.getLinkId());
 }
 
 inline btScalar addDiscreteSingleResult(btManifoldPoint& cp,
@@ -295,26 +849,29 @@ inline btScalar addDiscreteSingleResult(btManifoldPoint& cp,
                                         const btCollisionObjectWrapper* colObj1Wrap,
                                         ContactDistanceData& collisions)
 {
+  // Only the existence of a contact was requested
+  if (!collisions.storesResults())
+  {
+    collisions.done = true;
+    return 1;
+  }
+
   const CollisionObjectWrapper* cd0 = static_cast<const CollisionObjectWrapper*>(colObj0Wrap->getCollisionObject());
   const CollisionObjectWrapper* cd1 = static_cast<const CollisionObjectWrapper*>(colObj1Wrap->getCollisionObject());
 
-  ObjectPairKey pc = getObjectPairKey(cd0->getName(), cd1->getName());
-
-  const auto& it = collisions.res->find(pc);
-  bool found = (it != collisions.res->end());
-
-  //    size_t l = 0;
-  //    if (found)
-  //    {
-  //      l = it->second.size();
-  //      if (m_collisions.req->type == DistanceRequestType::LIMITED && l >= m_collisions.req->max_contacts_per_body)
-  //          return 0;
-
-  //    }
+  // The algorithm of a pair may report several contacts, the limits of LIMITED requests apply to each of them
+  if (collisions.done ||
+      isPairContactLimitReached(collisions, cd0->getName(), cd1->getName(), cd0->getLinkId(), cd1->getLinkId()))
+    return 0;
 
   ContactResult contact;
-  contact.link_names[0] = cd0->getName();
-  contact.link_names[1] = cd1->getName();
+  if (collisions.res != nullptr)
+  {
+    contact.link_names[0] = cd0->getName();
+    contact.link_names[1] = cd1->getName();
+  }
+  contact.link_ids[0] = cd0->getLinkId();
+  contact.link_ids[1] = cd1->getLinkId();
   contact.nearest_points[0] = convertBtToEigen(cp.m_positionWorldOnA);
   contact.nearest_points[1] = convertBtToEigen(cp.m_positionWorldOnB);
   contact.type_id[0] = cd0->getTypeID();
@@ -322,7 +879,7 @@ inline btScalar addDiscreteSingleResult(btManifoldPoint& cp,
   contact.distance = cp.m_distance1;
   contact.normal = convertBtToEigen(-1 * cp.m_normalWorldOnB);
 
-  if (!processResult(collisions, contact, pc, found))
+  if (!processResult(collisions, contact))
   {
     return 0;
   }
@@ -338,27 +895,34 @@ inline btScalar addCastSingleResult(btManifoldPoint& cp,
                                     ContactDistanceData& collisions,
                                     bool castShapeIsFirst)
 {
+  // Only the existence of a contact was requested
+  if (!collisions.storesResults())
+  {
+    collisions.done = true;
+    return 1;
+  }
+
   const CollisionObjectWrapper* cd0 = static_cast<const CollisionObjectWrapper*>(colObj0Wrap->getCollisionObject());
   const CollisionObjectWrapper* cd1 = static_cast<const CollisionObjectWrapper*>(colObj1Wrap->getCollisionObject());
 
-  const std::pair<std::string, std::string>& pc = cd0->getName() < cd1->getName() ?
-                                                      std::make_pair(cd0->getName(), cd1->getName()) :
-                                                      std::make_pair(cd1->getName(), cd0->getName());
-
-  ContactResultMap::iterator it = collisions.res->find(pc);
-  bool found = it != collisions.res->end();
+  // The algorithm of a pair may report several contacts, the limits of LIMITED requests apply to each of them
+  if (collisions.done ||
+      isPairContactLimitReached(collisions, cd0->getName(), cd1->getName(), cd0->getLinkId(), cd1->getLinkId()))
+    return 0;
 
-  //    size_t l = 0;
-  //    if (found)
-  //    {
-  //      l = it->second.size();
-  //      if (m_collisions.req->type == DistanceRequestType::LIMITED && l >= m_collisions.req->max_contacts_per_body)
-  //          return 0;
-  //    }
+  // The continuous data of a contact which would not replace the closest stored one is not computed
+  if (isCloserContactStored(
+          collisions, cd0->getName(), cd1->getName(), cd0->getLinkId(), cd1->getLinkId(), cp.m_distance1))
+    return 0;
 
   ContactResult contact;
-  contact.link_names[0] = cd0->getName();
-  contact.link_names[1] = cd1->getName();
+  if (collisions.res != nullptr)
+  {
+    contact.link_names[0] = cd0->getName();
+    contact.link_names[1] = cd1->getName();
+  }
+  contact.link_ids[0] = cd0->getLinkId();
+  contact.link_ids[1] = cd1->getLinkId();
   contact.nearest_points[0] = convertBtToEigen(cp.m_positionWorldOnA);
   contact.nearest_points[1] = convertBtToEigen(cp.m_positionWorldOnB);
   contact.type_id[0] = cd0->getTypeID();
@@ -366,11 +930,8 @@ inline btScalar addCastSingleResult(btManifoldPoint& cp,
   contact.distance = cp.m_distance1;
   contact.normal = convertBtToEigen(-1 * cp.m_normalWorldOnB);
 
-  ContactResult* col = processResult(collisions, contact, pc, found);
-  if (!col)
-  {
-    return 0;
-  }
+  // The continuous data is computed before storing the contact so it can be stored in any result container
+  ContactResult* col = &contact;
 
   btVector3 normalWorldFromCast = -(castShapeIsFirst ? 1 : -1) * cp.m_normalWorldOnB;
   const btCollisionObjectWrapper* firstColObjWrap = (castShapeIsFirst ? colObj0Wrap : colObj1Wrap);
@@ -380,6 +941,7 @@ inline btScalar addCastSingleResult(btManifoldPoint& cp,
   {
     std::swap(col->nearest_points[0], col->nearest_points[1]);
     std::swap(col->link_names[0], col->link_names[1]);
+    std::swap(col->link_ids[0], col->link_ids[1]);
     std::swap(col->type_id[0], col->type_id[1]);
     col->normal *= -1;
   }
@@ -454,6 +1016,11 @@ inline btScalar addCastSingleResult(btManifoldPoint& cp,
     }
   }
 
+  if (!processResult(collisions, contact))
+  {
+    return 0;
+  }
+
   return 1;
 }
 
@@ -530,6 +1097,13 @@ struct TesseractBroadphaseBridgedManifoldResult : public btManifoldResult
     if (depth > collisions_.req->contact_distance)
       return;
 
+    // Only the existence of a contact was requested
+    if (!collisions_.storesResults())
+    {
+      collisions_.done = true;
+      return;
+    }
+
     bool isSwapped = m_manifoldPtr->getBody0() != m_body0Wrap->getCollisionObject();
     btVector3 pointA = pointInWorld + normalOnBInWorld * depth;
     btVector3 localA;
@@ -652,10 +1226,14 @@ public:
   virtual ~TesseractCollisionPairCallback() {}
   virtual bool processOverlap(btBroadphasePair& pair)
   {
+    // The pair cache can not be interrupted so skip the remaining pairs once the search is finished
+    if (collisions_.done)
+      return false;
+
     const CollisionObjectWrapper* cow1 = static_cast<const CollisionObjectWrapper*>(pair.m_pProxy0->m_clientObject);
     const CollisionObjectWrapper* cow2 = static_cast<const CollisionObjectWrapper*>(pair.m_pProxy1->m_clientObject);
 
-    bool needs_collision = needsCollisionCheck(*cow1, *cow2, collisions_.req->isContactAllowed, false);
+    bool needs_collision = needsCollisionCheck(*cow1, *cow2, collisions_, false);
 
     if (needs_collision)
     {
@@ -674,6 +1252,9 @@ public:
         contactPointResult.m_closestPointDistanceThreshold = collisions_.req->contact_distance;
 
         // discrete collision detection query
+        NarrowphaseStatisticsCollector stats(collisions_.stats,
+                                             cow1->getCollisionShape()->getShapeType(),
+                                             cow2->getCollisionShape()->getShapeType());
         pair.m_algorithm->processCollision(&obj0Wrap, &obj1Wrap, dispatch_info_, &contactPointResult);
       }
     }
@@ -685,6 +1266,22 @@ btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
                                        const CollisionObjectType& collision_object_type,
                                        CollisionObjectWrapper* cow);
 
+/**
+ * @brief Get a bullet collision shape from the process wide shape cache, it is created if not cached
+ *
+ * Shapes with the same data and collision object type share one collision shape, which must not be modified.
+ * Octrees are not cached.
+ *
+ * @param geom The geometric shape
+ * @param collision_object_type The collision object type
+ * @return The collision shape, nullptr if the shape type is not supported
+ */
+std::shared_ptr<btCollisionShape> getCachedBulletShape(const shapes::ShapeConstPtr& geom,
+                                                       const CollisionObjectType& collision_object_type);
+
+/** @brief Get the process wide cache of bullet collision shapes */
+CollisionShapeCache<btCollisionShape>& getBulletShapeCache();
+
 /**
  * @brief updateCollisionObjectsWithRequest
  * @param req
@@ -723,6 +1320,576 @@ inline void updateCollisionObjectWithRequest(const ContactRequest& req, COW& cow
   cow.setContactProcessingThreshold(req.contact_distance);
 }
 
+/**
+ * @brief Check if updateCollisionObjectWithRequest() would change a collision object
+ * @param req The contact request
+ * @param cow The collision object
+ * @return True if the filter or the contact threshold of the object differ from the request
+ */
+inline bool needsRequestUpdate(const ContactRequest& req, const COW& cow)
+{
+  bool kinematic = req.link_names.empty() ||
+                   std::find(req.link_names.begin(), req.link_names.end(), cow.getName()) != req.link_names.end();
+
+  int group = kinematic ? btBroadphaseProxy::KinematicFilter : btBroadphaseProxy::StaticFilter;
+  int mask = kinematic ? (btBroadphaseProxy::StaticFilter | btBroadphaseProxy::KinematicFilter) :
+                         static_cast<int>(btBroadphaseProxy::KinematicFilter);
+
+  return cow.m_collisionFilterGroup != group || cow.m_collisionFilterMask != mask ||
+         cow.getContactProcessingThreshold() != static_cast<btScalar>(req.contact_distance);
+}
+
+/** @brief Check if a collision object has an octomap shape */
+bool hasOcTreeShapes(const COW& cow);
+
+/**
+ * @brief Mark voxels of the octomaps of a collision object occupied or free
+ *
+ * Collision shapes and octomaps are shared between clones of a collision object, so the octomap shapes and the
+ * compound shape holding them are copied, with updated copies of their octomaps, and the collision shape of the
+ * object is replaced. The narrowphase state of the object must be discarded afterwards.
+ *
+ * @param cow The collision object, which must not be shared with other managers
+ * @param occupied_voxels The centers of the voxels to mark occupied, in the frame of the octomap
+ * @param free_voxels The centers of the voxels to mark free, in the frame of the octomap
+ * @return True if the collision object has an octomap shape
+ */
+bool updateOcTreeShapes(COW& cow, const VectorVector3d& occupied_voxels, const VectorVector3d& free_voxels);
+
+/**
+ * @brief Assign the link id of a collision object and store it in a vector indexed by link id
+ * @param registry The link registry used to assign the id
+ * @param id2cow The collision objects indexed by link id
+ * @param cow The collision object
+ */
+inline void indexCollisionObject(NameRegistry& registry, std::vector<COWPtr>& id2cow, const COWPtr& cow)
+{
+  // Objects shared with a clone of the manager already have their link id
+  int link_id = registry.intern(cow->getName());
+  if (cow->getLinkId() != link_id)
+    cow->setLinkId(link_id);
+
+  if (static_cast<std::size_t>(link_id) >= id2cow.size())
+    id2cow.resize(static_cast<std::size_t>(link_id) + 1);
+
+  id2cow[static_cast<std::size_t>(link_id)] = cow;
+}
+
+/**
+ * @brief Remove a collision object from a vector indexed by link id
+ * @param id2cow The collision objects indexed by link id
+ * @param cow The collision object
+ */
+inline void unindexCollisionObject(std::vector<COWPtr>& id2cow, const COW& cow)
+{
+  int link_id = cow.getLinkId();
+  if (link_id >= 0 && static_cast<std::size_t>(link_id) < id2cow.size())
+    id2cow[static_cast<std::size_t>(link_id)] = nullptr;
+}
+
+/**
+ * @brief Get the collision object associated with a link id
+ * @param id2cow The collision objects indexed by link id
+ * @param link_id The link id
+ * @return The collision object, nullptr if the link id is not managed
+ */
+inline const COWPtr& getCollisionObject(const std::vector<COWPtr>& id2cow, int link_id)
+{
+  static const COWPtr null_cow;
+  if (link_id < 0 || static_cast<std::size_t>(link_id) >= id2cow.size())
+    return null_cow;
+
+  return id2cow[static_cast<std::size_t>(link_id)];
+}
+
+/**
+ * @brief A sweep and prune broadphase over a vector of collision objects (active followed by static)
+ *
+ * The AABB of every enabled object is computed once per update and stored as a structure of arrays
+ * sorted along the axis with the largest spread of AABB centers. Overlaps on the remaining two axes are
+ * tested for a whole sweep interval at a time with branch free comparisons so the compiler can vectorize them.
+ *
+ * The pairs are visited in sweep order, by the AABB minimum along the sweep axis, and not in the order of the
+ * objects. Requests which stop early, FIRST and LIMITED with max_total_contacts, therefore report the contacts
+ * of the pairs found first along the sweep axis.
+ */
+class SweepAndPrune
+{
+public:
+  SweepAndPrune() : num_active_(0) {}
+
+  /**
+   * @brief Compute and sort the AABBs of the collision objects
+   *
+   * The AABBs are increased by the contact processing threshold of each object.
+   *
+   * @param cows The collision objects, active (KinematicFilter) followed by static
+   */
+  void update(const std::vector<COWPtr>& cows)
+  {
+    num_active_ = 0;
+    index_.clear();
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      aabb_min_[i].clear();
+      aabb_max_[i].clear();
+    }
+
+    btVector3 center_sum(0, 0, 0), center_sq_sum(0, 0, 0);
+    for (std::size_t i = 0; i < cows.size(); ++i)
+    {
+      const COWPtr& cow = cows[i];
+      if (cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter)
+        num_active_ = i + 1;
+
+      if (!cow->m_enabled)
+        continue;
+
+      btVector3 aabb_min, aabb_max;
+      cow->getCollisionShape()->getAabb(cow->getWorldTransform(), aabb_min, aabb_max);
+
+      // need to increase the aabb for contact thresholds
+      btScalar threshold = cow->getContactProcessingThreshold();
+      aabb_min -= btVector3(threshold, threshold, threshold);
+      aabb_max += btVector3(threshold, threshold, threshold);
+
+      index_.push_back(static_cast<int>(i));
+      for (std::size_t j = 0; j < 3; ++j)
+      {
+        aabb_min_[j].push_back(aabb_min[static_cast<int>(j)]);
+        aabb_max_[j].push_back(aabb_max[static_cast<int>(j)]);
+      }
+
+      btVector3 center = 0.5 * (aabb_min + aabb_max);
+      center_sum += center;
+      center_sq_sum += center * center;
+    }
+
+    // Sweep along the axis with the largest variance of the centers
+    btScalar n = static_cast<btScalar>(std::max(index_.size(), static_cast<std::size_t>(1)));
+    btVector3 variance = center_sq_sum / n - (center_sum / n) * (center_sum / n);
+    std::size_t axis = static_cast<std::size_t>(variance.maxAxis());
+    axes_[0] = axis;
+    axes_[1] = (axis + 1) % 3;
+    axes_[2] = (axis + 2) % 3;
+
+    order_.resize(index_.size());
+    for (std::size_t i = 0; i < order_.size(); ++i)
+      order_[i] = i;
+
+    const std::vector<btScalar>& sweep_min = aabb_min_[axis];
+    // Ties are broken by the object order so the pairs are always visited in the same order
+    std::sort(order_.begin(), order_.end(), [&sweep_min](std::size_t a, std::size_t b) {
+      return sweep_min[a] < sweep_min[b] || (sweep_min[a] == sweep_min[b] && a < b);
+    });
+
+    // Store the AABBs in sweep order so each interval is contiguous in memory
+    sorted_index_.resize(order_.size());
+    for (std::size_t j = 0; j < 3; ++j)
+    {
+      sorted_min_[j].resize(order_.size());
+      sorted_max_[j].resize(order_.size());
+    }
+
+    for (std::size_t i = 0; i < order_.size(); ++i)
+    {
+      sorted_index_[i] = index_[order_[i]];
+      for (std::size_t j = 0; j < 3; ++j)
+      {
+        sorted_min_[j][i] = aabb_min_[axes_[j]][order_[i]];
+        sorted_max_[j][i] = aabb_max_[axes_[j]][order_[i]];
+      }
+    }
+  }
+
+  /**
+   * @brief Call a function for every pair of overlapping AABBs where at least one object is active
+   * @param cows The collision objects provided to update()
+   * @param fn Called with the two collision objects, in the order of cows. Returning true stops the search. The
+   *           pairs are visited in sweep order.
+   */
+  template <typename PairCallback>
+  void findOverlappingPairs(const std::vector<COWPtr>& cows, PairCallback fn)
+  {
+    const std::size_t size = sorted_index_.size();
+    const btScalar* min0 = sorted_min_[0].data();
+    const btScalar* max0 = sorted_max_[0].data();
+    const btScalar* min1 = sorted_min_[1].data();
+    const btScalar* max1 = sorted_max_[1].data();
+    const btScalar* min2 = sorted_min_[2].data();
+    const btScalar* max2 = sorted_max_[2].data();
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      // The interval of objects which overlap along the sweep axis
+      std::size_t end = std::upper_bound(min0 + i + 1, min0 + size, max0[i]) - min0;
+      if (end == i + 1)
+        continue;
+
+      overlap_.resize(end - i - 1);
+      unsigned char* overlap = overlap_.data();
+      const btScalar a_min1 = min1[i], a_max1 = max1[i], a_min2 = min2[i], a_max2 = max2[i];
+      for (std::size_t j = i + 1; j < end; ++j)
+        overlap[j - i - 1] = static_cast<unsigned char>((a_min1 <= max1[j]) & (a_max1 >= min1[j]) &
+                                                        (a_min2 <= max2[j]) & (a_max2 >= min2[j]));
+
+      for (std::size_t j = i + 1; j < end; ++j)
+      {
+        if (!overlap[j - i - 1])
+          continue;
+
+        std::size_t a = static_cast<std::size_t>(std::min(sorted_index_[i], sorted_index_[j]));
+        std::size_t b = static_cast<std::size_t>(std::max(sorted_index_[i], sorted_index_[j]));
+
+        // Static objects are never checked against each other
+        if (a >= num_active_)
+          continue;
+
+        if (fn(cows[a], cows[b]))
+          return;
+      }
+    }
+  }
+
+private:
+  std::size_t num_active_;              /**< @brief The number of active objects at the front of the vector */
+  std::size_t axes_[3];                 /**< @brief The sweep axis followed by the two remaining axes */
+  std::vector<int> index_;              /**< @brief The index of the enabled objects */
+  std::vector<btScalar> aabb_min_[3];   /**< @brief The AABB minimum of the enabled objects per axis */
+  std::vector<btScalar> aabb_max_[3];   /**< @brief The AABB maximum of the enabled objects per axis */
+  std::vector<std::size_t> order_;      /**< @brief The order of the enabled objects along the sweep axis */
+  std::vector<int> sorted_index_;       /**< @brief The object index in sweep order */
+  std::vector<btScalar> sorted_min_[3]; /**< @brief The AABB minimum in sweep order (sweep axis first) */
+  std::vector<btScalar> sorted_max_[3]; /**< @brief The AABB maximum in sweep order (sweep axis first) */
+  std::vector<unsigned char> overlap_;  /**< @brief The overlap flags of the current sweep interval */
+};
+
+/**
+ * @brief A broadphase keeping the static objects in a tree of their own
+ *
+ * Static objects (StaticFilter) rarely move. The leaf of a moving static object is updated in place, while the tree
+ * is rebuilt top down before the next search after objects were added or removed, or after as many leaf updates as
+ * the tree has leaves, so static objects which move on every query cost O(log n) each. The few kinematic objects
+ * (KinematicFilter) are kept in a second tree whose leaves are updated as they move, the tree is refit in a single
+ * bottom up pass before the next search so a batch of updates only refits it once. Overlapping pairs are searched
+ * within the kinematic tree and between the kinematic and the static tree only, static objects are never checked
+ * against each other.
+ */
+class StaticWorldBroadphase
+{
+public:
+  StaticWorldBroadphase() : static_changed_(false), static_updates_(0), kinematic_changed_(false) {}
+
+  StaticWorldBroadphase(const StaticWorldBroadphase&) = delete;
+  StaticWorldBroadphase& operator=(const StaticWorldBroadphase&) = delete;
+
+  /**
+   * @brief Add a collision object or update it after its transform, shape, contact threshold or group changed
+   *
+   * The AABB is increased by the contact processing threshold of the object. Objects whose AABB and group did not
+   * change are left untouched.
+   *
+   * @param cow The collision object, it must stay alive until it is removed
+   */
+  void update(const COW& cow)
+  {
+    btVector3 aabb_min, aabb_max;
+    cow.getCollisionShape()->getAabb(cow.getWorldTransform(), aabb_min, aabb_max);
+
+    // need to increase the aabb for contact thresholds
+    btScalar threshold = cow.getContactProcessingThreshold();
+    aabb_min -= btVector3(threshold, threshold, threshold);
+    aabb_max += btVector3(threshold, threshold, threshold);
+    btDbvtVolume volume = btDbvtVolume::FromMM(aabb_min, aabb_max);
+
+    bool kinematic = (cow.m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter);
+    auto it = leaves_.find(&cow);
+    if (it != leaves_.end() && it->second.kinematic == kinematic)
+    {
+      btDbvtNode* leaf = it->second.leaf;
+      if (leaf->volume.Mins() == volume.Mins() && leaf->volume.Maxs() == volume.Maxs())
+        return;
+
+      if (kinematic)
+      {
+        leaf->volume = volume;
+        kinematic_changed_ = true;
+      }
+      else
+      {
+        // The leaf is reinserted, the tree is only rebuilt once its quality may have degraded
+        static_tree_.update(leaf, volume);
+        if (++static_updates_ >= getNumStatic())
+          static_changed_ = true;
+      }
+      return;
+    }
+
+    if (it != leaves_.end())
+      remove(cow);
+
+    if (kinematic)
+      refitKinematic();
+
+    leaves_[&cow] = Leaf{ getTree(kinematic).insert(volume, const_cast<COW*>(&cow)), kinematic };
+    static_changed_ = static_changed_ || !kinematic;
+  }
+
+  /** @brief Remove a collision object, nothing is done if it was not added */
+  void remove(const COW& cow)
+  {
+    auto it = leaves_.find(&cow);
+    if (it == leaves_.end())
+      return;
+
+    if (it->second.kinematic)
+      refitKinematic();
+
+    getTree(it->second.kinematic).remove(it->second.leaf);
+    static_changed_ = static_changed_ || !it->second.kinematic;
+    leaves_.erase(it);
+  }
+
+  /**
+   * @brief Replace a collision object by a copy with the same AABB and group, keeping its leaf
+   * @param cow The collision object
+   * @param copy The copy, it must stay alive until it is removed
+   */
+  void replace(const COW& cow, const COW& copy)
+  {
+    auto it = leaves_.find(&cow);
+    if (it == leaves_.end())
+      return;
+
+    Leaf leaf = it->second;
+    leaves_.erase(it);
+    leaf.leaf->data = const_cast<COW*>(&copy);
+    leaves_[&copy] = leaf;
+  }
+
+  /**
+   * @brief Copy the trees to another broadphase without inserting the collision objects again
+   *
+   * The copy references the same collision objects, they are swapped for their own copies with replace().
+   *
+   * @param dest The broadphase receiving the copy, its current content is discarded
+   */
+  void clone(StaticWorldBroadphase& dest) const
+  {
+    dest.leaves_.clear();
+
+    LeafCloner cloner(dest.leaves_, false);
+    static_tree_.clone(dest.static_tree_, &cloner);
+    cloner.kinematic_ = true;
+    kinematic_tree_.clone(dest.kinematic_tree_, &cloner);
+
+    // btDbvt::clone() does not count the leaves
+    dest.static_tree_.m_leaves = static_tree_.m_leaves;
+    dest.kinematic_tree_.m_leaves = kinematic_tree_.m_leaves;
+    dest.static_changed_ = static_changed_;
+    dest.static_updates_ = static_updates_;
+    dest.kinematic_changed_ = kinematic_changed_;
+  }
+
+  /**
+   * @brief Call a function for every pair of overlapping AABBs where at least one object is kinematic
+   * @param fn Called with the two collision objects, the kinematic object first
+   */
+  template <typename PairCallback>
+  void findOverlappingPairs(PairCallback fn)
+  {
+    if (static_changed_)
+    {
+      static_tree_.optimizeTopDown();
+      static_changed_ = false;
+      static_updates_ = 0;
+    }
+    refitKinematic();
+
+    PairCollector<PairCallback> collector(fn);
+    kinematic_tree_.collideTTpersistentStack(kinematic_tree_.m_root, kinematic_tree_.m_root, collector);
+    kinematic_tree_.collideTTpersistentStack(kinematic_tree_.m_root, static_tree_.m_root, collector);
+  }
+
+  /** @brief Get the number of kinematic objects */
+  std::size_t getNumKinematic() const { return static_cast<std::size_t>(kinematic_tree_.m_leaves); }
+
+  /** @brief Get the number of static objects */
+  std::size_t getNumStatic() const { return static_cast<std::size_t>(static_tree_.m_leaves); }
+
+private:
+  /** @brief The leaf of a collision object */
+  struct Leaf
+  {
+    btDbvtNode* leaf; /**< @brief The leaf node, its data is the collision object */
+    bool kinematic;   /**< @brief Indicate if the leaf is in the kinematic tree */
+  };
+
+  /** @brief Forwards the overlapping leaves found by the tree traversal to a pair callback */
+  template <typename PairCallback>
+  struct PairCollector : public btDbvt::ICollide
+  {
+    explicit PairCollector(PairCallback& fn) : fn_(fn) {}
+
+    void Process(const btDbvtNode* a, const btDbvtNode* b) override
+    {
+      fn_(*static_cast<const COW*>(a->data), *static_cast<const COW*>(b->data));
+    }
+
+    PairCallback& fn_;
+  };
+
+  /** @brief Stores the leaves of a copied tree */
+  struct LeafCloner : public btDbvt::IClone
+  {
+    LeafCloner(std::unordered_map<const COW*, Leaf>& leaves, bool kinematic) : leaves_(leaves), kinematic_(kinematic)
+    {
+    }
+
+    void CloneLeaf(btDbvtNode* n) override { leaves_[static_cast<const COW*>(n->data)] = Leaf{ n, kinematic_ }; }
+
+    std::unordered_map<const COW*, Leaf>& leaves_;
+    bool kinematic_;
+  };
+
+  btDbvt static_tree_;                          /**< @brief The tree of the static objects */
+  btDbvt kinematic_tree_;                       /**< @brief The tree of the kinematic objects */
+  std::unordered_map<const COW*, Leaf> leaves_; /**< @brief The leaf of every collision object */
+  bool static_changed_;                         /**< @brief Indicate if the static tree must be rebuilt */
+  std::size_t static_updates_;                  /**< @brief The leaves of the static tree updated since the rebuild */
+  bool kinematic_changed_;                      /**< @brief Indicate if the kinematic tree must be refit */
+
+  btDbvt& getTree(bool kinematic) { return kinematic ? kinematic_tree_ : static_tree_; }
+
+  /** @brief Recompute the volumes of the internal nodes of the kinematic tree from its leaves */
+  void refitKinematic()
+  {
+    if (!kinematic_changed_)
+      return;
+
+    refit(kinematic_tree_.m_root);
+    kinematic_changed_ = false;
+  }
+
+  /** @brief Recompute the volumes of the internal nodes below a node */
+  static void refit(btDbvtNode* node)
+  {
+    if (node == nullptr || node->isleaf())
+      return;
+
+    refit(node->childs[0]);
+    refit(node->childs[1]);
+    Merge(node->childs[0]->volume, node->childs[1]->volume, node->volume);
+  }
+};
+
+/**
+ * @brief Keeps the narrowphase state of collision object pairs between contact tests
+ *
+ * Queries are usually made for nearly identical configurations back to back, so the collision algorithm of a pair
+ * is created once and reused. Pairs of convex shapes which the dispatcher would hand to the generic convex algorithm
+ * run GJK directly instead, starting from the separating axis found by the previous query of the pair. The entries
+ * of a collision object must be removed before it is destroyed. Entries of pairs which are no longer checked are
+ * removed by evict() at the end of every contact test, so the cache does not grow with every pair that ever overlapped.
+ */
+class NarrowphasePairCache
+{
+public:
+  explicit NarrowphasePairCache(btCollisionDispatcher* dispatcher) : dispatcher_(dispatcher) {}
+  ~NarrowphasePairCache() { clear(); }
+
+  NarrowphasePairCache(const NarrowphasePairCache&) = delete;
+  NarrowphasePairCache& operator=(const NarrowphasePairCache&) = delete;
+
+  /**
+   * @brief Run the narrowphase of a pair using its cached state
+   * @param obA The first collision object
+   * @param obB The second collision object
+   * @param dispatch_info The dispatcher configuration
+   * @param result The result receiving the contacts
+   */
+  void processCollision(const btCollisionObjectWrapper* obA,
+                        const btCollisionObjectWrapper* obB,
+                        const btDispatcherInfo& dispatch_info,
+                        btManifoldResult* result);
+
+  /** @brief Remove the entries of all pairs containing a collision object */
+  void remove(const btCollisionObject* object);
+
+  /** @brief Remove all entries */
+  void clear();
+
+  /**
+   * @brief Remove the entries of all pairs which were not processed since the previous call
+   *
+   * Pairs which are not checked by a query, because they no longer overlap or the query finished early, lose their
+   * state and start cold the next time they are checked.
+   */
+  void evict();
+
+  /** @brief Get the number of cached pairs */
+  std::size_t size() const { return entries_.size(); }
+
+private:
+  /** @brief The narrowphase state of a pair */
+  struct Entry
+  {
+    btCollisionAlgorithm* algorithm; /**< @brief The collision algorithm, nullptr if GJK is run directly */
+    btPersistentManifold* manifold;  /**< @brief The manifold used by GJK, nullptr if an algorithm is used */
+    btVector3 separating_axis;       /**< @brief The separating axis found by the last GJK query */
+    unsigned long query;             /**< @brief The query in which the pair was last processed */
+  };
+
+  typedef std::pair<const btCollisionObject*, const btCollisionObject*> Key;
+
+  struct KeyHash
+  {
+    std::size_t operator()(const Key& key) const
+    {
+      std::size_t hash = std::hash<const void*>()(key.first);
+      return hash ^ (std::hash<const void*>()(key.second) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+    }
+  };
+
+  btCollisionDispatcher* dispatcher_;               /**< @brief Creates the algorithms and manifolds */
+  btVoronoiSimplexSolver simplex_solver_;           /**< @brief The simplex solver of GJK */
+  btGjkEpaPenetrationDepthSolver pd_solver_;        /**< @brief The penetration depth solver of GJK */
+  std::unordered_map<Key, Entry, KeyHash> entries_; /**< @brief Entries keyed on the object pointers */
+  unsigned long query_ = 0;                         /**< @brief The current query, incremented by evict() */
+
+  /** @brief Release the algorithm and manifold of an entry */
+  void release(Entry& entry);
+};
+
+/**
+ * @brief The narrowphase state of a thread of a parallel contact test
+ *
+ * Dispatchers allocate algorithms and manifolds from pools which are not thread safe, so every thread has its own
+ * dispatcher and keeps the algorithms of the pairs it checked in its own cache.
+ */
+struct NarrowphaseWorker
+{
+  btDefaultCollisionConfiguration coll_config;       /**< @brief The collision configuration of the dispatcher */
+  std::unique_ptr<btCollisionDispatcher> dispatcher; /**< @brief The dispatcher of the thread */
+  std::unique_ptr<NarrowphasePairCache> pair_cache;  /**< @brief The narrowphase state of the pairs it checked */
+
+  NarrowphaseWorker();
+};
+
+/**
+ * @brief Run the narrowphase of an overlapping pair of the broadphase
+ * @param cow1 The first collision object
+ * @param cow2 The second collision object
+ * @param pair_cache The narrowphase state of the pairs
+ * @param dispatch_info The dispatcher configuration
+ * @param cdata The contact query data
+ */
+void processOverlappingPair(const COW& cow1,
+                            const COW& cow2,
+                            NarrowphasePairCache& pair_cache,
+                            const btDispatcherInfo& dispatch_info,
+                            ContactDistanceData& cdata);
+
 inline COWPtr createCollisionObject(const std::string& name,
                                     const int& type_id,
                                     const std::vector<shapes::ShapeConstPtr>& shapes,
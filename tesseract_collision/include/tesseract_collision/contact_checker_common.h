@@ -30,9 +30,26 @@
 #include <ros/console.h>
 
 #include <LinearMath/btConvexHullComputer.h>
+#include <octomap/OcTree.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <Eigen/Geometry>
 #include <fstream>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @brief Marks the inline accessors of process wide settings
+ *
+ * The single precision bullet plugin is built with hidden visibility, which would give it private copies of the
+ * function local statics of inline functions. With default visibility the dynamic linker resolves them to a single
+ * instance, so settings made through the tesseract_collision headers also apply to the plugin. The settings must
+ * not depend on btScalar.
+ */
+#define TESSERACT_COLLISION_SHARED_STATE __attribute__((visibility("default")))
 
 namespace tesseract
 {
@@ -49,6 +66,19 @@ inline ObjectPairKey getObjectPairKey(const std::string& obj1, const std::string
   return obj1 < obj2 ? std::make_pair(obj1, obj2) : std::make_pair(obj2, obj1);
 }
 
+typedef std::pair<int, int> ObjectPairIdKey;
+
+/**
+ * @brief Get a key for two object ids to search the id keyed contact results
+ * @param id1 First collision object link id
+ * @param id2 Second collision object link id
+ * @return The collision pair key
+ */
+inline ObjectPairIdKey getObjectPairKey(int id1, int id2)
+{
+  return id1 < id2 ? std::make_pair(id1, id2) : std::make_pair(id2, id1);
+}
+
 /**
  * @brief Determine if contact is allowed between two objects.
  * @param name1 The name of the first object
@@ -81,36 +111,290 @@ isContactAllowed(const std::string& name1, const std::string& name2, const IsCon
   return false;
 }
 
-inline ContactResult* processResult(ContactDistanceData& cdata,
-                                    ContactResult& contact,
-                                    const std::pair<std::string, std::string>& key,
-                                    bool found)
+/**
+ * @brief Determine if contact is allowed between two objects using the requests compiled allowed collision
+ * matrix when it is available, otherwise the requests contact allowed function.
+ * @param name1 The name of the first object
+ * @param name2 The name of the second object
+ * @param id1 The link id of the first object (-1 if it does not have one)
+ * @param id2 The link id of the second object (-1 if it does not have one)
+ * @param req The contact request
+ * @param verbose If true print debug informaton
+ * @return True if contact is allowed between the two object, otherwise false.
+ */
+inline bool isContactAllowed(const std::string& name1,
+                             const std::string& name2,
+                             int id1,
+                             int id2,
+                             const ContactRequest& req,
+                             bool verbose = false)
 {
-  if (!found)
+  if (req.allowed_collision_matrix == nullptr || id1 < 0 || id2 < 0)
+    return isContactAllowed(name1, name2, req.isContactAllowed, verbose);
+
+  // do not distance check geoms part of the same object / link / attached body
+  if (id1 == id2)
+    return true;
+
+  if (req.allowed_collision_matrix->isCollisionAllowed(id1, id2))
   {
-    ContactResultVector data;
-    if (cdata.req->type == ContactRequestType::FIRST)
+    if (verbose)
     {
-      data.emplace_back(contact);
-      cdata.done = true;
+      ROS_DEBUG("Collision between '%s' and '%s' is allowed. No contacts are computed.", name1.c_str(), name2.c_str());
     }
-    else
+    return true;
+  }
+
+  if (verbose)
+  {
+    ROS_DEBUG("Actually checking collisions between %s and %s", name1.c_str(), name2.c_str());
+  }
+
+  return false;
+}
+
+/**
+ * @brief Create a tag which marks the collision objects a manager may modify in place
+ *
+ * Tags are taken from a process wide counter and never reused, so objects tagged by a destroyed manager are not
+ * owned by a manager allocated later at the same address.
+ *
+ * @return The new tag, it is never zero which marks objects without owner
+ */
+TESSERACT_COLLISION_SHARED_STATE inline std::uint64_t createOwnerTag()
+{
+  static std::atomic<std::uint64_t> next_tag(1);
+  return next_tag++;
+}
+
+/**
+ * @brief Create a copy of an octomap with voxels marked occupied or free
+ *
+ * The voxels are set to the clamping thresholds of the octomap. Voxels outside of the octomap are ignored.
+ *
+ * @param octree The octomap, it is not modified
+ * @param occupied_voxels The centers of the voxels to mark occupied
+ * @param free_voxels The centers of the voxels to mark free
+ * @return The updated copy
+ */
+inline std::shared_ptr<const octomap::OcTree> createUpdatedOcTree(const octomap::OcTree& octree,
+                                                                 const VectorVector3d& occupied_voxels,
+                                                                 const VectorVector3d& free_voxels)
+{
+  std::shared_ptr<octomap::OcTree> copy(new octomap::OcTree(octree));
+  for (const auto& voxel : occupied_voxels)
+    copy->setNodeValue(voxel[0], voxel[1], voxel[2], copy->getClampingThresMaxLog());
+
+  for (const auto& voxel : free_voxels)
+    copy->setNodeValue(voxel[0], voxel[1], voxel[2], copy->getClampingThresMinLog());
+
+  return copy;
+}
+
+/**
+ * @brief Collects the statistics of a contact test for the lifetime of the object
+ *
+ * The contact query data is pointed to the statistics so the callbacks can update them.
+ * Nothing is collected if the statistics are nullptr.
+ */
+class ContactTestStatisticsCollector
+{
+public:
+  ContactTestStatisticsCollector(ContactDistanceData& cdata, ContactTestStatistics* stats)
+    : cdata_(cdata), narrowphase_time_(0)
+  {
+    cdata_.stats = stats;
+    if (stats != nullptr)
     {
-      data.reserve(100);  // TODO: Need better way to initialize this
-      data.emplace_back(contact);
+      ++stats->num_contact_tests;
+      narrowphase_time_ = stats->narrowphase_time;
+      start_ = std::chrono::steady_clock::now();
     }
+  }
+
+  ~ContactTestStatisticsCollector()
+  {
+    ContactTestStatistics* stats = cdata_.stats;
+    if (stats == nullptr)
+      return;
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    stats->total_time += elapsed;
+    stats->broadphase_time += elapsed - (stats->narrowphase_time - narrowphase_time_);
+    stats->num_results += cdata_.num_contacts;
+  }
+
+private:
+  ContactDistanceData& cdata_;
+  double narrowphase_time_;
+  std::chrono::steady_clock::time_point start_;
+};
 
-    return &(cdata.res->insert(std::make_pair(key, data)).first->second.back());
+/**
+ * @brief Counts a narrowphase invocation and its time for the lifetime of the object
+ *
+ * Nothing is collected if the statistics are nullptr.
+ */
+class NarrowphaseStatisticsCollector
+{
+public:
+  NarrowphaseStatisticsCollector(ContactTestStatistics* stats, int shape_type1, int shape_type2) : stats_(stats)
+  {
+    if (stats_ != nullptr)
+    {
+      ++stats_->num_narrowphase;
+      ++stats_->narrowphase_shape_types[std::make_pair(std::min(shape_type1, shape_type2),
+                                                       std::max(shape_type1, shape_type2))];
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~NarrowphaseStatisticsCollector()
+  {
+    if (stats_ != nullptr)
+      stats_->narrowphase_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  }
+
+private:
+  ContactTestStatistics* stats_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Count a contact which was stored and check if the search is finished
+ *
+ * The search is finished after the first contact for FIRST requests and once
+ * max_total_contacts are stored for LIMITED requests.
+ *
+ * @param cdata The contact query data
+ */
+inline void countStoredContact(ContactDistanceData& cdata)
+{
+  ++cdata.num_contacts;
+  if (cdata.req->type == ContactRequestType::FIRST)
+    cdata.done = true;
+  else if (cdata.req->type == ContactRequestType::LIMITED && cdata.req->max_total_contacts > 0 &&
+           cdata.num_contacts >= cdata.req->max_total_contacts)
+    cdata.done = true;
+}
+
+/**
+ * @brief Check if a pair of objects already has the maximum number of contacts of a LIMITED request
+ *
+ * This is used to skip the narrowphase of saturated pairs.
+ *
+ * @param cdata The contact query data
+ * @param name1 The name of the first object
+ * @param name2 The name of the second object
+ * @param id1 The link id of the first object
+ * @param id2 The link id of the second object
+ * @return True if no more contacts will be stored for the pair, otherwise false
+ */
+inline bool isPairContactLimitReached(const ContactDistanceData& cdata,
+                                      const std::string& name1,
+                                      const std::string& name2,
+                                      int id1,
+                                      int id2)
+{
+  if (cdata.req->type != ContactRequestType::LIMITED)
+    return false;
+
+  if (cdata.buffer_res != nullptr)
+    return cdata.buffer_res->getPairContactCount(id1, id2) >= cdata.req->max_contacts_per_pair;
+
+  if (cdata.id_res != nullptr)
+  {
+    auto it = cdata.id_res->find(getObjectPairKey(id1, id2));
+    return (it != cdata.id_res->end() && it->second.size() >= cdata.req->max_contacts_per_pair);
+  }
+
+  if (cdata.res != nullptr)
+  {
+    auto it = cdata.res->find(getObjectPairKey(name1, name2));
+    return (it != cdata.res->end() && it->second.size() >= cdata.req->max_contacts_per_pair);
+  }
+
+  return false;
+}
+
+/**
+ * @brief Check if a CLOSEST request already stores a contact of a pair which is at least as close as a new one
+ *
+ * This is used to skip computing the data of contacts which would not replace the stored contact.
+ *
+ * @param cdata The contact query data
+ * @param name1 The name of the first object
+ * @param name2 The name of the second object
+ * @param id1 The link id of the first object
+ * @param id2 The link id of the second object
+ * @param distance The distance of the new contact
+ * @return True if the new contact will not be stored, otherwise false
+ */
+inline bool isCloserContactStored(const ContactDistanceData& cdata,
+                                  const std::string& name1,
+                                  const std::string& name2,
+                                  int id1,
+                                  int id2,
+                                  double distance)
+{
+  if (cdata.req->type != ContactRequestType::CLOSEST)
+    return false;
+
+  if (cdata.buffer_res != nullptr)
+  {
+    const ContactRecord* record = cdata.buffer_res->find(id1, id2);
+    return (record != nullptr && !(distance < record->distance));
+  }
+
+  if (cdata.id_res != nullptr)
+  {
+    auto it = cdata.id_res->find(getObjectPairKey(id1, id2));
+    return (it != cdata.id_res->end() && !(distance < it->second[0].distance));
+  }
+
+  if (cdata.res != nullptr)
+  {
+    auto it = cdata.res->find(getObjectPairKey(name1, name2));
+    return (it != cdata.res->end() && !(distance < it->second[0].distance));
+  }
+
+  return false;
+}
+
+template <typename MapType>
+inline ContactResult* processResult(ContactDistanceData& cdata,
+                                    MapType& res,
+                                    ContactResult& contact,
+                                    const typename MapType::key_type& key,
+                                    bool found)
+{
+  if (!found)
+  {
+    ContactResultVector& data = res[key];
+    data.emplace_back(contact);
+    countStoredContact(cdata);
+
+    return &(data.back());
   }
   else
   {
     assert(cdata.req->type != ContactRequestType::FIRST);
-    ContactResultVector& dr = cdata.res->at(key);
+    ContactResultVector& dr = res.at(key);
     if (cdata.req->type == ContactRequestType::ALL)
     {
       dr.emplace_back(contact);
+      countStoredContact(cdata);
       return &(dr.back());
     }
+    else if (cdata.req->type == ContactRequestType::LIMITED)
+    {
+      if (dr.size() < cdata.req->max_contacts_per_pair)
+      {
+        dr.emplace_back(contact);
+        countStoredContact(cdata);
+        return &(dr.back());
+      }
+    }
     else if (cdata.req->type == ContactRequestType::CLOSEST)
     {
       if (contact.distance < dr[0].distance)
@@ -119,17 +403,424 @@ inline ContactResult* processResult(ContactDistanceData& cdata,
         return &(dr[0]);
       }
     }
-    //    else if (cdata.req->type == DistanceRequestType::LIMITED)
-    //    {
-    //      assert(dr.size() < cdata.req->max_contacts_per_body);
-    //      dr.emplace_back(contact);
-    //      return &(dr.back());
-    //    }
   }
 
   return nullptr;
 }
 
+inline ContactResult* processResult(ContactDistanceData& cdata,
+                                    ContactResult& contact,
+                                    const std::pair<std::string, std::string>& key,
+                                    bool found)
+{
+  return processResult(cdata, *cdata.res, contact, key, found);
+}
+
+/**
+ * @brief Store a contact in the results container provided by the caller
+ *
+ * The results are stored in a contact result buffer or keyed by link ids if the
+ * caller requested it, otherwise they are keyed by link names. The contact must
+ * have its link ids (and link names for name keyed results) populated.
+ *
+ * @param cdata The contact query data
+ * @param contact The contact to store
+ * @return True if the contact was stored, otherwise false
+ */
+inline bool processResult(ContactDistanceData& cdata, ContactResult& contact)
+{
+  if (!cdata.storesResults())
+  {
+    cdata.done = true;
+    return true;
+  }
+
+  // A narrowphase may report more contacts of a pair after the search is finished
+  if (cdata.done)
+    return false;
+
+  if (cdata.buffer_res != nullptr)
+  {
+    std::size_t size = cdata.buffer_res->size();
+    if (!cdata.buffer_res->add(contact, *cdata.req))
+      return false;
+
+    if (cdata.buffer_res->size() > size)
+      countStoredContact(cdata);
+
+    return true;
+  }
+
+  if (cdata.id_res != nullptr)
+  {
+    ObjectPairIdKey key = getObjectPairKey(contact.link_ids[0], contact.link_ids[1]);
+    bool found = (cdata.id_res->find(key) != cdata.id_res->end());
+    return processResult(cdata, *cdata.id_res, contact, key, found) != nullptr;
+  }
+
+  ObjectPairKey key = getObjectPairKey(contact.link_names[0], contact.link_names[1]);
+  bool found = (cdata.res->find(key) != cdata.res->end());
+  return processResult(cdata, *cdata.res, contact, key, found) != nullptr;
+}
+
+/**
+ * @brief Store the contacts found by a thread of a parallel contact test in the results of the query
+ *
+ * The contacts are stored through processResult(), so the request type and the contact limits are applied to the
+ * combined results. Merging the threads in a fixed order gives the same results for the same query.
+ *
+ * @param cdata The contact query data
+ * @param thread_res The contacts found by the thread, keyed by link names if cdata.res is set otherwise by link ids
+ */
+template <typename MapType>
+inline void mergeContactResults(ContactDistanceData& cdata, MapType& thread_res)
+{
+  for (auto& pair : thread_res)
+  {
+    for (auto& contact : pair.second)
+    {
+      if (cdata.done)
+        return;
+
+      processResult(cdata, contact);
+    }
+  }
+}
+
+/**
+ * @brief Add the counters collected by a thread of a parallel contact test to the statistics of the query
+ *
+ * The narrowphase time is not added since the threads run concurrently, the caller accounts for the wall time.
+ *
+ * @param stats The statistics of the query
+ * @param thread_stats The statistics collected by the thread
+ */
+inline void mergeNarrowphaseStatistics(ContactTestStatistics& stats, const ContactTestStatistics& thread_stats)
+{
+  stats.num_broadphase_pairs += thread_stats.num_broadphase_pairs;
+  stats.num_filter_rejected += thread_stats.num_filter_rejected;
+  stats.num_acm_rejected += thread_stats.num_acm_rejected;
+  stats.num_narrowphase += thread_stats.num_narrowphase;
+  for (const auto& shape_types : thread_stats.narrowphase_shape_types)
+    stats.narrowphase_shape_types[shape_types.first] += shape_types.second;
+}
+
+/**
+ * @brief Check if the collision geometry of a shape can be shared through a CollisionShapeCache
+ *
+ * Octrees are not cached since they can be modified after the collision geometry is created.
+ *
+ * @param shape The shape
+ * @return True if the shape can be cached
+ */
+inline bool isShapeCacheable(const shapes::Shape& shape)
+{
+  switch (shape.type)
+  {
+    case shapes::BOX:
+    case shapes::SPHERE:
+    case shapes::CYLINDER:
+    case shapes::CONE:
+    case shapes::PLANE:
+    case shapes::MESH:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Hash a block of memory (FNV-1a)
+ * @param seed The hash of the previous data
+ * @param data The data
+ * @param size The size of the data in bytes
+ */
+inline std::size_t hashShapeBytes(std::size_t seed, const void* data, std::size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  std::uint64_t hash = static_cast<std::uint64_t>(seed) ^ 14695981039346656037ULL;
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return static_cast<std::size_t>(hash);
+}
+
+/**
+ * @brief Hash the data of a cacheable shape (see isShapeCacheable())
+ * @param shape The shape
+ * @param collision_object_type The collision object type used for the shape
+ * @return The hash of the shape data
+ */
+inline std::size_t hashShapeData(const shapes::Shape& shape, CollisionObjectType collision_object_type)
+{
+  int header[2] = { static_cast<int>(shape.type), static_cast<int>(collision_object_type) };
+  std::size_t hash = hashShapeBytes(0, header, sizeof(header));
+
+  switch (shape.type)
+  {
+    case shapes::BOX:
+      return hashShapeBytes(hash, static_cast<const shapes::Box&>(shape).size, 3 * sizeof(double));
+    case shapes::SPHERE:
+      return hashShapeBytes(hash, &static_cast<const shapes::Sphere&>(shape).radius, sizeof(double));
+    case shapes::CYLINDER:
+    {
+      const shapes::Cylinder& cylinder = static_cast<const shapes::Cylinder&>(shape);
+      double data[2] = { cylinder.radius, cylinder.length };
+      return hashShapeBytes(hash, data, sizeof(data));
+    }
+    case shapes::CONE:
+    {
+      const shapes::Cone& cone = static_cast<const shapes::Cone&>(shape);
+      double data[2] = { cone.radius, cone.length };
+      return hashShapeBytes(hash, data, sizeof(data));
+    }
+    case shapes::PLANE:
+    {
+      const shapes::Plane& plane = static_cast<const shapes::Plane&>(shape);
+      double data[4] = { plane.a, plane.b, plane.c, plane.d };
+      return hashShapeBytes(hash, data, sizeof(data));
+    }
+    case shapes::MESH:
+    {
+      const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(shape);
+      unsigned int counts[2] = { mesh.vertex_count, mesh.triangle_count };
+      hash = hashShapeBytes(hash, counts, sizeof(counts));
+      hash = hashShapeBytes(hash, mesh.vertices, 3 * mesh.vertex_count * sizeof(double));
+      return hashShapeBytes(hash, mesh.triangles, 3 * mesh.triangle_count * sizeof(unsigned int));
+    }
+    default:
+      return hash;
+  }
+}
+
+/**
+ * @brief Check if two cacheable shapes (see isShapeCacheable()) have the same data
+ * @param shape1 The first shape
+ * @param shape2 The second shape
+ * @return True if the collision geometry created for the shapes would be the same
+ */
+inline bool isShapeDataEqual(const shapes::Shape& shape1, const shapes::Shape& shape2)
+{
+  if (&shape1 == &shape2)
+    return true;
+
+  if (shape1.type != shape2.type)
+    return false;
+
+  switch (shape1.type)
+  {
+    case shapes::BOX:
+    {
+      const double* size1 = static_cast<const shapes::Box&>(shape1).size;
+      const double* size2 = static_cast<const shapes::Box&>(shape2).size;
+      return size1[0] == size2[0] && size1[1] == size2[1] && size1[2] == size2[2];
+    }
+    case shapes::SPHERE:
+      return static_cast<const shapes::Sphere&>(shape1).radius == static_cast<const shapes::Sphere&>(shape2).radius;
+    case shapes::CYLINDER:
+    {
+      const shapes::Cylinder& cylinder1 = static_cast<const shapes::Cylinder&>(shape1);
+      const shapes::Cylinder& cylinder2 = static_cast<const shapes::Cylinder&>(shape2);
+      return cylinder1.radius == cylinder2.radius && cylinder1.length == cylinder2.length;
+    }
+    case shapes::CONE:
+    {
+      const shapes::Cone& cone1 = static_cast<const shapes::Cone&>(shape1);
+      const shapes::Cone& cone2 = static_cast<const shapes::Cone&>(shape2);
+      return cone1.radius == cone2.radius && cone1.length == cone2.length;
+    }
+    case shapes::PLANE:
+    {
+      const shapes::Plane& plane1 = static_cast<const shapes::Plane&>(shape1);
+      const shapes::Plane& plane2 = static_cast<const shapes::Plane&>(shape2);
+      return plane1.a == plane2.a && plane1.b == plane2.b && plane1.c == plane2.c && plane1.d == plane2.d;
+    }
+    case shapes::MESH:
+    {
+      const shapes::Mesh& mesh1 = static_cast<const shapes::Mesh&>(shape1);
+      const shapes::Mesh& mesh2 = static_cast<const shapes::Mesh&>(shape2);
+      return mesh1.vertex_count == mesh2.vertex_count && mesh1.triangle_count == mesh2.triangle_count &&
+             std::equal(mesh1.vertices, mesh1.vertices + 3 * mesh1.vertex_count, mesh2.vertices) &&
+             std::equal(mesh1.triangles, mesh1.triangles + 3 * mesh1.triangle_count, mesh2.triangles);
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief A process wide cache of collision geometry keyed on the shape data and collision object type
+ *
+ * Geometry which also depends on process wide settings, like the sphere decomposition of MultiSphere meshes, is
+ * additionally keyed on the values of those settings, so changing them does not return geometry created before.
+ *
+ * The cache only holds weak references, the geometry is destroyed when the last collision object using it is
+ * destroyed. The geometry returned is shared and must not be modified. This class is thread safe, the geometry is
+ * created without holding the lock so different shapes are created in parallel, while threads asking for a shape
+ * which is being created wait for it.
+ */
+template <typename GeometryType>
+class CollisionShapeCache
+{
+public:
+  typedef std::shared_ptr<GeometryType> GeometryPtr;
+
+  CollisionShapeCache() : purge_size_(64) {}
+
+  /**
+   * @brief Get the geometry for a shape, it is created if an identical shape is not cached
+   * @param shape The shape
+   * @param collision_object_type The collision object type used for the shape
+   * @param create A function returning a new GeometryPtr for the shape (it may return nullptr)
+   * @return The geometry
+   */
+  template <typename CreateFn>
+  GeometryPtr get(const shapes::ShapeConstPtr& shape, CollisionObjectType collision_object_type, CreateFn create)
+  {
+    return get(shape, collision_object_type, std::vector<double>(), create);
+  }
+
+  /**
+   * @brief Get the geometry for a shape created with a set of settings
+   * @param shape The shape
+   * @param collision_object_type The collision object type used for the shape
+   * @param settings The values of the settings the geometry is created with, part of the key
+   * @param create A function returning a new GeometryPtr for the shape (it may return nullptr)
+   * @return The geometry
+   */
+  template <typename CreateFn>
+  GeometryPtr get(const shapes::ShapeConstPtr& shape,
+                  CollisionObjectType collision_object_type,
+                  const std::vector<double>& settings,
+                  CreateFn create)
+  {
+    if (!isShapeCacheable(*shape))
+      return create();
+
+    std::size_t hash = hashShapeData(*shape, collision_object_type);
+    hash = hashShapeBytes(hash, settings.data(), settings.size() * sizeof(double));
+
+    std::promise<GeometryPtr> promise;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto range = entries_.equal_range(hash);
+      for (auto it = range.first; it != range.second; ++it)
+      {
+        if (it->second.type != collision_object_type || it->second.settings != settings ||
+            !isShapeDataEqual(*it->second.shape, *shape))
+          continue;
+
+        if (it->second.creator != nullptr)
+        {
+          std::shared_future<GeometryPtr> pending = it->second.pending;
+          lock.unlock();
+          return pending.get();
+        }
+
+        GeometryPtr geometry = it->second.geometry.lock();
+        if (geometry != nullptr)
+          return geometry;
+
+        entries_.erase(it);
+        break;
+      }
+
+      Entry entry;
+      entry.shape = shape;
+      entry.type = collision_object_type;
+      entry.settings = settings;
+      entry.creator = &promise;
+      entry.pending = promise.get_future().share();
+      entries_.insert(std::make_pair(hash, entry));
+    }
+
+    GeometryPtr geometry;
+    try
+    {
+      geometry = create();
+    }
+    catch (...)
+    {
+      finish(hash, &promise, nullptr);
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+
+    finish(hash, &promise, geometry);
+    promise.set_value(geometry);
+    return geometry;
+  }
+
+  /** @brief Get the number of cached shapes, this may include shapes which are no longer used */
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+  }
+
+private:
+  struct Entry
+  {
+    shapes::ShapeConstPtr shape;             /**< @brief The source shape, kept to compare the data on collisions */
+    CollisionObjectType type;                /**< @brief The collision object type the geometry was created for */
+    std::vector<double> settings;            /**< @brief The settings the geometry was created with */
+    std::weak_ptr<GeometryType> geometry;    /**< @brief The collision geometry */
+    const void* creator = nullptr;           /**< @brief Identifies the call creating the geometry, nullptr once done */
+    std::shared_future<GeometryPtr> pending; /**< @brief Provides the geometry to the callers waiting for it */
+  };
+
+  /**
+   * @brief Store the geometry created for an entry, the entry is removed if the creation failed
+   * @param hash The hash of the entry
+   * @param creator The creator of the entry
+   * @param geometry The geometry created, nullptr if the creation failed
+   */
+  void finish(std::size_t hash, const void* creator, const GeometryPtr& geometry)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto range = entries_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second.creator != creator)
+        continue;
+
+      if (geometry == nullptr)
+      {
+        entries_.erase(it);
+      }
+      else
+      {
+        it->second.geometry = geometry;
+        it->second.creator = nullptr;
+        it->second.pending = std::shared_future<GeometryPtr>();
+      }
+      break;
+    }
+
+    if (entries_.size() > purge_size_)
+      purge();
+  }
+
+  /** @brief Remove the entries whose geometry is no longer used */
+  void purge()
+  {
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+      if (it->second.creator == nullptr && it->second.geometry.expired())
+        it = entries_.erase(it);
+      else
+        ++it;
+    }
+    purge_size_ = std::max(static_cast<std::size_t>(64), 2 * entries_.size());
+  }
+
+  mutable std::mutex mutex_;                            /**< @brief Protects the entries */
+  std::unordered_multimap<std::size_t, Entry> entries_; /**< @brief The cached geometry keyed by the shape hash */
+  std::size_t purge_size_;                              /**< @brief The number of entries which triggers a purge */
+};
+
 /**
  * @brief Create a convex hull from vertices using Bullet Convex Hull Computer
  * @param (Output) vertices A vector of vertices
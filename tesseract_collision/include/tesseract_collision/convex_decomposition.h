@@ -0,0 +1,560 @@
+/**
+ * @file convex_decomposition.h
+ * @brief Approximate concave meshes by a set of convex hulls for the ConvexDecomposition collision object type
+ *
+ * @date Oct 16, 2018
+ * @version TODO
+ * @bug No known bugs
+ *
+ * @copyright Copyright (c) 2017, Southwest Research Institute
+ *
+ * @par License
+ * Software License Agreement (Apache License)
+ * @par
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * @par
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TESSERACT_COLLISION_CONVEX_DECOMPOSITION_H
+#define TESSERACT_COLLISION_CONVEX_DECOMPOSITION_H
+
+#include <tesseract_collision/signed_distance_field.h>
+#include <limits>
+
+namespace tesseract
+{
+/** @brief The default maximum distance a hull of a convex decomposition extends beyond the mesh */
+const double CONVEX_DECOMPOSITION_DEFAULT_MAX_ERROR = 0.005;
+
+/** @brief The default maximum number of hulls of a convex decomposition */
+const int CONVEX_DECOMPOSITION_DEFAULT_MAX_HULLS = 16;
+
+/** @brief The default number of samples along the longest axis of the mesh used to measure the error */
+const int CONVEX_DECOMPOSITION_DEFAULT_RESOLUTION = 40;
+
+/** @brief The number of cut positions tried along each axis when a part is split */
+const int CONVEX_DECOMPOSITION_CUTS_PER_AXIS = 8;
+
+/** @brief The parameters of the convex decomposition of ConvexDecomposition meshes */
+struct ConvexDecompositionSettings
+{
+  double max_error; /**< @brief The maximum distance the hulls may extend beyond the mesh */
+  int max_hulls;    /**< @brief The maximum number of hulls, the error may be exceeded to stay within it */
+  int resolution;   /**< @brief The number of samples along the longest axis of the mesh used to measure the error */
+
+  ConvexDecompositionSettings()
+    : max_error(CONVEX_DECOMPOSITION_DEFAULT_MAX_ERROR)
+    , max_hulls(CONVEX_DECOMPOSITION_DEFAULT_MAX_HULLS)
+    , resolution(CONVEX_DECOMPOSITION_DEFAULT_RESOLUTION)
+  {
+  }
+};
+
+/** @brief The process wide convex decomposition settings */
+struct ConvexDecompositionState
+{
+  std::mutex mutex;                     /**< @brief Protects the settings */
+  ConvexDecompositionSettings settings; /**< @brief The settings used for ConvexDecomposition meshes */
+};
+
+TESSERACT_COLLISION_SHARED_STATE inline ConvexDecompositionState& getConvexDecompositionState()
+{
+  static ConvexDecompositionState state;
+  return state;
+}
+
+/** @brief Get the settings used for the convex decomposition of ConvexDecomposition meshes */
+inline ConvexDecompositionSettings getConvexDecompositionSettings()
+{
+  ConvexDecompositionState& state = getConvexDecompositionState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.settings;
+}
+
+/**
+ * @brief Set the settings used for the convex decomposition of ConvexDecomposition meshes
+ *
+ * They only apply to collision objects created afterwards. Geometry in the shape cache is only shared with objects
+ * created with the same settings. Changing them while collision objects are created from another thread is not
+ * supported.
+ *
+ * @param settings The settings
+ */
+inline void setConvexDecompositionSettings(const ConvexDecompositionSettings& settings)
+{
+  ConvexDecompositionState& state = getConvexDecompositionState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.settings = settings;
+}
+
+/** @brief A part of a convex decomposition, the mesh inside of an axis aligned box of samples */
+struct ConvexDecompositionPart
+{
+  Eigen::Vector3i lower; /**< @brief The index of the first sample of the box */
+  Eigen::Vector3i upper; /**< @brief The index of the last sample of the box */
+  double error;          /**< @brief The largest distance of a sample outside of the mesh covered by the hull */
+  double cost;           /**< @brief The sum of the distances of the samples outside of the mesh covered by the hull */
+};
+
+/**
+ * @brief Measure how far the convex hull of a part extends beyond the mesh
+ *
+ * The hull of the samples inside of the mesh is computed and the samples outside of the mesh which it covers are
+ * found by intersecting each row of samples with the faces of the hull, so the error is only measured at the samples.
+ *
+ * @param part (Input/Output) The part, its error and cost are updated
+ * @param sdf The signed distance field of the mesh
+ */
+inline void evaluateConvexDecompositionPart(ConvexDecompositionPart& part, const SignedDistanceField& sdf)
+{
+  part.error = 0;
+  part.cost = 0;
+
+  const Eigen::Vector3i& lower = part.lower;
+  const Eigen::Vector3i& upper = part.upper;
+
+  // Only the samples on the boundary of the inside region can be vertices of the hull
+  VectorVector3d points;
+  for (int z = lower[2]; z <= upper[2]; ++z)
+    for (int y = lower[1]; y <= upper[1]; ++y)
+      for (int x = lower[0]; x <= upper[0]; ++x)
+      {
+        if (sdf.getSample(x, y, z) > 0)
+          continue;
+
+        bool boundary = (x == lower[0] || x == upper[0] || y == lower[1] || y == upper[1] || z == lower[2] ||
+                         z == upper[2] || sdf.getSample(x - 1, y, z) > 0 || sdf.getSample(x + 1, y, z) > 0 ||
+                         sdf.getSample(x, y - 1, z) > 0 || sdf.getSample(x, y + 1, z) > 0 ||
+                         sdf.getSample(x, y, z - 1) > 0 || sdf.getSample(x, y, z + 1) > 0);
+        if (boundary)
+          points.push_back(Eigen::Vector3d(x, y, z));
+      }
+
+  // The hull of less than four samples covers no other sample
+  if (points.size() < 4)
+    return;
+
+  // Samples in a single plane have no hull, this is checked here to avoid errors from the hull computation
+  Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+  for (std::size_t i = 1; i < points.size() && normal.isZero(); ++i)
+    for (std::size_t j = i + 1; j < points.size() && normal.isZero(); ++j)
+      normal = (points[i] - points[0]).cross(points[j] - points[0]);
+
+  if (normal.isZero() || std::all_of(points.begin(), points.end(), [&](const Eigen::Vector3d& p) {
+        return std::abs(normal.dot(p - points[0])) < 1e-9;
+      }))
+    return;
+
+  VectorVector3d vertices;
+  std::vector<int> faces;
+  int num_faces = createConvexHull(vertices, faces, points);
+  if (num_faces <= 0)
+    return;
+
+  Eigen::Vector3d centroid = Eigen::Vector3d::Zero();
+  for (const auto& v : vertices)
+    centroid += v;
+  centroid /= static_cast<double>(vertices.size());
+
+  // The planes of the faces in sample coordinates with their normals pointing out of the hull
+  VectorVector3d normals;
+  std::vector<double> offsets;
+  for (std::size_t i = 0; i < faces.size(); i += static_cast<std::size_t>(faces[i]) + 1)
+  {
+    const Eigen::Vector3d& v0 = vertices[static_cast<std::size_t>(faces[i + 1])];
+    Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+    for (int j = 2; j < faces[i] && normal.squaredNorm() < 1e-12; ++j)
+      normal = (vertices[static_cast<std::size_t>(faces[i + j])] - v0)
+                   .cross(vertices[static_cast<std::size_t>(faces[i + j + 1])] - v0);
+
+    if (normal.squaredNorm() < 1e-12)
+      continue;
+
+    normal.normalize();
+    if (normal.dot(centroid - v0) > 0)
+      normal = -normal;
+
+    normals.push_back(normal);
+    offsets.push_back(normal.dot(v0) + 1e-6);
+  }
+
+  for (int y = lower[1]; y <= upper[1]; ++y)
+    for (int x = lower[0]; x <= upper[0]; ++x)
+    {
+      // The range of the row inside of all of the planes
+      double z_min = lower[2];
+      double z_max = upper[2];
+      for (std::size_t i = 0; i < normals.size() && z_min <= z_max; ++i)
+      {
+        double rhs = offsets[i] - normals[i][0] * x - normals[i][1] * y;
+        if (normals[i][2] > 1e-12)
+          z_max = std::min(z_max, rhs / normals[i][2]);
+        else if (normals[i][2] < -1e-12)
+          z_min = std::max(z_min, rhs / normals[i][2]);
+        else if (rhs < 0)
+          z_max = z_min - 1;
+      }
+
+      for (int z = static_cast<int>(std::ceil(z_min)); z <= static_cast<int>(std::floor(z_max)); ++z)
+      {
+        double distance = sdf.getSample(x, y, z);
+        if (distance > 0)
+        {
+          part.error = std::max(part.error, distance);
+          part.cost += distance;
+        }
+      }
+    }
+}
+
+/**
+ * @brief Check if a point is inside of a closed mesh by counting the triangles crossed by a ray
+ *
+ * The ray direction is skewed so it does not pass through the edges of axis aligned meshes.
+ *
+ * @param point The point
+ * @param vertices The vertices of the mesh
+ * @param triangles The vertex indices of the triangles, three per triangle
+ * @return True if the point is inside of the mesh
+ */
+inline bool isPointInsideMesh(const Eigen::Vector3d& point,
+                              const VectorVector3d& vertices,
+                              const std::vector<int>& triangles)
+{
+  const Eigen::Vector3d direction = Eigen::Vector3d(1, 0.0137, 0.0071).normalized();
+  bool inside = false;
+  for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+  {
+    // Moller-Trumbore ray triangle intersection
+    const Eigen::Vector3d& v0 = vertices[static_cast<std::size_t>(triangles[i])];
+    Eigen::Vector3d e1 = vertices[static_cast<std::size_t>(triangles[i + 1])] - v0;
+    Eigen::Vector3d e2 = vertices[static_cast<std::size_t>(triangles[i + 2])] - v0;
+    Eigen::Vector3d p = direction.cross(e2);
+    double det = e1.dot(p);
+    if (std::abs(det) < 1e-15)
+      continue;
+
+    Eigen::Vector3d s = (point - v0) / det;
+    double u = s.dot(p);
+    if (u < 0 || u > 1)
+      continue;
+
+    Eigen::Vector3d q = s.cross(e1);
+    double v = direction.dot(q);
+    if (v < 0 || u + v > 1)
+      continue;
+
+    if (e2.dot(q) > 0)
+      inside = !inside;
+  }
+  return inside;
+}
+
+/**
+ * @brief Clip a polygon to one side of an axis aligned plane (Sutherland-Hodgman)
+ * @param polygon (Input/Output) The vertices of the polygon
+ * @param axis The axis of the plane normal
+ * @param value The position of the plane along the axis
+ * @param keep_below Keep the side below the plane if true, otherwise the side above it
+ */
+inline void clipConvexDecompositionPolygon(VectorVector3d& polygon, int axis, double value, bool keep_below)
+{
+  VectorVector3d clipped;
+  for (std::size_t i = 0; i < polygon.size(); ++i)
+  {
+    const Eigen::Vector3d& a = polygon[i];
+    const Eigen::Vector3d& b = polygon[(i + 1) % polygon.size()];
+    double da = keep_below ? value - a[axis] : a[axis] - value;
+    double db = keep_below ? value - b[axis] : b[axis] - value;
+
+    if (da >= 0)
+      clipped.push_back(a);
+
+    if ((da >= 0) != (db >= 0))
+    {
+      Eigen::Vector3d p = a + (b - a) * (da / (da - db));
+      p[axis] = value;
+      clipped.push_back(p);
+    }
+  }
+  polygon.swap(clipped);
+}
+
+/**
+ * @brief Approximate a closed mesh by a set of convex hulls which contains it
+ *
+ * The mesh is sampled by a signed distance field. Starting from the hull of the whole mesh, the part whose hull
+ * extends the furthest beyond the mesh is split by the axis aligned plane which minimizes the distance of the empty
+ * samples covered by the hulls of both halves, until every hull is within the maximum error or max_hulls is
+ * reached. Each hull is computed from the triangles of the mesh clipped to the box of its part, so the hulls
+ * together contain the mesh. Features thinner than the sample spacing do not contribute to the error.
+ *
+ * @param hulls (Output) The vertices of the convex hulls
+ * @param vertices The vertices of the mesh
+ * @param triangles The vertex indices of the triangles, three per triangle
+ * @param max_error The maximum distance the hulls may extend beyond the mesh
+ * @param max_hulls The maximum number of hulls
+ * @param resolution The number of samples along the longest axis of the mesh used to measure the error
+ * @return The number of hulls, -1 if the mesh is empty
+ */
+inline int createConvexDecomposition(std::vector<VectorVector3d>& hulls,
+                                     const VectorVector3d& vertices,
+                                     const std::vector<int>& triangles,
+                                     double max_error = CONVEX_DECOMPOSITION_DEFAULT_MAX_ERROR,
+                                     int max_hulls = CONVEX_DECOMPOSITION_DEFAULT_MAX_HULLS,
+                                     int resolution = CONVEX_DECOMPOSITION_DEFAULT_RESOLUTION)
+{
+  hulls.clear();
+  if (vertices.empty() || triangles.size() < 3)
+  {
+    ROS_ERROR("Unable to create a convex decomposition from an empty mesh");
+    return -1;
+  }
+
+  Eigen::Vector3d aabb_min = vertices[0], aabb_max = vertices[0];
+  for (const auto& v : vertices)
+  {
+    aabb_min = aabb_min.cwiseMin(v);
+    aabb_max = aabb_max.cwiseMax(v);
+  }
+
+  // The field is padded by a sample so the samples on the boundary of the grid are outside of the mesh
+  double spacing = std::max((aabb_max - aabb_min).maxCoeff() / std::max(1, resolution), 1e-6);
+  SignedDistanceFieldConstPtr sdf = createCachedSignedDistanceField(vertices, triangles, spacing, spacing);
+  if (sdf == nullptr)
+    return -1;
+
+  spacing = sdf->getResolution();
+  const Eigen::Vector3i& size = sdf->getSize();
+
+  std::vector<ConvexDecompositionPart> parts(1);
+  parts[0].lower = Eigen::Vector3i(1, 1, 1);
+  parts[0].upper = size - Eigen::Vector3i(2, 2, 2);
+  evaluateConvexDecompositionPart(parts[0], *sdf);
+
+  while (static_cast<int>(parts.size()) < max_hulls)
+  {
+    // Split the part whose hull extends the furthest beyond the mesh
+    std::size_t worst = 0;
+    for (std::size_t i = 1; i < parts.size(); ++i)
+      if (parts[i].error > parts[worst].error)
+        worst = i;
+
+    if (parts[worst].error <= max_error)
+      break;
+
+    const ConvexDecompositionPart part = parts[worst];
+    ConvexDecompositionPart best[2];
+    int best_axis = -1, best_cut = 0, best_step = 1;
+    double best_cost = std::numeric_limits<double>::max();
+    double best_balance = 1;
+    auto tryCut = [&](int axis, int cut, int step) {
+      ConvexDecompositionPart halves[2] = { part, part };
+      halves[0].upper[axis] = cut - 1;
+      halves[1].lower[axis] = cut;
+      evaluateConvexDecompositionPart(halves[0], *sdf);
+      evaluateConvexDecompositionPart(halves[1], *sdf);
+
+      // Cuts closer to the middle of the part are preferred if the cost is the same
+      int extent = part.upper[axis] - part.lower[axis] + 1;
+      double cost = halves[0].cost + halves[1].cost;
+      double balance = std::abs(2.0 * (cut - part.lower[axis]) / extent - 1.0);
+      if (cost < best_cost || (cost == best_cost && balance < best_balance))
+      {
+        best_axis = axis;
+        best_cut = cut;
+        best_step = step;
+        best_cost = cost;
+        best_balance = balance;
+        best[0] = halves[0];
+        best[1] = halves[1];
+      }
+    };
+
+    // Try evenly spaced cuts along each axis, then every cut between the neighbors of the best one
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      int extent = part.upper[axis] - part.lower[axis] + 1;
+      int num_cuts = std::min(extent - 1, CONVEX_DECOMPOSITION_CUTS_PER_AXIS);
+      for (int i = 1; i <= num_cuts; ++i)
+        tryCut(axis, part.lower[axis] + (i * extent) / (num_cuts + 1), (extent + num_cuts) / (num_cuts + 1));
+    }
+
+    if (best_axis >= 0 && best_step > 1)
+    {
+      const int axis = best_axis, center = best_cut, step = best_step;
+      for (int cut = std::max(part.lower[axis] + 1, center - step + 1);
+           cut <= std::min(part.upper[axis], center + step - 1);
+           ++cut)
+      {
+        if (cut != center)
+          tryCut(axis, cut, 1);
+      }
+    }
+
+    // A single sample can not be split
+    if (best_cost == std::numeric_limits<double>::max())
+    {
+      parts[worst].error = 0;
+      continue;
+    }
+
+    parts[worst] = best[0];
+    parts.push_back(best[1]);
+  }
+
+  // The hull of each part is the hull of the triangles clipped to the box of the part and the corners of the box
+  // inside of the mesh. The boxes of the parts on the boundary of the grid are not clipped there.
+  for (const auto& part : parts)
+  {
+    Eigen::Vector3d box_min = sdf->getOrigin() + spacing * (part.lower.cast<double>() - Eigen::Vector3d::Constant(0.5));
+    Eigen::Vector3d box_max = sdf->getOrigin() + spacing * (part.upper.cast<double>() + Eigen::Vector3d::Constant(0.5));
+
+    VectorVector3d points;
+    for (int i = 0; i < 8; ++i)
+    {
+      Eigen::Vector3d corner((i & 1) ? box_max[0] : box_min[0],
+                             (i & 2) ? box_max[1] : box_min[1],
+                             (i & 4) ? box_max[2] : box_min[2]);
+      if (isPointInsideMesh(corner, vertices, triangles))
+        points.push_back(corner);
+    }
+
+    for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    {
+      VectorVector3d polygon = { vertices[static_cast<std::size_t>(triangles[i])],
+                                 vertices[static_cast<std::size_t>(triangles[i + 1])],
+                                 vertices[static_cast<std::size_t>(triangles[i + 2])] };
+      for (int axis = 0; axis < 3 && !polygon.empty(); ++axis)
+      {
+        if (part.lower[axis] > 1)
+          clipConvexDecompositionPolygon(polygon, axis, box_min[axis], false);
+
+        if (part.upper[axis] < size[axis] - 2 && !polygon.empty())
+          clipConvexDecompositionPolygon(polygon, axis, box_max[axis], true);
+      }
+
+      points.insert(points.end(), polygon.begin(), polygon.end());
+    }
+
+    if (points.size() < 4)
+      continue;
+
+    VectorVector3d hull;
+    std::vector<int> faces;
+    if (createConvexHull(hull, faces, points) > 0)
+      hulls.push_back(hull);
+  }
+
+  double error = 0;
+  for (const auto& part : parts)
+    error = std::max(error, part.error);
+
+  if (error > max_error)
+    ROS_WARN("The convex decomposition error is %f to stay within %d hulls", error, max_hulls);
+
+  return static_cast<int>(hulls.size());
+}
+
+/**
+ * @brief Same as createConvexDecomposition() but the result is stored in the geometry cache and loaded on later calls
+ *
+ * The cache is keyed on the mesh and the parameters.
+ */
+inline int createCachedConvexDecomposition(std::vector<VectorVector3d>& hulls,
+                                           const VectorVector3d& vertices,
+                                           const std::vector<int>& triangles,
+                                           double max_error = CONVEX_DECOMPOSITION_DEFAULT_MAX_ERROR,
+                                           int max_hulls = CONVEX_DECOMPOSITION_DEFAULT_MAX_HULLS,
+                                           int resolution = CONVEX_DECOMPOSITION_DEFAULT_RESOLUTION)
+{
+  const std::uint32_t format = 1;
+  double params[4] = { max_error, static_cast<double>(max_hulls), static_cast<double>(resolution),
+                       static_cast<double>(SDF_MAX_SAMPLES) };
+  GeometryCacheKey key;
+  key.add(params, sizeof(params));
+  key.add(vertices);
+  key.add(triangles.data(), triangles.size() * sizeof(int));
+  std::string path = getGeometryCacheFilePath("convex_decomposition", key);
+
+  // The payload is the number of hulls and the number of vertices of each hull followed by the vertices
+  std::size_t size;
+  std::shared_ptr<char> mapping = mapGeometryCacheFile(path, key, format, size);
+  if (mapping != nullptr && size >= sizeof(std::int64_t))
+  {
+    const std::int64_t* counts = reinterpret_cast<const std::int64_t*>(mapping.get());
+    std::size_t num_hulls = static_cast<std::size_t>(counts[0]);
+    std::size_t num_vertices = 0;
+    if (size >= (num_hulls + 1) * sizeof(std::int64_t))
+    {
+      for (std::size_t i = 0; i < num_hulls; ++i)
+        num_vertices += static_cast<std::size_t>(counts[i + 1]);
+    }
+
+    if (size == (num_hulls + 1) * sizeof(std::int64_t) + num_vertices * 3 * sizeof(double))
+    {
+      const double* v = reinterpret_cast<const double*>(counts + num_hulls + 1);
+      hulls.assign(num_hulls, VectorVector3d());
+      for (std::size_t i = 0; i < num_hulls; ++i)
+      {
+        hulls[i].reserve(static_cast<std::size_t>(counts[i + 1]));
+        for (std::int64_t j = 0; j < counts[i + 1]; ++j, v += 3)
+          hulls[i].push_back(Eigen::Vector3d(v[0], v[1], v[2]));
+      }
+      return static_cast<int>(num_hulls);
+    }
+  }
+
+  int num_hulls = createConvexDecomposition(hulls, vertices, triangles, max_error, max_hulls, resolution);
+  if (num_hulls <= 0 || path.empty())
+    return num_hulls;
+
+  std::size_t num_vertices = 0;
+  for (const auto& hull : hulls)
+    num_vertices += hull.size();
+
+  std::vector<char> payload((hulls.size() + 1) * sizeof(std::int64_t) + num_vertices * 3 * sizeof(double));
+  std::int64_t* counts = reinterpret_cast<std::int64_t*>(payload.data());
+  counts[0] = static_cast<std::int64_t>(hulls.size());
+  for (std::size_t i = 0; i < hulls.size(); ++i)
+    counts[i + 1] = static_cast<std::int64_t>(hulls[i].size());
+
+  double* v = reinterpret_cast<double*>(counts + hulls.size() + 1);
+  for (const auto& hull : hulls)
+  {
+    for (const auto& vertex : hull)
+    {
+      v[0] = vertex[0];
+      v[1] = vertex[1];
+      v[2] = vertex[2];
+      v += 3;
+    }
+  }
+
+  writeGeometryCacheFile(path, key, format, payload.data(), payload.size());
+  return num_hulls;
+}
+
+/** @brief Approximate a closed mesh by a set of convex hulls using the process wide settings and the geometry cache */
+inline int createCachedConvexDecomposition(std::vector<VectorVector3d>& hulls, const shapes::Mesh& mesh)
+{
+  VectorVector3d vertices;
+  vertices.reserve(mesh.vertex_count);
+  for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+    vertices.push_back(Eigen::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]));
+
+  std::vector<int> triangles(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+  ConvexDecompositionSettings settings = getConvexDecompositionSettings();
+  return createCachedConvexDecomposition(
+      hulls, vertices, triangles, settings.max_error, settings.max_hulls, settings.resolution);
+}
+}
+
+#endif  // TESSERACT_COLLISION_CONVEX_DECOMPOSITION_H
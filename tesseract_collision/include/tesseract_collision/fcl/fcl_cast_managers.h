@@ -0,0 +1,192 @@
+/**
+ * @file fcl_cast_managers.h
+ * @brief Tesseract ROS FCL continuous contact checker implementation.
+ *
+ * @date Oct 16, 2018
+ * @version TODO
+ * @bug No known bugs
+ *
+ * @copyright Copyright (c) 2017, Southwest Research Institute
+ *
+ * @par License
+ * Software License Agreement (BSD)
+ * @par
+ * All rights reserved.
+ * @par
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * @par
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ * @par
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TESSERACT_COLLISION_FCL_CAST_MANAGERS_H
+#define TESSERACT_COLLISION_FCL_CAST_MANAGERS_H
+
+#include <tesseract_core/continuous_contact_manager_base.h>
+#include <tesseract_collision/fcl/fcl_utils.h>
+
+namespace tesseract
+{
+/** @brief A cast (moving) collision object of the FCL cast manager */
+struct FCLCastObject
+{
+  FCLCOWPtr cow;          /**< @brief The collision object */
+  VectorIsometry3d poses; /**< @brief The poses of the object along its motion, a single pose if it does not move */
+};
+
+/**
+ * @brief A FCL implementation of the continuous contact manager
+ *
+ * The static objects are kept in a FCL dynamic AABB tree which is queried with the swept AABB of every cast object.
+ * The pairs are checked by continuous collision (see castCollisionCheck()), so the contacts report the time of
+ * contact along the motion in cc_time and cc_type like the Bullet cast managers.
+ */
+class FCLCastBVHManager : public ContinuousContactManagerBase
+{
+public:
+  FCLCastBVHManager();
+
+  ContinuousContactManagerBasePtr clone() const override;
+
+  bool addCollisionObject(const std::string& name,
+                          const int& mask_id,
+                          const std::vector<shapes::ShapeConstPtr>& shapes,
+                          const VectorIsometry3d& shape_poses,
+                          const CollisionObjectTypeVector& collision_object_types,
+                          bool enabled = true) override;
+
+  bool hasCollisionObject(const std::string& name) const override;
+
+  bool removeCollisionObject(const std::string& name) override;
+
+  bool enableCollisionObject(const std::string& name) override;
+
+  bool disableCollisionObject(const std::string& name) override;
+
+  bool updateCollisionObjectOcTree(const std::string& name,
+                                   const VectorVector3d& occupied_voxels,
+                                   const VectorVector3d& free_voxels) override;
+
+  void setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose) override;
+
+  void setCollisionObjectsTransform(const std::vector<std::string>& names,
+                                    const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsTransform(const TransformMap& transforms) override;
+
+  void setCollisionObjectsTransform(const std::string& name,
+                                    const Eigen::Isometry3d& pose1,
+                                    const Eigen::Isometry3d& pose2) override;
+
+  void setCollisionObjectsTransform(const std::vector<std::string>& names,
+                                    const VectorIsometry3d& pose1,
+                                    const VectorIsometry3d& pose2) override;
+
+  void setCollisionObjectsTransform(const TransformMap& pose1, const TransformMap& pose2) override;
+
+  void setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsTransform(const VectorIsometry3d& link_transforms) override;
+
+  void setCollisionObjectsTransform(int link_id,
+                                    const Eigen::Isometry3d& pose1,
+                                    const Eigen::Isometry3d& pose2) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                    const VectorIsometry3d& pose1,
+                                    const VectorIsometry3d& pose2) override;
+
+  void setCollisionObjectsSweptTransform(const std::string& name, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsSweptTransform(int link_id, const VectorIsometry3d& poses) override;
+
+  void setContactRequest(const ContactRequest& req) override;
+
+  const ContactRequest& getContactRequest() const override;
+
+  void contactTest(ContactResultMap& collisions) override;
+
+  void contactTest(ContactResultIdMap& collisions) override;
+
+  void contactTest(ContactResultBuffer& collisions) override;
+
+  bool isCollisionFree() override;
+
+  void setStatisticsEnabled(bool enabled) override;
+
+  bool isStatisticsEnabled() const override;
+
+  const ContactTestStatistics& getStatistics() const override;
+
+  void clearStatistics() override;
+
+  void setLinkRegistry(NameRegistryPtr registry) override;
+
+  NameRegistryConstPtr getLinkRegistry() const override { return link_registry_; }
+
+  /**
+   * @brief Add a fcl collision object to the manager
+   * @param cow The tesseract fcl collision object
+   */
+  void addCollisionObject(const FCLCOWPtr& cow);
+
+  /**
+   * @brief Return collision objects
+   * @return A map of collision objects <name, collision object>
+   */
+  const Link2FCLCOW& getCollisionObjects() const;
+
+private:
+  std::unique_ptr<fcl::BroadPhaseCollisionManagerd> manager_; /**< @brief FCL Broad Phase Collision Manager of the static objects */
+  Link2FCLCOW link2cow_;                                      /**< @brief A map of all (static and active) collision objects being managed */
+  std::map<std::string, FCLCastObject> link2castcow_;         /**< @brief A map of the cast (active) collision objects and their motion */
+  ContactRequest request_;                                    /**< @brief Active request to be used for methods that don't require a request */
+  NameRegistryPtr link_registry_;                             /**< @brief Assigns the link ids of the collision objects */
+  std::vector<FCLCOWPtr> id2cow_;                             /**< @brief The collision objects indexed by link id (nullptr if not managed) */
+  std::vector<FCLCastObject*> id2castcow_;                    /**< @brief The cast collision objects indexed by link id (nullptr if not active) */
+  ContactTestStatistics stats_;                               /**< @brief The statistics collected during contact tests */
+  bool stats_enabled_;                                        /**< @brief Indicate if statistics are collected during contact tests */
+  bool broadphase_changed_;                                   /**< @brief Indicate if the broadphase must be refit before the next contact test */
+
+  /**
+   * @brief Perform a contact test for all objects, storing the results in the container provided by cdata
+   * @param cdata The contact query data
+   */
+  void contactTest(ContactDistanceData& cdata);
+
+  /**
+   * @brief Get the cast collision object associated with a link id
+   * @param link_id The link id
+   * @return The cast collision object, nullptr if the link is not active
+   */
+  FCLCastObject* getCastObject(int link_id) const;
+
+  /** @brief Rebuild the index of the cast collision objects by link id */
+  void indexCastObjects();
+
+};
+typedef std::shared_ptr<FCLCastBVHManager> FCLCastBVHManagerPtr;
+
+}
+#endif // TESSERACT_COLLISION_FCL_CAST_MANAGERS_H
@@ -44,6 +44,7 @@
 
 #include <tesseract_core/discrete_contact_manager_base.h>
 #include <tesseract_collision/fcl/fcl_utils.h>
+#include <atomic>
 
 namespace tesseract
 {
@@ -70,6 +71,10 @@ public:
 
   bool disableCollisionObject(const std::string& name) override;
 
+  bool updateCollisionObjectOcTree(const std::string& name,
+                                   const VectorVector3d& occupied_voxels,
+                                   const VectorVector3d& free_voxels) override;
+
   void setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose) override;
 
   void setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -77,15 +82,39 @@ public:
 
   void setCollisionObjectsTransform(const TransformMap& transforms) override;
 
+  void setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose) override;
+
+  void setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses) override;
+
+  void setCollisionObjectsTransform(const VectorIsometry3d& link_transforms) override;
+
   void contactTest(ContactResultMap& collisions) override;
 
+  void contactTest(ContactResultIdMap& collisions) override;
+
+  void contactTest(ContactResultBuffer& collisions) override;
+
+  bool isCollisionFree() override;
+
+  void setStatisticsEnabled(bool enabled) override;
+
+  bool isStatisticsEnabled() const override;
+
+  const ContactTestStatistics& getStatistics() const override;
+
+  void clearStatistics() override;
+
   void setContactRequest(const ContactRequest& req) override;
 
   const ContactRequest& getContactRequest() const override;
 
+  void setLinkRegistry(NameRegistryPtr registry) override;
+
+  NameRegistryConstPtr getLinkRegistry() const override { return link_registry_; }
+
   /**
    * @brief Add a fcl collision object to the manager
-   * @param cow The tesseract fcl collision object
+   * @param cow The tesseract fcl collision object, the manager takes ownership of it and may modify it
    */
   void addCollisionObject(const FCLCOWPtr& cow);
 
@@ -99,6 +128,25 @@ private:
   std::unique_ptr<fcl::BroadPhaseCollisionManagerd> manager_; /**< @brief FCL Broad Phase Collision Manager */
   Link2FCLCOW link2cow_;                                      /**< @brief A map of all (static and active) collision objects being managed */
   ContactRequest request_;                                    /**< @brief Active request to be used for methods that don't require a request */
+  NameRegistryPtr link_registry_;                             /**< @brief Assigns the link ids of the collision objects */
+  std::vector<FCLCOWPtr> id2cow_;                             /**< @brief The collision objects indexed by link id (nullptr if not managed) */
+  ContactTestStatistics stats_;                               /**< @brief The statistics collected during contact tests */
+  bool stats_enabled_;                                        /**< @brief Indicate if statistics are collected during contact tests */
+  bool broadphase_changed_;                                   /**< @brief Indicate if the broadphase must be refit before the next contact test */
+  mutable std::atomic<std::uint64_t> owner_tag_;              /**< @brief Replaced by clone(), see FCLCOW::isOwnedBy() */
+
+  /**
+   * @brief Perform a contact test for all objects, storing the results in the container provided by cdata
+   * @param cdata The contact query data
+   */
+  void contactTest(ContactDistanceData& cdata);
+
+  /**
+   * @brief Get a collision object to modify it, it is copied first if it is still shared with a clone
+   * @param cow The collision object, it is replaced in the containers of the manager by its copy
+   * @return The collision object which may be modified
+   */
+  FCLCOW& getWritableCollisionObject(const FCLCOWPtr& cow);
 
 };
 typedef std::shared_ptr<FCLDiscreteBVHManager> FCLDiscreteBVHManagerPtr;
@@ -50,15 +50,45 @@
 #include <set>
 #include <tesseract_core/basic_types.h>
 #include <tesseract_collision/contact_checker_common.h>
+#include <tesseract_collision/signed_distance_field.h>
 #include <geometric_shapes/mesh_operations.h>
 #include <ros/console.h>
 
 namespace tesseract
 {
+/** @brief The maximum number of iterations of the continuous collision checks of the cast managers */
+const std::size_t FCL_CAST_MAX_ITERATIONS = 20;
+
+/** @brief The maximum number of distance queries of the cast managers for a segment of a motion */
+const std::size_t FCL_CAST_MAX_DISTANCE_QUERIES = 100;
+
+/** @brief The tolerance of the closest approach of two shapes the cast managers find along a segment of a motion */
+const double FCL_CAST_DISTANCE_TOLERANCE = 1e-3;
+
+/** @brief The distance at which the conservative advancement of the cast managers considers two shapes in contact */
+const double FCL_CAST_CONTACT_TOLERANCE = 1e-6;
+
 typedef std::shared_ptr<fcl::CollisionGeometryd> FCLCollisionGeometryPtr;
 typedef std::shared_ptr<fcl::CollisionObjectd> FCLCollisionObjectPtr;
 typedef std::shared_ptr<const fcl::CollisionObjectd> FCLCollisionObjectConstPtr;
 
+/**
+ * @brief A collision geometry shared through the shape cache and a collision object of it
+ *
+ * The constructor of fcl::CollisionObjectd computes the local AABB of the geometry, which would write to the shared
+ * geometry for every collision object created. The prototype does it once, collision objects are copies of it.
+ */
+struct FCLCachedGeometry
+{
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  FCLCachedGeometry(const FCLCollisionGeometryPtr& geometry) : geometry(geometry), prototype(geometry) {}
+
+  FCLCollisionGeometryPtr geometry; /**< @brief The collision geometry */
+  fcl::CollisionObjectd prototype;  /**< @brief A collision object of the geometry with its local AABB computed */
+};
+typedef std::shared_ptr<FCLCachedGeometry> FCLCachedGeometryPtr;
+
 enum FCLCollisionFilterGroups
 {
   DefaultFilter = 1,
@@ -67,6 +97,37 @@ enum FCLCollisionFilterGroups
   AllFilter = -1 //all bits sets: DefaultFilter | StaticFilter | KinematicFilter
 };
 
+/**
+ * @brief The fcl collision geometry of a signed distance field
+ *
+ * fcl has no support for custom geometry, so the collision and distance callbacks check pairs containing a
+ * field themselves (see SignedDistanceField::getClosestSample()). It supports spheres, capsules, boxes,
+ * cylinders, cones, convex shapes and meshes.
+ */
+class FCLSignedDistanceField : public fcl::CollisionGeometryd
+{
+public:
+  FCLSignedDistanceField(SignedDistanceFieldConstPtr sdf) : sdf_(std::move(sdf)) {}
+
+  void computeLocalAABB() override
+  {
+    Eigen::Vector3d field_min, field_max;
+    sdf_->getAABB(field_min, field_max);
+    aabb_local = fcl::AABBd(field_min, field_max);
+    aabb_center = aabb_local.center();
+    aabb_radius = (aabb_local.min_ - aabb_center).norm();
+  }
+
+  fcl::NODE_TYPE getNodeType() const override { return fcl::BV_UNKNOWN; }
+  fcl::OBJECT_TYPE getObjectType() const override { return fcl::OT_UNKNOWN; }
+
+  /** @brief Get the signed distance field */
+  const SignedDistanceField& getField() const { return *sdf_; }
+
+private:
+  SignedDistanceFieldConstPtr sdf_;
+};
+
 class FCLCollisionObjectWrapper
 {
 public:
@@ -82,6 +143,23 @@ public:
 
   const std::string& getName() const { return name_; }
   const int& getTypeID() const { return type_id_; }
+  /** @brief Get the link id assigned by the managers link registry (-1 if not assigned) */
+  int getLinkId() const { return link_id_; }
+  /** @brief Set the link id assigned by the managers link registry */
+  void setLinkId(int link_id) { link_id_ = link_id; }
+
+  /**
+   * @brief Check if a manager may modify the object in place
+   *
+   * Clones of a manager share its collision objects. Cloning gives the source manager a new owner tag, so objects
+   * tagged before are copied by the first manager modifying them. Copies made by clone() have no owner.
+   *
+   * @param owner_tag The owner tag of the manager, see createOwnerTag()
+   */
+  bool isOwnedBy(std::uint64_t owner_tag) const { return owner_ != 0 && owner_ == owner_tag; }
+
+  /** @brief Tag the object as owned by a manager, it must not be shared with other managers */
+  void setOwner(std::uint64_t owner_tag) { owner_ = owner_tag; }
 
   /** \brief Check if two objects point to the same source object */
   bool sameObject(const FCLCollisionObjectWrapper& other) const
@@ -117,6 +195,31 @@ public:
     return collision_objects_;
   }
 
+  /** @brief Check if the object has an octomap */
+  bool hasOcTrees() const
+  {
+    for (const auto& geometry : collision_geometries_)
+    {
+      if (geometry->getNodeType() == fcl::GEOM_OCTREE)
+        return true;
+    }
+
+    return false;
+  }
+
+  /**
+   * @brief Mark voxels of the octomaps of the object occupied or free
+   *
+   * The octomaps are shared with clones of the object, so they are replaced by updated copies together with their
+   * collision geometries and collision objects. The collision objects have to be unregistered from a broadphase
+   * before and registered again after.
+   *
+   * @param occupied_voxels The centers of the voxels to mark occupied, in the frame of the octomap
+   * @param free_voxels The centers of the voxels to mark free, in the frame of the octomap
+   * @return True if the object has an octomap
+   */
+  bool updateOcTrees(const VectorVector3d& occupied_voxels, const VectorVector3d& free_voxels);
+
   std::shared_ptr<FCLCollisionObjectWrapper> clone() const
   {
     std::shared_ptr<FCLCollisionObjectWrapper> clone_cow(
@@ -124,6 +227,8 @@ public:
     clone_cow->m_collisionFilterGroup = m_collisionFilterGroup;
     clone_cow->m_collisionFilterMask = m_collisionFilterMask;
     clone_cow->m_enabled = m_enabled;
+    clone_cow->link_id_ = link_id_;
+    clone_cow->world_pose_ = world_pose_;
     return clone_cow;
   }
 
@@ -139,6 +244,8 @@ protected:
 
   std::string name_;  // name of the collision object
   int type_id_;       // user defined type id
+  int link_id_;       // link id assigned by the managers link registry
+  std::uint64_t owner_;          /**< @brief The owner tag of the manager which may modify the object */
   Eigen::Isometry3d world_pose_; /**< @brief Collision Object World Transformation */
   std::vector<shapes::ShapeConstPtr> shapes_;
   VectorIsometry3d shape_poses_;
@@ -150,6 +257,22 @@ protected:
 FCLCollisionGeometryPtr createShapePrimitive(const shapes::ShapeConstPtr& geom,
                                              const CollisionObjectType& collision_object_type);
 
+/**
+ * @brief Get fcl collision geometry from the process wide shape cache, it is created if not cached
+ *
+ * Shapes with the same data and collision object type share one collision geometry, which must not be modified.
+ * Octrees are not cached.
+ *
+ * @param geom The geometric shape
+ * @param collision_object_type The collision object type
+ * @return The collision geometry and its prototype collision object, nullptr if the shape type is not supported
+ */
+FCLCachedGeometryPtr getCachedFCLShape(const shapes::ShapeConstPtr& geom,
+                                       const CollisionObjectType& collision_object_type);
+
+/** @brief Get the process wide cache of fcl collision geometry */
+CollisionShapeCache<FCLCachedGeometry>& getFCLShapeCache();
+
 typedef FCLCollisionObjectWrapper FCLCOW;
 typedef std::shared_ptr<FCLCollisionObjectWrapper> FCLCOWPtr;
 typedef std::shared_ptr<const FCLCollisionObjectWrapper> FCLCOWConstPtr;
@@ -177,6 +300,51 @@ inline FCLCOWPtr createFCLCollisionObject(const std::string& name,
   return new_cow;
 }
 
+/**
+ * @brief Assign the link id of a collision object and store it in a vector indexed by link id
+ * @param registry The link registry used to assign the id
+ * @param id2cow The collision objects indexed by link id
+ * @param cow The collision object
+ */
+inline void indexCollisionObject(NameRegistry& registry, std::vector<FCLCOWPtr>& id2cow, const FCLCOWPtr& cow)
+{
+  int link_id = registry.intern(cow->getName());
+  if (cow->getLinkId() != link_id)
+    cow->setLinkId(link_id);
+
+  if (static_cast<std::size_t>(link_id) >= id2cow.size())
+    id2cow.resize(static_cast<std::size_t>(link_id) + 1);
+
+  id2cow[static_cast<std::size_t>(link_id)] = cow;
+}
+
+/**
+ * @brief Remove a collision object from a vector indexed by link id
+ * @param id2cow The collision objects indexed by link id
+ * @param cow The collision object
+ */
+inline void unindexCollisionObject(std::vector<FCLCOWPtr>& id2cow, const FCLCOW& cow)
+{
+  int link_id = cow.getLinkId();
+  if (link_id >= 0 && static_cast<std::size_t>(link_id) < id2cow.size())
+    id2cow[static_cast<std::size_t>(link_id)] = nullptr;
+}
+
+/**
+ * @brief Get the collision object associated with a link id
+ * @param id2cow The collision objects indexed by link id
+ * @param link_id The link id
+ * @return The collision object, nullptr if the link id is not managed
+ */
+inline const FCLCOWPtr& getCollisionObject(const std::vector<FCLCOWPtr>& id2cow, int link_id)
+{
+  static const FCLCOWPtr null_cow;
+  if (link_id < 0 || static_cast<std::size_t>(link_id) >= id2cow.size())
+    return null_cow;
+
+  return id2cow[static_cast<std::size_t>(link_id)];
+}
+
 /**
  * @brief updateCollisionObjectsWithRequest
  * @param req
@@ -208,9 +376,65 @@ inline void updateCollisionObjectWithRequest(const ContactRequest& req, FCLCOW&
   }
 }
 
+/**
+ * @brief Check if updateCollisionObjectWithRequest() would change a collision object
+ * @param req The contact request
+ * @param cow The collision object
+ * @return True if the filter of the object differs from the request
+ */
+inline bool needsRequestUpdate(const ContactRequest& req, const FCLCOW& cow)
+{
+  bool kinematic = req.link_names.empty() ||
+                   std::find(req.link_names.begin(), req.link_names.end(), cow.getName()) != req.link_names.end();
+
+  short int group = kinematic ? FCLCollisionFilterGroups::KinematicFilter : FCLCollisionFilterGroups::StaticFilter;
+  short int mask = kinematic ? (FCLCollisionFilterGroups::StaticFilter | FCLCollisionFilterGroups::KinematicFilter) :
+                               FCLCollisionFilterGroups::KinematicFilter;
+
+  return cow.m_collisionFilterGroup != group || cow.m_collisionFilterMask != mask;
+}
+
 bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data);
 
 bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& min_dist);
 
+/**
+ * @brief Get an AABB containing a collision object along its motion
+ *
+ * Every shape is bounded by a sphere around the origin of the object which does not depend on its orientation, so
+ * the AABB contains the object while it moves linearly between consecutive poses.
+ *
+ * @param cow The collision object
+ * @param poses The poses of the object along its motion
+ * @param margin The distance the AABB is extended by, usually the contact distance
+ * @return The swept AABB
+ */
+fcl::AABBd getSweptAABB(const FCLCOW& cow, const VectorIsometry3d& poses, double margin);
+
+/**
+ * @brief Check a pair of shapes of which at least one moves, used by the cast managers
+ *
+ * Both motions are parameterized by the same time from zero to one, the poses of a window are spread uniformly over
+ * it and the objects move linearly between consecutive poses. The first segment in collision is checked by
+ * continuous collision in both directions and the contact is evaluated halfway between entering and leaving the
+ * other shape (CCType_Between), or at the start (CCType_Time0) or the end (CCType_Time1) of the motion if the shapes
+ * are in collision there. Otherwise the closest approach within the contact distance is searched along every
+ * segment. The distance changes at most as fast as the shapes move, which bounds it between the times where it was
+ * computed, so the search finds the closest approach within FCL_CAST_DISTANCE_TOLERANCE unless it needs more than
+ * FCL_CAST_MAX_DISTANCE_QUERIES per segment. Signed distance fields are not supported.
+ *
+ * @param o1 The first shape
+ * @param poses1 The poses of the collision object of the first shape, a single pose if it does not move
+ * @param o2 The second shape
+ * @param poses2 The poses of the collision object of the second shape, a single pose if it does not move
+ * @param cdata The contact query data
+ * @return True if the search is finished
+ */
+bool castCollisionCheck(const fcl::CollisionObjectd& o1,
+                        const VectorIsometry3d& poses1,
+                        const fcl::CollisionObjectd& o2,
+                        const VectorIsometry3d& poses2,
+                        ContactDistanceData& cdata);
+
 }
 #endif // TESSERACT_COLLISION_FCL_UTILS_H
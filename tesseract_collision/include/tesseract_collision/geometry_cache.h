@@ -0,0 +1,397 @@
+/**
+ * @file geometry_cache.h
+ * @brief A persistent on-disk cache of preprocessed collision geometry
+ *
+ * @date Oct 16, 2018
+ * @version TODO
+ * @bug No known bugs
+ *
+ * @copyright Copyright (c) 2017, Southwest Research Institute
+ *
+ * @par License
+ * Software License Agreement (Apache License)
+ * @par
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * @par
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TESSERACT_COLLISION_GEOMETRY_CACHE_H
+#define TESSERACT_COLLISION_GEOMETRY_CACHE_H
+
+#include <tesseract_collision/contact_checker_common.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tesseract
+{
+/** @brief The version of the cache files, it is part of the cache directory so old files are never read */
+const int GEOMETRY_CACHE_VERSION = 2;
+
+/** @brief The magic number at the start of every cache file */
+const std::uint32_t GEOMETRY_CACHE_MAGIC = 0x54534743;  // "TSGC"
+
+/**
+ * @brief The header at the start of every cache file
+ *
+ * The header is 32 bytes so the payload of a memory mapped file keeps a 16 byte alignment.
+ */
+struct GeometryCacheFileHeader
+{
+  std::uint32_t magic;       /**< @brief GEOMETRY_CACHE_MAGIC */
+  std::uint32_t format;      /**< @brief A format identifier defined by the writer of the file */
+  std::uint64_t size;        /**< @brief The size of the payload in bytes */
+  std::uint64_t key_size;    /**< @brief The size of the input data the file was created from (see GeometryCacheKey) */
+  std::uint64_t key_digest;  /**< @brief The digest of the input data the file was created from */
+};
+
+/**
+ * @brief The key of a cache file, computed from all the input data used to create its contents
+ *
+ * The hash names the file. Different input data may have the same 64 bit hash, so the size and an independent
+ * digest of the input data are stored in the file header and must match for the file to be used.
+ */
+struct GeometryCacheKey
+{
+  std::uint64_t hash = 0;   /**< @brief The hash of the input data (see hashShapeBytes()) */
+  std::uint64_t digest = 0; /**< @brief A digest of the input data using a different function than the hash */
+  std::uint64_t size = 0;   /**< @brief The size of the input data in bytes */
+
+  /**
+   * @brief Add a block of memory to the key
+   * @param data The data
+   * @param size The size of the data in bytes
+   */
+  void add(const void* data, std::size_t size)
+  {
+    hash = hashShapeBytes(static_cast<std::size_t>(hash), data, size);
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      digest = (digest + bytes[i] + 1) * 0xff51afd7ed558ccdULL;
+      digest ^= digest >> 32;
+    }
+    this->size += size;
+  }
+
+  /** @brief Add the vertices of a mesh to the key */
+  void add(const VectorVector3d& vertices)
+  {
+    for (const auto& v : vertices)
+      add(v.data(), 3 * sizeof(double));
+  }
+};
+
+/** @brief The mutable state of the geometry cache */
+struct GeometryCacheSettings
+{
+  std::mutex mutex;      /**< @brief Protects the directory */
+  std::string directory; /**< @brief The versioned cache directory, empty if the cache is disabled */
+
+  GeometryCacheSettings()
+  {
+    // The cache is disabled unless TESSERACT_GEOMETRY_CACHE_DIR is set
+    const char* dir = std::getenv("TESSERACT_GEOMETRY_CACHE_DIR");
+    if (dir != nullptr && dir[0] != '\0')
+      directory = std::string(dir) + "/v" + std::to_string(GEOMETRY_CACHE_VERSION);
+  }
+};
+
+TESSERACT_COLLISION_SHARED_STATE inline GeometryCacheSettings& getGeometryCacheSettings()
+{
+  static GeometryCacheSettings settings;
+  return settings;
+}
+
+/**
+ * @brief Get the directory of the geometry cache
+ *
+ * The cache is disabled by default. It is enabled by setting the environment variable TESSERACT_GEOMETRY_CACHE_DIR
+ * or by calling setGeometryCacheDirectory(), the format version is appended to the directory.
+ *
+ * @return The cache directory, empty if the cache is disabled
+ */
+inline std::string getGeometryCacheDirectory()
+{
+  GeometryCacheSettings& settings = getGeometryCacheSettings();
+  std::lock_guard<std::mutex> lock(settings.mutex);
+  return settings.directory;
+}
+
+/**
+ * @brief Set the directory of the geometry cache, the format version is appended
+ * @param directory The cache directory, an empty string disables the cache
+ */
+inline void setGeometryCacheDirectory(const std::string& directory)
+{
+  GeometryCacheSettings& settings = getGeometryCacheSettings();
+  std::lock_guard<std::mutex> lock(settings.mutex);
+  settings.directory = directory.empty() ? directory : directory + "/v" + std::to_string(GEOMETRY_CACHE_VERSION);
+}
+
+/**
+ * @brief Get the conventional location of the geometry cache
+ *
+ * It is not used unless it is passed to setGeometryCacheDirectory().
+ *
+ * @return $ROS_HOME/tesseract_geometry_cache (~/.ros if ROS_HOME is not set), empty if neither is set
+ */
+inline std::string getDefaultGeometryCacheDirectory()
+{
+  const char* ros_home = std::getenv("ROS_HOME");
+  if (ros_home != nullptr)
+    return std::string(ros_home) + "/tesseract_geometry_cache";
+
+  const char* home = std::getenv("HOME");
+  if (home != nullptr)
+    return std::string(home) + "/.ros/tesseract_geometry_cache";
+
+  return std::string();
+}
+
+/**
+ * @brief Get the path of a cache file
+ * @param prefix The kind of data stored in the file
+ * @param key The key of the data used to create the file contents
+ * @return The path of the file, empty if the cache is disabled
+ */
+inline std::string getGeometryCacheFilePath(const std::string& prefix, const GeometryCacheKey& key)
+{
+  std::string directory = getGeometryCacheDirectory();
+  if (directory.empty())
+    return directory;
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key.hash));
+  return directory + "/" + prefix + "_" + name + ".bin";
+}
+
+/**
+ * @brief Create a directory and its parents if they do not exist
+ * @param directory The directory
+ * @return True if the directory exists
+ */
+inline bool createGeometryCacheDirectory(const std::string& directory)
+{
+  for (std::size_t pos = directory.find('/', 1); ; pos = directory.find('/', pos + 1))
+  {
+    std::string path = directory.substr(0, pos);
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST)
+      return false;
+
+    if (pos == std::string::npos)
+      return true;
+  }
+}
+
+/**
+ * @brief Write all bytes to a file descriptor
+ * @return True if all bytes were written
+ */
+inline bool writeGeometryCacheBytes(int fd, const void* data, std::size_t size)
+{
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0)
+  {
+    ssize_t written = write(fd, bytes, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+
+    if (written <= 0)
+      return false;
+
+    bytes += written;
+    size -= static_cast<std::size_t>(written);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Write a cache file
+ *
+ * The file is written to a unique temporary file which is renamed, so other threads and processes never see a
+ * partial file.
+ *
+ * @param path The path of the file
+ * @param key The key of the data used to create the file contents, it is verified when the file is loaded
+ * @param format The format identifier stored in the header
+ * @param data The payload
+ * @param size The size of the payload in bytes
+ * @return True if the file was written
+ */
+inline bool writeGeometryCacheFile(const std::string& path,
+                                   const GeometryCacheKey& key,
+                                   std::uint32_t format,
+                                   const void* data,
+                                   std::size_t size)
+{
+  if (path.empty() || !createGeometryCacheDirectory(path.substr(0, path.rfind('/'))))
+    return false;
+
+  std::string tmp_path = path + ".XXXXXX";
+  int fd = mkstemp(&tmp_path[0]);
+  if (fd < 0)
+  {
+    ROS_WARN("Failed to create geometry cache file: %s", path.c_str());
+    return false;
+  }
+
+  GeometryCacheFileHeader header;
+  header.magic = GEOMETRY_CACHE_MAGIC;
+  header.format = format;
+  header.size = size;
+  header.key_size = key.size;
+  header.key_digest = key.digest;
+
+  // mkstemp() creates the file readable by the owner only
+  bool success = fchmod(fd, 0644) == 0 && writeGeometryCacheBytes(fd, &header, sizeof(header)) &&
+                 writeGeometryCacheBytes(fd, data, size);
+  success = (close(fd) == 0) && success;
+
+  if (!success || std::rename(tmp_path.c_str(), path.c_str()) != 0)
+  {
+    std::remove(tmp_path.c_str());
+    ROS_WARN("Failed to write geometry cache file: %s", path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Memory map a cache file
+ *
+ * The mapping is private, so the payload may be modified in memory without changing the file.
+ *
+ * @param path The path of the file
+ * @param key The key of the data used to create the file contents, the file is invalid if it does not match
+ * @param format The expected format identifier
+ * @param size (Output) The size of the payload in bytes
+ * @return The mapping which is unmapped when released, nullptr if the file does not exist or is invalid
+ */
+inline std::shared_ptr<char> mapGeometryCacheFile(const std::string& path,
+                                                  const GeometryCacheKey& key,
+                                                  std::uint32_t format,
+                                                  std::size_t& size)
+{
+  size = 0;
+  if (path.empty())
+    return nullptr;
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(GeometryCacheFileHeader))
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  std::size_t file_size = static_cast<std::size_t>(st.st_size);
+  void* addr = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return nullptr;
+
+  std::shared_ptr<char> mapping(static_cast<char*>(addr), [file_size](char* p) { munmap(p, file_size); });
+
+  const GeometryCacheFileHeader* header = reinterpret_cast<const GeometryCacheFileHeader*>(addr);
+  if (header->magic != GEOMETRY_CACHE_MAGIC || header->format != format ||
+      header->size != file_size - sizeof(GeometryCacheFileHeader))
+  {
+    ROS_WARN("Ignoring invalid geometry cache file: %s", path.c_str());
+    return nullptr;
+  }
+
+  // A file created from different data with the same hash, it is replaced when the caller writes its result
+  if (header->key_size != key.size || header->key_digest != key.digest)
+    return nullptr;
+
+  size = static_cast<std::size_t>(header->size);
+  return std::shared_ptr<char>(mapping, mapping.get() + sizeof(GeometryCacheFileHeader));
+}
+
+/**
+ * @brief Same as createConvexHull() but the result is stored in the geometry cache and loaded on later calls
+ *
+ * The cache is keyed on the input vertices and the shrink parameters.
+ */
+inline int createCachedConvexHull(VectorVector3d& vertices,
+                                  std::vector<int>& faces,
+                                  const VectorVector3d& input,
+                                  double shrink = -1,
+                                  double shrinkClamp = -1)
+{
+  const std::uint32_t format = 1;
+  double params[2] = { shrink, shrinkClamp };
+  GeometryCacheKey key;
+  key.add(params, sizeof(params));
+  key.add(input);
+  std::string path = getGeometryCacheFilePath("convex_hull", key);
+
+  // The payload is the number of faces, vertices and face indices followed by the vertices and the faces
+  std::size_t size;
+  std::shared_ptr<char> mapping = mapGeometryCacheFile(path, key, format, size);
+  if (mapping != nullptr && size >= 3 * sizeof(std::int64_t))
+  {
+    const std::int64_t* counts = reinterpret_cast<const std::int64_t*>(mapping.get());
+    std::size_t num_vertices = static_cast<std::size_t>(counts[1]);
+    std::size_t num_indices = static_cast<std::size_t>(counts[2]);
+    if (size == 3 * sizeof(std::int64_t) + num_vertices * 3 * sizeof(double) + num_indices * sizeof(int))
+    {
+      const double* v = reinterpret_cast<const double*>(counts + 3);
+      const int* f = reinterpret_cast<const int*>(v + 3 * num_vertices);
+
+      vertices.clear();
+      vertices.reserve(num_vertices);
+      for (std::size_t i = 0; i < num_vertices; ++i)
+        vertices.push_back(Eigen::Vector3d(v[3 * i], v[3 * i + 1], v[3 * i + 2]));
+
+      faces.assign(f, f + num_indices);
+      return static_cast<int>(counts[0]);
+    }
+  }
+
+  int num_faces = createConvexHull(vertices, faces, input, shrink, shrinkClamp);
+  if (num_faces < 0 || path.empty())
+    return num_faces;
+
+  std::vector<char> payload(3 * sizeof(std::int64_t) + vertices.size() * 3 * sizeof(double) + faces.size() * sizeof(int));
+  std::int64_t* counts = reinterpret_cast<std::int64_t*>(payload.data());
+  counts[0] = num_faces;
+  counts[1] = static_cast<std::int64_t>(vertices.size());
+  counts[2] = static_cast<std::int64_t>(faces.size());
+
+  double* v = reinterpret_cast<double*>(counts + 3);
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+  {
+    v[3 * i] = vertices[i][0];
+    v[3 * i + 1] = vertices[i][1];
+    v[3 * i + 2] = vertices[i][2];
+  }
+
+  if (!faces.empty())
+    std::memcpy(v + 3 * vertices.size(), faces.data(), faces.size() * sizeof(int));
+
+  writeGeometryCacheFile(path, key, format, payload.data(), payload.size());
+  return num_faces;
+}
+}
+
+#endif  // TESSERACT_COLLISION_GEOMETRY_CACHE_H
@@ -0,0 +1,903 @@
+/**
+ * @file signed_distance_field.h
+ * @brief A voxel signed distance field used by the SDF collision object type
+ *
+ * @date Oct 16, 2018
+ * @version TODO
+ * @bug No known bugs
+ *
+ * @copyright Copyright (c) 2017, Southwest Research Institute
+ *
+ * @par License
+ * Software License Agreement (Apache License)
+ * @par
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * @par
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TESSERACT_COLLISION_SIGNED_DISTANCE_FIELD_H
+#define TESSERACT_COLLISION_SIGNED_DISTANCE_FIELD_H
+
+#include <tesseract_collision/geometry_cache.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <new>
+
+namespace tesseract
+{
+/** @brief The default distance between the samples of a signed distance field */
+const double SDF_DEFAULT_RESOLUTION = 0.01;
+
+/** @brief The default distance the signed distance field extends beyond the mesh */
+const double SDF_DEFAULT_PADDING = 0.1;
+
+/** @brief The maximum number of samples along an axis, the resolution is reduced for large meshes */
+const int SDF_MAX_SAMPLES = 128;
+
+/** @brief The alignment of every row of samples in bytes, which is the size of a cache line */
+const std::size_t SDF_ALIGNMENT = 64;
+
+/** @brief The sample sphere of a shape closest to the surface of a signed distance field */
+struct SignedDistanceFieldContact
+{
+  double distance;                   /**< @brief The distance between the sample sphere and the surface */
+  Eigen::Vector3d normal;            /**< @brief The unit normal pointing out of the field towards the sample */
+  Eigen::Vector3d nearest_points[2]; /**< @brief The nearest point on the surface and on the sample sphere */
+  std::size_t index;                 /**< @brief The index of the sample */
+};
+
+/**
+ * @brief A signed distance field sampled on a regular grid, negative inside of the surface
+ *
+ * The samples are stored as floats with x changing fastest. Every row along x starts on a cache line, so
+ * the eight samples of a trilinear lookup are read from at most four cache lines. Outside of the grid the
+ * distance is approximated by the distance to the grid plus the distance at the closest grid point.
+ */
+class SignedDistanceField
+{
+public:
+  /**
+   * @brief Create a signed distance field with all distances set to zero
+   * @param origin The position of the first sample
+   * @param resolution The distance between samples
+   * @param size The number of samples along each axis, at least two
+   */
+  SignedDistanceField(const Eigen::Vector3d& origin, double resolution, const Eigen::Vector3i& size)
+    : origin_(origin), resolution_(resolution), size_(size)
+  {
+    initStrides();
+
+    std::size_t bytes = getDataSize(size_) * sizeof(float);
+    void* data = nullptr;
+    if (posix_memalign(&data, SDF_ALIGNMENT, bytes) != 0)
+      throw std::bad_alloc();
+
+    std::memset(data, 0, bytes);
+    data_ = std::shared_ptr<float>(static_cast<float*>(data), [](float* p) { std::free(p); });
+  }
+
+  /**
+   * @brief Create a signed distance field from existing samples
+   * @param origin The position of the first sample
+   * @param resolution The distance between samples
+   * @param size The number of samples along each axis, at least two
+   * @param data The samples in the layout described by getRowStride(), aligned to SDF_ALIGNMENT
+   */
+  SignedDistanceField(const Eigen::Vector3d& origin,
+                      double resolution,
+                      const Eigen::Vector3i& size,
+                      const std::shared_ptr<float>& data)
+    : origin_(origin), resolution_(resolution), size_(size), data_(data)
+  {
+    initStrides();
+  }
+
+  /** @brief The number of floats between two rows, rows are padded to a multiple of SDF_ALIGNMENT */
+  static std::size_t getRowStride(int size_x)
+  {
+    const std::size_t floats = SDF_ALIGNMENT / sizeof(float);
+    return ((static_cast<std::size_t>(size_x) + floats - 1) / floats) * floats;
+  }
+
+  /** @brief The number of floats needed to store a grid of the given size */
+  static std::size_t getDataSize(const Eigen::Vector3i& size)
+  {
+    return getRowStride(size[0]) * static_cast<std::size_t>(size[1]) * static_cast<std::size_t>(size[2]);
+  }
+
+  /** @brief Get the position of the first sample */
+  const Eigen::Vector3d& getOrigin() const { return origin_; }
+  /** @brief Get the distance between samples */
+  double getResolution() const { return resolution_; }
+  /** @brief Get the number of samples along each axis */
+  const Eigen::Vector3i& getSize() const { return size_; }
+  /** @brief Get the samples, see getRowStride() for the layout */
+  const float* getData() const { return data_.get(); }
+
+  /** @brief Get the bounds of the grid */
+  void getAABB(Eigen::Vector3d& aabb_min, Eigen::Vector3d& aabb_max) const
+  {
+    aabb_min = origin_;
+    aabb_max = origin_ + resolution_ * (size_ - Eigen::Vector3i::Ones()).cast<double>();
+  }
+
+  /** @brief Get the distance stored at a sample */
+  float getSample(int x, int y, int z) const { return data_.get()[index(x, y, z)]; }
+  /** @brief Set the distance stored at a sample */
+  void setSample(int x, int y, int z, float distance) { data_.get()[index(x, y, z)] = distance; }
+
+  /**
+   * @brief Get the signed distance at a point by trilinear interpolation
+   * @param point The point in the frame of the field
+   * @return The signed distance, negative inside of the surface
+   */
+  double getDistance(const Eigen::Vector3d& point) const { return interpolate(point, nullptr); }
+
+  /**
+   * @brief Get the signed distance and its gradient at a point by trilinear interpolation
+   * @param point The point in the frame of the field
+   * @param gradient (Output) The gradient of the distance, it is not normalized
+   * @return The signed distance, negative inside of the surface
+   */
+  double getDistance(const Eigen::Vector3d& point, Eigen::Vector3d& gradient) const
+  {
+    return interpolate(point, &gradient);
+  }
+
+  /**
+   * @brief Find the sample sphere closest to the surface of the field
+   *
+   * The distance of every sample is a constant time lookup, the gradient is only computed for the closest one.
+   *
+   * @param centers The centers of the sample spheres in the frame of the field
+   * @param radii The radii of the sample spheres, zero for points
+   * @param contact (Output) The closest sample, the nearest points are in the frame of the field
+   * @return False if there are no samples
+   */
+  bool getClosestSample(const VectorVector3d& centers,
+                        const std::vector<double>& radii,
+                        SignedDistanceFieldContact& contact) const
+  {
+    assert(centers.size() == radii.size());
+    if (centers.empty())
+      return false;
+
+    contact.distance = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < centers.size(); ++i)
+    {
+      double distance = getDistance(centers[i]) - radii[i];
+      if (distance < contact.distance)
+      {
+        contact.distance = distance;
+        contact.index = i;
+      }
+    }
+
+    const Eigen::Vector3d& center = centers[contact.index];
+    double radius = radii[contact.index];
+    Eigen::Vector3d gradient;
+    double center_distance = getDistance(center, gradient);
+
+    double norm = gradient.norm();
+    if (norm > std::numeric_limits<double>::epsilon())
+      contact.normal = gradient / norm;
+    else
+      contact.normal = Eigen::Vector3d::UnitZ();
+
+    contact.nearest_points[0] = center - center_distance * contact.normal;
+    contact.nearest_points[1] = center - radius * contact.normal;
+    return true;
+  }
+
+private:
+  Eigen::Vector3d origin_;      /**< @brief The position of the first sample */
+  double resolution_;           /**< @brief The distance between samples */
+  Eigen::Vector3i size_;        /**< @brief The number of samples along each axis */
+  std::size_t row_stride_;      /**< @brief The number of floats between two rows */
+  std::size_t slice_stride_;    /**< @brief The number of floats between two slices */
+  std::shared_ptr<float> data_; /**< @brief The samples */
+
+  void initStrides()
+  {
+    assert(size_.minCoeff() >= 2);
+    row_stride_ = getRowStride(size_[0]);
+    slice_stride_ = row_stride_ * static_cast<std::size_t>(size_[1]);
+  }
+
+  std::size_t index(int x, int y, int z) const
+  {
+    return static_cast<std::size_t>(z) * slice_stride_ + static_cast<std::size_t>(y) * row_stride_ +
+           static_cast<std::size_t>(x);
+  }
+
+  double interpolate(const Eigen::Vector3d& point, Eigen::Vector3d* gradient) const
+  {
+    // Grid coordinates of the closest point in the grid and the cell containing it
+    Eigen::Vector3d u = (point - origin_) / resolution_;
+    Eigen::Vector3d clamped;
+    int cell[3];
+    double f[3];
+    for (int a = 0; a < 3; ++a)
+    {
+      clamped[a] = std::max(0.0, std::min(u[a], static_cast<double>(size_[a] - 1)));
+      cell[a] = std::min(static_cast<int>(clamped[a]), size_[a] - 2);
+      f[a] = clamped[a] - cell[a];
+    }
+
+    const float* c = data_.get() + index(cell[0], cell[1], cell[2]);
+    const std::size_t r = row_stride_, s = slice_stride_;
+    double c00 = c[0] + f[0] * (c[1] - c[0]);
+    double c10 = c[r] + f[0] * (c[r + 1] - c[r]);
+    double c01 = c[s] + f[0] * (c[s + 1] - c[s]);
+    double c11 = c[s + r] + f[0] * (c[s + r + 1] - c[s + r]);
+    double c0 = c00 + f[1] * (c10 - c00);
+    double c1 = c01 + f[1] * (c11 - c01);
+    double distance = c0 + f[2] * (c1 - c0);
+
+    // Outside of the grid the distance to the grid is added
+    Eigen::Vector3d outside = (u - clamped) * resolution_;
+    double outside_distance = outside.norm();
+    if (outside_distance > 0)
+    {
+      if (gradient != nullptr)
+        *gradient = outside / outside_distance;
+
+      return distance + outside_distance;
+    }
+
+    if (gradient != nullptr)
+    {
+      double dx00 = c[1] - c[0], dx10 = c[r + 1] - c[r], dx01 = c[s + 1] - c[s], dx11 = c[s + r + 1] - c[s + r];
+      double dx0 = dx00 + f[1] * (dx10 - dx00);
+      double dx1 = dx01 + f[1] * (dx11 - dx01);
+      (*gradient)[0] = (dx0 + f[2] * (dx1 - dx0)) / resolution_;
+      (*gradient)[1] = ((c10 - c00) + f[2] * ((c11 - c01) - (c10 - c00))) / resolution_;
+      (*gradient)[2] = (c1 - c0) / resolution_;
+    }
+
+    return distance;
+  }
+};
+
+typedef std::shared_ptr<SignedDistanceField> SignedDistanceFieldPtr;
+typedef std::shared_ptr<const SignedDistanceField> SignedDistanceFieldConstPtr;
+
+/** @brief The number of segments of the circles of cylinders and cones in a SignedDistanceFieldSurface */
+const int SDF_SURFACE_CIRCLE_SEGMENTS = 32;
+
+/**
+ * @brief The interpolated distance of a field changes by at most this factor times the distance between two points
+ *
+ * Each partial derivative of the trilinear interpolation of a distance is at most one, and the distance outside of
+ * the grid adds one more.
+ */
+const double SDF_LIPSCHITZ_CONSTANT = 1 + std::sqrt(3.0);
+
+/**
+ * @brief The surface of a shape queried against a signed distance field, made of triangles and swept spheres
+ *
+ * A sphere is a segment with equal vertices and a capsule is a segment with different ones.
+ */
+struct SignedDistanceFieldSurface
+{
+  VectorVector3d vertices;    /**< @brief The vertices of the triangles and segments */
+  std::vector<int> triangles; /**< @brief The vertex indices of the triangles, three per triangle */
+  std::vector<int> segments;  /**< @brief The vertex indices of the segments, two per segment */
+  std::vector<double> radii;  /**< @brief The radius of the sphere swept along each segment */
+  double margin = 0;          /**< @brief The distance the surface extends beyond the triangles */
+
+  void clear()
+  {
+    vertices.clear();
+    triangles.clear();
+    segments.clear();
+    radii.clear();
+    margin = 0;
+  }
+
+  /** @brief Add a segment, the surface is the sphere of the given radius swept from p to q */
+  void addSegment(const Eigen::Vector3d& p, const Eigen::Vector3d& q, double radius)
+  {
+    segments.push_back(static_cast<int>(vertices.size()));
+    vertices.push_back(p);
+    segments.push_back(static_cast<int>(vertices.size()));
+    vertices.push_back(q);
+    radii.push_back(radius);
+  }
+
+  /** @brief Add a triangle */
+  void addTriangle(const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c)
+  {
+    for (const Eigen::Vector3d* v : { &a, &b, &c })
+    {
+      triangles.push_back(static_cast<int>(vertices.size()));
+      vertices.push_back(*v);
+    }
+  }
+
+  /**
+   * @brief Add polygons, e.g. the faces of a convex hull
+   * @param points The vertices of the polygons
+   * @param faces The number of vertices of each polygon followed by their indices, see createConvexHull()
+   */
+  void addPolygons(const VectorVector3d& points, const std::vector<int>& faces)
+  {
+    const int offset = static_cast<int>(vertices.size());
+    vertices.insert(vertices.end(), points.begin(), points.end());
+    for (std::size_t i = 0; i < faces.size(); i += static_cast<std::size_t>(faces[i]) + 1)
+    {
+      for (int j = 2; j < faces[i]; ++j)
+      {
+        triangles.push_back(offset + faces[i + 1]);
+        triangles.push_back(offset + faces[i + static_cast<std::size_t>(j)]);
+        triangles.push_back(offset + faces[i + static_cast<std::size_t>(j) + 1]);
+      }
+    }
+  }
+
+  /** @brief Add a box centered at the origin */
+  void addBox(const Eigen::Vector3d& half_extents)
+  {
+    VectorVector3d corners;
+    for (int i = 0; i < 8; ++i)
+      corners.push_back(Eigen::Vector3d((i & 1) ? half_extents[0] : -half_extents[0],
+                                        (i & 2) ? half_extents[1] : -half_extents[1],
+                                        (i & 4) ? half_extents[2] : -half_extents[2]));
+
+    const std::vector<int> faces = { 4, 0, 2, 3, 1, 4, 4, 5, 7, 6, 4, 0, 1, 5, 4,
+                                     4, 2, 6, 7, 3, 4, 0, 4, 6, 2, 4, 1, 3, 7, 5 };
+    addPolygons(corners, faces);
+  }
+
+  /**
+   * @brief Add a cylinder or a cone along an axis, centered at the origin
+   *
+   * The circles are approximated by polygons of SDF_SURFACE_CIRCLE_SEGMENTS edges, the distance between the
+   * polygons and the circles is added to the margin.
+   *
+   * @param bottom_radius The radius at the negative end of the axis
+   * @param top_radius The radius at the positive end of the axis, zero for a cone
+   * @param half_height Half of the length along the axis
+   * @param axis The index of the axis
+   */
+  void addFrustum(double bottom_radius, double top_radius, double half_height, int axis = 2)
+  {
+    auto point = [axis](double x, double y, double z) {
+      Eigen::Vector3d p;
+      p[axis] = z;
+      p[(axis + 1) % 3] = x;
+      p[(axis + 2) % 3] = y;
+      return p;
+    };
+
+    const int n = SDF_SURFACE_CIRCLE_SEGMENTS;
+    Eigen::Vector3d bottom_center = point(0, 0, -half_height), top_center = point(0, 0, half_height);
+    for (int i = 0; i < n; ++i)
+    {
+      double c0 = std::cos(2 * M_PI * i / n), s0 = std::sin(2 * M_PI * i / n);
+      double c1 = std::cos(2 * M_PI * (i + 1) / n), s1 = std::sin(2 * M_PI * (i + 1) / n);
+      Eigen::Vector3d b0 = point(bottom_radius * c0, bottom_radius * s0, -half_height);
+      Eigen::Vector3d b1 = point(bottom_radius * c1, bottom_radius * s1, -half_height);
+      Eigen::Vector3d t0 = point(top_radius * c0, top_radius * s0, half_height);
+      Eigen::Vector3d t1 = point(top_radius * c1, top_radius * s1, half_height);
+      addTriangle(bottom_center, b1, b0);
+      addTriangle(b0, b1, t1);
+      if (top_radius > 0)
+      {
+        addTriangle(b0, t1, t0);
+        addTriangle(top_center, t0, t1);
+      }
+    }
+
+    margin = std::max(margin, std::max(bottom_radius, top_radius) * (1 - std::cos(M_PI / n)));
+  }
+};
+
+/**
+ * @brief Add the sample spheres covering the part of a triangle which may be closer to a field than the best sample
+ *
+ * The triangle is split in two at the middle of its longest edge until its edges are no longer than the resolution
+ * of the field, which keeps thin triangles from being split into even thinner ones. A triangle is inside of the
+ * sphere around its centroid through its farthest corner, which bounds the distance of all of its points, so it is
+ * skipped if even that bound is beyond the best distance found so far.
+ *
+ * @param best The distance beyond which samples are not needed, it is lowered to the distance of every new sample
+ */
+inline void addSignedDistanceFieldTriangleSamples(const SignedDistanceField& field,
+                                                  const Eigen::Vector3d& a,
+                                                  const Eigen::Vector3d& b,
+                                                  const Eigen::Vector3d& c,
+                                                  double radius,
+                                                  double& best,
+                                                  VectorVector3d& centers,
+                                                  std::vector<double>& radii)
+{
+  Eigen::Vector3d centroid = (a + b + c) / 3;
+  double bound = std::sqrt(std::max({ (a - centroid).squaredNorm(), (b - centroid).squaredNorm(),
+                                      (c - centroid).squaredNorm() }));
+  double distance = field.getDistance(centroid) - radius;
+  if (distance - SDF_LIPSCHITZ_CONSTANT * bound > best)
+    return;
+
+  const double ab = (b - a).squaredNorm(), bc = (c - b).squaredNorm(), ca = (a - c).squaredNorm();
+  if (std::max({ ab, bc, ca }) <= field.getResolution() * field.getResolution())
+  {
+    centers.push_back(centroid);
+    radii.push_back(bound + radius);
+    best = std::min(best, distance - bound);
+    return;
+  }
+
+  if (ab >= bc && ab >= ca)
+  {
+    addSignedDistanceFieldTriangleSamples(field, a, (a + b) / 2, c, radius, best, centers, radii);
+    addSignedDistanceFieldTriangleSamples(field, (a + b) / 2, b, c, radius, best, centers, radii);
+  }
+  else if (bc >= ca)
+  {
+    addSignedDistanceFieldTriangleSamples(field, a, b, (b + c) / 2, radius, best, centers, radii);
+    addSignedDistanceFieldTriangleSamples(field, a, (b + c) / 2, c, radius, best, centers, radii);
+  }
+  else
+  {
+    addSignedDistanceFieldTriangleSamples(field, a, b, (c + a) / 2, radius, best, centers, radii);
+    addSignedDistanceFieldTriangleSamples(field, (c + a) / 2, b, c, radius, best, centers, radii);
+  }
+}
+
+/** @brief Same as addSignedDistanceFieldTriangleSamples() for the sphere of the given radius swept from p to q */
+inline void addSignedDistanceFieldSegmentSamples(const SignedDistanceField& field,
+                                                 const Eigen::Vector3d& p,
+                                                 const Eigen::Vector3d& q,
+                                                 double radius,
+                                                 double& best,
+                                                 VectorVector3d& centers,
+                                                 std::vector<double>& radii)
+{
+  Eigen::Vector3d center = (p + q) / 2;
+  double bound = (q - p).norm() / 2;
+  double distance = field.getDistance(center) - radius;
+  if (distance - SDF_LIPSCHITZ_CONSTANT * bound > best)
+    return;
+
+  if (2 * bound <= field.getResolution())
+  {
+    centers.push_back(center);
+    radii.push_back(bound + radius);
+    best = std::min(best, distance - bound);
+    return;
+  }
+
+  addSignedDistanceFieldSegmentSamples(field, p, center, radius, best, centers, radii);
+  addSignedDistanceFieldSegmentSamples(field, center, q, radius, best, centers, radii);
+}
+
+/**
+ * @brief Add the sample spheres of a surface to a signed distance field query
+ *
+ * The samples cover the surface at the resolution of the field, so the closest sample never overestimates the
+ * distance of the surface. Parts of the surface which can not be closer than the threshold or an earlier sample
+ * are skipped.
+ *
+ * @param field The signed distance field
+ * @param surface The surface in its own frame
+ * @param tf The transform from the surface to the field
+ * @param threshold The distance beyond which samples are not needed, it is lowered to the closest sample added
+ * @param centers (Output) The centers of the sample spheres in the frame of the field
+ * @param radii (Output) The radii of the sample spheres
+ */
+inline void addSignedDistanceFieldSamples(const SignedDistanceField& field,
+                                          const SignedDistanceFieldSurface& surface,
+                                          const Eigen::Isometry3d& tf,
+                                          double& threshold,
+                                          VectorVector3d& centers,
+                                          std::vector<double>& radii)
+{
+  auto vertex = [&](int i) -> Eigen::Vector3d { return tf * surface.vertices[static_cast<std::size_t>(i)]; };
+
+  for (std::size_t i = 0; i + 2 < surface.triangles.size(); i += 3)
+    addSignedDistanceFieldTriangleSamples(field,
+                                          vertex(surface.triangles[i]),
+                                          vertex(surface.triangles[i + 1]),
+                                          vertex(surface.triangles[i + 2]),
+                                          surface.margin,
+                                          threshold,
+                                          centers,
+                                          radii);
+
+  for (std::size_t i = 0; i < surface.radii.size(); ++i)
+    addSignedDistanceFieldSegmentSamples(field,
+                                         vertex(surface.segments[2 * i]),
+                                         vertex(surface.segments[2 * i + 1]),
+                                         surface.radii[i],
+                                         threshold,
+                                         centers,
+                                         radii);
+}
+
+/** @brief Get the closest point on the triangle a, b, c to the point p */
+inline Eigen::Vector3d getClosestPointOnTriangle(const Eigen::Vector3d& p,
+                                                 const Eigen::Vector3d& a,
+                                                 const Eigen::Vector3d& b,
+                                                 const Eigen::Vector3d& c)
+{
+  Eigen::Vector3d ab = b - a, ac = c - a, ap = p - a;
+  double d1 = ab.dot(ap), d2 = ac.dot(ap);
+  if (d1 <= 0 && d2 <= 0)
+    return a;
+
+  Eigen::Vector3d bp = p - b;
+  double d3 = ab.dot(bp), d4 = ac.dot(bp);
+  if (d3 >= 0 && d4 <= d3)
+    return b;
+
+  double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0 && d1 >= 0 && d3 <= 0)
+    return a + (d1 / (d1 - d3)) * ab;
+
+  Eigen::Vector3d cp = p - c;
+  double d5 = ab.dot(cp), d6 = ac.dot(cp);
+  if (d6 >= 0 && d5 <= d6)
+    return c;
+
+  double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0 && d2 >= 0 && d6 <= 0)
+    return a + (d2 / (d2 - d6)) * ac;
+
+  double va = d3 * d6 - d5 * d4;
+  if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+    return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+
+  // The closest point is inside of the face
+  if (va + vb + vc == 0)
+    return a;
+
+  double denom = 1 / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/**
+ * @brief Get twice the signed area of the 2D triangle (0, 0), (x1, y1), (x2, y2)
+ *
+ * Ties are broken consistently by simulation of simplicity, so an edge shared by two triangles is only
+ * ever inside of one of them.
+ *
+ * @return The sign of the area, only zero if the two points are equal
+ */
+inline int getSignedDistanceFieldOrientation(double x1, double y1, double x2, double y2, double& twice_signed_area)
+{
+  twice_signed_area = y1 * x2 - x1 * y2;
+  if (twice_signed_area > 0)
+    return 1;
+  if (twice_signed_area < 0)
+    return -1;
+  if (y2 > y1)
+    return 1;
+  if (y2 < y1)
+    return -1;
+  if (x1 > x2)
+    return 1;
+  if (x1 < x2)
+    return -1;
+  return 0;
+}
+
+/**
+ * @brief Check if the 2D point (x0, y0) is inside of a 2D triangle using consistent tie breaking
+ * @param w (Output) The barycentric coordinates of the point if it is inside
+ * @return True if the point is inside of the triangle
+ */
+inline bool isPointInTriangle2D(double x0,
+                                double y0,
+                                const Eigen::Vector2d& a,
+                                const Eigen::Vector2d& b,
+                                const Eigen::Vector2d& c,
+                                Eigen::Vector3d& w)
+{
+  Eigen::Vector2d p0(x0, y0);
+  Eigen::Vector2d p1 = a - p0, p2 = b - p0, p3 = c - p0;
+  int sign_a = getSignedDistanceFieldOrientation(p2[0], p2[1], p3[0], p3[1], w[0]);
+  if (sign_a == 0)
+    return false;
+
+  int sign_b = getSignedDistanceFieldOrientation(p3[0], p3[1], p1[0], p1[1], w[1]);
+  if (sign_b != sign_a)
+    return false;
+
+  int sign_c = getSignedDistanceFieldOrientation(p1[0], p1[1], p2[0], p2[1], w[2]);
+  if (sign_c != sign_a)
+    return false;
+
+  w /= w.sum();
+  return true;
+}
+
+/**
+ * @brief Create a signed distance field from a closed triangle mesh
+ *
+ * Exact distances are computed in a band of one sample around each triangle and propagated to the rest of
+ * the grid by fast sweeping of the closest triangle. The sign is found by counting the crossings of the
+ * surface along each row of the grid, so the mesh must be closed, every edge must be shared by an even number of
+ * triangles.
+ *
+ * @param vertices The vertices of the mesh
+ * @param triangles The vertex indices of the triangles, three per triangle
+ * @param resolution The distance between samples, it is increased if the grid would exceed SDF_MAX_SAMPLES
+ * @param padding The distance the grid extends beyond the bounds of the mesh
+ * @return The signed distance field, nullptr if the mesh is empty or not closed
+ */
+inline SignedDistanceFieldPtr createSignedDistanceField(const VectorVector3d& vertices,
+                                                        const std::vector<int>& triangles,
+                                                        double resolution = SDF_DEFAULT_RESOLUTION,
+                                                        double padding = SDF_DEFAULT_PADDING)
+{
+  if (vertices.empty() || triangles.size() < 3)
+  {
+    ROS_ERROR("Unable to create a signed distance field from an empty mesh");
+    return nullptr;
+  }
+
+  // The crossings of an open surface do not tell inside from outside
+  std::vector<std::pair<int, int>> edges;
+  edges.reserve(triangles.size());
+  for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    for (std::size_t j = 0; j < 3; ++j)
+      edges.push_back(std::minmax(triangles[i + j], triangles[i + (j + 1) % 3]));
+
+  std::sort(edges.begin(), edges.end());
+  for (std::size_t i = 0, j = 0; i < edges.size(); i = j)
+  {
+    while (j < edges.size() && edges[j] == edges[i])
+      ++j;
+
+    if ((j - i) % 2 != 0)
+    {
+      ROS_ERROR("Unable to create a signed distance field, the mesh is not closed");
+      return nullptr;
+    }
+  }
+
+  Eigen::Vector3d aabb_min = vertices[0], aabb_max = vertices[0];
+  for (const auto& v : vertices)
+  {
+    aabb_min = aabb_min.cwiseMin(v);
+    aabb_max = aabb_max.cwiseMax(v);
+  }
+  aabb_min.array() -= padding;
+  aabb_max.array() += padding;
+
+  Eigen::Vector3d extents = aabb_max - aabb_min;
+  resolution = std::max(resolution, extents.maxCoeff() / (SDF_MAX_SAMPLES - 1));
+
+  Eigen::Vector3i size;
+  for (int a = 0; a < 3; ++a)
+    size[a] = std::max(2, std::min(SDF_MAX_SAMPLES, static_cast<int>(std::ceil(extents[a] / resolution)) + 1));
+
+  SignedDistanceFieldPtr sdf(new SignedDistanceField(aabb_min, resolution, size));
+
+  // The computation is done in grid coordinates so samples are at integer positions
+  VectorVector3d points(vertices.size());
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+    points[i] = (vertices[i] - aabb_min) / resolution;
+
+  const int nx = size[0], ny = size[1], nz = size[2];
+  const std::size_t num_samples = static_cast<std::size_t>(nx) * static_cast<std::size_t>(ny) * static_cast<std::size_t>(nz);
+  std::vector<double> distances(num_samples, std::numeric_limits<double>::max());
+  std::vector<int> closest(num_samples, -1);
+  std::vector<int> crossings(num_samples, 0);
+  auto index = [nx, ny](int x, int y, int z) {
+    return (static_cast<std::size_t>(z) * static_cast<std::size_t>(ny) + static_cast<std::size_t>(y)) *
+               static_cast<std::size_t>(nx) + static_cast<std::size_t>(x);
+  };
+
+  auto distance = [&points, &triangles](const Eigen::Vector3d& p, int t) {
+    const Eigen::Vector3d& a = points[static_cast<std::size_t>(triangles[3 * static_cast<std::size_t>(t)])];
+    const Eigen::Vector3d& b = points[static_cast<std::size_t>(triangles[3 * static_cast<std::size_t>(t) + 1])];
+    const Eigen::Vector3d& c = points[static_cast<std::size_t>(triangles[3 * static_cast<std::size_t>(t) + 2])];
+    return (p - getClosestPointOnTriangle(p, a, b, c)).norm();
+  };
+
+  const int num_triangles = static_cast<int>(triangles.size() / 3);
+  for (int t = 0; t < num_triangles; ++t)
+  {
+    const int* tri = &triangles[3 * static_cast<std::size_t>(t)];
+    if (std::any_of(tri, tri + 3, [&points](int v) { return v < 0 || static_cast<std::size_t>(v) >= points.size(); }))
+    {
+      ROS_ERROR("Unable to create a signed distance field, the mesh has an invalid vertex index");
+      return nullptr;
+    }
+
+    const Eigen::Vector3d& a = points[static_cast<std::size_t>(tri[0])];
+    const Eigen::Vector3d& b = points[static_cast<std::size_t>(tri[1])];
+    const Eigen::Vector3d& c = points[static_cast<std::size_t>(tri[2])];
+    Eigen::Vector3d tri_min = a.cwiseMin(b).cwiseMin(c), tri_max = a.cwiseMax(b).cwiseMax(c);
+
+    // Exact distances in a band of one sample around the triangle
+    int lo[3], hi[3];
+    for (int d = 0; d < 3; ++d)
+    {
+      lo[d] = std::max(0, std::min(size[d] - 1, static_cast<int>(std::floor(tri_min[d])) - 1));
+      hi[d] = std::max(0, std::min(size[d] - 1, static_cast<int>(std::ceil(tri_max[d])) + 1));
+    }
+
+    for (int z = lo[2]; z <= hi[2]; ++z)
+      for (int y = lo[1]; y <= hi[1]; ++y)
+        for (int x = lo[0]; x <= hi[0]; ++x)
+        {
+          std::size_t i = index(x, y, z);
+          double d = distance(Eigen::Vector3d(x, y, z), t);
+          if (d < distances[i])
+          {
+            distances[i] = d;
+            closest[i] = t;
+          }
+        }
+
+    // Count the crossings of the rows along x, stored at the first sample past the crossing
+    int y_lo = std::max(0, static_cast<int>(std::ceil(tri_min[1])));
+    int y_hi = std::min(ny - 1, static_cast<int>(std::floor(tri_max[1])));
+    int z_lo = std::max(0, static_cast<int>(std::ceil(tri_min[2])));
+    int z_hi = std::min(nz - 1, static_cast<int>(std::floor(tri_max[2])));
+    Eigen::Vector2d a2(a[1], a[2]), b2(b[1], b[2]), c2(c[1], c[2]);
+    for (int z = z_lo; z <= z_hi; ++z)
+      for (int y = y_lo; y <= y_hi; ++y)
+      {
+        Eigen::Vector3d w;
+        if (!isPointInTriangle2D(y, z, a2, b2, c2, w))
+          continue;
+
+        int x = static_cast<int>(std::ceil(w[0] * a[0] + w[1] * b[0] + w[2] * c[0]));
+        if (x < nx)
+          ++crossings[index(std::max(x, 0), y, z)];
+      }
+  }
+
+  // Propagate the closest triangle to the rest of the grid
+  auto check = [&](std::size_t i, const Eigen::Vector3d& p, int x, int y, int z) {
+    int t = closest[index(x, y, z)];
+    if (t >= 0 && t != closest[i])
+    {
+      double d = distance(p, t);
+      if (d < distances[i])
+      {
+        distances[i] = d;
+        closest[i] = t;
+      }
+    }
+  };
+
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (int sweep = 0; sweep < 8; ++sweep)
+    {
+      const int dx = (sweep & 1) ? -1 : 1, dy = (sweep & 2) ? -1 : 1, dz = (sweep & 4) ? -1 : 1;
+      const int x0 = dx > 0 ? 1 : nx - 2, x1 = dx > 0 ? nx : -1;
+      const int y0 = dy > 0 ? 1 : ny - 2, y1 = dy > 0 ? ny : -1;
+      const int z0 = dz > 0 ? 1 : nz - 2, z1 = dz > 0 ? nz : -1;
+      for (int z = z0; z != z1; z += dz)
+        for (int y = y0; y != y1; y += dy)
+          for (int x = x0; x != x1; x += dx)
+          {
+            std::size_t i = index(x, y, z);
+            Eigen::Vector3d p(x, y, z);
+            check(i, p, x - dx, y, z);
+            check(i, p, x, y - dy, z);
+            check(i, p, x - dx, y - dy, z);
+            check(i, p, x, y, z - dz);
+            check(i, p, x - dx, y, z - dz);
+            check(i, p, x, y - dy, z - dz);
+            check(i, p, x - dx, y - dy, z - dz);
+          }
+    }
+  }
+
+  // An odd number of crossings before a sample along its row means it is inside
+  for (int z = 0; z < nz; ++z)
+    for (int y = 0; y < ny; ++y)
+    {
+      int count = 0;
+      for (int x = 0; x < nx; ++x)
+      {
+        std::size_t i = index(x, y, z);
+        count += crossings[i];
+        double d = distances[i] * resolution;
+        sdf->setSample(x, y, z, static_cast<float>((count % 2 == 1) ? -d : d));
+      }
+    }
+
+  return sdf;
+}
+
+/** @brief The header of a signed distance field stored in the geometry cache, the samples follow it */
+struct SignedDistanceFieldCacheHeader
+{
+  std::int32_t size[3];     /**< @brief The number of samples along each axis */
+  std::int32_t padding[13]; /**< @brief Unused, aligns the samples which follow the header */
+  double origin[3];         /**< @brief The position of the first sample */
+  double resolution;        /**< @brief The distance between samples */
+};
+
+/**
+ * @brief Same as createSignedDistanceField() but the result is stored in the geometry cache and loaded on later calls
+ *
+ * A cached field uses the samples of the memory mapped cache file in place. The 32 byte file header and the
+ * 96 byte field header keep the rows aligned to SDF_ALIGNMENT.
+ */
+inline SignedDistanceFieldPtr createCachedSignedDistanceField(const VectorVector3d& vertices,
+                                                              const std::vector<int>& triangles,
+                                                              double resolution = SDF_DEFAULT_RESOLUTION,
+                                                              double padding = SDF_DEFAULT_PADDING)
+{
+  static_assert((sizeof(GeometryCacheFileHeader) + sizeof(SignedDistanceFieldCacheHeader)) % SDF_ALIGNMENT == 0,
+                "The samples of a cached signed distance field must be aligned");
+
+  const std::uint32_t format = 1;
+  double params[3] = { resolution, padding, static_cast<double>(SDF_MAX_SAMPLES) };
+  GeometryCacheKey key;
+  key.add(params, sizeof(params));
+  key.add(vertices);
+  key.add(triangles.data(), triangles.size() * sizeof(int));
+  std::string path = getGeometryCacheFilePath("sdf", key);
+
+  std::size_t size;
+  std::shared_ptr<char> mapping = mapGeometryCacheFile(path, key, format, size);
+  if (mapping != nullptr && size >= sizeof(SignedDistanceFieldCacheHeader))
+  {
+    const SignedDistanceFieldCacheHeader* header =
+        reinterpret_cast<const SignedDistanceFieldCacheHeader*>(mapping.get());
+    Eigen::Vector3i grid_size(header->size[0], header->size[1], header->size[2]);
+    if (grid_size.minCoeff() >= 2 && grid_size.maxCoeff() <= SDF_MAX_SAMPLES &&
+        size == sizeof(SignedDistanceFieldCacheHeader) + SignedDistanceField::getDataSize(grid_size) * sizeof(float))
+    {
+      std::shared_ptr<float> data(mapping,
+                                  reinterpret_cast<float*>(mapping.get() + sizeof(SignedDistanceFieldCacheHeader)));
+      return std::make_shared<SignedDistanceField>(
+          Eigen::Vector3d(header->origin[0], header->origin[1], header->origin[2]),
+          header->resolution,
+          grid_size,
+          data);
+    }
+  }
+
+  SignedDistanceFieldPtr sdf = createSignedDistanceField(vertices, triangles, resolution, padding);
+  if (sdf == nullptr || path.empty())
+    return sdf;
+
+  std::size_t data_size = SignedDistanceField::getDataSize(sdf->getSize()) * sizeof(float);
+  std::vector<char> payload(sizeof(SignedDistanceFieldCacheHeader) + data_size);
+  SignedDistanceFieldCacheHeader* header = reinterpret_cast<SignedDistanceFieldCacheHeader*>(payload.data());
+  for (int a = 0; a < 3; ++a)
+  {
+    header->size[a] = sdf->getSize()[a];
+    header->origin[a] = sdf->getOrigin()[a];
+  }
+  std::memset(header->padding, 0, sizeof(header->padding));
+  header->resolution = sdf->getResolution();
+  std::memcpy(payload.data() + sizeof(SignedDistanceFieldCacheHeader), sdf->getData(), data_size);
+
+  writeGeometryCacheFile(path, key, format, payload.data(), payload.size());
+  return sdf;
+}
+
+/** @brief Create a signed distance field from a closed mesh using the default resolution and the geometry cache */
+inline SignedDistanceFieldPtr createCachedSignedDistanceField(const shapes::Mesh& mesh)
+{
+  VectorVector3d vertices;
+  vertices.reserve(mesh.vertex_count);
+  for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+    vertices.push_back(Eigen::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]));
+
+  std::vector<int> triangles(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+  return createCachedSignedDistanceField(vertices, triangles);
+}
+}
+
+#endif  // TESSERACT_COLLISION_SIGNED_DISTANCE_FIELD_H
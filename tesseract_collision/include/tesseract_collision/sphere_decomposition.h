@@ -0,0 +1,216 @@
+/**
+ * @file sphere_decomposition.h
+ * @brief Approximate meshes by a set of spheres for the MultiSphere collision object type
+ *
+ * @date Oct 16, 2018
+ * @version TODO
+ * @bug No known bugs
+ *
+ * @copyright Copyright (c) 2017, Southwest Research Institute
+ *
+ * @par License
+ * Software License Agreement (Apache License)
+ * @par
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * @par
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TESSERACT_COLLISION_SPHERE_DECOMPOSITION_H
+#define TESSERACT_COLLISION_SPHERE_DECOMPOSITION_H
+
+#include <tesseract_collision/signed_distance_field.h>
+
+namespace tesseract
+{
+/** @brief The default maximum distance a sphere decomposition extends beyond the mesh */
+const double SPHERE_DECOMPOSITION_DEFAULT_MAX_ERROR = 0.01;
+
+/** @brief The default maximum number of spheres of a sphere decomposition */
+const int SPHERE_DECOMPOSITION_DEFAULT_MAX_SPHERES = 100;
+
+/** @brief The parameters of the sphere decomposition of MultiSphere meshes */
+struct SphereDecompositionSettings
+{
+  double max_error; /**< @brief The maximum distance the spheres extend beyond the mesh */
+  int max_spheres;  /**< @brief The maximum number of spheres, the error is increased if it is exceeded */
+
+  SphereDecompositionSettings()
+    : max_error(SPHERE_DECOMPOSITION_DEFAULT_MAX_ERROR), max_spheres(SPHERE_DECOMPOSITION_DEFAULT_MAX_SPHERES)
+  {
+  }
+};
+
+/** @brief The process wide sphere decomposition settings */
+struct SphereDecompositionState
+{
+  std::mutex mutex;                     /**< @brief Protects the settings */
+  SphereDecompositionSettings settings; /**< @brief The settings used for MultiSphere meshes */
+};
+
+TESSERACT_COLLISION_SHARED_STATE inline SphereDecompositionState& getSphereDecompositionState()
+{
+  static SphereDecompositionState state;
+  return state;
+}
+
+/** @brief Get the settings used for the sphere decomposition of MultiSphere meshes */
+inline SphereDecompositionSettings getSphereDecompositionSettings()
+{
+  SphereDecompositionState& state = getSphereDecompositionState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.settings;
+}
+
+/**
+ * @brief Set the settings used for the sphere decomposition of MultiSphere meshes
+ *
+ * They only apply to collision objects created afterwards. Geometry in the shape cache is only shared with objects
+ * created with the same settings. Changing them while collision objects are created from another thread is not
+ * supported.
+ *
+ * @param settings The settings
+ */
+inline void setSphereDecompositionSettings(const SphereDecompositionSettings& settings)
+{
+  SphereDecompositionState& state = getSphereDecompositionState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.settings = settings;
+}
+
+/**
+ * @brief Approximate a closed mesh by a set of spheres which contains it
+ *
+ * The mesh is converted to a signed distance field with a resolution derived from the maximum error. Every
+ * sample inside of the mesh (or within half a cell diagonal of it) must be covered by a sphere. Samples are
+ * visited from the deepest to the shallowest and every sample which is not covered yet becomes the center of a
+ * sphere whose radius is its depth plus the error budget, so no sphere extends further than the maximum error
+ * beyond the mesh. If more than max_spheres are needed the error is increased until they fit.
+ *
+ * @param centers (Output) The centers of the spheres
+ * @param radii (Output) The radii of the spheres
+ * @param vertices The vertices of the mesh
+ * @param triangles The vertex indices of the triangles, three per triangle
+ * @param max_error The maximum distance the spheres extend beyond the mesh
+ * @param max_spheres The maximum number of spheres
+ * @return The number of spheres, -1 if the mesh is empty
+ */
+inline int createSphereDecomposition(VectorVector3d& centers,
+                                     std::vector<double>& radii,
+                                     const VectorVector3d& vertices,
+                                     const std::vector<int>& triangles,
+                                     double max_error = SPHERE_DECOMPOSITION_DEFAULT_MAX_ERROR,
+                                     int max_spheres = SPHERE_DECOMPOSITION_DEFAULT_MAX_SPHERES)
+{
+  centers.clear();
+  radii.clear();
+
+  // Half of the error budget is used by the grid, the resolution is increased for large meshes
+  double resolution = max_error / std::sqrt(3.0);
+  SignedDistanceFieldConstPtr sdf = createCachedSignedDistanceField(vertices, triangles, resolution, 2 * resolution);
+  if (sdf == nullptr)
+    return -1;
+
+  resolution = sdf->getResolution();
+  const double slack = resolution * std::sqrt(3.0) / 2;
+  const Eigen::Vector3i& size = sdf->getSize();
+
+  // Every point inside of the mesh is within half a cell diagonal (slack) of a sample whose distance is at most
+  // slack. Covering these samples by spheres shrunk by slack covers the mesh, samples are sorted by depth.
+  struct Target
+  {
+    int x, y, z;
+    double depth; /**< @brief The negated signed distance of the sample */
+  };
+
+  std::vector<Target> targets;
+  for (int z = 0; z < size[2]; ++z)
+    for (int y = 0; y < size[1]; ++y)
+      for (int x = 0; x < size[0]; ++x)
+      {
+        double distance = sdf->getSample(x, y, z);
+        if (distance <= slack)
+          targets.push_back(Target{ x, y, z, -distance });
+      }
+
+  std::stable_sort(
+      targets.begin(), targets.end(), [](const Target& a, const Target& b) { return a.depth > b.depth; });
+
+  auto index = [&size](int x, int y, int z) {
+    return (static_cast<std::size_t>(z) * static_cast<std::size_t>(size[1]) + static_cast<std::size_t>(y)) *
+               static_cast<std::size_t>(size[0]) + static_cast<std::size_t>(x);
+  };
+
+  std::vector<unsigned char> covered(static_cast<std::size_t>(size.prod()));
+  // The error must be at least slack so that every sample covers itself
+  double error = std::max(slack, max_error - slack);
+  for (;;)
+  {
+    centers.clear();
+    radii.clear();
+    std::fill(covered.begin(), covered.end(), 0);
+
+    for (const Target& target : targets)
+    {
+      if (covered[index(target.x, target.y, target.z)])
+        continue;
+
+      if (static_cast<int>(centers.size()) >= max_spheres)
+        break;
+
+      double radius = target.depth + error + slack;
+      Eigen::Vector3d center = sdf->getOrigin() + resolution * Eigen::Vector3d(target.x, target.y, target.z);
+      centers.push_back(center);
+      radii.push_back(radius);
+
+      // Mark the samples inside of the sphere shrunk by slack as covered
+      double covered_radius = (radius - slack) / resolution;
+      int cells = static_cast<int>(std::floor(covered_radius));
+      double radius_sq = covered_radius * covered_radius;
+      for (int z = std::max(0, target.z - cells); z <= std::min(size[2] - 1, target.z + cells); ++z)
+        for (int y = std::max(0, target.y - cells); y <= std::min(size[1] - 1, target.y + cells); ++y)
+          for (int x = std::max(0, target.x - cells); x <= std::min(size[0] - 1, target.x + cells); ++x)
+          {
+            Eigen::Vector3d offset(x - target.x, y - target.y, z - target.z);
+            if (offset.squaredNorm() <= radius_sq)
+              covered[index(x, y, z)] = 1;
+          }
+    }
+
+    bool complete = std::all_of(
+        targets.begin(), targets.end(), [&](const Target& t) { return covered[index(t.x, t.y, t.z)] != 0; });
+    if (complete)
+      break;
+
+    error = std::max(2 * error, resolution);
+  }
+
+  if (error + slack > max_error)
+    ROS_WARN("The sphere decomposition error was increased to %f to stay within %d spheres",
+             error + slack,
+             max_spheres);
+
+  return static_cast<int>(centers.size());
+}
+
+/** @brief Approximate a closed mesh by a set of spheres using the process wide settings */
+inline int createSphereDecomposition(VectorVector3d& centers, std::vector<double>& radii, const shapes::Mesh& mesh)
+{
+  VectorVector3d vertices;
+  vertices.reserve(mesh.vertex_count);
+  for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+    vertices.push_back(Eigen::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]));
+
+  std::vector<int> triangles(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+  SphereDecompositionSettings settings = getSphereDecompositionSettings();
+  return createSphereDecomposition(centers, radii, vertices, triangles, settings.max_error, settings.max_spheres);
+}
+}
+
+#endif  // TESSERACT_COLLISION_SPHERE_DECOMPOSITION_H
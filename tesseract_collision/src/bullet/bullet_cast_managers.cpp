@@ -43,6 +43,45 @@
 
 namespace tesseract
 {
+/**
+ * @brief Add a cast shape for every occupied leaf of an octomap to a compound shape
+ * @param cow The collision object which manages the new shapes
+ * @param compound The compound shape
+ * @param octree The octomap shape
+ * @param octree_trans The transform of the octomap in the compound shape
+ */
+static void addCastOcTreeLeaves(const COWPtr& cow,
+                                btCompoundShape* compound,
+                                const OcTreeShape* octree,
+                                const btTransform& octree_trans)
+{
+  btVector3 infinity(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+  btTransform tf;
+  tf.setIdentity();
+
+  octree->processAllLeaves(
+      [&](const btVector3& center, btScalar size, int /*index*/) {
+        btConvexShape* leaf;
+        if (octree->usesSpheres())
+          leaf = new btSphereShape(octree->getLeafHalfExtent(size));
+        else
+          leaf = new btBoxShape(btVector3(size / 2, size / 2, size / 2));
+
+        leaf->setMargin(BULLET_MARGIN);
+        cow->manage(leaf);
+
+        btCollisionShape* subshape = new CastHullShape(leaf, tf);
+        subshape->setMargin(BULLET_MARGIN);
+        cow->manage(subshape);
+
+        btTransform geomTrans = octree_trans;
+        geomTrans.setOrigin(octree_trans * center);
+        compound->addChildShape(geomTrans, subshape);
+      },
+      -infinity,
+      infinity);
+}
+
 COWPtr makeCastCollisionObject(const COWPtr& cow)
 {
   COWPtr new_cow = cow->clone();
@@ -63,6 +102,17 @@ COWPtr makeCastCollisionObject(const COWPtr& cow)
     new_cow->manage(shape);
     new_cow->setCollisionShape(shape);
   }
+  else if (dynamic_cast<const OcTreeShape*>(new_cow->getCollisionShape()) != nullptr)
+  {
+    // The leaves of an octomap are cast individually
+    btCompoundShape* new_compound = new btCompoundShape(/*dynamicAABBtree=*/BULLET_COMPOUND_USE_DYNAMIC_AABB);
+    addCastOcTreeLeaves(new_cow, new_compound, static_cast<const OcTreeShape*>(new_cow->getCollisionShape()), tf);
+
+    new_compound->setMargin(BULLET_MARGIN);
+    new_cow->manage(new_compound);
+    new_cow->setCollisionShape(new_compound);
+    new_cow->setWorldTransform(cow->getWorldTransform());
+  }
   else if (btBroadphaseProxy::isCompound(new_cow->getCollisionShape()->getShapeType()))
   {
     btCompoundShape* compound = static_cast<btCompoundShape*>(new_cow->getCollisionShape());
@@ -70,6 +120,13 @@ COWPtr makeCastCollisionObject(const COWPtr& cow)
 
     for (int i = 0; i < compound->getNumChildShapes(); ++i)
     {
+      const OcTreeShape* octree = dynamic_cast<const OcTreeShape*>(compound->getChildShape(i));
+      if (octree != nullptr)
+      {
+        addCastOcTreeLeaves(new_cow, new_compound, octree, compound->getChildTransform(i));
+        continue;
+      }
+
       btConvexShape* convex = static_cast<btConvexShape*>(compound->getChildShape(i));
       assert(convex != NULL);
       assert(convex->getShapeType() !=
@@ -104,10 +161,140 @@ COWPtr makeCastCollisionObject(const COWPtr& cow)
 
   return new_cow;
 }
+
+/**
+ * @brief Copy a cast shape with its cast transforms
+ * @param shape The cast shape
+ * @return The copy, it casts the same convex shape
+ */
+static std::shared_ptr<CastHullShape> copyCastHullShape(const CastHullShape& shape)
+{
+  std::shared_ptr<CastHullShape> copy(new CastHullShape(shape.m_shape, shape.m_t01));
+  copy->m_waypoints = shape.m_waypoints;
+  copy->setMargin(shape.getMargin());
+  return copy;
+}
+
+/**
+ * @brief Copy an active (cast) collision object shared with a clone of the manager
+ *
+ * The cast shapes are updated in place when the object is moved, so the copy gets its own cast shapes. The convex
+ * shapes which are cast stay shared.
+ *
+ * @param cow The cast collision object
+ * @return The copy, with the same transform and cast transforms
+ */
+static COWPtr copyCastCollisionObject(const COWPtr& cow)
+{
+  COWPtr new_cow = cow->clone();
+
+  btCollisionShape* shape = cow->getCollisionShape();
+  if (btBroadphaseProxy::isConvex(shape->getShapeType()))
+  {
+    const CastHullShape* cast = static_cast<const CastHullShape*>(shape);
+    std::shared_ptr<CastHullShape> new_cast = copyCastHullShape(*cast);
+    new_cow->replaceManaged(cast, new_cast);
+    new_cow->setCollisionShape(new_cast.get());
+  }
+  else if (btBroadphaseProxy::isCompound(shape->getShapeType()))
+  {
+    const btCompoundShape* compound = static_cast<const btCompoundShape*>(shape);
+    std::shared_ptr<btCompoundShape> new_compound(
+        new btCompoundShape(/*dynamicAABBtree=*/BULLET_COMPOUND_USE_DYNAMIC_AABB, compound->getNumChildShapes()));
+
+    for (int i = 0; i < compound->getNumChildShapes(); ++i)
+    {
+      const CastHullShape* child = static_cast<const CastHullShape*>(compound->getChildShape(i));
+      std::shared_ptr<CastHullShape> new_child = copyCastHullShape(*child);
+      new_cow->replaceManaged(child, new_child);
+      new_compound->addChildShape(compound->getChildTransform(i), new_child.get());
+    }
+
+    new_compound->setMargin(compound->getMargin());
+    new_cow->replaceManaged(compound, new_compound);
+    new_cow->setCollisionShape(new_compound.get());
+  }
+
+  return new_cow;
+}
+
+/**
+ * @brief Update the cast shapes of an active collision object to move between two poses
+ * @param cow The active (cast) collision object
+ * @param tf1 The start pose of the collision object in world
+ * @param tf2 The end pose of the collision object in world
+ */
+static void updateCastTransform(CollisionObjectWrapper& cow, const btTransform& tf1, const btTransform& tf2)
+{
+  btCollisionShape* shape = cow.getCollisionShape();
+  if (btBroadphaseProxy::isConvex(shape->getShapeType()))
+  {
+    static_cast<CastHullShape*>(shape)->updateCastTransform(tf1.inverseTimes(tf2));
+  }
+  else if (btBroadphaseProxy::isCompound(shape->getShapeType()))
+  {
+    // Every child is cast relative to its own start pose and its bounds in the compound are updated
+    btCompoundShape* compound = static_cast<btCompoundShape*>(shape);
+    for (int i = 0; i < compound->getNumChildShapes(); ++i)
+    {
+      btTransform geom_trans = compound->getChildTransform(i);
+      CastHullShape* child = static_cast<CastHullShape*>(compound->getChildShape(i));
+      child->updateCastTransform((tf1 * geom_trans).inverseTimes(tf2 * geom_trans));
+      compound->updateChildTransform(i, geom_trans, i + 1 == compound->getNumChildShapes());
+    }
+  }
+
+  cow.setWorldTransform(tf1);
+}
+
+/**
+ * @brief Sweep the cast shapes of an active collision object over a window of consecutive poses
+ * @param cow The active (cast) collision object
+ * @param poses The poses of the collision object in world, at least two
+ */
+static void updateCastSweptTransform(CollisionObjectWrapper& cow, const VectorIsometry3d& poses)
+{
+  assert(poses.size() >= 2);
+  btAlignedObjectArray<btTransform> tfs;
+  tfs.reserve(static_cast<int>(poses.size()));
+  for (const auto& pose : poses)
+    tfs.push_back(convertEigenToBt(pose));
+
+  btAlignedObjectArray<btTransform> waypoints;
+  btCollisionShape* shape = cow.getCollisionShape();
+  if (btBroadphaseProxy::isConvex(shape->getShapeType()))
+  {
+    for (int i = 1; i < tfs.size() - 1; ++i)
+      waypoints.push_back(tfs[0].inverseTimes(tfs[i]));
+
+    static_cast<CastHullShape*>(shape)->updateCastTransforms(waypoints, tfs[0].inverseTimes(tfs[tfs.size() - 1]));
+  }
+  else if (btBroadphaseProxy::isCompound(shape->getShapeType()))
+  {
+    // Every child is swept relative to its own first pose
+    btCompoundShape* compound = static_cast<btCompoundShape*>(shape);
+    for (int i = 0; i < compound->getNumChildShapes(); ++i)
+    {
+      btTransform geom_trans = compound->getChildTransform(i);
+      btTransform child_tf0 = tfs[0] * geom_trans;
+
+      waypoints.resize(0);
+      for (int j = 1; j < tfs.size() - 1; ++j)
+        waypoints.push_back(child_tf0.inverseTimes(tfs[j] * geom_trans));
+
+      CastHullShape* child = static_cast<CastHullShape*>(compound->getChildShape(i));
+      child->updateCastTransforms(waypoints, child_tf0.inverseTimes(tfs[tfs.size() - 1] * geom_trans));
+      compound->updateChildTransform(i, geom_trans, i + 1 == compound->getNumChildShapes());
+    }
+  }
+
+  cow.setWorldTransform(tfs[0]);
+}
+
 ////////////////////////////////////////////////
 /////// BulletCastManagerSimple ////////////
 ////////////////////////////////////////////////
-BulletCastSimpleManager::BulletCastSimpleManager()
+BulletCastSimpleManager::BulletCastSimpleManager() : coll_config_(getCollisionConstructionInfo())
 {
   dispatcher_.reset(new btCollisionDispatcher(&coll_config_));
 
@@ -116,27 +303,31 @@ BulletCastSimpleManager::BulletCastSimpleManager()
       BOX_SHAPE_PROXYTYPE,
       coll_config_.getCollisionAlgorithmCreateFunc(CONVEX_SHAPE_PROXYTYPE, CONVEX_SHAPE_PROXYTYPE));
 
+  registerCustomCollisionAlgorithms(dispatcher_.get());
+
   dispatcher_->setDispatcherFlags(dispatcher_->getDispatcherFlags() &
                                   ~btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD);
+
+  link_registry_.reset(new NameRegistry());
+  stats_enabled_ = false;
+  owner_tag_ = createOwnerTag();
 }
 
 ContinuousContactManagerBasePtr BulletCastSimpleManager::clone() const
 {
   BulletCastSimpleManagerPtr manager(new BulletCastSimpleManager());
-
-  for (const auto& cow : link2cow_)
-  {
-    COWPtr new_cow = cow.second->clone();
-
-    assert(new_cow->getCollisionShape());
-    assert(new_cow->getCollisionShape()->getShapeType() != CUSTOM_CONVEX_SHAPE_TYPE);
-
-    new_cow->setWorldTransform(cow.second->getWorldTransform());
-
-    new_cow->setContactProcessingThreshold(request_.contact_distance);
-    manager->addCollisionObject(new_cow);
-  }
-  manager->setContactRequest(request_);
+  manager->setLinkRegistry(link_registry_);
+  manager->setStatisticsEnabled(stats_enabled_);
+
+  // The collision objects and the cast collision objects are shared, they are copied by the first manager modifying
+  // them
+  owner_tag_ = createOwnerTag();
+  manager->link2cow_ = link2cow_;
+  manager->link2castcow_ = link2castcow_;
+  manager->id2cow_ = id2cow_;
+  manager->id2castcow_ = id2castcow_;
+  manager->cows_ = cows_;
+  manager->request_ = request_;
   return manager;
 }
 
@@ -171,6 +362,7 @@ bool BulletCastSimpleManager::removeCollisionObject(const std::string& name)
   if (it != link2cow_.end())
   {
     cows_.erase(std::find(cows_.begin(), cows_.end(), it->second));
+    unindexCollisionObject(id2cow_, *it->second);
     link2cow_.erase(name);
     removed = true;
   }
@@ -179,6 +371,7 @@ bool BulletCastSimpleManager::removeCollisionObject(const std::string& name)
   if (it2 != link2castcow_.end())
   {
     cows_.erase(std::find(cows_.begin(), cows_.end(), it2->second));
+    unindexCollisionObject(id2castcow_, *it2->second);
     link2castcow_.erase(name);
     removed = true;
   }
@@ -192,14 +385,18 @@ bool BulletCastSimpleManager::enableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = true;
+    if (!it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = true;
+
     enabled = true;
   }
 
   auto it2 = link2castcow_.find(name);
   if (it2 != link2castcow_.end())
   {
-    it2->second->m_enabled = true;
+    if (!it2->second->m_enabled)
+      getWritableCollisionObject(it2->second).m_enabled = true;
+
     enabled = true;
   }
 
@@ -212,27 +409,80 @@ bool BulletCastSimpleManager::disableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = false;
+    if (it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = false;
+
     disabled = true;
   }
 
   auto it2 = link2castcow_.find(name);
   if (it2 != link2castcow_.end())
   {
-    it2->second->m_enabled = true;
+    if (it2->second->m_enabled)
+      getWritableCollisionObject(it2->second).m_enabled = false;
+
     disabled = true;
   }
 
   return disabled;
 }
 
+bool BulletCastSimpleManager::updateCollisionObjectOcTree(const std::string& name,
+                                                          const VectorVector3d& occupied_voxels,
+                                                          const VectorVector3d& free_voxels)
+{
+  // The AABBs are computed on every contact test
+  auto it = link2cow_.find(name);
+  if (it == link2cow_.end() || !hasOcTreeShapes(*it->second))
+    return false;
+
+  // The cast object of an active octomap holds a copy of its leaves
+  if (link2castcow_.find(name) != link2castcow_.end())
+  {
+    ROS_WARN("The octomap of the active collision object %s can not be updated", name.c_str());
+    return false;
+  }
+
+  // Shared collision objects are copied first, the updated shapes are copies too
+  return updateOcTreeShapes(getWritableCollisionObject(it->second), occupied_voxels, free_voxels);
+}
+
 void BulletCastSimpleManager::setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose)
 {
   // TODO: Find a way to remove this check. Need to store information in Tesseract EnvState indicating transforms with
   // geometry
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
-    it->second->setWorldTransform(convertEigenToBt(pose));
+    setCollisionObjectsTransform(it->second->getLinkId(), pose);
+}
+
+void BulletCastSimpleManager::setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose)
+{
+  const COWPtr& cow = getCollisionObject(id2cow_, link_id);
+  if (!cow)
+    return;
+
+  btTransform transform = convertEigenToBt(pose);
+  if (!(transform == cow->getWorldTransform()))
+    getWritableCollisionObject(cow).setWorldTransform(transform);
+}
+
+void BulletCastSimpleManager::setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                                           const VectorIsometry3d& poses)
+{
+  assert(link_ids.size() == poses.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], poses[i]);
+}
+
+void BulletCastSimpleManager::setCollisionObjectsTransform(const VectorIsometry3d& link_transforms)
+{
+  const std::size_t size = std::min(id2cow_.size(), link_transforms.size());
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    if (id2cow_[i])
+      setCollisionObjectsTransform(static_cast<int>(i), link_transforms[i]);
+  }
 }
 
 void BulletCastSimpleManager::setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -257,17 +507,31 @@ void BulletCastSimpleManager::setCollisionObjectsTransform(const std::string& na
   // geometry
   auto it = link2castcow_.find(name);
   if (it != link2castcow_.end())
-  {
-    assert(it->second->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter);
+    setCollisionObjectsTransform(it->second->getLinkId(), pose1, pose2);
+}
 
-    btTransform tf1 = convertEigenToBt(pose1);
-    btTransform tf2 = convertEigenToBt(pose2);
+void BulletCastSimpleManager::setCollisionObjectsTransform(int link_id,
+                                                           const Eigen::Isometry3d& pose1,
+                                                           const Eigen::Isometry3d& pose2)
+{
+  const COWPtr& cow = getCollisionObject(id2castcow_, link_id);
+  if (cow)
+  {
+    assert(cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter);
 
-    static_cast<tesseract::CastHullShape*>(it->second->getCollisionShape())->updateCastTransform(tf1.inverseTimes(tf2));
-    it->second->setWorldTransform(tf1);
+    updateCastTransform(getWritableCollisionObject(cow), convertEigenToBt(pose1), convertEigenToBt(pose2));
   }
 }
 
+void BulletCastSimpleManager::setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                                           const VectorIsometry3d& pose1,
+                                                           const VectorIsometry3d& pose2)
+{
+  assert(link_ids.size() == pose1.size() && link_ids.size() == pose2.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], pose1[i], pose2[i]);
+}
+
 void BulletCastSimpleManager::setCollisionObjectsTransform(const std::vector<std::string>& names,
                                                            const VectorIsometry3d& pose1,
                                                            const VectorIsometry3d& pose2)
@@ -277,6 +541,24 @@ void BulletCastSimpleManager::setCollisionObjectsTransform(const std::vector<std
     setCollisionObjectsTransform(names[i], pose1[i], pose2[i]);
 }
 
+void BulletCastSimpleManager::setCollisionObjectsSweptTransform(const std::string& name,
+                                                                const VectorIsometry3d& poses)
+{
+  auto it = link2castcow_.find(name);
+  if (it != link2castcow_.end())
+    setCollisionObjectsSweptTransform(it->second->getLinkId(), poses);
+}
+
+void BulletCastSimpleManager::setCollisionObjectsSweptTransform(int link_id, const VectorIsometry3d& poses)
+{
+  const COWPtr& cow = getCollisionObject(id2castcow_, link_id);
+  if (cow)
+  {
+    assert(cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter);
+    updateCastSweptTransform(getWritableCollisionObject(cow), poses);
+  }
+}
+
 void BulletCastSimpleManager::setCollisionObjectsTransform(const TransformMap& pose1, const TransformMap& pose2)
 {
   assert(pose1.size() == pose2.size());
@@ -297,68 +579,42 @@ void BulletCastSimpleManager::setContactRequest(const ContactRequest& req)
   cows_.clear();
   cows_.reserve(link2cow_.size());
 
-  // Now need to update the broadphase with correct aabb
   for (auto& co : link2cow_)
   {
     COWPtr& cow = co.second;
+    if (needsRequestUpdate(request_, *cow))
+      updateCollisionObjectWithRequest(request_, getWritableCollisionObject(cow));
 
-    // Need to check if a collision object is still active
-    if (cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter)
+    bool active = (std::find(req.link_names.begin(), req.link_names.end(), cow->getName()) != req.link_names.end());
+    auto it = link2castcow_.find(cow->getName());
+    if (active)
     {
-      // Update with request
-      updateCollisionObjectWithRequest(request_, *cow);
-
-      bool still_active = (std::find_if(req.link_names.begin(), req.link_names.end(), [&](std::string link) {
-                             return link == cow->getName();
-                           }) != req.link_names.end());
-
-      if (still_active)
+      if (it == link2castcow_.end())
       {
-        // Get the existing active collision object
-        COWPtr active_cow = link2castcow_[cow->getName()];
-
-        // Update with request
-        updateCollisionObjectWithRequest(request_, *active_cow);
-
-        // Add to collision object vector
-        cows_.insert(cows_.begin(), active_cow);
+        // Create active collision object and add it to the active map
+        COWPtr active_cow = makeCastCollisionObject(cow);
+        active_cow->setOwner(owner_tag_);
+        it = link2castcow_.emplace(active_cow->getName(), active_cow).first;
+        indexCollisionObject(*link_registry_, id2castcow_, active_cow);
       }
-      else
-      {
-        // Remove the collision object from active map
-        link2castcow_.erase(cow->getName());
 
-        // Add to collision object vector
-        cows_.push_back(cow);
-      }
+      if (needsRequestUpdate(request_, *it->second))
+        updateCollisionObjectWithRequest(request_, getWritableCollisionObject(it->second));
+
+      // Add to collision object vector
+      cows_.insert(cows_.begin(), it->second);
     }
     else
     {
-      // Update with request
-      updateCollisionObjectWithRequest(request_, *cow);
-
-      bool now_active = (std::find_if(req.link_names.begin(), req.link_names.end(), [&](std::string link) {
-                           return link == cow->getName();
-                         }) != req.link_names.end());
-      if (now_active)
+      // Remove the collision object from active map
+      if (it != link2castcow_.end())
       {
-        // Create active collision object
-        COWPtr active_cow = makeCastCollisionObject(cow);
-
-        // Update with request
-        updateCollisionObjectWithRequest(request_, *active_cow);
-
-        // Add it to the active map
-        link2castcow_[active_cow->getName()] = active_cow;
-
-        // Add to collision object vector
-        cows_.insert(cows_.begin(), active_cow);
-      }
-      else
-      {
-        // Add to collision object vector
-        cows_.push_back(cow);
+        unindexCollisionObject(id2castcow_, *it->second);
+        link2castcow_.erase(it);
       }
+
+      // Add to collision object vector
+      cows_.push_back(cow);
     }
   }
 }
@@ -367,7 +623,36 @@ const ContactRequest& BulletCastSimpleManager::getContactRequest() const { retur
 void BulletCastSimpleManager::contactTest(ContactResultMap& collisions)
 {
   ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
 
+void BulletCastSimpleManager::contactTest(ContactResultIdMap& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+void BulletCastSimpleManager::contactTest(ContactResultBuffer& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+bool BulletCastSimpleManager::isCollisionFree()
+{
+  ContactDistanceData cdata(&request_);
+  contactTest(cdata);
+  return !cdata.done;
+}
+
+void BulletCastSimpleManager::setStatisticsEnabled(bool enabled) { stats_enabled_ = enabled; }
+bool BulletCastSimpleManager::isStatisticsEnabled() const { return stats_enabled_; }
+const ContactTestStatistics& BulletCastSimpleManager::getStatistics() const { return stats_; }
+void BulletCastSimpleManager::clearStatistics() { stats_.clear(); }
+
+void BulletCastSimpleManager::contactTest(ContactDistanceData& cdata)
+{
+  ContactTestStatisticsCollector stats(cdata, stats_enabled_ ? &stats_ : nullptr);
   for (auto cow1_iter = cows_.begin(); cow1_iter != (cows_.end() - 1); cow1_iter++)
   {
     const COWPtr& cow1 = *cow1_iter;
@@ -412,7 +697,7 @@ void BulletCastSimpleManager::contactTest(ContactResultMap& collisions)
 
       if (aabb_check)
       {
-        bool needs_collision = needsCollisionCheck(*cow1, *cow2, cdata.req->isContactAllowed, false);
+        bool needs_collision = needsCollisionCheck(*cow1, *cow2, cdata, false);
 
         if (needs_collision)
         {
@@ -425,7 +710,12 @@ void BulletCastSimpleManager::contactTest(ContactResultMap& collisions)
             contactPointResult.m_closestPointDistanceThreshold = cc.m_closestDistanceThreshold;
 
             // discrete collision detection query
-            algorithm->processCollision(&obA, &obB, dispatch_info_, &contactPointResult);
+            {
+              NarrowphaseStatisticsCollector stats(cdata.stats,
+                                                   cow1->getCollisionShape()->getShapeType(),
+                                                   cow2->getCollisionShape()->getShapeType());
+              algorithm->processCollision(&obA, &obB, dispatch_info_, &contactPointResult);
+            }
 
             algorithm->~btCollisionAlgorithm();
             dispatcher_->freeCollisionAlgorithm(algorithm);
@@ -436,12 +726,17 @@ void BulletCastSimpleManager::contactTest(ContactResultMap& collisions)
       if (cdata.done)
         break;
     }
+
+    if (cdata.done)
+      break;
   }
 }
 
 void BulletCastSimpleManager::addCollisionObject(const COWPtr &cow)
 {
+  cow->setOwner(owner_tag_);
   link2cow_[cow->getName()] = cow;
+  indexCollisionObject(*link_registry_, id2cow_, cow);
 
   if (cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter)
     cows_.insert(cows_.begin(), cow);
@@ -449,11 +744,61 @@ void BulletCastSimpleManager::addCollisionObject(const COWPtr &cow)
     cows_.push_back(cow);
 }
 
+void BulletCastSimpleManager::setLinkRegistry(NameRegistryPtr registry)
+{
+  // Objects shared with a clone are copied before their link id changes
+  for (auto& element : link2cow_)
+  {
+    if (registry->find(element.first) != element.second->getLinkId())
+      getWritableCollisionObject(element.second);
+  }
+
+  for (auto& element : link2castcow_)
+  {
+    if (registry->find(element.first) != element.second->getLinkId())
+      getWritableCollisionObject(element.second);
+  }
+
+  link_registry_ = registry;
+  id2cow_.clear();
+  id2castcow_.clear();
+  for (auto& element : link2cow_)
+    indexCollisionObject(*link_registry_, id2cow_, element.second);
+
+  for (auto& element : link2castcow_)
+    indexCollisionObject(*link_registry_, id2castcow_, element.second);
+}
+
+COW& BulletCastSimpleManager::getWritableCollisionObject(const COWPtr& cow)
+{
+  if (cow->isOwnedBy(owner_tag_))
+    return *cow;
+
+  // The cast shapes are updated in place, so a cast collision object gets its own copy of them
+  COWPtr shared = cow;
+  auto it = link2castcow_.find(shared->getName());
+  bool cast = (it != link2castcow_.end() && it->second == shared);
+  COWPtr copy = cast ? copyCastCollisionObject(shared) : shared->clone();
+  copy->setOwner(owner_tag_);
+  std::replace(cows_.begin(), cows_.end(), shared, copy);
+
+  std::vector<COWPtr>& id2cow = cast ? id2castcow_ : id2cow_;
+  if (cast)
+    it->second = copy;
+  else
+    link2cow_[copy->getName()] = copy;
+
+  if (getCollisionObject(id2cow, copy->getLinkId()) == shared)
+    id2cow[static_cast<std::size_t>(copy->getLinkId())] = copy;
+
+  return *copy;
+}
+
 ////////////////////////////////////////////////
 ////////// BulletCastBVHManager ////////////
 ////////////////////////////////////////////////
 
-BulletCastBVHManager::BulletCastBVHManager()
+BulletCastBVHManager::BulletCastBVHManager() : coll_config_(getCollisionConstructionInfo())
 {
   dispatcher_.reset(new btCollisionDispatcher(&coll_config_));
 
@@ -462,62 +807,32 @@ BulletCastBVHManager::BulletCastBVHManager()
       BOX_SHAPE_PROXYTYPE,
       coll_config_.getCollisionAlgorithmCreateFunc(CONVEX_SHAPE_PROXYTYPE, CONVEX_SHAPE_PROXYTYPE));
 
+  registerCustomCollisionAlgorithms(dispatcher_.get());
+
   dispatcher_->setDispatcherFlags(dispatcher_->getDispatcherFlags() &
                                   ~btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD);
 
-  broadphase_.reset(new btDbvtBroadphase());
-}
-
-BulletCastBVHManager::~BulletCastBVHManager()
-{
-  // clean up remaining objects
-  for (auto& co : link2cow_)
-  {
-    btCollisionObject* collisionObject = co.second.get();
-
-    btBroadphaseProxy* bp = collisionObject->getBroadphaseHandle();
-    if (bp)
-    {
-      // only clear the cached algorithms
-      broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(bp, dispatcher_.get());
-      broadphase_->destroyProxy(bp, dispatcher_.get());
-      collisionObject->setBroadphaseHandle(0);
-    }
-  }
-
-  // clean up remaining objects
-  for (auto& co : link2castcow_)
-  {
-    btCollisionObject* collisionObject = co.second.get();
-
-    btBroadphaseProxy* bp = collisionObject->getBroadphaseHandle();
-    if (bp)
-    {
-      // only clear the cached algorithms
-      broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(bp, dispatcher_.get());
-      broadphase_->destroyProxy(bp, dispatcher_.get());
-      collisionObject->setBroadphaseHandle(0);
-    }
-  }
+  pair_cache_.reset(new NarrowphasePairCache(dispatcher_.get()));
+  link_registry_.reset(new NameRegistry());
+  stats_enabled_ = false;
+  owner_tag_ = createOwnerTag();
 }
 
 ContinuousContactManagerBasePtr BulletCastBVHManager::clone() const
 {
   BulletCastBVHManagerPtr manager(new BulletCastBVHManager());
-
-  for (const auto& cow : link2cow_)
-  {
-    COWPtr new_cow = cow.second->clone();
-
-    assert(new_cow->getCollisionShape());
-    assert(new_cow->getCollisionShape()->getShapeType() != CUSTOM_CONVEX_SHAPE_TYPE);
-
-    new_cow->setWorldTransform(cow.second->getWorldTransform());
-
-    new_cow->setContactProcessingThreshold(request_.contact_distance);
-    manager->addCollisionObject(new_cow);
-  }
-  manager->setContactRequest(request_);
+  manager->setLinkRegistry(link_registry_);
+  manager->setStatisticsEnabled(stats_enabled_);
+
+  // The collision objects and the cast collision objects are shared, they are copied by the first manager modifying
+  // them. The BVHs are copied instead of inserting every object again.
+  owner_tag_ = createOwnerTag();
+  manager->link2cow_ = link2cow_;
+  manager->link2castcow_ = link2castcow_;
+  manager->id2cow_ = id2cow_;
+  manager->id2castcow_ = id2castcow_;
+  broadphase_.clone(manager->broadphase_);
+  manager->request_ = request_;
   return manager;
 }
 
@@ -551,15 +866,9 @@ bool BulletCastBVHManager::removeCollisionObject(const std::string& name)
   auto it = link2castcow_.find(name);
   if (it != link2castcow_.end())
   {
-    btBroadphaseProxy* bp = it->second->getBroadphaseHandle();
-    if (bp)
-    {
-      // only clear the cached algorithms
-      broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(bp, dispatcher_.get());
-      broadphase_->destroyProxy(bp, dispatcher_.get());
-      it->second->setBroadphaseHandle(0);
-    }
-
+    broadphase_.remove(*it->second);
+    pair_cache_->remove(it->second.get());
+    unindexCollisionObject(id2castcow_, *it->second);
     link2castcow_.erase(name);
     removed = true;
   }
@@ -567,15 +876,9 @@ bool BulletCastBVHManager::removeCollisionObject(const std::string& name)
   auto it2 = link2cow_.find(name);
   if (it2 != link2cow_.end())
   {
-    btBroadphaseProxy* bp = it2->second->getBroadphaseHandle();
-    if (bp)
-    {
-      // only clear the cached algorithms
-      broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(bp, dispatcher_.get());
-      broadphase_->destroyProxy(bp, dispatcher_.get());
-      it2->second->setBroadphaseHandle(0);
-    }
-
+    broadphase_.remove(*it2->second);
+    pair_cache_->remove(it2->second.get());
+    unindexCollisionObject(id2cow_, *it2->second);
     link2cow_.erase(name);
     removed = true;
   }
@@ -589,14 +892,18 @@ bool BulletCastBVHManager::enableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = true;
+    if (!it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = true;
+
     enabled = true;
   }
 
   auto it2 = link2castcow_.find(name);
   if (it2 != link2castcow_.end())
   {
-    it2->second->m_enabled = true;
+    if (!it2->second->m_enabled)
+      getWritableCollisionObject(it2->second).m_enabled = true;
+
     enabled = true;
   }
 
@@ -609,27 +916,86 @@ bool BulletCastBVHManager::disableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = false;
+    if (it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = false;
+
     disabled = true;
   }
 
   auto it2 = link2castcow_.find(name);
   if (it2 != link2castcow_.end())
   {
-    it2->second->m_enabled = true;
+    if (it2->second->m_enabled)
+      getWritableCollisionObject(it2->second).m_enabled = false;
+
     disabled = true;
   }
 
   return disabled;
 }
 
+bool BulletCastBVHManager::updateCollisionObjectOcTree(const std::string& name,
+                                                       const VectorVector3d& occupied_voxels,
+                                                       const VectorVector3d& free_voxels)
+{
+  auto it = link2cow_.find(name);
+  if (it == link2cow_.end() || !hasOcTreeShapes(*it->second))
+    return false;
+
+  // The cast object of an active octomap holds a copy of its leaves
+  if (link2castcow_.find(name) != link2castcow_.end())
+  {
+    ROS_WARN("The octomap of the active collision object %s can not be updated", name.c_str());
+    return false;
+  }
+
+  // Shared collision objects are copied first, the updated shapes are copies too
+  COW& writable = getWritableCollisionObject(it->second);
+  updateOcTreeShapes(writable, occupied_voxels, free_voxels);
+  pair_cache_->remove(&writable);
+  broadphase_.update(writable);
+  return true;
+}
+
 void BulletCastBVHManager::setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose)
 {
   // TODO: Find a way to remove this check. Need to store information in Tesseract EnvState indicating transforms with
   // geometry
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
-    it->second->setWorldTransform(convertEigenToBt(pose));
+    setCollisionObjectsTransform(it->second->getLinkId(), pose);
+}
+
+void BulletCastBVHManager::setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose)
+{
+  const COWPtr& cow = getCollisionObject(id2cow_, link_id);
+  if (!cow)
+    return;
+
+  // Unchanged objects are skipped, the cast objects are only updated by the overloads taking two poses
+  btTransform transform = convertEigenToBt(pose);
+  if (transform == cow->getWorldTransform())
+    return;
+
+  // The cast object of an active link is in the broadphase instead of its collision object
+  COW& writable = getWritableCollisionObject(cow);
+  writable.setWorldTransform(transform);
+  if (!getCollisionObject(id2castcow_, link_id))
+    broadphase_.update(writable);
+}
+
+void BulletCastBVHManager::setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses)
+{
+  assert(link_ids.size() == poses.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], poses[i]);
+}
+
+void BulletCastBVHManager::setCollisionObjectsTransform(const VectorIsometry3d& link_transforms)
+{
+  const std::size_t size = std::min(id2cow_.size(), link_transforms.size());
+  for (std::size_t i = 0; i < size; ++i)
+    setCollisionObjectsTransform(static_cast<int>(i), link_transforms[i]);
 }
 
 void BulletCastBVHManager::setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -654,48 +1020,21 @@ void BulletCastBVHManager::setCollisionObjectsTransform(const std::string& name,
   // geometry
   auto it = link2castcow_.find(name);
   if (it != link2castcow_.end())
+    setCollisionObjectsTransform(it->second->getLinkId(), pose1, pose2);
+}
+
+void BulletCastBVHManager::setCollisionObjectsTransform(int link_id,
+                                                        const Eigen::Isometry3d& pose1,
+                                                        const Eigen::Isometry3d& pose2)
+{
+  const COWPtr& cow = getCollisionObject(id2castcow_, link_id);
+  if (cow)
   {
-    COWPtr& cow = it->second;
     assert(cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter);
 
-    btTransform tf1 = convertEigenToBt(pose1);
-    btTransform tf2 = convertEigenToBt(pose2);
-
-    static_cast<tesseract::CastHullShape*>(cow->getCollisionShape())->updateCastTransform(tf1.inverseTimes(tf2));
-    cow->setWorldTransform(tf1);
-
-    // Now update Broadphase AABB (Copied from BulletWorld updateSingleAabb function
-    btVector3 minAabb, maxAabb;
-    cow->getCollisionShape()->getAabb(cow->getWorldTransform(), minAabb, maxAabb);
-    // need to increase the aabb for contact thresholds
-    btVector3 contactThreshold(cow->getContactProcessingThreshold(),
-                               cow->getContactProcessingThreshold(),
-                               cow->getContactProcessingThreshold());
-    minAabb -= contactThreshold;
-    maxAabb += contactThreshold;
-
-    if (dispatch_info_.m_useContinuous && cow->getInternalType() == btCollisionObject::CO_RIGID_BODY &&
-        !cow->isStaticOrKinematicObject())
-    {
-      btVector3 minAabb2, maxAabb2;
-      cow->getCollisionShape()->getAabb(cow->getInterpolationWorldTransform(), minAabb2, maxAabb2);
-      minAabb2 -= contactThreshold;
-      maxAabb2 += contactThreshold;
-      minAabb.setMin(minAabb2);
-      maxAabb.setMax(maxAabb2);
-    }
-
-    // moving objects should be moderately sized, probably something wrong if not
-    if (cow->isStaticObject() || ((maxAabb - minAabb).length2() < btScalar(1e12)))
-    {
-      broadphase_->setAabb(cow->getBroadphaseHandle(), minAabb, maxAabb, dispatcher_.get());
-    }
-    else
-    {
-      // something went wrong, investigate
-      // this assert is unwanted in 3D modelers (danger of loosing work)
-      cow->setActivationState(DISABLE_SIMULATION);
-    }
+    COW& writable = getWritableCollisionObject(cow);
+    updateCastTransform(writable, convertEigenToBt(pose1), convertEigenToBt(pose2));
+    broadphase_.update(writable);
   }
 }
 
@@ -708,6 +1047,35 @@ void BulletCastBVHManager::setCollisionObjectsTransform(const std::vector<std::s
     setCollisionObjectsTransform(names[i], pose1[i], pose2[i]);
 }
 
+void BulletCastBVHManager::setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                                        const VectorIsometry3d& pose1,
+                                                        const VectorIsometry3d& pose2)
+{
+  assert(link_ids.size() == pose1.size() && link_ids.size() == pose2.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], pose1[i], pose2[i]);
+}
+
+void BulletCastBVHManager::setCollisionObjectsSweptTransform(const std::string& name, const VectorIsometry3d& poses)
+{
+  auto it = link2castcow_.find(name);
+  if (it != link2castcow_.end())
+    setCollisionObjectsSweptTransform(it->second->getLinkId(), poses);
+}
+
+void BulletCastBVHManager::setCollisionObjectsSweptTransform(int link_id, const VectorIsometry3d& poses)
+{
+  const COWPtr& cow = getCollisionObject(id2castcow_, link_id);
+  if (cow)
+  {
+    assert(cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter);
+
+    COW& writable = getWritableCollisionObject(cow);
+    updateCastSweptTransform(writable, poses);
+    broadphase_.update(writable);
+  }
+}
+
 void BulletCastBVHManager::setCollisionObjectsTransform(const TransformMap& pose1, const TransformMap& pose2)
 {
   assert(pose1.size() == pose2.size());
@@ -725,154 +1093,92 @@ void BulletCastBVHManager::setCollisionObjectsTransform(const TransformMap& pose
 void BulletCastBVHManager::contactTest(ContactResultMap& collisions)
 {
   ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
 
-  broadphase_->calculateOverlappingPairs(dispatcher_.get());
+void BulletCastBVHManager::contactTest(ContactResultIdMap& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
 
-  btOverlappingPairCache* pairCache = broadphase_->getOverlappingPairCache();
+void BulletCastBVHManager::contactTest(ContactResultBuffer& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+bool BulletCastBVHManager::isCollisionFree()
+{
+  ContactDistanceData cdata(&request_);
+  contactTest(cdata);
+  return !cdata.done;
+}
+
+void BulletCastBVHManager::setStatisticsEnabled(bool enabled) { stats_enabled_ = enabled; }
+bool BulletCastBVHManager::isStatisticsEnabled() const { return stats_enabled_; }
+const ContactTestStatistics& BulletCastBVHManager::getStatistics() const { return stats_; }
+void BulletCastBVHManager::clearStatistics() { stats_.clear(); }
 
-  TesseractCollisionPairCallback collisionCallback(dispatch_info_, dispatcher_.get(), cdata);
+void BulletCastBVHManager::contactTest(ContactDistanceData& cdata)
+{
+  ContactTestStatisticsCollector stats(cdata, stats_enabled_ ? &stats_ : nullptr);
+
+  // Only the active objects are checked against each other and against the static objects. The tree traversal can
+  // not be interrupted so the remaining pairs are skipped once the search is finished.
+  broadphase_.findOverlappingPairs([&](const COW& cow1, const COW& cow2) {
+    if (!cdata.done)
+      processOverlappingPair(cow1, cow2, *pair_cache_, dispatch_info_, cdata);
+  });
 
-  pairCache->processAllOverlappingPairs(&collisionCallback, dispatcher_.get());
+  // The state of pairs which were not checked by this query is released
+  pair_cache_->evict();
 }
 
 void BulletCastBVHManager::setContactRequest(const ContactRequest& req)
 {
   request_ = req;
 
-  // Now need to update the broadphase with correct aabb
+  // The broadphase holds the cast object of every active link and the collision object of every other link
   for (auto& co : link2cow_)
   {
     COWPtr& cow = co.second;
+    if (needsRequestUpdate(request_, *cow))
+      updateCollisionObjectWithRequest(request_, getWritableCollisionObject(cow));
 
-    // Need to check if a collision object is still active
-    if (cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter)
+    bool active = (std::find(req.link_names.begin(), req.link_names.end(), cow->getName()) != req.link_names.end());
+    auto it = link2castcow_.find(cow->getName());
+    if (active)
     {
-      // Update with request
-      updateCollisionObjectWithRequest(request_, *cow);
-
-      bool still_active = (std::find_if(req.link_names.begin(), req.link_names.end(), [&](std::string link) {
-                             return link == cow->getName();
-                           }) != req.link_names.end());
-
-      if (still_active)
+      if (it == link2castcow_.end())
       {
-        // Get the existing active collision object
-        COWPtr active_cow = link2castcow_[cow->getName()];
-
-        // Update with request
-        updateCollisionObjectWithRequest(request_, *active_cow);
-
-        // Calculate the aabb
-        btVector3 minAabb, maxAabb;
-        active_cow->getCollisionShape()->getAabb(cow->getWorldTransform(), minAabb, maxAabb);
-        btVector3 contactThreshold(active_cow->getContactProcessingThreshold(),
-                                   active_cow->getContactProcessingThreshold(),
-                                   active_cow->getContactProcessingThreshold());
-        minAabb -= contactThreshold;
-        maxAabb += contactThreshold;
-
-        // Update the broadphase aabb
-        broadphase_->setAabb(active_cow->getBroadphaseHandle(), minAabb, maxAabb, dispatcher_.get());
+        // Replace the static collision object in the broadphase by an active collision object
+        broadphase_.remove(*cow);
+        pair_cache_->remove(cow.get());
+
+        COWPtr active_cow = makeCastCollisionObject(cow);
+        active_cow->setOwner(owner_tag_);
+        it = link2castcow_.emplace(active_cow->getName(), active_cow).first;
+        indexCollisionObject(*link_registry_, id2castcow_, active_cow);
       }
-      else
-      {
-        COWPtr active_cow = link2castcow_[cow->getName()];
 
-        // Remove the active collision object from the broadphase
-        btBroadphaseProxy* bp = active_cow->getBroadphaseHandle();
-        if (bp)
-        {
-          // only clear the cached algorithms
-          broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(bp, dispatcher_.get());
-          broadphase_->destroyProxy(bp, dispatcher_.get());
-          active_cow->setBroadphaseHandle(0);
-        }
+      if (needsRequestUpdate(request_, *it->second))
+        updateCollisionObjectWithRequest(request_, getWritableCollisionObject(it->second));
 
-        // Remove the collision object from active map
-        link2castcow_.erase(cow->getName());
-
-        // Calculate broadphase aabb
-        btVector3 minAabb, maxAabb;
-        cow->getCollisionShape()->getAabb(cow->getWorldTransform(), minAabb, maxAabb);
-        btVector3 contactThreshold(cow->getContactProcessingThreshold(),
-                                   cow->getContactProcessingThreshold(),
-                                   cow->getContactProcessingThreshold());
-        minAabb -= contactThreshold;
-        maxAabb += contactThreshold;
-
-        // Add the static collision object to the broadphase
-        int type = cow->getCollisionShape()->getShapeType();
-        cow->setBroadphaseHandle(broadphase_->createProxy(minAabb,
-                                                          maxAabb,
-                                                          type,
-                                                          cow.get(),
-                                                          cow->m_collisionFilterGroup,
-                                                          cow->m_collisionFilterMask,
-                                                          dispatcher_.get()));
-      }
+      broadphase_.update(*it->second);
     }
     else
     {
-      // Update with request
-      updateCollisionObjectWithRequest(request_, *cow);
-
-      bool now_active = (std::find_if(req.link_names.begin(), req.link_names.end(), [&](std::string link) {
-                           return link == cow->getName();
-                         }) != req.link_names.end());
-      if (now_active)
-      {
-        // Create active collision object
-        COWPtr active_cow = makeCastCollisionObject(cow);
-
-        // Update with request
-        updateCollisionObjectWithRequest(request_, *active_cow);
-
-        // Remove the static collision object from the broadphase
-        btBroadphaseProxy* bp = cow->getBroadphaseHandle();
-        if (bp)
-        {
-          // only clear the cached algorithms
-          broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(bp, dispatcher_.get());
-          broadphase_->destroyProxy(bp, dispatcher_.get());
-          cow->setBroadphaseHandle(0);
-        }
-
-        // Calculate broadphase aabb
-        btVector3 minAabb, maxAabb;
-        active_cow->getCollisionShape()->getAabb(active_cow->getWorldTransform(), minAabb, maxAabb);
-        btVector3 contactThreshold(active_cow->getContactProcessingThreshold(),
-                                   active_cow->getContactProcessingThreshold(),
-                                   active_cow->getContactProcessingThreshold());
-        minAabb -= contactThreshold;
-        maxAabb += contactThreshold;
-
-        // Add the active collision object to the broadphase
-        int type = active_cow->getCollisionShape()->getShapeType();
-        active_cow->setBroadphaseHandle(broadphase_->createProxy(minAabb,
-                                                                 maxAabb,
-                                                                 type,
-                                                                 active_cow.get(),
-                                                                 active_cow->m_collisionFilterGroup,
-                                                                 active_cow->m_collisionFilterMask,
-                                                                 dispatcher_.get()));
-
-        // Add it to the active map
-        link2castcow_[active_cow->getName()] = active_cow;
-      }
-      else
+      if (it != link2castcow_.end())
       {
-        // Calculate the aabb
-        btVector3 minAabb, maxAabb;
-        cow->getCollisionShape()->getAabb(cow->getWorldTransform(), minAabb, maxAabb);
-        btVector3 contactThreshold(cow->getContactProcessingThreshold(),
-                                   cow->getContactProcessingThreshold(),
-                                   cow->getContactProcessingThreshold());
-        minAabb -= contactThreshold;
-        maxAabb += contactThreshold;
-
-        // Update the broadphase aabb
-        broadphase_->setAabb(cow->getBroadphaseHandle(), minAabb, maxAabb, dispatcher_.get());
+        // Replace the active collision object in the broadphase by the static collision object
+        broadphase_.remove(*it->second);
+        pair_cache_->remove(it->second.get());
+        unindexCollisionObject(id2castcow_, *it->second);
+        link2castcow_.erase(it);
       }
+
+      broadphase_.update(*cow);
     }
   }
 }
@@ -880,41 +1186,67 @@ void BulletCastBVHManager::setContactRequest(const ContactRequest& req)
 const ContactRequest& BulletCastBVHManager::getContactRequest() const { return request_; }
 void BulletCastBVHManager::addCollisionObject(const COWPtr &cow)
 {
+  auto it = link2cow_.find(cow->getName());
+  if (it != link2cow_.end())
+  {
+    broadphase_.remove(*it->second);
+    pair_cache_->remove(it->second.get());
+  }
+
+  cow->setOwner(owner_tag_);
   link2cow_[cow->getName()] = cow;
+  indexCollisionObject(*link_registry_, id2cow_, cow);
+  broadphase_.update(*cow);
+}
 
-  // calculate new AABB
-  btTransform trans = cow->getWorldTransform();
+void BulletCastBVHManager::setLinkRegistry(NameRegistryPtr registry)
+{
+  // Objects shared with a clone are copied before their link id changes
+  for (auto& element : link2cow_)
+  {
+    if (registry->find(element.first) != element.second->getLinkId())
+      getWritableCollisionObject(element.second);
+  }
 
-  btVector3 minAabb;
-  btVector3 maxAabb;
-  cow->getCollisionShape()->getAabb(trans, minAabb, maxAabb);
+  for (auto& element : link2castcow_)
+  {
+    if (registry->find(element.first) != element.second->getLinkId())
+      getWritableCollisionObject(element.second);
+  }
 
-  // need to increase the aabb for contact thresholds
-  btVector3 contactThreshold(
-      cow->getContactProcessingThreshold(), cow->getContactProcessingThreshold(), cow->getContactProcessingThreshold());
-  minAabb -= contactThreshold;
-  maxAabb += contactThreshold;
+  link_registry_ = registry;
+  id2cow_.clear();
+  id2castcow_.clear();
+  for (auto& element : link2cow_)
+    indexCollisionObject(*link_registry_, id2cow_, element.second);
 
-  int type = cow->getCollisionShape()->getShapeType();
-  cow->setBroadphaseHandle(broadphase_->createProxy(
-      minAabb, maxAabb, type, cow.get(), cow->m_collisionFilterGroup, cow->m_collisionFilterMask, dispatcher_.get()));
+  for (auto& element : link2castcow_)
+    indexCollisionObject(*link_registry_, id2castcow_, element.second);
 }
 
-void BulletCastBVHManager::contactTest(const COWPtr& cow, ContactDistanceData& collisions)
+COW& BulletCastBVHManager::getWritableCollisionObject(const COWPtr& cow)
 {
-  btVector3 aabbMin, aabbMax;
-  cow->getCollisionShape()->getAabb(cow->getWorldTransform(), aabbMin, aabbMax);
-
-  // need to increase the aabb for contact thresholds
-  btVector3 contactThreshold1(
-      cow->getContactProcessingThreshold(), cow->getContactProcessingThreshold(), cow->getContactProcessingThreshold());
-  aabbMin -= contactThreshold1;
-  aabbMax += contactThreshold1;
-
-  CastCollisionCollector cc(collisions, cow, cow->getContactProcessingThreshold());
+  if (cow->isOwnedBy(owner_tag_))
+    return *cow;
+
+  // The cast shapes are updated in place, so a cast collision object gets its own copy of them
+  COWPtr shared = cow;
+  auto it = link2castcow_.find(shared->getName());
+  bool cast = (it != link2castcow_.end() && it->second == shared);
+  COWPtr copy = cast ? copyCastCollisionObject(shared) : shared->clone();
+  copy->setOwner(owner_tag_);
+  broadphase_.replace(*shared, *copy);
+  pair_cache_->remove(shared.get());
+
+  std::vector<COWPtr>& id2cow = cast ? id2castcow_ : id2cow_;
+  if (cast)
+    it->second = copy;
+  else
+    link2cow_[copy->getName()] = copy;
 
-  TesseractSingleContactCallback contactCB(cow.get(), dispatcher_.get(), dispatch_info_, cc);
+  if (getCollisionObject(id2cow, copy->getLinkId()) == shared)
+    id2cow[static_cast<std::size_t>(copy->getLinkId())] = copy;
 
-  broadphase_->aabbTest(aabbMin, aabbMax, contactCB);
+  return *copy;
 }
 }
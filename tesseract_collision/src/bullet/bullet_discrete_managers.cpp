@@ -40,6 +40,8 @@
  */
 
 #include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include <atomic>
+#include <limits>
 
 namespace tesseract
 {
@@ -47,7 +49,7 @@ namespace tesseract
 /////// BulletDiscreteManagerSimple ////////////
 ////////////////////////////////////////////////
 
-BulletDiscreteSimpleManager::BulletDiscreteSimpleManager()
+BulletDiscreteSimpleManager::BulletDiscreteSimpleManager() : coll_config_(getCollisionConstructionInfo())
 {
   dispatcher_.reset(new btCollisionDispatcher(&coll_config_));
 
@@ -56,28 +58,29 @@ BulletDiscreteSimpleManager::BulletDiscreteSimpleManager()
       BOX_SHAPE_PROXYTYPE,
       coll_config_.getCollisionAlgorithmCreateFunc(CONVEX_SHAPE_PROXYTYPE, CONVEX_SHAPE_PROXYTYPE));
 
+  registerCustomCollisionAlgorithms(dispatcher_.get());
+
   dispatcher_->setDispatcherFlags(dispatcher_->getDispatcherFlags() &
                                   ~btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD);
+
+  pair_cache_.reset(new NarrowphasePairCache(dispatcher_.get()));
+  link_registry_.reset(new NameRegistry());
+  stats_enabled_ = false;
+  owner_tag_ = createOwnerTag();
 }
 
 DiscreteContactManagerBasePtr BulletDiscreteSimpleManager::clone() const
 {
   BulletDiscreteSimpleManagerPtr manager(new BulletDiscreteSimpleManager());
-
-  for (const auto& cow : link2cow_)
-  {
-    COWPtr new_cow = cow.second->clone();
-
-    assert(new_cow->getCollisionShape());
-    assert(new_cow->getCollisionShape()->getShapeType() != CUSTOM_CONVEX_SHAPE_TYPE);
-
-    new_cow->setWorldTransform(cow.second->getWorldTransform());
-
-    new_cow->setContactProcessingThreshold(request_.contact_distance);
-    manager->addCollisionObject(new_cow);
-  }
-
-  manager->setContactRequest(request_);
+  manager->setLinkRegistry(link_registry_);
+  manager->setStatisticsEnabled(stats_enabled_);
+
+  // The collision objects are shared, they are copied by the first manager modifying them
+  owner_tag_ = createOwnerTag();
+  manager->link2cow_ = link2cow_;
+  manager->id2cow_ = id2cow_;
+  manager->cows_ = cows_;
+  manager->request_ = request_;
   return manager;
 }
 
@@ -110,7 +113,9 @@ bool BulletDiscreteSimpleManager::removeCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
+    pair_cache_->remove(it->second.get());
     cows_.erase(std::find(cows_.begin(), cows_.end(), it->second));
+    unindexCollisionObject(id2cow_, *it->second);
     link2cow_.erase(name);
     return true;
   }
@@ -123,7 +128,9 @@ bool BulletDiscreteSimpleManager::enableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = true;
+    if (!it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = true;
+
     return true;
   }
   return false;
@@ -134,19 +141,36 @@ bool BulletDiscreteSimpleManager::disableCollisionObject(const std::string& name
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = false;
+    if (it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = false;
+
     return true;
   }
   return false;
 }
 
+bool BulletDiscreteSimpleManager::updateCollisionObjectOcTree(const std::string& name,
+                                                              const VectorVector3d& occupied_voxels,
+                                                              const VectorVector3d& free_voxels)
+{
+  // The AABBs are computed on every contact test
+  auto it = link2cow_.find(name);
+  if (it == link2cow_.end() || !hasOcTreeShapes(*it->second))
+    return false;
+
+  COW& writable = getWritableCollisionObject(it->second);
+  updateOcTreeShapes(writable, occupied_voxels, free_voxels);
+  pair_cache_->remove(&writable);
+  return true;
+}
+
 void BulletDiscreteSimpleManager::setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose)
 {
   // TODO: Find a way to remove this check. Need to store information in Tesseract EnvState indicating transforms with
   // geometry
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
-    it->second->setWorldTransform(convertEigenToBt(pose));
+    setCollisionObjectsTransform(it->second->getLinkId(), pose);
 }
 
 void BulletDiscreteSimpleManager::setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -163,79 +187,97 @@ void BulletDiscreteSimpleManager::setCollisionObjectsTransform(const TransformMa
     setCollisionObjectsTransform(transform.first, transform.second);
 }
 
-void BulletDiscreteSimpleManager::contactTest(ContactResultMap& collisions)
+void BulletDiscreteSimpleManager::setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose)
 {
-  ContactDistanceData cdata(&request_, &collisions);
+  const COWPtr& cow = getCollisionObject(id2cow_, link_id);
+  if (!cow)
+    return;
 
-  for (auto cow1_iter = cows_.begin(); cow1_iter != (cows_.end() - 1); cow1_iter++)
-  {
-    const COWPtr& cow1 = *cow1_iter;
-
-    if (cow1->m_collisionFilterGroup != btBroadphaseProxy::KinematicFilter)
-      break;
+  btTransform transform = convertEigenToBt(pose);
+  if (!(transform == cow->getWorldTransform()))
+    getWritableCollisionObject(cow).setWorldTransform(transform);
+}
 
-    if (!cow1->m_enabled)
-      continue;
+void BulletDiscreteSimpleManager::setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                                               const VectorIsometry3d& poses)
+{
+  assert(link_ids.size() == poses.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], poses[i]);
+}
 
-    btVector3 aabbMin[2], aabbMax[2];
-    cow1->getCollisionShape()->getAabb(cow1->getWorldTransform(), aabbMin[0], aabbMax[0]);
+void BulletDiscreteSimpleManager::setCollisionObjectsTransform(const VectorIsometry3d& link_transforms)
+{
+  const std::size_t size = std::min(id2cow_.size(), link_transforms.size());
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    if (id2cow_[i])
+      setCollisionObjectsTransform(static_cast<int>(i), link_transforms[i]);
+  }
+}
 
-    // need to increase the aabb for contact thresholds
-    btVector3 contactThreshold1(cow1->getContactProcessingThreshold(),
-                                cow1->getContactProcessingThreshold(),
-                                cow1->getContactProcessingThreshold());
-    aabbMin[0] -= contactThreshold1;
-    aabbMax[0] += contactThreshold1;
+void BulletDiscreteSimpleManager::contactTest(ContactResultMap& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
 
-    btCollisionObjectWrapper obA(0, cow1->getCollisionShape(), cow1.get(), cow1->getWorldTransform(), -1, -1);
+void BulletDiscreteSimpleManager::contactTest(ContactResultIdMap& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
 
-    DiscreteCollisionCollector cc(cdata, cow1, cow1->getContactProcessingThreshold());
-    for (auto cow2_iter = cow1_iter + 1; cow2_iter != cows_.end(); cow2_iter++)
-    {
-      assert(!cdata.done);
+void BulletDiscreteSimpleManager::contactTest(ContactResultBuffer& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
 
-      const COWPtr& cow2 = *cow2_iter;
+bool BulletDiscreteSimpleManager::isCollisionFree()
+{
+  ContactDistanceData cdata(&request_);
+  contactTest(cdata);
+  return !cdata.done;
+}
 
-      cow2->getCollisionShape()->getAabb(cow2->getWorldTransform(), aabbMin[1], aabbMax[1]);
+void BulletDiscreteSimpleManager::setStatisticsEnabled(bool enabled) { stats_enabled_ = enabled; }
+bool BulletDiscreteSimpleManager::isStatisticsEnabled() const { return stats_enabled_; }
+const ContactTestStatistics& BulletDiscreteSimpleManager::getStatistics() const { return stats_; }
+void BulletDiscreteSimpleManager::clearStatistics() { stats_.clear(); }
 
-      // need to increase the aabb for contact thresholds
-      btVector3 contactThreshold2(cow2->getContactProcessingThreshold(),
-                                  cow2->getContactProcessingThreshold(),
-                                  cow2->getContactProcessingThreshold());
-      aabbMin[1] -= contactThreshold2;
-      aabbMax[1] += contactThreshold2;
+void BulletDiscreteSimpleManager::contactTest(ContactDistanceData& cdata)
+{
+  ContactTestStatisticsCollector stats(cdata, stats_enabled_ ? &stats_ : nullptr);
 
-      bool aabb_check = (aabbMin[0][0] <= aabbMax[1][0] && aabbMax[0][0] >= aabbMin[1][0]) &&
-                        (aabbMin[0][1] <= aabbMax[1][1] && aabbMax[0][1] >= aabbMin[1][1]) &&
-                        (aabbMin[0][2] <= aabbMax[1][2] && aabbMax[0][2] >= aabbMin[1][2]);
+  // The AABBs are only computed once per query, the pairs which overlap are checked in the narrowphase
+  sap_.update(cows_);
+  sap_.findOverlappingPairs(cows_, [&](const COWPtr& cow1, const COWPtr& cow2) {
+    assert(!cdata.done);
 
-      if (aabb_check)
-      {
-        bool needs_collision = needsCollisionCheck(*cow1, *cow2, request_.isContactAllowed, false);
+    if (!needsCollisionCheck(*cow1, *cow2, cdata, false))
+      return false;
 
-        if (needs_collision)
-        {
-          btCollisionObjectWrapper obB(0, cow2->getCollisionShape(), cow2.get(), cow2->getWorldTransform(), -1, -1);
+    btCollisionObjectWrapper obA(0, cow1->getCollisionShape(), cow1.get(), cow1->getWorldTransform(), -1, -1);
+    btCollisionObjectWrapper obB(0, cow2->getCollisionShape(), cow2.get(), cow2->getWorldTransform(), -1, -1);
 
-          btCollisionAlgorithm* algorithm = dispatcher_->findAlgorithm(&obA, &obB, 0, BT_CLOSEST_POINT_ALGORITHMS);
-          if (algorithm)
-          {
-            TesseractBridgedManifoldResult contactPointResult(&obA, &obB, cc);
-            contactPointResult.m_closestPointDistanceThreshold = cc.m_closestDistanceThreshold;
+    DiscreteCollisionCollector cc(cdata, cow1, cow1->getContactProcessingThreshold());
+    TesseractBridgedManifoldResult contactPointResult(&obA, &obB, cc);
+    contactPointResult.m_closestPointDistanceThreshold = cc.m_closestDistanceThreshold;
 
-            // discrete collision detection query
-            algorithm->processCollision(&obA, &obB, dispatch_info_, &contactPointResult);
+    // discrete collision detection query, the algorithm of the pair is reused across contact tests
+    {
+      NarrowphaseStatisticsCollector stats(cdata.stats,
+                                           cow1->getCollisionShape()->getShapeType(),
+                                           cow2->getCollisionShape()->getShapeType());
+      pair_cache_->processCollision(&obA, &obB, dispatch_info_, &contactPointResult);
+    }
 
-            algorithm->~btCollisionAlgorithm();
-            dispatcher_->freeCollisionAlgorithm(algorithm);
-          }
-        }
-      }
+    return cdata.done;
+  });
 
-      if (cdata.done)
-        break;
-    }
-  }
+  // The state of pairs which were not checked by this query is released
+  pair_cache_->evict();
 }
 
 void BulletDiscreteSimpleManager::setContactRequest(const ContactRequest& req)
@@ -246,7 +288,8 @@ void BulletDiscreteSimpleManager::setContactRequest(const ContactRequest& req)
 
   for (auto& element : link2cow_)
   {
-    updateCollisionObjectWithRequest(request_, *element.second);
+    if (needsRequestUpdate(request_, *element.second))
+      updateCollisionObjectWithRequest(request_, getWritableCollisionObject(element.second));
 
     // Update collision object vector
     if (element.second->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter)
@@ -259,7 +302,13 @@ void BulletDiscreteSimpleManager::setContactRequest(const ContactRequest& req)
 const ContactRequest& BulletDiscreteSimpleManager::getContactRequest() const { return request_; }
 void BulletDiscreteSimpleManager::addCollisionObject(const COWPtr &cow)
 {
+  auto it = link2cow_.find(cow->getName());
+  if (it != link2cow_.end())
+    pair_cache_->remove(it->second.get());
+
+  cow->setOwner(owner_tag_);
   link2cow_[cow->getName()] = cow;
+  indexCollisionObject(*link_registry_, id2cow_, cow);
 
   if (cow->m_collisionFilterGroup == btBroadphaseProxy::KinematicFilter)
     cows_.insert(cows_.begin(), cow);
@@ -268,11 +317,44 @@ void BulletDiscreteSimpleManager::addCollisionObject(const COWPtr &cow)
 }
 
 const Link2Cow& BulletDiscreteSimpleManager::getCollisionObjects() const { return link2cow_; }
+void BulletDiscreteSimpleManager::setLinkRegistry(NameRegistryPtr registry)
+{
+  // Objects shared with a clone are copied before their link id changes
+  for (auto& element : link2cow_)
+  {
+    if (registry->find(element.first) != element.second->getLinkId())
+      getWritableCollisionObject(element.second);
+  }
+
+  link_registry_ = registry;
+  id2cow_.clear();
+  for (auto& element : link2cow_)
+    indexCollisionObject(*link_registry_, id2cow_, element.second);
+}
+
+COW& BulletDiscreteSimpleManager::getWritableCollisionObject(const COWPtr& cow)
+{
+  if (cow->isOwnedBy(owner_tag_))
+    return *cow;
+
+  COWPtr shared = cow;
+  COWPtr copy = shared->clone();
+  copy->setOwner(owner_tag_);
+  pair_cache_->remove(shared.get());
+  std::replace(cows_.begin(), cows_.end(), shared, copy);
+  link2cow_[copy->getName()] = copy;
+
+  if (getCollisionObject(id2cow_, copy->getLinkId()) == shared)
+    id2cow_[static_cast<std::size_t>(copy->getLinkId())] = copy;
+
+  return *copy;
+}
+
 ////////////////////////////////////////////////
 ////////// BulletDiscreteBVHManager ////////////
 ////////////////////////////////////////////////
 
-BulletDiscreteBVHManager::BulletDiscreteBVHManager()
+BulletDiscreteBVHManager::BulletDiscreteBVHManager() : coll_config_(getCollisionConstructionInfo())
 {
   dispatcher_.reset(new btCollisionDispatcher(&coll_config_));
 
@@ -281,48 +363,32 @@ BulletDiscreteBVHManager::BulletDiscreteBVHManager()
       BOX_SHAPE_PROXYTYPE,
       coll_config_.getCollisionAlgorithmCreateFunc(CONVEX_SHAPE_PROXYTYPE, CONVEX_SHAPE_PROXYTYPE));
 
+  registerCustomCollisionAlgorithms(dispatcher_.get());
+
   dispatcher_->setDispatcherFlags(dispatcher_->getDispatcherFlags() &
                                   ~btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD);
 
-  broadphase_.reset(new btDbvtBroadphase());
-}
-
-BulletDiscreteBVHManager::~BulletDiscreteBVHManager()
-{
-  // clean up remaining objects
-  for (auto& co : link2cow_)
-  {
-    btCollisionObject* collisionObject = co.second.get();
-
-    btBroadphaseProxy* bp = collisionObject->getBroadphaseHandle();
-    if (bp)
-    {
-      // only clear the cached algorithms
-      broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(bp, dispatcher_.get());
-      broadphase_->destroyProxy(bp, dispatcher_.get());
-      collisionObject->setBroadphaseHandle(0);
-    }
-  }
+  pair_cache_.reset(new NarrowphasePairCache(dispatcher_.get()));
+  link_registry_.reset(new NameRegistry());
+  stats_enabled_ = false;
+  owner_tag_ = createOwnerTag();
+  narrowphase_threads_ = 1;
 }
 
 DiscreteContactManagerBasePtr BulletDiscreteBVHManager::clone() const
 {
   BulletDiscreteBVHManagerPtr manager(new BulletDiscreteBVHManager());
-
-  for (const auto& cow : link2cow_)
-  {
-    COWPtr new_cow = cow.second->clone();
-
-    assert(new_cow->getCollisionShape());
-    assert(new_cow->getCollisionShape()->getShapeType() != CUSTOM_CONVEX_SHAPE_TYPE);
-
-    new_cow->setWorldTransform(cow.second->getWorldTransform());
-
-    new_cow->setContactProcessingThreshold(request_.contact_distance);
-    manager->addCollisionObject(new_cow);
-  }
-
-  manager->setContactRequest(request_);
+  manager->setLinkRegistry(link_registry_);
+  manager->setStatisticsEnabled(stats_enabled_);
+  manager->setNarrowphaseThreads(narrowphase_threads_);
+
+  // The collision objects are shared, they are copied by the first manager modifying them. The BVHs are copied
+  // instead of inserting every object again.
+  owner_tag_ = createOwnerTag();
+  manager->link2cow_ = link2cow_;
+  manager->id2cow_ = id2cow_;
+  broadphase_.clone(manager->broadphase_);
+  manager->request_ = request_;
   return manager;
 }
 
@@ -355,15 +421,12 @@ bool BulletDiscreteBVHManager::removeCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);  // Levi TODO: Should these check be removed?
   if (it != link2cow_.end())
   {
-    btBroadphaseProxy* bp = it->second->getBroadphaseHandle();
-    if (bp)
-    {
-      // only clear the cached algorithms
-      broadphase_->getOverlappingPairCache()->cleanProxyFromPairs(bp, dispatcher_.get());
-      broadphase_->destroyProxy(bp, dispatcher_.get());
-      it->second->setBroadphaseHandle(0);
-    }
+    broadphase_.remove(*it->second);
+    pair_cache_->remove(it->second.get());
+    for (auto& worker : workers_)
+      worker->pair_cache->remove(it->second.get());
 
+    unindexCollisionObject(id2cow_, *it->second);
     link2cow_.erase(name);
     return true;
   }
@@ -376,7 +439,9 @@ bool BulletDiscreteBVHManager::enableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);  // Levi TODO: Should these check be removed?
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = true;
+    if (!it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = true;
+
     return true;
   }
   return false;
@@ -387,44 +452,54 @@ bool BulletDiscreteBVHManager::disableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);  // Levi TODO: Should these check be removed?
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = false;
+    if (it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = false;
+
     return true;
   }
   return false;
 }
 
+bool BulletDiscreteBVHManager::updateCollisionObjectOcTree(const std::string& name,
+                                                           const VectorVector3d& occupied_voxels,
+                                                           const VectorVector3d& free_voxels)
+{
+  auto it = link2cow_.find(name);
+  if (it == link2cow_.end() || !hasOcTreeShapes(*it->second))
+    return false;
+
+  COW& writable = getWritableCollisionObject(it->second);
+  updateOcTreeShapes(writable, occupied_voxels, free_voxels);
+  pair_cache_->remove(&writable);
+  for (auto& worker : workers_)
+    worker->pair_cache->remove(&writable);
+
+  broadphase_.update(writable);
+  return true;
+}
+
 void BulletDiscreteBVHManager::setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose)
 {
   // TODO: Find a way to remove this check. Need to store information in Tesseract EnvState indicating transforms with
   // geometry
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
-  {
-    COWPtr& cow = it->second;
-    cow->setWorldTransform(convertEigenToBt(pose));
-
-    // Now update Broadphase AABB (Copied from BulletWorld updateSingleAabb function)
-    btVector3 minAabb, maxAabb;
-    cow->getCollisionShape()->getAabb(cow->getWorldTransform(), minAabb, maxAabb);
-    // need to increase the aabb for contact thresholds
-    btVector3 contactThreshold(cow->getContactProcessingThreshold(),
-                               cow->getContactProcessingThreshold(),
-                               cow->getContactProcessingThreshold());
-    minAabb -= contactThreshold;
-    maxAabb += contactThreshold;
-
-    // moving objects should be moderately sized, probably something wrong if not
-    if (cow->isStaticObject() || ((maxAabb - minAabb).length2() < btScalar(1e12)))
-    {
-      broadphase_->setAabb(cow->getBroadphaseHandle(), minAabb, maxAabb, dispatcher_.get());
-    }
-    else
-    {
-      // something went wrong, investigate
-      // this assert is unwanted in 3D modelers (danger of loosing work)
-      cow->setActivationState(DISABLE_SIMULATION);
-    }
-  }
+    setCollisionObjectsTransform(it->second->getLinkId(), pose);
+}
+
+void BulletDiscreteBVHManager::setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose)
+{
+  const COWPtr& cow = getCollisionObject(id2cow_, link_id);
+  if (!cow)
+    return;
+
+  btTransform transform = convertEigenToBt(pose);
+  if (transform == cow->getWorldTransform())
+    return;
+
+  COW& writable = getWritableCollisionObject(cow);
+  writable.setWorldTransform(transform);
+  broadphase_.update(writable);
 }
 
 void BulletDiscreteBVHManager::setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -441,37 +516,37 @@ void BulletDiscreteBVHManager::setCollisionObjectsTransform(const TransformMap&
     setCollisionObjectsTransform(transform.first, transform.second);
 }
 
+void BulletDiscreteBVHManager::setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                                            const VectorIsometry3d& poses)
+{
+  assert(link_ids.size() == poses.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], poses[i]);
+}
+
+void BulletDiscreteBVHManager::setCollisionObjectsTransform(const VectorIsometry3d& link_transforms)
+{
+  // Only the leaves are updated, the kinematic BVH is refit once before the next contact test
+  const std::size_t size = std::min(id2cow_.size(), link_transforms.size());
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    if (id2cow_[i])
+      setCollisionObjectsTransform(static_cast<int>(i), link_transforms[i]);
+  }
+}
+
 void BulletDiscreteBVHManager::setContactRequest(const ContactRequest& req)
 {
   request_ = req;
 
-  // Now need to update the broadphase with correct aabb
+  // Objects are moved between the static and kinematic BVH if their group changed, the AABBs only change with the
+  // contact distance
   for (auto& co : link2cow_)
   {
-    COWPtr& cow = co.second;
-
-    updateCollisionObjectWithRequest(request_, *cow);
-
-    btVector3 minAabb, maxAabb;
-    cow->getCollisionShape()->getAabb(cow->getWorldTransform(), minAabb, maxAabb);
-    // need to increase the aabb for contact thresholds
-    btVector3 contactThreshold(cow->getContactProcessingThreshold(),
-                               cow->getContactProcessingThreshold(),
-                               cow->getContactProcessingThreshold());
-    minAabb -= contactThreshold;
-    maxAabb += contactThreshold;
+    if (needsRequestUpdate(request_, *co.second))
+      updateCollisionObjectWithRequest(request_, getWritableCollisionObject(co.second));
 
-    // moving objects should be moderately sized, probably something wrong if not
-    if (cow->isStaticObject() || ((maxAabb - minAabb).length2() < btScalar(1e12)))
-    {
-      broadphase_->setAabb(cow->getBroadphaseHandle(), minAabb, maxAabb, dispatcher_.get());
-    }
-    else
-    {
-      // something went wrong, investigate
-      // this assert is unwanted in 3D modelers (danger of loosing work)
-      cow->setActivationState(DISABLE_SIMULATION);
-    }
+    broadphase_.update(*co.second);
   }
 }
 
@@ -479,54 +554,222 @@ const ContactRequest& BulletDiscreteBVHManager::getContactRequest() const { retu
 void BulletDiscreteBVHManager::contactTest(ContactResultMap& collisions)
 {
   ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
 
-  broadphase_->calculateOverlappingPairs(dispatcher_.get());
+void BulletDiscreteBVHManager::contactTest(ContactResultIdMap& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
 
-  btOverlappingPairCache* pairCache = broadphase_->getOverlappingPairCache();
+void BulletDiscreteBVHManager::contactTest(ContactResultBuffer& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+bool BulletDiscreteBVHManager::isCollisionFree()
+{
+  ContactDistanceData cdata(&request_);
+  contactTest(cdata);
+  return !cdata.done;
+}
 
-  TesseractCollisionPairCallback collisionCallback(dispatch_info_, dispatcher_.get(), cdata);
+void BulletDiscreteBVHManager::setStatisticsEnabled(bool enabled) { stats_enabled_ = enabled; }
+bool BulletDiscreteBVHManager::isStatisticsEnabled() const { return stats_enabled_; }
+const ContactTestStatistics& BulletDiscreteBVHManager::getStatistics() const { return stats_; }
+void BulletDiscreteBVHManager::clearStatistics() { stats_.clear(); }
 
-  pairCache->processAllOverlappingPairs(&collisionCallback, dispatcher_.get());
+void BulletDiscreteBVHManager::setNarrowphaseThreads(unsigned num_threads)
+{
+  narrowphase_threads_ = num_threads;
+  if (narrowphase_threads_ != 0 && workers_.size() > narrowphase_threads_)
+  {
+    workers_.resize(narrowphase_threads_);
+    thread_pool_.reset();
+  }
 }
 
-void BulletDiscreteBVHManager::addCollisionObject(const COWPtr& cow)
+unsigned BulletDiscreteBVHManager::getNarrowphaseThreads() const { return narrowphase_threads_; }
+void BulletDiscreteBVHManager::contactTest(ContactDistanceData& cdata)
 {
-  link2cow_[cow->getName()] = cow;
+  ContactTestStatisticsCollector stats(cdata, stats_enabled_ ? &stats_ : nullptr);
+
+  // Only the kinematic objects are checked against each other and against the static objects
+  pairs_.clear();
+  broadphase_.findOverlappingPairs([this](const COW& cow1, const COW& cow2) { pairs_.emplace_back(&cow1, &cow2); });
+
+  // The number of threads does not depend on the number of pairs, so pairs stay assigned to the same thread
+  long num_workers = getNumWorkerThreads(std::numeric_limits<long>::max(), narrowphase_threads_);
+  if (num_workers > 1 && static_cast<long>(pairs_.size()) >= num_workers * BULLET_NARROWPHASE_MIN_PAIRS_PER_THREAD)
+  {
+    contactTestParallel(cdata, num_workers);
+  }
+  else
+  {
+    for (const auto& pair : pairs_)
+    {
+      processOverlappingPair(*pair.first, *pair.second, *pair_cache_, dispatch_info_, cdata);
+      if (cdata.done)
+        break;
+    }
+  }
+
+  // The state of pairs which were not checked by this query is released, including the caches of idle workers
+  pair_cache_->evict();
+  for (auto& worker : workers_)
+    worker->pair_cache->evict();
+}
+
+/**
+ * @brief Get the thread checking an overlapping pair
+ *
+ * The pointers of the collision objects are mixed, their low bits are the same for all objects because of alignment.
+ *
+ * @param cow1 The first collision object
+ * @param cow2 The second collision object
+ * @param num_workers The number of threads
+ * @return The index of the thread
+ */
+static std::size_t getPairWorker(const COW* cow1, const COW* cow2, std::size_t num_workers)
+{
+  std::uint64_t h = reinterpret_cast<std::uintptr_t>(cow1) * 0x9e3779b97f4a7c15ull;
+  h += reinterpret_cast<std::uintptr_t>(cow2);
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+  return static_cast<std::size_t>((h ^ (h >> 31)) % num_workers);
+}
+
+void BulletDiscreteBVHManager::contactTestParallel(ContactDistanceData& cdata, long num_workers)
+{
+  while (static_cast<long>(workers_.size()) < num_workers)
+    workers_.emplace_back(new NarrowphaseWorker());
+
+  if (thread_pool_ == nullptr)
+    thread_pool_.reset(new WorkerThreadPool());
+
+  const std::size_t size = static_cast<std::size_t>(num_workers);
+
+  // A pair is always checked by the same thread, which keeps its narrowphase state cached
+  worker_pairs_.resize(size);
+  for (auto& worker_pairs : worker_pairs_)
+    worker_pairs.clear();
+
+  for (std::size_t i = 0; i < pairs_.size(); ++i)
+    worker_pairs_[getPairWorker(pairs_[i].first, pairs_[i].second, size)].push_back(i);
+
+  // Each thread stores its contacts in its own container, they are merged in thread order afterwards
+  std::vector<ContactResultMap> res(size);
+  std::vector<ContactResultIdMap> id_res(size);
+  std::vector<ContactTestStatistics> thread_stats(size);
+  std::vector<unsigned char> thread_done(size, 0);
+  std::atomic<bool> cancel(false);
+
+  // Only the first contact of any thread is needed for FIRST requests and queries without results
+  const bool first_only = !cdata.storesResults() || cdata.req->type == ContactRequestType::FIRST;
+
+  auto start = std::chrono::steady_clock::now();
+  thread_pool_->run(num_workers, [&](long worker_index) {
+    std::size_t w = static_cast<std::size_t>(worker_index);
+    NarrowphaseWorker& worker = *workers_[w];
+
+    ContactDistanceData thread_cdata(cdata.req);
+    if (cdata.res != nullptr)
+      thread_cdata.res = &res[w];
+    else if (cdata.storesResults())
+      thread_cdata.id_res = &id_res[w];
+
+    if (cdata.stats != nullptr)
+      thread_cdata.stats = &thread_stats[w];
+
+    for (std::size_t i : worker_pairs_[w])
+    {
+      if (cancel.load(std::memory_order_relaxed))
+        break;
 
-  // calculate new AABB
-  btTransform trans = cow->getWorldTransform();
+      const auto& pair = pairs_[i];
+      processOverlappingPair(*pair.first, *pair.second, *worker.pair_cache, dispatch_info_, thread_cdata);
+      if (thread_cdata.done)
+      {
+        thread_done[w] = 1;
+        if (first_only)
+          cancel = true;
 
-  btVector3 minAabb;
-  btVector3 maxAabb;
-  cow->getCollisionShape()->getAabb(trans, minAabb, maxAabb);
+        break;
+      }
+    }
+  });
 
-  // need to increase the aabb for contact thresholds
-  btVector3 contactThreshold(
-      cow->getContactProcessingThreshold(), cow->getContactProcessingThreshold(), cow->getContactProcessingThreshold());
-  minAabb -= contactThreshold;
-  maxAabb += contactThreshold;
+  if (cdata.stats != nullptr)
+  {
+    for (const auto& s : thread_stats)
+      mergeNarrowphaseStatistics(*cdata.stats, s);
 
-  int type = cow->getCollisionShape()->getShapeType();
-  cow->setBroadphaseHandle(broadphase_->createProxy(
-      minAabb, maxAabb, type, cow.get(), cow->m_collisionFilterGroup, cow->m_collisionFilterMask, dispatcher_.get()));
+    cdata.stats->narrowphase_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  for (std::size_t w = 0; w < size && !cdata.done; ++w)
+  {
+    if (cdata.res != nullptr)
+      mergeContactResults(cdata, res[w]);
+    else if (cdata.storesResults())
+      mergeContactResults(cdata, id_res[w]);
+    else if (thread_done[w])
+      cdata.done = true;
+  }
 }
 
-const Link2Cow& BulletDiscreteBVHManager::getCollisionObjects() const { return link2cow_; }
-void BulletDiscreteBVHManager::contactTest(const COWPtr& cow, ContactDistanceData& collisions)
+void BulletDiscreteBVHManager::addCollisionObject(const COWPtr& cow)
 {
-  btVector3 aabbMin, aabbMax;
-  cow->getCollisionShape()->getAabb(cow->getWorldTransform(), aabbMin, aabbMax);
+  auto it = link2cow_.find(cow->getName());
+  if (it != link2cow_.end())
+  {
+    broadphase_.remove(*it->second);
+    pair_cache_->remove(it->second.get());
+    for (auto& worker : workers_)
+      worker->pair_cache->remove(it->second.get());
+  }
 
-  // need to increase the aabb for contact thresholds
-  btVector3 contactThreshold1(
-      cow->getContactProcessingThreshold(), cow->getContactProcessingThreshold(), cow->getContactProcessingThreshold());
-  aabbMin -= contactThreshold1;
-  aabbMax += contactThreshold1;
+  cow->setOwner(owner_tag_);
+  link2cow_[cow->getName()] = cow;
+  indexCollisionObject(*link_registry_, id2cow_, cow);
+  broadphase_.update(*cow);
+}
 
-  DiscreteCollisionCollector cc(collisions, cow, cow->getContactProcessingThreshold());
+const Link2Cow& BulletDiscreteBVHManager::getCollisionObjects() const { return link2cow_; }
+void BulletDiscreteBVHManager::setLinkRegistry(NameRegistryPtr registry)
+{
+  // Objects shared with a clone are copied before their link id changes
+  for (auto& element : link2cow_)
+  {
+    if (registry->find(element.first) != element.second->getLinkId())
+      getWritableCollisionObject(element.second);
+  }
 
-  TesseractSingleContactCallback contactCB(cow.get(), dispatcher_.get(), dispatch_info_, cc);
+  link_registry_ = registry;
+  id2cow_.clear();
+  for (auto& element : link2cow_)
+    indexCollisionObject(*link_registry_, id2cow_, element.second);
+}
 
-  broadphase_->aabbTest(aabbMin, aabbMax, contactCB);
+COW& BulletDiscreteBVHManager::getWritableCollisionObject(const COWPtr& cow)
+{
+  if (cow->isOwnedBy(owner_tag_))
+    return *cow;
+
+  COWPtr shared = cow;
+  COWPtr copy = shared->clone();
+  copy->setOwner(owner_tag_);
+  broadphase_.replace(*shared, *copy);
+  pair_cache_->remove(shared.get());
+  for (auto& worker : workers_)
+    worker->pair_cache->remove(shared.get());
+
+  link2cow_[copy->getName()] = copy;
+  if (getCollisionObject(id2cow_, copy->getLinkId()) == shared)
+    id2cow_[static_cast<std::size_t>(copy->getLinkId())] = copy;
+
+  return *copy;
 }
 }
@@ -0,0 +1,23 @@
+#include <class_loader/class_loader.h>
+#include <tesseract_collision/bullet/bullet_discrete_managers.h>
+#include <tesseract_collision/bullet/bullet_cast_managers.h>
+
+#ifdef BT_USE_DOUBLE_PRECISION
+#error "The bullet float plugin must be built against a single precision bullet"
+#endif
+
+// The class loader registers plugins by the name of the class, these names keep the single precision managers
+// apart from the double precision managers of the bullet plugin if both libraries are loaded.
+namespace tesseract
+{
+typedef BulletDiscreteSimpleManager BulletFloatDiscreteSimpleManager;
+typedef BulletDiscreteBVHManager BulletFloatDiscreteBVHManager;
+typedef BulletCastSimpleManager BulletFloatCastSimpleManager;
+typedef BulletCastBVHManager BulletFloatCastBVHManager;
+}
+
+CLASS_LOADER_REGISTER_CLASS(tesseract::BulletFloatDiscreteSimpleManager, tesseract::DiscreteContactManagerBase)
+CLASS_LOADER_REGISTER_CLASS(tesseract::BulletFloatDiscreteBVHManager, tesseract::DiscreteContactManagerBase)
+
+CLASS_LOADER_REGISTER_CLASS(tesseract::BulletFloatCastSimpleManager, tesseract::ContinuousContactManagerBase)
+CLASS_LOADER_REGISTER_CLASS(tesseract::BulletFloatCastBVHManager, tesseract::ContinuousContactManagerBase)
@@ -44,11 +44,15 @@
 #pragma GCC diagnostic ignored "-Wall"
 #pragma GCC diagnostic ignored "-Wint-to-pointer-cast"
 #include <BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
 #include <BulletCollision/CollisionShapes/btShapeHull.h>
 #include <BulletCollision/Gimpact/btGImpactShape.h>
 #pragma GCC diagnostic pop
 
 #include "tesseract_collision/bullet/bullet_utils.h"
+#include "tesseract_collision/convex_decomposition.h"
+#include "tesseract_collision/geometry_cache.h"
+#include "tesseract_collision/sphere_decomposition.h"
 #include <boost/thread/mutex.hpp>
 #include <geometric_shapes/shapes.h>
 #include <memory>
@@ -86,13 +90,60 @@ btCollisionShape* createShapePrimitive(const shapes::Cone* geom,
   return (new btConeShapeZ(geom->radius, geom->length));
 }
 
+/**
+ * @brief Create a BVH triangle mesh shape, the BVH is loaded from the geometry cache if it exists
+ *
+ * The serialized BVH is used in place from the memory mapped cache file, which is added to data so it
+ * lives as long as the shape.
+ */
+static btCollisionShape* createBvhTriangleMeshShape(const shapes::Mesh* geom,
+                                                    const std::shared_ptr<btTriangleMesh>& ptrimesh,
+                                                    std::vector<std::shared_ptr<void>>& data)
+{
+  // The serialized BVH depends on the bullet version and precision, both precisions may share the cache
+  const std::uint32_t format = static_cast<std::uint32_t>(BT_BULLET_VERSION * 100 + sizeof(btScalar));
+  GeometryCacheKey key;
+  key.add(geom->vertices, 3 * geom->vertex_count * sizeof(double));
+  key.add(geom->triangles, 3 * geom->triangle_count * sizeof(unsigned int));
+  std::string path = getGeometryCacheFilePath(sizeof(btScalar) == sizeof(double) ? "bvh" : "bvh_float", key);
+
+  std::size_t size;
+  std::shared_ptr<char> mapping = mapGeometryCacheFile(path, key, format, size);
+  if (mapping != nullptr)
+  {
+    btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace(mapping.get(), static_cast<unsigned>(size), false);
+    if (bvh != nullptr)
+    {
+      data.push_back(mapping);
+      btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape(ptrimesh.get(), true, false);
+      shape->setOptimizedBvh(bvh);
+      return shape;
+    }
+  }
+
+  btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape(ptrimesh.get(), true);
+  if (path.empty())
+    return shape;
+
+  const btOptimizedBvh* bvh = shape->getOptimizedBvh();
+  unsigned buffer_size = bvh->calculateSerializeBufferSize();
+  void* buffer = btAlignedAlloc(buffer_size, 16);
+  if (bvh->serializeInPlace(buffer, buffer_size, false))
+    writeGeometryCacheFile(path, key, format, buffer, buffer_size);
+
+  btAlignedFree(buffer);
+  return shape;
+}
+
 btCollisionShape* createShapePrimitive(const shapes::Mesh* geom,
                                        const CollisionObjectType& collision_object_type,
-                                       CollisionObjectWrapper* cow)
+                                       std::vector<std::shared_ptr<void>>& data)
 {
   assert(collision_object_type == CollisionObjectType::UseShapeType ||
          collision_object_type == CollisionObjectType::ConvexHull ||
-         collision_object_type == CollisionObjectType::SDF);
+         collision_object_type == CollisionObjectType::SDF ||
+         collision_object_type == CollisionObjectType::MultiSphere ||
+         collision_object_type == CollisionObjectType::ConvexDecomposition);
 
   if (geom->vertex_count > 0 && geom->triangle_count > 0)
   {
@@ -124,7 +175,7 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom,
         for (unsigned int i = 0; i < geom->vertex_count; ++i)
           input.push_back(Eigen::Vector3d(geom->vertices[3 * i], geom->vertices[3 * i + 1], geom->vertices[3 * i + 2]));
 
-        if (tesseract::createConvexHull(vertices, faces, input) < 0)
+        if (tesseract::createCachedConvexHull(vertices, faces, input) < 0)
           return nullptr;
 
         btConvexHullShape* subshape = new btConvexHullShape();
@@ -135,8 +186,72 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom,
       }
       case CollisionObjectType::UseShapeType:
       {
-        cow->manage(ptrimesh);
-        return (new btBvhTriangleMeshShape(ptrimesh.get(), true));
+        data.push_back(ptrimesh);
+        return createBvhTriangleMeshShape(geom, ptrimesh, data);
+      }
+      case CollisionObjectType::SDF:
+      {
+        SignedDistanceFieldPtr sdf = createCachedSignedDistanceField(*geom);
+        if (sdf == nullptr)
+          return nullptr;
+
+        return new SignedDistanceFieldShape(sdf);
+      }
+      case CollisionObjectType::MultiSphere:
+      {
+        // The dynamic AABB tree of the compound shape is the sphere tree
+        tesseract::VectorVector3d centers;
+        std::vector<double> radii;
+        if (createSphereDecomposition(centers, radii, *geom) <= 0)
+          return nullptr;
+
+        btCompoundShape* subshape =
+            new btCompoundShape(/*dynamicAABBtree=*/BULLET_COMPOUND_USE_DYNAMIC_AABB, static_cast<int>(centers.size()));
+        for (std::size_t i = 0; i < centers.size(); ++i)
+        {
+          btTransform geomTrans;
+          geomTrans.setIdentity();
+          geomTrans.setOrigin(convertEigenToBt(centers[i]));
+          btSphereShape* childshape = new btSphereShape(radii[i]);
+          childshape->setMargin(BULLET_MARGIN);
+          data.push_back(std::shared_ptr<btCollisionShape>(childshape));
+
+          subshape->addChildShape(geomTrans, childshape);
+        }
+        return subshape;
+      }
+      case CollisionObjectType::ConvexDecomposition:
+      {
+        std::vector<tesseract::VectorVector3d> hulls;
+        if (createCachedConvexDecomposition(hulls, *geom) <= 0)
+          return nullptr;
+
+        if (hulls.size() == 1)
+        {
+          btConvexHullShape* subshape = new btConvexHullShape();
+          for (const auto& v : hulls[0])
+            subshape->addPoint(btVector3(v[0], v[1], v[2]));
+
+          return subshape;
+        }
+
+        // Each hull is a convex child, so the cast managers cast them individually
+        btCompoundShape* subshape =
+            new btCompoundShape(/*dynamicAABBtree=*/BULLET_COMPOUND_USE_DYNAMIC_AABB, static_cast<int>(hulls.size()));
+        btTransform geomTrans;
+        geomTrans.setIdentity();
+        for (const auto& hull : hulls)
+        {
+          btConvexHullShape* childshape = new btConvexHullShape();
+          for (const auto& v : hull)
+            childshape->addPoint(btVector3(v[0], v[1], v[2]));
+
+          childshape->setMargin(BULLET_MARGIN);
+          data.push_back(std::shared_ptr<btCollisionShape>(childshape));
+
+          subshape->addChildShape(geomTrans, childshape);
+        }
+        return subshape;
       }
       default:
       {
@@ -149,58 +264,23 @@ btCollisionShape* createShapePrimitive(const shapes::Mesh* geom,
   return nullptr;
 }
 
-btCollisionShape* createShapePrimitive(const shapes::OcTree* geom,
-                                       const CollisionObjectType& collision_object_type,
-                                       CollisionObjectWrapper* cow)
+btCollisionShape* createShapePrimitive(const shapes::OcTree* geom, const CollisionObjectType& collision_object_type)
 {
   assert(collision_object_type == CollisionObjectType::UseShapeType ||
          collision_object_type == CollisionObjectType::ConvexHull ||
          collision_object_type == CollisionObjectType::SDF ||
          collision_object_type == CollisionObjectType::MultiSphere);
 
-  btCompoundShape* subshape = new btCompoundShape(/*dynamicAABBtree=*/BULLET_COMPOUND_USE_DYNAMIC_AABB, geom->octree->size());
-  double occupancy_threshold = geom->octree->getOccupancyThres();
-
   // convert the mesh to the assigned collision object type
   switch (collision_object_type)
   {
     case CollisionObjectType::UseShapeType:
     {
-      for (auto it = geom->octree->begin(geom->octree->getTreeDepth()), end = geom->octree->end(); it != end; ++it)
-      {
-        if (it->getOccupancy() >= occupancy_threshold)
-        {
-          double size = it.getSize();
-          btTransform geomTrans;
-          geomTrans.setIdentity();
-          geomTrans.setOrigin(btVector3(it.getX(), it.getY(), it.getZ()));
-          btBoxShape* childshape = new btBoxShape(btVector3(size / 2, size / 2, size / 2));
-          childshape->setMargin(BULLET_MARGIN);
-          cow->manage(childshape);
-
-          subshape->addChildShape(geomTrans, childshape);
-        }
-      }
-      return subshape;
+      return new OcTreeShape(geom->octree, false);
     }
     case CollisionObjectType::MultiSphere:
     {
-      for (auto it = geom->octree->begin(geom->octree->getTreeDepth()), end = geom->octree->end(); it != end; ++it)
-      {
-        if (it->getOccupancy() >= occupancy_threshold)
-        {
-          double size = it.getSize();
-          btTransform geomTrans;
-          geomTrans.setIdentity();
-          geomTrans.setOrigin(btVector3(it.getX(), it.getY(), it.getZ()));
-          btSphereShape* childshape = new btSphereShape(std::sqrt(2 * ((size / 2) * (size / 2))));
-          childshape->setMargin(BULLET_MARGIN);
-          cow->manage(childshape);
-
-          subshape->addChildShape(geomTrans, childshape);
-        }
-      }
-      return subshape;
+      return new OcTreeShape(geom->octree, true);
     }
     default:
     {
@@ -210,9 +290,16 @@ btCollisionShape* createShapePrimitive(const shapes::OcTree* geom,
   }
 }
 
+/**
+ * @brief Create a bullet collision shape
+ * @param geom The geometric shape
+ * @param collision_object_type The collision object type
+ * @param data (Output) The data referenced by the collision shape which must outlive it
+ * @return The collision shape, nullptr if the shape type is not supported
+ */
 btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
                                        const CollisionObjectType& collision_object_type,
-                                       CollisionObjectWrapper* cow)
+                                       std::vector<std::shared_ptr<void>>& data)
 {
   switch (geom->type)
   {
@@ -234,11 +321,11 @@ btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
     }
     case shapes::MESH:
     {
-      return createShapePrimitive(static_cast<const shapes::Mesh*>(geom.get()), collision_object_type, cow);
+      return createShapePrimitive(static_cast<const shapes::Mesh*>(geom.get()), collision_object_type, data);
     }
     case shapes::OCTREE:
     {
-      return createShapePrimitive(static_cast<const shapes::OcTree*>(geom.get()), collision_object_type, cow);
+      return createShapePrimitive(static_cast<const shapes::OcTree*>(geom.get()), collision_object_type);
     }
     default:
     {
@@ -248,6 +335,655 @@ btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
   }
 }
 
+btCollisionShape* createShapePrimitive(const shapes::ShapeConstPtr& geom,
+                                       const CollisionObjectType& collision_object_type,
+                                       CollisionObjectWrapper* cow)
+{
+  std::vector<std::shared_ptr<void>> data;
+  btCollisionShape* shape = createShapePrimitive(geom, collision_object_type, data);
+  for (const auto& d : data)
+    cow->manage(d);
+
+  return shape;
+}
+
+CollisionShapeCache<btCollisionShape>& getBulletShapeCache()
+{
+  static CollisionShapeCache<btCollisionShape> cache;
+  return cache;
+}
+
+/**
+ * @brief Get the values of the process wide settings a collision shape is created with
+ * @param collision_object_type The collision object type
+ * @return The values of the settings, empty if the shape does not depend on any
+ */
+static std::vector<double> getShapeSettings(const CollisionObjectType& collision_object_type)
+{
+  if (collision_object_type == CollisionObjectType::MultiSphere)
+  {
+    SphereDecompositionSettings settings = getSphereDecompositionSettings();
+    return { settings.max_error, static_cast<double>(settings.max_spheres) };
+  }
+
+  if (collision_object_type == CollisionObjectType::ConvexDecomposition)
+  {
+    ConvexDecompositionSettings settings = getConvexDecompositionSettings();
+    return { settings.max_error, static_cast<double>(settings.max_hulls), static_cast<double>(settings.resolution) };
+  }
+
+  return std::vector<double>();
+}
+
+std::shared_ptr<btCollisionShape> getCachedBulletShape(const shapes::ShapeConstPtr& geom,
+                                                       const CollisionObjectType& collision_object_type)
+{
+  return getBulletShapeCache().get(geom, collision_object_type, getShapeSettings(collision_object_type), [&]() {
+    // The collision shape shares ownership of itself and the data it references
+    std::shared_ptr<std::vector<std::shared_ptr<void>>> data(new std::vector<std::shared_ptr<void>>());
+    btCollisionShape* shape = createShapePrimitive(geom, collision_object_type, *data);
+    if (shape == nullptr)
+      return std::shared_ptr<btCollisionShape>();
+
+    shape->setMargin(BULLET_MARGIN);
+    data->push_back(std::shared_ptr<btCollisionShape>(shape));
+    return std::shared_ptr<btCollisionShape>(data, shape);
+  });
+}
+
+/** @brief Collects the triangles of a concave shape */
+struct SignedDistanceFieldTriangleCallback : public btTriangleCallback
+{
+  SignedDistanceFieldSurface& surface;
+
+  SignedDistanceFieldTriangleCallback(SignedDistanceFieldSurface& surface) : surface(surface) {}
+
+  void processTriangle(btVector3* triangle, int /*partId*/, int /*triangleIndex*/) override
+  {
+    surface.addTriangle(convertBtToEigen(triangle[0]), convertBtToEigen(triangle[1]), convertBtToEigen(triangle[2]));
+  }
+};
+
+/**
+ * @brief Get the surface of a shape queried against a signed distance field
+ * @param shape The shape, for a cast shape the shape being cast
+ * @param surface (Output) The surface in the frame of the shape
+ * @return False if the shape is not supported
+ */
+static bool getSignedDistanceFieldSurface(const btCollisionShape* shape, SignedDistanceFieldSurface& surface)
+{
+  surface.clear();
+  switch (shape->getShapeType())
+  {
+    case SPHERE_SHAPE_PROXYTYPE:
+    {
+      const btSphereShape* sphere = static_cast<const btSphereShape*>(shape);
+      surface.addSegment(Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero(), sphere->getRadius());
+      return true;
+    }
+    case MULTI_SPHERE_SHAPE_PROXYTYPE:
+    {
+      const btMultiSphereShape* multi_sphere = static_cast<const btMultiSphereShape*>(shape);
+      for (int i = 0; i < multi_sphere->getSphereCount(); ++i)
+      {
+        Eigen::Vector3d center = convertBtToEigen(multi_sphere->getSpherePosition(i));
+        surface.addSegment(center, center, multi_sphere->getSphereRadius(i));
+      }
+      return true;
+    }
+    case CAPSULE_SHAPE_PROXYTYPE:
+    {
+      const btCapsuleShape* capsule = static_cast<const btCapsuleShape*>(shape);
+      Eigen::Vector3d axis = Eigen::Vector3d::Zero();
+      axis[capsule->getUpAxis()] = capsule->getHalfHeight();
+      surface.addSegment(-axis, axis, capsule->getRadius());
+      return true;
+    }
+    case BOX_SHAPE_PROXYTYPE:
+    {
+      const btBoxShape* box = static_cast<const btBoxShape*>(shape);
+      surface.addBox(convertBtToEigen(box->getHalfExtentsWithoutMargin()));
+      surface.margin = box->getMargin();
+      return true;
+    }
+    case CYLINDER_SHAPE_PROXYTYPE:
+    {
+      const btCylinderShape* cylinder = static_cast<const btCylinderShape*>(shape);
+      const int axis = cylinder->getUpAxis();
+      const btVector3 half_extents = cylinder->getHalfExtentsWithoutMargin();
+      const double radius = half_extents[(axis + 1) % 3];
+      surface.addFrustum(radius, radius, half_extents[axis], axis);
+      surface.margin += cylinder->getMargin();
+      return true;
+    }
+    case CONE_SHAPE_PROXYTYPE:
+    {
+      const btConeShape* cone = static_cast<const btConeShape*>(shape);
+      surface.addFrustum(cone->getRadius(), 0, cone->getHeight() / 2, cone->getConeUpIndex());
+      surface.margin += cone->getMargin();
+      return true;
+    }
+    case CUSTOM_CONCAVE_SHAPE_TYPE:
+    {
+      // Signed distance fields and octomaps
+      return false;
+    }
+  }
+
+  if (shape->isConcave())
+  {
+    const btConcaveShape* concave = static_cast<const btConcaveShape*>(shape);
+    SignedDistanceFieldTriangleCallback callback(surface);
+    btVector3 aabb_max(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+    concave->processAllTriangles(&callback, -aabb_max, aabb_max);
+    surface.margin = concave->getMargin();
+    return true;
+  }
+
+  // The faces of polyhedral shapes are the faces of the convex hull of their vertices
+  const btPolyhedralConvexShape* polyhedral = dynamic_cast<const btPolyhedralConvexShape*>(shape);
+  if (polyhedral != nullptr)
+  {
+    VectorVector3d input, vertices;
+    std::vector<int> faces;
+    input.reserve(static_cast<std::size_t>(polyhedral->getNumVertices()));
+    for (int i = 0; i < polyhedral->getNumVertices(); ++i)
+    {
+      btVector3 vertex;
+      polyhedral->getVertex(i, vertex);
+      input.push_back(convertBtToEigen(vertex));
+    }
+
+    if (input.empty() || createConvexHull(vertices, faces, input) < 0)
+      return false;
+
+    surface.addPolygons(vertices, faces);
+    surface.margin = polyhedral->getMargin();
+    return true;
+  }
+
+  return false;
+}
+
+SignedDistanceFieldCollisionAlgorithm::SignedDistanceFieldCollisionAlgorithm(
+    btPersistentManifold* mf,
+    const btCollisionAlgorithmConstructionInfo& ci,
+    const btCollisionObjectWrapper* body0Wrap,
+    const btCollisionObjectWrapper* body1Wrap,
+    bool isSwapped)
+  : btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap)
+  , m_ownManifold(false)
+  , m_manifoldPtr(mf)
+  , m_isSwapped(isSwapped)
+  , m_shape(nullptr)
+  , m_surfaceSupported(false)
+{
+  if (!m_manifoldPtr)
+  {
+    m_manifoldPtr = m_dispatcher->getNewManifold(body0Wrap->getCollisionObject(), body1Wrap->getCollisionObject());
+    m_ownManifold = true;
+  }
+}
+
+SignedDistanceFieldCollisionAlgorithm::~SignedDistanceFieldCollisionAlgorithm()
+{
+  if (m_ownManifold && m_manifoldPtr)
+    m_dispatcher->releaseManifold(m_manifoldPtr);
+}
+
+void SignedDistanceFieldCollisionAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap,
+                                                             const btCollisionObjectWrapper* body1Wrap,
+                                                             const btDispatcherInfo& /*dispatchInfo*/,
+                                                             btManifoldResult* resultOut)
+{
+  const btCollisionObjectWrapper* field_wrap = m_isSwapped ? body1Wrap : body0Wrap;
+  const btCollisionObjectWrapper* convex_wrap = m_isSwapped ? body0Wrap : body1Wrap;
+  const SignedDistanceFieldShape* field_shape =
+      static_cast<const SignedDistanceFieldShape*>(field_wrap->getCollisionShape());
+
+  resultOut->setPersistentManifold(m_manifoldPtr);
+
+  // A cast shape is represented by the surface of its shape at all of its transforms
+  const btCollisionShape* shape = convex_wrap->getCollisionShape();
+  const CastHullShape* cast = nullptr;
+  if (shape->getShapeType() == CUSTOM_CONVEX_SHAPE_TYPE)
+  {
+    cast = dynamic_cast<const CastHullShape*>(shape);
+    if (cast != nullptr)
+      shape = cast->m_shape;
+  }
+
+  if (shape != m_shape)
+  {
+    m_shape = shape;
+    m_surfaceSupported = getSignedDistanceFieldSurface(shape, m_surface);
+  }
+
+  if (!m_surfaceSupported)
+  {
+    ROS_WARN_ONCE("Signed distance fields can only be checked against convex shapes and triangle meshes, other "
+                  "signed distance fields and octomaps are ignored");
+    return;
+  }
+
+  const btTransform& field_tf = field_wrap->getWorldTransform();
+  const btTransform tf = field_tf.inverseTimes(convex_wrap->getWorldTransform());
+  const double threshold = resultOut->m_closestPointDistanceThreshold;
+  const SignedDistanceField& field = field_shape->getField();
+  double best = threshold;
+  m_centers.clear();
+  m_radii.clear();
+  addSignedDistanceFieldSamples(field, m_surface, convertBtToEigen(tf), best, m_centers, m_radii);
+  if (cast != nullptr)
+  {
+    addSignedDistanceFieldSamples(field, m_surface, convertBtToEigen(tf * cast->m_t01), best, m_centers, m_radii);
+    for (int i = 0; i < cast->m_waypoints.size(); ++i)
+      addSignedDistanceFieldSamples(
+          field, m_surface, convertBtToEigen(tf * cast->m_waypoints[i]), best, m_centers, m_radii);
+  }
+
+  SignedDistanceFieldContact contact;
+  if (!field.getClosestSample(m_centers, m_radii, contact) || contact.distance > threshold)
+    return;
+
+  // The normal of a contact points from the second object to the first one and the point is on the second object
+  btVector3 normal = field_tf.getBasis() * convertEigenToBt(contact.normal);
+  if (m_isSwapped)
+    resultOut->addContactPoint(normal, field_tf * convertEigenToBt(contact.nearest_points[0]), contact.distance);
+  else
+    resultOut->addContactPoint(-normal, field_tf * convertEigenToBt(contact.nearest_points[1]), contact.distance);
+}
+
+OcTreeCollisionAlgorithm::OcTreeCollisionAlgorithm(const btCollisionAlgorithmConstructionInfo& ci,
+                                                   const btCollisionObjectWrapper* body0Wrap,
+                                                   const btCollisionObjectWrapper* body1Wrap,
+                                                   bool isSwapped)
+  : btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap), m_isSwapped(isSwapped)
+{
+  // The leaf algorithms are always called with the octomap first, so the manifold must have the same order
+  const btCollisionObjectWrapper* octree_wrap = m_isSwapped ? body1Wrap : body0Wrap;
+  const btCollisionObjectWrapper* other_wrap = m_isSwapped ? body0Wrap : body1Wrap;
+  m_manifoldPtr = m_dispatcher->getNewManifold(octree_wrap->getCollisionObject(), other_wrap->getCollisionObject());
+}
+
+OcTreeCollisionAlgorithm::~OcTreeCollisionAlgorithm()
+{
+  if (m_manifoldPtr)
+    m_dispatcher->releaseManifold(m_manifoldPtr);
+}
+
+void OcTreeCollisionAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap,
+                                                const btCollisionObjectWrapper* body1Wrap,
+                                                const btDispatcherInfo& dispatchInfo,
+                                                btManifoldResult* resultOut)
+{
+  const btCollisionObjectWrapper* octree_wrap = m_isSwapped ? body1Wrap : body0Wrap;
+  const btCollisionObjectWrapper* other_wrap = m_isSwapped ? body0Wrap : body1Wrap;
+  const OcTreeShape* octree_shape = static_cast<const OcTreeShape*>(octree_wrap->getCollisionShape());
+
+  // The AABB of the other shape in the frame of the octomap
+  const btTransform& octree_tf = octree_wrap->getWorldTransform();
+  btVector3 aabb_min, aabb_max;
+  other_wrap->getCollisionShape()->getAabb(octree_tf.inverseTimes(other_wrap->getWorldTransform()), aabb_min, aabb_max);
+  btVector3 threshold(resultOut->m_closestPointDistanceThreshold,
+                      resultOut->m_closestPointDistanceThreshold,
+                      resultOut->m_closestPointDistanceThreshold);
+  aabb_min -= threshold;
+  aabb_max += threshold;
+
+  ebtDispatcherQueryType query_type =
+      resultOut->m_closestPointDistanceThreshold > 0 ? BT_CLOSEST_POINT_ALGORITHMS : BT_CONTACT_POINT_ALGORITHMS;
+
+  octree_shape->processAllLeaves(
+      [&](const btVector3& center, btScalar size, int index) {
+        // The leaf shape only lives on the stack for the duration of the query
+        btBoxShape box(btVector3(size / 2, size / 2, size / 2));
+        btSphereShape sphere(octree_shape->getLeafHalfExtent(size));
+        btCollisionShape* leaf_shape = &box;
+        if (octree_shape->usesSpheres())
+          leaf_shape = &sphere;
+        leaf_shape->setMargin(BULLET_MARGIN);
+
+        btTransform leaf_tf(octree_tf.getBasis(), octree_tf * center);
+        btCollisionObjectWrapper leaf_wrap(
+            octree_wrap, leaf_shape, octree_wrap->getCollisionObject(), leaf_tf, -1, index);
+
+        btCollisionAlgorithm* algorithm =
+            m_dispatcher->findAlgorithm(&leaf_wrap, other_wrap, m_manifoldPtr, query_type);
+        if (algorithm == nullptr)
+          return;
+
+        // Substitute the leaf for the octomap in the result like btCompoundCollisionAlgorithm does for its children.
+        // The result may be built in a different order than the algorithm is called, so the side is looked up.
+        const bool octree_is_body1 = resultOut->getBody0Internal() != octree_wrap->getCollisionObject();
+        const btCollisionObjectWrapper* tmp_wrap;
+        if (octree_is_body1)
+        {
+          tmp_wrap = resultOut->getBody1Wrap();
+          resultOut->setBody1Wrap(&leaf_wrap);
+          resultOut->setShapeIdentifiersB(-1, index);
+        }
+        else
+        {
+          tmp_wrap = resultOut->getBody0Wrap();
+          resultOut->setBody0Wrap(&leaf_wrap);
+          resultOut->setShapeIdentifiersA(-1, index);
+        }
+
+        algorithm->processCollision(&leaf_wrap, other_wrap, dispatchInfo, resultOut);
+
+        if (octree_is_body1)
+          resultOut->setBody1Wrap(tmp_wrap);
+        else
+          resultOut->setBody0Wrap(tmp_wrap);
+
+        algorithm->~btCollisionAlgorithm();
+        m_dispatcher->freeCollisionAlgorithm(algorithm);
+      },
+      aabb_min,
+      aabb_max);
+}
+
+/**
+ * @brief Creates the algorithm of the custom concave shape of a pair
+ *
+ * SignedDistanceFieldShape and OcTreeShape share CUSTOM_CONCAVE_SHAPE_TYPE, so the shape is checked when the
+ * algorithm is created. Octomaps take precedence, their leaves are dispatched again against the other shape.
+ */
+struct CustomConcaveCreateFunc : public btCollisionAlgorithmCreateFunc
+{
+  SignedDistanceFieldCollisionAlgorithm::CreateFunc sdf_create_func{ false };
+  SignedDistanceFieldCollisionAlgorithm::CreateFunc sdf_swapped_create_func{ true };
+  OcTreeCollisionAlgorithm::CreateFunc octree_create_func{ false };
+  OcTreeCollisionAlgorithm::CreateFunc octree_swapped_create_func{ true };
+
+  btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci,
+                                                 const btCollisionObjectWrapper* body0Wrap,
+                                                 const btCollisionObjectWrapper* body1Wrap) override
+  {
+    if (dynamic_cast<const OcTreeShape*>(body0Wrap->getCollisionShape()) != nullptr)
+      return octree_create_func.CreateCollisionAlgorithm(ci, body0Wrap, body1Wrap);
+
+    if (dynamic_cast<const OcTreeShape*>(body1Wrap->getCollisionShape()) != nullptr)
+      return octree_swapped_create_func.CreateCollisionAlgorithm(ci, body0Wrap, body1Wrap);
+
+    if (body0Wrap->getCollisionShape()->getShapeType() == CUSTOM_CONCAVE_SHAPE_TYPE)
+      return sdf_create_func.CreateCollisionAlgorithm(ci, body0Wrap, body1Wrap);
+
+    return sdf_swapped_create_func.CreateCollisionAlgorithm(ci, body0Wrap, body1Wrap);
+  }
+};
+
+void registerCustomCollisionAlgorithms(btCollisionDispatcher* dispatcher)
+{
+  static CustomConcaveCreateFunc create_func;
+
+  // Compound shapes keep the default algorithm which dispatches their children
+  for (int i = 0; i < MAX_BROADPHASE_COLLISION_TYPES; ++i)
+  {
+    if (i == COMPOUND_SHAPE_PROXYTYPE)
+      continue;
+
+    dispatcher->registerCollisionCreateFunc(CUSTOM_CONCAVE_SHAPE_TYPE, i, &create_func);
+    dispatcher->registerCollisionCreateFunc(i, CUSTOM_CONCAVE_SHAPE_TYPE, &create_func);
+    dispatcher->registerClosestPointsCreateFunc(CUSTOM_CONCAVE_SHAPE_TYPE, i, &create_func);
+    dispatcher->registerClosestPointsCreateFunc(i, CUSTOM_CONCAVE_SHAPE_TYPE, &create_func);
+  }
+}
+
+/**
+ * @brief Check if the dispatcher hands a pair of shapes to the generic convex algorithm, which runs plain GJK
+ *
+ * Sphere pairs have a dedicated algorithm and capsules are special cased by the convex algorithm.
+ */
+static bool usesGenericConvexAlgorithm(const btCollisionShape* shape0, const btCollisionShape* shape1)
+{
+  int type0 = shape0->getShapeType();
+  int type1 = shape1->getShapeType();
+  if (!btBroadphaseProxy::isConvex(type0) || !btBroadphaseProxy::isConvex(type1))
+    return false;
+
+  if (type0 == CUSTOM_CONVEX_SHAPE_TYPE || type1 == CUSTOM_CONVEX_SHAPE_TYPE)
+    return false;
+
+  if (type0 == CAPSULE_SHAPE_PROXYTYPE || type1 == CAPSULE_SHAPE_PROXYTYPE)
+    return false;
+
+  return !(type0 == SPHERE_SHAPE_PROXYTYPE && type1 == SPHERE_SHAPE_PROXYTYPE);
+}
+
+void NarrowphasePairCache::processCollision(const btCollisionObjectWrapper* obA,
+                                            const btCollisionObjectWrapper* obB,
+                                            const btDispatcherInfo& dispatch_info,
+                                            btManifoldResult* result)
+{
+  // The pair is processed in the order of the result, a pair seen in both orders gets an entry for each of them
+  Key key(obA->getCollisionObject(), obB->getCollisionObject());
+  auto it = entries_.find(key);
+  if (it == entries_.end())
+  {
+    Entry entry;
+    entry.algorithm = nullptr;
+    entry.manifold = nullptr;
+    entry.separating_axis.setValue(0, 1, 0);
+
+    if (usesGenericConvexAlgorithm(obA->getCollisionShape(), obB->getCollisionShape()))
+      entry.manifold = dispatcher_->getNewManifold(obA->getCollisionObject(), obB->getCollisionObject());
+    else
+      entry.algorithm = dispatcher_->findAlgorithm(obA, obB, nullptr, BT_CLOSEST_POINT_ALGORITHMS);
+
+    it = entries_.emplace(key, entry).first;
+  }
+
+  Entry& entry = it->second;
+  entry.query = query_;
+  if (entry.algorithm != nullptr)
+  {
+    entry.algorithm->processCollision(obA, obB, dispatch_info, result);
+    return;
+  }
+
+  if (entry.manifold == nullptr)
+    return;
+
+  // Same as btConvexConvexAlgorithm without the special cases, warm started from the previous separating axis
+  const btConvexShape* shape0 = static_cast<const btConvexShape*>(obA->getCollisionShape());
+  const btConvexShape* shape1 = static_cast<const btConvexShape*>(obB->getCollisionShape());
+  result->setPersistentManifold(entry.manifold);
+
+  btGjkPairDetector::ClosestPointInput input;
+  input.m_maximumDistanceSquared = shape0->getMargin() + shape1->getMargin() +
+                                   entry.manifold->getContactBreakingThreshold() +
+                                   result->m_closestPointDistanceThreshold;
+  input.m_maximumDistanceSquared *= input.m_maximumDistanceSquared;
+  input.m_transformA = obA->getWorldTransform();
+  input.m_transformB = obB->getWorldTransform();
+
+  btGjkPairDetector gjk(shape0, shape1, &simplex_solver_, &pd_solver_);
+  gjk.setCachedSeperatingAxis(entry.separating_axis);
+  gjk.getClosestPoints(input, *result, dispatch_info.m_debugDraw);
+
+  entry.separating_axis = gjk.getCachedSeparatingAxis();
+  if (entry.separating_axis.fuzzyZero())
+    entry.separating_axis.setValue(0, 1, 0);
+}
+
+void NarrowphasePairCache::remove(const btCollisionObject* object)
+{
+  for (auto it = entries_.begin(); it != entries_.end();)
+  {
+    if (it->first.first == object || it->first.second == object)
+    {
+      release(it->second);
+      it = entries_.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void NarrowphasePairCache::clear()
+{
+  for (auto& entry : entries_)
+    release(entry.second);
+
+  entries_.clear();
+}
+
+void NarrowphasePairCache::evict()
+{
+  for (auto it = entries_.begin(); it != entries_.end();)
+  {
+    if (it->second.query != query_)
+    {
+      release(it->second);
+      it = entries_.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  ++query_;
+}
+
+void NarrowphasePairCache::release(Entry& entry)
+{
+  if (entry.algorithm != nullptr)
+  {
+    entry.algorithm->~btCollisionAlgorithm();
+    dispatcher_->freeCollisionAlgorithm(entry.algorithm);
+    entry.algorithm = nullptr;
+  }
+
+  if (entry.manifold != nullptr)
+  {
+    dispatcher_->releaseManifold(entry.manifold);
+    entry.manifold = nullptr;
+  }
+}
+
+NarrowphaseWorker::NarrowphaseWorker() : coll_config(getCollisionConstructionInfo())
+{
+  dispatcher.reset(new btCollisionDispatcher(&coll_config));
+
+  dispatcher->registerCollisionCreateFunc(
+      BOX_SHAPE_PROXYTYPE,
+      BOX_SHAPE_PROXYTYPE,
+      coll_config.getCollisionAlgorithmCreateFunc(CONVEX_SHAPE_PROXYTYPE, CONVEX_SHAPE_PROXYTYPE));
+
+  registerCustomCollisionAlgorithms(dispatcher.get());
+
+  dispatcher->setDispatcherFlags(dispatcher->getDispatcherFlags() &
+                                 ~btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD);
+
+  pair_cache.reset(new NarrowphasePairCache(dispatcher.get()));
+}
+
+void processOverlappingPair(const COW& cow1,
+                            const COW& cow2,
+                            NarrowphasePairCache& pair_cache,
+                            const btDispatcherInfo& dispatch_info,
+                            ContactDistanceData& cdata)
+{
+  if (!needsCollisionCheck(cow1, cow2, cdata, false))
+    return;
+
+  btCollisionObjectWrapper obj0Wrap(0, cow1.getCollisionShape(), &cow1, cow1.getWorldTransform(), -1, -1);
+  btCollisionObjectWrapper obj1Wrap(0, cow2.getCollisionShape(), &cow2, cow2.getWorldTransform(), -1, -1);
+
+  TesseractBroadphaseBridgedManifoldResult contactPointResult(&obj0Wrap, &obj1Wrap, cdata);
+  contactPointResult.m_closestPointDistanceThreshold = cdata.req->contact_distance;
+
+  NarrowphaseStatisticsCollector stats(
+      cdata.stats, cow1.getCollisionShape()->getShapeType(), cow2.getCollisionShape()->getShapeType());
+  pair_cache.processCollision(&obj0Wrap, &obj1Wrap, dispatch_info, &contactPointResult);
+}
+
+bool hasOcTreeShapes(const COW& cow)
+{
+  const btCollisionShape* shape = cow.getCollisionShape();
+  if (dynamic_cast<const OcTreeShape*>(shape) != nullptr)
+    return true;
+
+  if (!shape->isCompound())
+    return false;
+
+  const btCompoundShape* compound = static_cast<const btCompoundShape*>(shape);
+  for (int i = 0; i < compound->getNumChildShapes(); ++i)
+  {
+    if (dynamic_cast<const OcTreeShape*>(compound->getChildShape(i)) != nullptr)
+      return true;
+  }
+
+  return false;
+}
+
+/** @brief Copy an octomap shape with the voxels of its octomap updated */
+static std::shared_ptr<OcTreeShape> createUpdatedOcTreeShape(const OcTreeShape& octree,
+                                                             const VectorVector3d& occupied_voxels,
+                                                             const VectorVector3d& free_voxels,
+                                                             const VectorVector3d& changed_voxels)
+{
+  std::shared_ptr<OcTreeShape> copy(new OcTreeShape(octree));
+  copy->updateOcTree(createUpdatedOcTree(octree.getOcTree(), occupied_voxels, free_voxels), changed_voxels);
+  return copy;
+}
+
+bool updateOcTreeShapes(COW& cow, const VectorVector3d& occupied_voxels, const VectorVector3d& free_voxels)
+{
+  VectorVector3d changed_voxels;
+  changed_voxels.reserve(occupied_voxels.size() + free_voxels.size());
+  changed_voxels.insert(changed_voxels.end(), occupied_voxels.begin(), occupied_voxels.end());
+  changed_voxels.insert(changed_voxels.end(), free_voxels.begin(), free_voxels.end());
+
+  btCollisionShape* shape = cow.getCollisionShape();
+  const OcTreeShape* octree = dynamic_cast<const OcTreeShape*>(shape);
+  if (octree != nullptr)
+  {
+    std::shared_ptr<OcTreeShape> copy = createUpdatedOcTreeShape(*octree, occupied_voxels, free_voxels, changed_voxels);
+    cow.setCollisionShape(copy.get());
+    cow.replaceManaged(shape, copy);
+    return true;
+  }
+
+  if (!hasOcTreeShapes(cow))
+    return false;
+
+  // The children are added again so the dynamic AABB tree of the compound shape stores their new bounds
+  const btCompoundShape* compound = static_cast<const btCompoundShape*>(shape);
+  std::shared_ptr<btCompoundShape> compound_copy(
+      new btCompoundShape(/*dynamicAABBtree=*/BULLET_COMPOUND_USE_DYNAMIC_AABB, compound->getNumChildShapes()));
+  compound_copy->setMargin(compound->getMargin());
+
+  std::vector<std::pair<const btCollisionShape*, std::shared_ptr<OcTreeShape>>> replaced;
+  for (int i = 0; i < compound->getNumChildShapes(); ++i)
+  {
+    const btCollisionShape* child = compound->getChildShape(i);
+    octree = dynamic_cast<const OcTreeShape*>(child);
+    if (octree == nullptr)
+    {
+      compound_copy->addChildShape(compound->getChildTransform(i), const_cast<btCollisionShape*>(child));
+      continue;
+    }
+
+    std::shared_ptr<OcTreeShape> copy = createUpdatedOcTreeShape(*octree, occupied_voxels, free_voxels, changed_voxels);
+    compound_copy->addChildShape(compound->getChildTransform(i), copy.get());
+    replaced.emplace_back(child, copy);
+  }
+
+  // The old shapes are released last, they may only be owned by this collision object
+  cow.setCollisionShape(compound_copy.get());
+  cow.replaceManaged(shape, compound_copy);
+  for (auto& r : replaced)
+    cow.replaceManaged(r.first, r.second);
+
+  return true;
+}
+
 CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name,
                                                const int& type_id,
                                                const std::vector<shapes::ShapeConstPtr>& shapes,
@@ -255,9 +991,11 @@ CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name,
                                                const CollisionObjectTypeVector& collision_object_types)
   : m_name(name)
   , m_type_id(type_id)
+  , m_link_id(-1)
   , m_shapes(shapes)
   , m_shape_poses(shape_poses)
   , m_collision_object_types(collision_object_types)
+  , m_owner(0)
 {
   assert(!shapes.empty());
   assert(!shape_poses.empty());
@@ -268,10 +1006,9 @@ CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name,
 
   if (shapes.size() == 1 && m_shape_poses[0].matrix().isIdentity())
   {
-    btCollisionShape* shape = createShapePrimitive(m_shapes[0], collision_object_types[0], this);
-    shape->setMargin(BULLET_MARGIN);
+    std::shared_ptr<btCollisionShape> shape = getCachedBulletShape(m_shapes[0], collision_object_types[0]);
     manage(shape);
-    setCollisionShape(shape);
+    setCollisionShape(shape.get());
   }
   else
   {
@@ -284,13 +1021,24 @@ CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name,
 
     for (std::size_t j = 0; j < m_shapes.size(); ++j)
     {
-      btCollisionShape* subshape = createShapePrimitive(m_shapes[j], collision_object_types[j], this);
-      if (subshape != NULL)
+      std::shared_ptr<btCollisionShape> subshape = getCachedBulletShape(m_shapes[j], collision_object_types[j]);
+      if (subshape != nullptr)
       {
         manage(subshape);
-        subshape->setMargin(BULLET_MARGIN);
         btTransform geomTrans = convertEigenToBt(m_shape_poses[j]);
-        compound->addChildShape(geomTrans, subshape);
+
+        // Flatten compound shapes (sphere decompositions) so every child is a primitive shape
+        if (subshape->isCompound())
+        {
+          const btCompoundShape* child_compound = static_cast<const btCompoundShape*>(subshape.get());
+          for (int i = 0; i < child_compound->getNumChildShapes(); ++i)
+            compound->addChildShape(geomTrans * child_compound->getChildTransform(i),
+                                    const_cast<btCollisionShape*>(child_compound->getChildShape(i)));
+        }
+        else
+        {
+          compound->addChildShape(geomTrans, subshape.get());
+        }
       }
     }
   }
@@ -308,9 +1056,11 @@ CollisionObjectWrapper::CollisionObjectWrapper(const std::string& name,
                                                const std::vector<std::shared_ptr<void>>& data)
   : m_name(name)
   , m_type_id(type_id)
+  , m_link_id(-1)
   , m_shapes(shapes)
   , m_shape_poses(shape_poses)
   , m_collision_object_types(collision_object_types)
+  , m_owner(0)
   , m_data(data)
 {
 }
@@ -0,0 +1,469 @@
+/**
+ * @file fcl_cast_managers.cpp
+ * @brief Tesseract ROS FCL continuous contact checker implementation.
+ *
+ * @date Oct 16, 2018
+ * @version TODO
+ * @bug No known bugs
+ *
+ * @copyright Copyright (c) 2017, Southwest Research Institute
+ *
+ * @par License
+ * Software License Agreement (BSD)
+ * @par
+ * All rights reserved.
+ * @par
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * @par
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ * @par
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tesseract_collision/fcl/fcl_cast_managers.h"
+#include <fcl/geometry/shape/box.h>
+
+
+namespace tesseract
+{
+
+/** @brief The data of a query of the static objects with the swept AABB of a cast object */
+struct FCLCastQueryData
+{
+  const fcl::CollisionObjectd* query; /**< @brief The collision object of the swept AABB */
+  const FCLCastObject* cast;          /**< @brief The cast object */
+  ContactDistanceData* cdata;         /**< @brief The contact query data */
+};
+
+/** @brief Check the cast object of a query against a static object whose AABB overlaps its swept AABB */
+static bool castQueryCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+{
+  FCLCastQueryData* query_data = reinterpret_cast<FCLCastQueryData*>(data);
+  ContactDistanceData& cdata = *query_data->cdata;
+
+  const fcl::CollisionObjectd* other = (o1 == query_data->query) ? o2 : o1;
+  const FCLCollisionObjectWrapper* other_cow = static_cast<const FCLCollisionObjectWrapper*>(other->getUserData());
+  const VectorIsometry3d other_poses(1, other_cow->getCollisionObjectsTransform());
+
+  for (const auto& co : query_data->cast->cow->getCollisionObjects())
+  {
+    if (castCollisionCheck(*co, query_data->cast->poses, *other, other_poses, cdata))
+      return true;
+  }
+
+  return cdata.done;
+}
+
+FCLCastBVHManager::FCLCastBVHManager()
+{
+  manager_ = std::unique_ptr<fcl::BroadPhaseCollisionManagerd>(new fcl::DynamicAABBTreeCollisionManagerd());
+  link_registry_.reset(new NameRegistry());
+  stats_enabled_ = false;
+  broadphase_changed_ = false;
+}
+
+ContinuousContactManagerBasePtr FCLCastBVHManager::clone() const
+{
+  FCLCastBVHManagerPtr manager(new FCLCastBVHManager());
+  manager->setLinkRegistry(link_registry_);
+  manager->setStatisticsEnabled(stats_enabled_);
+
+  for (const auto& cow : link2cow_)
+    manager->addCollisionObject(cow.second->clone());
+
+  manager->setContactRequest(request_);
+
+  for (const auto& cast : link2castcow_)
+    manager->link2castcow_[cast.first].poses = cast.second.poses;
+
+  return manager;
+}
+
+bool FCLCastBVHManager::addCollisionObject(const std::string& name,
+                                           const int& mask_id,
+                                           const std::vector<shapes::ShapeConstPtr>& shapes,
+                                           const VectorIsometry3d& shape_poses,
+                                           const CollisionObjectTypeVector& collision_object_types,
+                                           bool enabled)
+{
+  FCLCOWPtr new_cow = createFCLCollisionObject(name, mask_id, shapes, shape_poses, collision_object_types, enabled);
+  if (new_cow != nullptr)
+  {
+    addCollisionObject(new_cow);
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+bool FCLCastBVHManager::hasCollisionObject(const std::string& name) const
+{
+  return (link2cow_.find(name) != link2cow_.end());
+}
+
+bool FCLCastBVHManager::removeCollisionObject(const std::string& name)
+{
+  auto it = link2cow_.find(name);
+  if (it != link2cow_.end())
+  {
+    // Cast objects are not part of the broadphase
+    if (link2castcow_.erase(name) == 0)
+    {
+      for (auto& co : it->second->getCollisionObjects())
+        manager_->unregisterObject(co.get());
+    }
+
+    unindexCollisionObject(id2cow_, *it->second);
+    link2cow_.erase(it);
+    indexCastObjects();
+    return true;
+  }
+  return false;
+}
+
+bool FCLCastBVHManager::enableCollisionObject(const std::string& name)
+{
+  auto it = link2cow_.find(name);
+  if (it != link2cow_.end())
+  {
+    it->second->m_enabled = true;
+    return true;
+  }
+  return false;
+}
+
+bool FCLCastBVHManager::disableCollisionObject(const std::string& name)
+{
+  auto it = link2cow_.find(name);
+  if (it != link2cow_.end())
+  {
+    it->second->m_enabled = false;
+    return true;
+  }
+  return false;
+}
+
+bool FCLCastBVHManager::updateCollisionObjectOcTree(const std::string& name,
+                                                    const VectorVector3d& occupied_voxels,
+                                                    const VectorVector3d& free_voxels)
+{
+  auto it = link2cow_.find(name);
+  if (it == link2cow_.end() || !it->second->hasOcTrees())
+    return false;
+
+  // Collision objects are copied by clone(), cast objects are not part of the broadphase
+  FCLCOW& cow = *it->second;
+  bool registered = (link2castcow_.find(name) == link2castcow_.end());
+  if (registered)
+  {
+    for (auto& co : cow.getCollisionObjects())
+      manager_->unregisterObject(co.get());
+  }
+
+  cow.updateOcTrees(occupied_voxels, free_voxels);
+  if (registered)
+  {
+    for (auto& co : cow.getCollisionObjects())
+      manager_->registerObject(co.get());
+  }
+
+  broadphase_changed_ = true;
+  return true;
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose)
+{
+  auto it = link2cow_.find(name);
+  if (it != link2cow_.end())
+    setCollisionObjectsTransform(it->second->getLinkId(), pose);
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const std::vector<std::string>& names,
+                                                     const VectorIsometry3d& poses)
+{
+  assert(names.size() == poses.size());
+  for (auto i = 0u; i < names.size(); ++i)
+    setCollisionObjectsTransform(names[i], poses[i]);
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const TransformMap& transforms)
+{
+  for (const auto& transform : transforms)
+    setCollisionObjectsTransform(transform.first, transform.second);
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose)
+{
+  // The motion of cast objects is only updated by the overloads taking two or more poses
+  const FCLCOWPtr& cow = getCollisionObject(id2cow_, link_id);
+  if (cow)
+  {
+    cow->setCollisionObjectsTransform(pose);
+    broadphase_changed_ = true;
+  }
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses)
+{
+  assert(link_ids.size() == poses.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], poses[i]);
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const VectorIsometry3d& link_transforms)
+{
+  const std::size_t size = std::min(id2cow_.size(), link_transforms.size());
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    if (id2cow_[i])
+      id2cow_[i]->setCollisionObjectsTransform(link_transforms[i]);
+  }
+
+  broadphase_changed_ = true;
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const std::string& name,
+                                                     const Eigen::Isometry3d& pose1,
+                                                     const Eigen::Isometry3d& pose2)
+{
+  auto it = link2castcow_.find(name);
+  if (it != link2castcow_.end())
+    it->second.poses = { pose1, pose2 };
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const std::vector<std::string>& names,
+                                                     const VectorIsometry3d& pose1,
+                                                     const VectorIsometry3d& pose2)
+{
+  assert(names.size() == pose1.size() && names.size() == pose2.size());
+  for (auto i = 0u; i < names.size(); ++i)
+    setCollisionObjectsTransform(names[i], pose1[i], pose2[i]);
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const TransformMap& pose1, const TransformMap& pose2)
+{
+  assert(pose1.size() == pose2.size());
+  for (const auto& transform : pose1)
+  {
+    auto it = pose2.find(transform.first);
+    assert(it != pose2.end());
+    setCollisionObjectsTransform(transform.first, transform.second, it->second);
+  }
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(int link_id,
+                                                     const Eigen::Isometry3d& pose1,
+                                                     const Eigen::Isometry3d& pose2)
+{
+  FCLCastObject* cast = getCastObject(link_id);
+  if (cast)
+    cast->poses = { pose1, pose2 };
+}
+
+void FCLCastBVHManager::setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                                     const VectorIsometry3d& pose1,
+                                                     const VectorIsometry3d& pose2)
+{
+  assert(link_ids.size() == pose1.size() && link_ids.size() == pose2.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], pose1[i], pose2[i]);
+}
+
+void FCLCastBVHManager::setCollisionObjectsSweptTransform(const std::string& name, const VectorIsometry3d& poses)
+{
+  auto it = link2castcow_.find(name);
+  if (it != link2castcow_.end())
+    setCollisionObjectsSweptTransform(it->second.cow->getLinkId(), poses);
+}
+
+void FCLCastBVHManager::setCollisionObjectsSweptTransform(int link_id, const VectorIsometry3d& poses)
+{
+  assert(poses.size() >= 2);
+  FCLCastObject* cast = getCastObject(link_id);
+  if (cast)
+    cast->poses = poses;
+}
+
+void FCLCastBVHManager::contactTest(ContactResultMap& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+void FCLCastBVHManager::contactTest(ContactResultIdMap& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+void FCLCastBVHManager::contactTest(ContactResultBuffer& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+bool FCLCastBVHManager::isCollisionFree()
+{
+  ContactDistanceData cdata(&request_);
+  contactTest(cdata);
+  return !cdata.done;
+}
+
+void FCLCastBVHManager::setStatisticsEnabled(bool enabled) { stats_enabled_ = enabled; }
+bool FCLCastBVHManager::isStatisticsEnabled() const { return stats_enabled_; }
+const ContactTestStatistics& FCLCastBVHManager::getStatistics() const { return stats_; }
+void FCLCastBVHManager::clearStatistics() { stats_.clear(); }
+
+void FCLCastBVHManager::contactTest(ContactDistanceData& cdata)
+{
+  ContactTestStatisticsCollector stats(cdata, stats_enabled_ ? &stats_ : nullptr);
+
+  // The tree is refit once for all objects moved since the last contact test instead of once per object
+  if (broadphase_changed_)
+  {
+    manager_->update();
+    broadphase_changed_ = false;
+  }
+
+  std::vector<const FCLCastObject*> casts;
+  std::vector<fcl::AABBd> aabbs;
+  for (const auto& cast : link2castcow_)
+  {
+    if (!cast.second.cow->m_enabled)
+      continue;
+
+    casts.push_back(&cast.second);
+    aabbs.push_back(getSweptAABB(*cast.second.cow, cast.second.poses, request_.contact_distance));
+  }
+
+  // Cast objects against each other, there are usually few of them
+  for (std::size_t i = 0; i < casts.size(); ++i)
+  {
+    for (std::size_t j = i + 1; j < casts.size(); ++j)
+    {
+      if (!aabbs[i].overlap(aabbs[j]))
+        continue;
+
+      for (const auto& co1 : casts[i]->cow->getCollisionObjects())
+        for (const auto& co2 : casts[j]->cow->getCollisionObjects())
+          if (castCollisionCheck(*co1, casts[i]->poses, *co2, casts[j]->poses, cdata))
+            return;
+    }
+  }
+
+  // Cast objects against the static objects overlapping their swept AABB
+  for (std::size_t i = 0; i < casts.size(); ++i)
+  {
+    fcl::CollisionObjectd query(
+        std::make_shared<fcl::Boxd>(aabbs[i].width(), aabbs[i].height(), aabbs[i].depth()),
+        Eigen::Isometry3d(Eigen::Translation3d(aabbs[i].center())));
+
+    FCLCastQueryData query_data{ &query, casts[i], &cdata };
+    manager_->collide(&query, &query_data, &castQueryCallback);
+    if (cdata.done)
+      return;
+  }
+}
+
+void FCLCastBVHManager::setContactRequest(const ContactRequest& req)
+{
+  request_ = req;
+
+  // The cast objects are removed from the broadphase and the static objects are added back
+  for (auto& co : link2cow_)
+  {
+    FCLCOWPtr& cow = co.second;
+    updateCollisionObjectWithRequest(request_, *cow);
+
+    bool active = (std::find(req.link_names.begin(), req.link_names.end(), cow->getName()) != req.link_names.end());
+    auto it = link2castcow_.find(co.first);
+    if (active && it == link2castcow_.end())
+    {
+      for (auto& fcl_co : cow->getCollisionObjects())
+        manager_->unregisterObject(fcl_co.get());
+
+      FCLCastObject& cast = link2castcow_[co.first];
+      cast.cow = cow;
+      cast.poses.assign(1, cow->getCollisionObjectsTransform());
+    }
+    else if (!active && it != link2castcow_.end())
+    {
+      link2castcow_.erase(it);
+      for (auto& fcl_co : cow->getCollisionObjects())
+        manager_->registerObject(fcl_co.get());
+    }
+  }
+
+  indexCastObjects();
+}
+
+const ContactRequest& FCLCastBVHManager::getContactRequest() const { return request_; }
+
+void FCLCastBVHManager::addCollisionObject(const FCLCOWPtr& cow)
+{
+  link2cow_[cow->getName()] = cow;
+  indexCollisionObject(*link_registry_, id2cow_, cow);
+
+  // Objects are static until they are made active by the contact request
+  std::vector<FCLCollisionObjectPtr>& objects = cow->getCollisionObjects();
+  for (auto& co : objects)
+    manager_->registerObject(co.get());
+}
+
+const Link2FCLCOW& FCLCastBVHManager::getCollisionObjects() const { return link2cow_; }
+
+void FCLCastBVHManager::setLinkRegistry(NameRegistryPtr registry)
+{
+  link_registry_ = registry;
+  id2cow_.clear();
+  for (auto& element : link2cow_)
+    indexCollisionObject(*link_registry_, id2cow_, element.second);
+
+  indexCastObjects();
+}
+
+FCLCastObject* FCLCastBVHManager::getCastObject(int link_id) const
+{
+  if (link_id < 0 || static_cast<std::size_t>(link_id) >= id2castcow_.size())
+    return nullptr;
+
+  return id2castcow_[static_cast<std::size_t>(link_id)];
+}
+
+void FCLCastBVHManager::indexCastObjects()
+{
+  id2castcow_.clear();
+  for (auto& cast : link2castcow_)
+  {
+    int link_id = cast.second.cow->getLinkId();
+    if (link_id < 0)
+      continue;
+
+    if (static_cast<std::size_t>(link_id) >= id2castcow_.size())
+      id2castcow_.resize(static_cast<std::size_t>(link_id) + 1, nullptr);
+
+    id2castcow_[static_cast<std::size_t>(link_id)] = &cast.second;
+  }
+}
+
+}
@@ -49,22 +49,31 @@ namespace tesseract
 FCLDiscreteBVHManager::FCLDiscreteBVHManager()
 {
   manager_ = std::unique_ptr<fcl::BroadPhaseCollisionManagerd>(new fcl::DynamicAABBTreeCollisionManagerd());
+  link_registry_.reset(new NameRegistry());
+  stats_enabled_ = false;
+  broadphase_changed_ = false;
+  owner_tag_ = createOwnerTag();
 }
 
 DiscreteContactManagerBasePtr FCLDiscreteBVHManager::clone() const
 {
   FCLDiscreteBVHManagerPtr manager(new FCLDiscreteBVHManager());
+  manager->setLinkRegistry(link_registry_);
+  manager->setStatisticsEnabled(stats_enabled_);
 
-  for (const auto& cow : link2cow_)
-  {
-    FCLCOWPtr new_cow = cow.second->clone();
+  // The collision objects are shared, they are copied by the first manager modifying them. The tree is built
+  // once from all objects instead of inserting them one at a time.
+  owner_tag_ = createOwnerTag();
+  manager->link2cow_ = link2cow_;
+  manager->id2cow_ = id2cow_;
+  manager->request_ = request_;
 
-    // TODO LEVI: Should this happen as part of the clone?
-    new_cow->setCollisionObjectsTransform(cow.second->getCollisionObjectsTransform());
-    manager->addCollisionObject(new_cow);
-  }
+  std::vector<fcl::CollisionObjectd*> objects;
+  for (const auto& cow : link2cow_)
+    for (auto& co : cow.second->getCollisionObjects())
+      objects.push_back(co.get());
 
-  manager->setContactRequest(request_);
+  manager->manager_->registerObjects(objects);
   return manager;
 }
 
@@ -101,6 +110,7 @@ bool FCLDiscreteBVHManager::removeCollisionObject(const std::string& name)
     for (auto& co : objects)
       manager_->unregisterObject(co.get());
 
+    unindexCollisionObject(id2cow_, *it->second);
     link2cow_.erase(name);
     return true;
   }
@@ -112,7 +122,9 @@ bool FCLDiscreteBVHManager::enableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = true;
+    if (!it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = true;
+
     return true;
   }
   return false;
@@ -123,17 +135,39 @@ bool FCLDiscreteBVHManager::disableCollisionObject(const std::string& name)
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
   {
-    it->second->m_enabled = false;
+    if (it->second->m_enabled)
+      getWritableCollisionObject(it->second).m_enabled = false;
+
     return true;
   }
   return false;
 }
 
+bool FCLDiscreteBVHManager::updateCollisionObjectOcTree(const std::string& name,
+                                                        const VectorVector3d& occupied_voxels,
+                                                        const VectorVector3d& free_voxels)
+{
+  auto it = link2cow_.find(name);
+  if (it == link2cow_.end() || !it->second->hasOcTrees())
+    return false;
+
+  FCLCOW& writable = getWritableCollisionObject(it->second);
+  for (auto& co : writable.getCollisionObjects())
+    manager_->unregisterObject(co.get());
+
+  writable.updateOcTrees(occupied_voxels, free_voxels);
+  for (auto& co : writable.getCollisionObjects())
+    manager_->registerObject(co.get());
+
+  broadphase_changed_ = true;
+  return true;
+}
+
 void FCLDiscreteBVHManager::setCollisionObjectsTransform(const std::string& name, const Eigen::Isometry3d& pose)
 {
   auto it = link2cow_.find(name);
   if (it != link2cow_.end())
-    it->second->setCollisionObjectsTransform(pose);
+    setCollisionObjectsTransform(it->second->getLinkId(), pose);
 }
 
 void FCLDiscreteBVHManager::setCollisionObjectsTransform(const std::vector<std::string>& names,
@@ -150,9 +184,75 @@ void FCLDiscreteBVHManager::setCollisionObjectsTransform(const TransformMap& tra
     setCollisionObjectsTransform(transform.first, transform.second);
 }
 
+void FCLDiscreteBVHManager::setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose)
+{
+  const FCLCOWPtr& cow = getCollisionObject(id2cow_, link_id);
+  if (!cow || cow->getCollisionObjectsTransform().matrix() == pose.matrix())
+    return;
+
+  getWritableCollisionObject(cow).setCollisionObjectsTransform(pose);
+  broadphase_changed_ = true;
+}
+
+void FCLDiscreteBVHManager::setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                                         const VectorIsometry3d& poses)
+{
+  assert(link_ids.size() == poses.size());
+  for (auto i = 0u; i < link_ids.size(); ++i)
+    setCollisionObjectsTransform(link_ids[i], poses[i]);
+}
+
+void FCLDiscreteBVHManager::setCollisionObjectsTransform(const VectorIsometry3d& link_transforms)
+{
+  const std::size_t size = std::min(id2cow_.size(), link_transforms.size());
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    if (id2cow_[i])
+      setCollisionObjectsTransform(static_cast<int>(i), link_transforms[i]);
+  }
+}
+
 void FCLDiscreteBVHManager::contactTest(ContactResultMap& collisions)
 {
   ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+void FCLDiscreteBVHManager::contactTest(ContactResultIdMap& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+void FCLDiscreteBVHManager::contactTest(ContactResultBuffer& collisions)
+{
+  ContactDistanceData cdata(&request_, &collisions);
+  contactTest(cdata);
+}
+
+bool FCLDiscreteBVHManager::isCollisionFree()
+{
+  ContactDistanceData cdata(&request_);
+  contactTest(cdata);
+  return !cdata.done;
+}
+
+void FCLDiscreteBVHManager::setStatisticsEnabled(bool enabled) { stats_enabled_ = enabled; }
+bool FCLDiscreteBVHManager::isStatisticsEnabled() const { return stats_enabled_; }
+const ContactTestStatistics& FCLDiscreteBVHManager::getStatistics() const { return stats_; }
+void FCLDiscreteBVHManager::clearStatistics() { stats_.clear(); }
+
+void FCLDiscreteBVHManager::contactTest(ContactDistanceData& cdata)
+{
+  ContactTestStatisticsCollector stats(cdata, stats_enabled_ ? &stats_ : nullptr);
+
+  // The tree is refit once for all objects moved since the last contact test instead of once per object
+  if (broadphase_changed_)
+  {
+    manager_->update();
+    broadphase_changed_ = false;
+  }
+
   if (request_.contact_distance > 0)
   {
     manager_->distance(&cdata, &distanceCallback);
@@ -170,9 +270,8 @@ void FCLDiscreteBVHManager::setContactRequest(const ContactRequest& req)
   // Now need to update the broadphase with correct aabb
   for (auto& co : link2cow_)
   {
-    FCLCOWPtr& cow = co.second;
-
-    updateCollisionObjectWithRequest(request_, *cow);
+    if (needsRequestUpdate(request_, *co.second))
+      updateCollisionObjectWithRequest(request_, getWritableCollisionObject(co.second));
   }
 }
 
@@ -180,7 +279,9 @@ const ContactRequest& FCLDiscreteBVHManager::getContactRequest() const { return
 
 void FCLDiscreteBVHManager::addCollisionObject(const FCLCOWPtr &cow)
 {
+  cow->setOwner(owner_tag_);
   link2cow_[cow->getName()] = cow;
+  indexCollisionObject(*link_registry_, id2cow_, cow);
 
   std::vector<FCLCollisionObjectPtr>& objects = cow->getCollisionObjects();
   for (auto& co : objects)
@@ -189,4 +290,41 @@ void FCLDiscreteBVHManager::addCollisionObject(const FCLCOWPtr &cow)
 
 const Link2FCLCOW& FCLDiscreteBVHManager::getCollisionObjects() const { return link2cow_; }
 
+void FCLDiscreteBVHManager::setLinkRegistry(NameRegistryPtr registry)
+{
+  // Objects shared with a clone are copied before their link id changes
+  for (auto& element : link2cow_)
+  {
+    if (registry->find(element.first) != element.second->getLinkId())
+      getWritableCollisionObject(element.second);
+  }
+
+  link_registry_ = registry;
+  id2cow_.clear();
+  for (auto& element : link2cow_)
+    indexCollisionObject(*link_registry_, id2cow_, element.second);
+}
+
+FCLCOW& FCLDiscreteBVHManager::getWritableCollisionObject(const FCLCOWPtr& cow)
+{
+  if (cow->isOwnedBy(owner_tag_))
+    return *cow;
+
+  FCLCOWPtr shared = cow;
+  FCLCOWPtr copy = shared->clone();
+  copy->setOwner(owner_tag_);
+  for (auto& co : shared->getCollisionObjects())
+    manager_->unregisterObject(co.get());
+
+  for (auto& co : copy->getCollisionObjects())
+    manager_->registerObject(co.get());
+
+  link2cow_[copy->getName()] = copy;
+  if (getCollisionObject(id2cow_, copy->getLinkId()) == shared)
+    id2cow_[static_cast<std::size_t>(copy->getLinkId())] = copy;
+
+  broadphase_changed_ = true;
+  return *copy;
+}
+
 }
@@ -1,4 +1,6 @@
 #include <class_loader/class_loader.h>
 #include <tesseract_collision/fcl/fcl_discrete_managers.h>
+#include <tesseract_collision/fcl/fcl_cast_managers.h>
 
 CLASS_LOADER_REGISTER_CLASS(tesseract::FCLDiscreteBVHManager, tesseract::DiscreteContactManagerBase)
+CLASS_LOADER_REGISTER_CLASS(tesseract::FCLCastBVHManager, tesseract::ContinuousContactManagerBase)
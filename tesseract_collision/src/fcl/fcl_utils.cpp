@@ -40,18 +40,22 @@
  */
 
 #include <tesseract_collision/fcl/fcl_utils.h>
+#include <tesseract_collision/geometry_cache.h>
 #include <geometric_shapes/shapes.h>
 #include <geometric_shapes/bodies.h>
 #include <fcl/geometry/bvh/BVH_model.h>
 #include <fcl/geometry/shape/box.h>
+#include <fcl/geometry/shape/capsule.h>
 #include <fcl/geometry/shape/cylinder.h>
 #include <fcl/geometry/shape/convex.h>
 #include <fcl/geometry/shape/plane.h>
 #include <fcl/geometry/shape/sphere.h>
 #include <fcl/geometry/shape/cone.h>
 #include <fcl/geometry/octree/octree.h>
+#include <fcl/narrowphase/continuous_collision.h>
 #include <boost/thread/mutex.hpp>
 #include <memory>
+#include <queue>
 
 namespace tesseract
 {
@@ -111,13 +115,21 @@ FCLCollisionGeometryPtr createShapePrimitive(const shapes::Mesh* geom,
 
       VectorVector3d convex_hull_vertices;
       std::vector<int> convex_hull_faces;
-      int num_faces = createConvexHull(convex_hull_vertices, convex_hull_faces, mesh_vertices);
+      int num_faces = createCachedConvexHull(convex_hull_vertices, convex_hull_faces, mesh_vertices);
 
       if (num_faces < 0)
         return nullptr;
 
       return FCLCollisionGeometryPtr(new fcl::Convexd(convex_hull_vertices.size(), convex_hull_vertices.data(), num_faces, convex_hull_faces.data()));
     }
+    case CollisionObjectType::SDF:
+    {
+      SignedDistanceFieldPtr sdf = createCachedSignedDistanceField(*geom);
+      if (sdf == nullptr)
+        return nullptr;
+
+      return FCLCollisionGeometryPtr(new FCLSignedDistanceField(sdf));
+    }
     case CollisionObjectType::UseShapeType:
     {
       auto g = new fcl::BVHModel<fcl::OBBRSSd>();
@@ -211,6 +223,196 @@ FCLCollisionGeometryPtr createShapePrimitive(const shapes::ShapeConstPtr& geom,
   }
 }
 
+/**
+ * @brief Check if two collision objects need to be checked, updating the statistics of the query if they are collected
+ * @param cd1 The first collision object
+ * @param cd2 The second collision object
+ * @param cdata The contact query data
+ * @return True if the two collision objects should be checked for collision, otherwise false
+ */
+static bool needsCollisionCheck(const FCLCollisionObjectWrapper& cd1,
+                                const FCLCollisionObjectWrapper& cd2,
+                                ContactDistanceData& cdata)
+{
+  const std::vector<std::string>& link_names = cdata.req->link_names;
+
+  if (cdata.stats != nullptr)
+    ++cdata.stats->num_broadphase_pairs;
+
+  if (!(cd1.m_enabled && cd2.m_enabled && (cd1.m_collisionFilterGroup & cd2.m_collisionFilterMask) &&
+        (cd2.m_collisionFilterGroup & cd1.m_collisionFilterMask) &&
+        (std::find(link_names.begin(), link_names.end(), cd1.getName()) != link_names.end() ||
+         std::find(link_names.begin(), link_names.end(), cd2.getName()) != link_names.end())))
+  {
+    if (cdata.stats != nullptr)
+      ++cdata.stats->num_filter_rejected;
+
+    return false;
+  }
+
+  if (isContactAllowed(cd1.getName(), cd2.getName(), cd1.getLinkId(), cd2.getLinkId(), *cdata.req, false))
+  {
+    if (cdata.stats != nullptr)
+      ++cdata.stats->num_acm_rejected;
+
+    return false;
+  }
+
+  return !isPairContactLimitReached(cdata, cd1.getName(), cd2.getName(), cd1.getLinkId(), cd2.getLinkId());
+}
+
+/** @brief Get the signed distance field of a collision object, nullptr if it is not a field */
+static const FCLSignedDistanceField* getSignedDistanceField(const fcl::CollisionObjectd& o)
+{
+  if (o.collisionGeometry()->getObjectType() != fcl::OT_UNKNOWN)
+    return nullptr;
+
+  return dynamic_cast<const FCLSignedDistanceField*>(o.collisionGeometry().get());
+}
+
+/**
+ * @brief Get the surface of a geometry queried against a signed distance field
+ * @param geom The geometry
+ * @param surface (Output) The surface in the frame of the geometry
+ * @return False if the geometry is not supported
+ */
+static bool getSignedDistanceFieldSurface(const fcl::CollisionGeometryd& geom, SignedDistanceFieldSurface& surface)
+{
+  surface.clear();
+  switch (geom.getNodeType())
+  {
+    case fcl::GEOM_SPHERE:
+    {
+      const double radius = static_cast<const fcl::Sphered&>(geom).radius;
+      surface.addSegment(Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero(), radius);
+      return true;
+    }
+    case fcl::GEOM_CAPSULE:
+    {
+      const fcl::Capsuled& capsule = static_cast<const fcl::Capsuled&>(geom);
+      surface.addSegment(Eigen::Vector3d(0, 0, -capsule.lz / 2), Eigen::Vector3d(0, 0, capsule.lz / 2), capsule.radius);
+      return true;
+    }
+    case fcl::GEOM_BOX:
+    {
+      surface.addBox(static_cast<const fcl::Boxd&>(geom).side / 2);
+      return true;
+    }
+    case fcl::GEOM_CYLINDER:
+    {
+      const fcl::Cylinderd& cylinder = static_cast<const fcl::Cylinderd&>(geom);
+      surface.addFrustum(cylinder.radius, cylinder.radius, cylinder.lz / 2);
+      return true;
+    }
+    case fcl::GEOM_CONE:
+    {
+      const fcl::Coned& cone = static_cast<const fcl::Coned&>(geom);
+      surface.addFrustum(cone.radius, 0, cone.lz / 2);
+      return true;
+    }
+    case fcl::GEOM_CONVEX:
+    {
+      // The points are the vertices of a convex hull, so computing it again gives back its faces
+      const fcl::Convexd& convex = static_cast<const fcl::Convexd&>(geom);
+      VectorVector3d input(convex.points, convex.points + convex.num_points), vertices;
+      std::vector<int> faces;
+      if (input.empty() || createConvexHull(vertices, faces, input) < 0)
+        return false;
+
+      surface.addPolygons(vertices, faces);
+      return true;
+    }
+    case fcl::BV_OBBRSS:
+    {
+      const fcl::BVHModel<fcl::OBBRSSd>& mesh = static_cast<const fcl::BVHModel<fcl::OBBRSSd>&>(geom);
+      surface.vertices.assign(mesh.vertices, mesh.vertices + mesh.num_vertices);
+      surface.triangles.reserve(3 * static_cast<std::size_t>(mesh.num_tris));
+      for (int i = 0; i < mesh.num_tris; ++i)
+        for (int j = 0; j < 3; ++j)
+          surface.triangles.push_back(static_cast<int>(mesh.tri_indices[i][j]));
+
+      return true;
+    }
+    default:
+    {
+      return false;
+    }
+  }
+}
+
+/**
+ * @brief Check a pair of collision objects where at least one of them is a signed distance field
+ * @param o1 The first collision object
+ * @param o2 The second collision object
+ * @param cdata The contact query data
+ * @param threshold The distance below which a contact is reported
+ * @return True if the search is finished
+ */
+static bool signedDistanceFieldCallback(const fcl::CollisionObjectd& o1,
+                                        const fcl::CollisionObjectd& o2,
+                                        ContactDistanceData& cdata,
+                                        double threshold)
+{
+  const FCLCollisionObjectWrapper* cd1 = static_cast<const FCLCollisionObjectWrapper*>(o1.getUserData());
+  const FCLCollisionObjectWrapper* cd2 = static_cast<const FCLCollisionObjectWrapper*>(o2.getUserData());
+
+  // The field is always the first object of the query
+  const FCLSignedDistanceField* field = getSignedDistanceField(o1);
+  bool swapped = (field == nullptr);
+  const fcl::CollisionObjectd& field_object = swapped ? o2 : o1;
+  const fcl::CollisionObjectd& other_object = swapped ? o1 : o2;
+  if (swapped)
+    field = getSignedDistanceField(o2);
+
+  SignedDistanceFieldSurface surface;
+  VectorVector3d centers;
+  std::vector<double> radii;
+  SignedDistanceFieldContact sdf_contact;
+  {
+    NarrowphaseStatisticsCollector stats(
+        cdata.stats, o1.collisionGeometry()->getNodeType(), o2.collisionGeometry()->getNodeType());
+
+    if (!getSignedDistanceFieldSurface(*other_object.collisionGeometry(), surface))
+    {
+      ROS_WARN_ONCE("Signed distance fields can only be checked against convex shapes and triangle meshes using fcl, "
+                    "other signed distance fields and octomaps are ignored");
+      return cdata.done;
+    }
+
+    Eigen::Isometry3d tf = field_object.getTransform().inverse() * other_object.getTransform();
+    double best = threshold;
+    addSignedDistanceFieldSamples(field->getField(), surface, tf, best, centers, radii);
+    if (!field->getField().getClosestSample(centers, radii, sdf_contact) || sdf_contact.distance > threshold)
+      return cdata.done;
+  }
+
+  // Only the existence of a contact was requested
+  if (!cdata.storesResults())
+  {
+    cdata.done = true;
+    return true;
+  }
+
+  const Eigen::Isometry3d& field_tf = field_object.getTransform();
+  ContactResult contact;
+  if (cdata.res != nullptr)
+  {
+    contact.link_names[0] = cd1->getName();
+    contact.link_names[1] = cd2->getName();
+  }
+  contact.link_ids[0] = cd1->getLinkId();
+  contact.link_ids[1] = cd2->getLinkId();
+  contact.nearest_points[swapped ? 1 : 0] = field_tf * sdf_contact.nearest_points[0];
+  contact.nearest_points[swapped ? 0 : 1] = field_tf * sdf_contact.nearest_points[1];
+  contact.type_id[0] = cd1->getTypeID();
+  contact.type_id[1] = cd2->getTypeID();
+  contact.distance = sdf_contact.distance;
+  contact.normal = (swapped ? -1 : 1) * (field_tf.linear() * sdf_contact.normal);
+
+  processResult(cdata, contact);
+  return cdata.done;
+}
+
 bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
 {
   ContactDistanceData* cdata = reinterpret_cast<ContactDistanceData*>(data);
@@ -221,27 +423,38 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
   const FCLCollisionObjectWrapper* cd1 = static_cast<const FCLCollisionObjectWrapper*>(o1->getUserData());
   const FCLCollisionObjectWrapper* cd2 = static_cast<const FCLCollisionObjectWrapper*>(o2->getUserData());
 
-  bool needs_collision = cd1->m_enabled && cd2->m_enabled &&
-      (cd1->m_collisionFilterGroup & cd2->m_collisionFilterMask) &&
-      (cd2->m_collisionFilterGroup & cd1->m_collisionFilterMask) &&
-      !isContactAllowed(cd1->getName(), cd2->getName(), cdata->req->isContactAllowed, false) &&
-      (std::find(cdata->req->link_names.begin(), cdata->req->link_names.end(), cd1->getName()) != cdata->req->link_names.end() ||
-       std::find(cdata->req->link_names.begin(), cdata->req->link_names.end(), cd2->getName()) != cdata->req->link_names.end());
-
-  if (!needs_collision)
+  if (!needsCollisionCheck(*cd1, *cd2, *cdata))
     return false;
 
+  if (getSignedDistanceField(*o1) != nullptr || getSignedDistanceField(*o2) != nullptr)
+    return signedDistanceFieldCallback(*o1, *o2, *cdata, 0);
+
   fcl::CollisionResultd col_result;
 
-  int num_contacts = fcl::collide(
-      o1, o2, fcl::CollisionRequestd(1, true, 1, false),
-      col_result);
+  bool store_results = cdata->storesResults();
+  {
+    NarrowphaseStatisticsCollector stats(
+        cdata->stats, o1->collisionGeometry()->getNodeType(), o2->collisionGeometry()->getNodeType());
+    fcl::collide(o1, o2, fcl::CollisionRequestd(1, store_results, 1, false), col_result);
+  }
 
   if (col_result.isCollision())
   {
+    // Only the existence of a contact was requested
+    if (!store_results)
+    {
+      cdata->done = true;
+      return true;
+    }
+
     ContactResult contact;
-    contact.link_names[0] = cd1->getName();
-    contact.link_names[1] = cd2->getName();
+    if (cdata->res != nullptr)
+    {
+      contact.link_names[0] = cd1->getName();
+      contact.link_names[1] = cd2->getName();
+    }
+    contact.link_ids[0] = cd1->getLinkId();
+    contact.link_ids[1] = cd2->getLinkId();
     contact.nearest_points[0] = Eigen::Vector3d(-1, -1, -1);
     contact.nearest_points[1] = Eigen::Vector3d(-1, -1, -1);
     contact.type_id[0] = cd1->getTypeID();
@@ -249,11 +462,7 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
     contact.distance = 0;
     contact.normal = Eigen::Vector3d(-1, -1, -1);
 
-    ObjectPairKey pc = getObjectPairKey(cd1->getName(), cd2->getName());
-    const auto& it = cdata->res->find(pc);
-    bool found = (it != cdata->res->end());
-
-    processResult(*cdata, contact, pc, found);
+    processResult(*cdata, contact);
   }
 
   return cdata->done;
@@ -270,25 +479,39 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
   const FCLCollisionObjectWrapper* cd1 = static_cast<const FCLCollisionObjectWrapper*>(o1->getUserData());
   const FCLCollisionObjectWrapper* cd2 = static_cast<const FCLCollisionObjectWrapper*>(o2->getUserData());
 
-  bool needs_collision = cd1->m_enabled && cd2->m_enabled &&
-      (cd1->m_collisionFilterGroup & cd2->m_collisionFilterMask) &&
-      (cd2->m_collisionFilterGroup & cd1->m_collisionFilterMask) &&
-      !isContactAllowed(cd1->getName(), cd2->getName(), cdata->req->isContactAllowed, false) &&
-      (std::find(cdata->req->link_names.begin(), cdata->req->link_names.end(), cd1->getName()) != cdata->req->link_names.end() ||
-       std::find(cdata->req->link_names.begin(), cdata->req->link_names.end(), cd2->getName()) != cdata->req->link_names.end());
-
-  if (!needs_collision)
+  if (!needsCollisionCheck(*cd1, *cd2, *cdata))
     return false;
 
+  if (getSignedDistanceField(*o1) != nullptr || getSignedDistanceField(*o2) != nullptr)
+    return signedDistanceFieldCallback(*o1, *o2, *cdata, cdata->req->contact_distance);
+
   fcl::DistanceResultd fcl_result;
-  fcl::DistanceRequestd fcl_request(true, true);
-  double d = fcl::distance(o1, o2, fcl_request, fcl_result);
+  bool store_results = cdata->storesResults();
+  fcl::DistanceRequestd fcl_request(store_results, true);
+  double d;
+  {
+    NarrowphaseStatisticsCollector stats(
+        cdata->stats, o1->collisionGeometry()->getNodeType(), o2->collisionGeometry()->getNodeType());
+    d = fcl::distance(o1, o2, fcl_request, fcl_result);
+  }
 
   if (d < cdata->req->contact_distance)
   {
+    // Only the existence of a contact was requested
+    if (!store_results)
+    {
+      cdata->done = true;
+      return true;
+    }
+
     ContactResult contact;
-    contact.link_names[0] = cd1->getName();
-    contact.link_names[1] = cd2->getName();
+    if (cdata->res != nullptr)
+    {
+      contact.link_names[0] = cd1->getName();
+      contact.link_names[1] = cd2->getName();
+    }
+    contact.link_ids[0] = cd1->getLinkId();
+    contact.link_ids[1] = cd2->getLinkId();
     contact.nearest_points[0] = fcl_result.nearest_points[0];
     contact.nearest_points[1] = fcl_result.nearest_points[1];
     contact.type_id[0] = cd1->getTypeID();
@@ -302,16 +525,458 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
       ROS_ERROR("Nearest Points are NAN's");
     }
 
-    ObjectPairKey pc = getObjectPairKey(cd1->getName(), cd2->getName());
-    const auto& it = cdata->res->find(pc);
-    bool found = (it != cdata->res->end());
-
-    processResult(*cdata, contact, pc, found);
+    processResult(*cdata, contact);
   }
 
   return cdata->done;
 }
 
+/** @brief Get the pose of a shape relative to the origin of its collision object */
+static Eigen::Isometry3d getShapePose(const fcl::CollisionObjectd& o)
+{
+  const FCLCollisionObjectWrapper* cd = static_cast<const FCLCollisionObjectWrapper*>(o.getUserData());
+  return cd->getCollisionObjectsTransform().inverse() * o.getTransform();
+}
+
+/**
+ * @brief Get the pose at a time of a motion which is linear between poses spread uniformly from zero to one
+ * @param poses The poses along the motion, a single pose if it does not move
+ * @param t The time from zero to one
+ * @return The pose
+ */
+static Eigen::Isometry3d interpolatePose(const VectorIsometry3d& poses, double t)
+{
+  if (poses.size() == 1)
+    return poses.front();
+
+  double s = t * static_cast<double>(poses.size() - 1);
+  std::size_t i = std::min(static_cast<std::size_t>(s), poses.size() - 2);
+  double f = s - static_cast<double>(i);
+
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.linear() = Eigen::Quaterniond(poses[i].linear()).slerp(f, Eigen::Quaterniond(poses[i + 1].linear())).matrix();
+  pose.translation() = (1 - f) * poses[i].translation() + f * poses[i + 1].translation();
+  return pose;
+}
+
+/**
+ * @brief Get an upper bound of the distance any point of a shape moves while its collision object moves linearly
+ * @param geom The shape
+ * @param shape_pose The pose of the shape relative to its collision object
+ * @param beg The pose of the collision object at the start of the motion
+ * @param end The pose of the collision object at the end of the motion
+ * @return The bound, the shape rotates around the origin of its collision object (see interpolatePose())
+ */
+static double getMaxDisplacement(const fcl::CollisionGeometryd& geom,
+                                 const Eigen::Isometry3d& shape_pose,
+                                 const Eigen::Isometry3d& beg,
+                                 const Eigen::Isometry3d& end)
+{
+  double radius = (shape_pose * geom.aabb_center).norm() + geom.aabb_radius;
+  double angle = Eigen::Quaterniond(beg.linear()).angularDistance(Eigen::Quaterniond(end.linear()));
+  return (end.translation() - beg.translation()).norm() + radius * angle;
+}
+
+/** @brief Get the distance of two shapes, negative or zero if they are in collision */
+static double getDistance(const fcl::CollisionGeometryd& g1,
+                          const Eigen::Isometry3d& tf1,
+                          const fcl::CollisionGeometryd& g2,
+                          const Eigen::Isometry3d& tf2)
+{
+  fcl::DistanceResultd result;
+  return fcl::distance(&g1, tf1, &g2, tf2, fcl::DistanceRequestd(), result);
+}
+
+/**
+ * @brief Get the time of contact of two shapes moving linearly by conservative advancement
+ *
+ * The distance of the shapes shrinks at most by the sum of their displacements, so advancing the time by the
+ * distance divided by this bound never passes a contact. It is used for the pairs of geometry types the conservative
+ * advancement of FCL does not support, octrees for example.
+ *
+ * @return The time of contact from zero to one, -1 if they are not in collision. If neither is decided within
+ * FCL_CAST_MAX_DISTANCE_QUERIES the time reached is returned, so a contact is never missed.
+ */
+static double getTimeOfContactByAdvancement(const fcl::CollisionGeometryd& g1,
+                                            const Eigen::Isometry3d& tf1_beg,
+                                            const Eigen::Isometry3d& tf1_end,
+                                            const fcl::CollisionGeometryd& g2,
+                                            const Eigen::Isometry3d& tf2_beg,
+                                            const Eigen::Isometry3d& tf2_end)
+{
+  const VectorIsometry3d poses1 = { tf1_beg, tf1_end };
+  const VectorIsometry3d poses2 = { tf2_beg, tf2_end };
+  const Eigen::Isometry3d identity = Eigen::Isometry3d::Identity();
+  const double bound =
+      getMaxDisplacement(g1, identity, tf1_beg, tf1_end) + getMaxDisplacement(g2, identity, tf2_beg, tf2_end);
+
+  double t = 0;
+  for (std::size_t i = 0; i < FCL_CAST_MAX_DISTANCE_QUERIES; ++i)
+  {
+    double d = getDistance(g1, interpolatePose(poses1, t), g2, interpolatePose(poses2, t));
+    if (d <= FCL_CAST_CONTACT_TOLERANCE)
+      return t;
+
+    if (t >= 1 || bound <= 0)
+      return -1;
+
+    t = std::min(1.0, t + d / bound);
+  }
+
+  return t;
+}
+
+/**
+ * @brief Get the time of contact of two shapes moving linearly
+ * @return The time of contact from zero to one, -1 if they are not in collision
+ */
+static double getTimeOfContact(const fcl::CollisionGeometryd& g1,
+                               const Eigen::Isometry3d& tf1_beg,
+                               const Eigen::Isometry3d& tf1_end,
+                               const fcl::CollisionGeometryd& g2,
+                               const Eigen::Isometry3d& tf2_beg,
+                               const Eigen::Isometry3d& tf2_end)
+{
+  if (g1.getNodeType() == fcl::GEOM_OCTREE || g2.getNodeType() == fcl::GEOM_OCTREE)
+    return getTimeOfContactByAdvancement(g1, tf1_beg, tf1_end, g2, tf2_beg, tf2_end);
+
+  fcl::ContinuousCollisionRequestd request;
+  request.num_max_iterations = FCL_CAST_MAX_ITERATIONS;
+  request.ccd_motion_type = fcl::CCDM_LINEAR;
+  request.ccd_solver_type = fcl::CCDC_CONSERVATIVE_ADVANCEMENT;
+
+  // The conservative advancement of FCL does not support all pairs of geometry types
+  fcl::ContinuousCollisionResultd result;
+  if (fcl::continuousCollide(&g1, tf1_beg, tf1_end, &g2, tf2_beg, tf2_end, request, result) < 0)
+    return getTimeOfContactByAdvancement(g1, tf1_beg, tf1_end, g2, tf2_beg, tf2_end);
+
+  return result.is_collide ? result.time_of_contact : -1;
+}
+
+/**
+ * @brief Find the closest approach of two shapes during a segment of their motions
+ *
+ * The distance changes at most by rate per unit of time, which bounds it from below on an interval by the distances
+ * at its ends. The interval with the lowest bound is split until no interval can be closer than the closest
+ * approach found by more than FCL_CAST_DISTANCE_TOLERANCE, none can be below the threshold, or
+ * FCL_CAST_MAX_DISTANCE_QUERIES distances were computed.
+ *
+ * @param distance The distance of the shapes at a time
+ * @param t0 The start of the segment
+ * @param d0 The distance at the start of the segment
+ * @param t1 The end of the segment
+ * @param d1 The distance at the end of the segment
+ * @param rate The upper bound of the change of the distance per unit of time
+ * @param threshold Only a closest approach below it is searched
+ * @param time (Output) The time of the closest approach, unchanged if it is not below the threshold
+ * @return The distance of the closest approach, the threshold if it is not below it
+ */
+template <typename DistanceFn>
+static double getClosestApproach(const DistanceFn& distance,
+                                 double t0,
+                                 double d0,
+                                 double t1,
+                                 double d1,
+                                 double rate,
+                                 double threshold,
+                                 double& time)
+{
+  struct Interval
+  {
+    double t0, d0, t1, d1; /**< @brief The interval and the distances at its ends */
+    double bound;          /**< @brief The lower bound of the distance within the interval */
+  };
+
+  auto makeInterval = [rate](double a, double da, double b, double db) {
+    return Interval{ a, da, b, db, (da + db - rate * (b - a)) / 2 };
+  };
+  auto compare = [](const Interval& a, const Interval& b) { return a.bound > b.bound; };
+  std::priority_queue<Interval, std::vector<Interval>, decltype(compare)> queue(compare);
+
+  double closest = threshold;
+  if (d0 < closest)
+  {
+    closest = d0;
+    time = t0;
+  }
+  if (d1 < closest)
+  {
+    closest = d1;
+    time = t1;
+  }
+
+  queue.push(makeInterval(t0, d0, t1, d1));
+  for (std::size_t i = 0; i < FCL_CAST_MAX_DISTANCE_QUERIES; ++i)
+  {
+    const Interval interval = queue.top();
+    if (interval.bound >= (closest < threshold ? closest - FCL_CAST_DISTANCE_TOLERANCE : threshold))
+      break;
+
+    queue.pop();
+    double t = (interval.t0 + interval.t1) / 2;
+    double d = distance(t);
+    if (d < closest)
+    {
+      closest = d;
+      time = t;
+    }
+
+    queue.push(makeInterval(interval.t0, interval.d0, t, d));
+    queue.push(makeInterval(t, d, interval.t1, interval.d1));
+  }
+
+  return closest;
+}
+
+/**
+ * @brief Store the contact of two shapes at a time of their motions
+ * @param o1 The first shape
+ * @param tf1 The pose of the first shape
+ * @param o2 The second shape
+ * @param tf2 The pose of the second shape
+ * @param cc_time The time of the contact from zero to one
+ * @param cc_type The type of the contact
+ * @param cdata The contact query data
+ * @return True if the search is finished
+ */
+static bool addCastContact(const fcl::CollisionObjectd& o1,
+                           const Eigen::Isometry3d& tf1,
+                           const fcl::CollisionObjectd& o2,
+                           const Eigen::Isometry3d& tf2,
+                           double cc_time,
+                           ContinouseCollisionType cc_type,
+                           ContactDistanceData& cdata)
+{
+  const FCLCollisionObjectWrapper* cd1 = static_cast<const FCLCollisionObjectWrapper*>(o1.getUserData());
+  const FCLCollisionObjectWrapper* cd2 = static_cast<const FCLCollisionObjectWrapper*>(o2.getUserData());
+
+  fcl::DistanceResultd fcl_result;
+  {
+    NarrowphaseStatisticsCollector stats(
+        cdata.stats, o1.collisionGeometry()->getNodeType(), o2.collisionGeometry()->getNodeType());
+    fcl::distance(o1.collisionGeometry().get(),
+                  tf1,
+                  o2.collisionGeometry().get(),
+                  tf2,
+                  fcl::DistanceRequestd(true, true),
+                  fcl_result);
+  }
+
+  ContactResult contact;
+  if (cdata.res != nullptr)
+  {
+    contact.link_names[0] = cd1->getName();
+    contact.link_names[1] = cd2->getName();
+  }
+  contact.link_ids[0] = cd1->getLinkId();
+  contact.link_ids[1] = cd2->getLinkId();
+  contact.nearest_points[0] = fcl_result.nearest_points[0];
+  contact.nearest_points[1] = fcl_result.nearest_points[1];
+  contact.type_id[0] = cd1->getTypeID();
+  contact.type_id[1] = cd2->getTypeID();
+  contact.distance = fcl_result.min_distance;
+  contact.normal = (fcl_result.min_distance * (contact.nearest_points[1] - contact.nearest_points[0])).normalized();
+  contact.cc_time = cc_time;
+  contact.cc_type = cc_type;
+
+  processResult(cdata, contact);
+  return cdata.done;
+}
+
+fcl::AABBd getSweptAABB(const FCLCOW& cow, const VectorIsometry3d& poses, double margin)
+{
+  fcl::AABBd aabb;
+  for (const auto& co : cow.getCollisionObjects())
+  {
+    const fcl::CollisionGeometryd& geom = *co->collisionGeometry();
+    double radius = (getShapePose(*co) * geom.aabb_center).norm() + geom.aabb_radius + margin;
+    for (const auto& pose : poses)
+      aabb += fcl::AABBd(pose.translation() - Eigen::Vector3d::Constant(radius),
+                         pose.translation() + Eigen::Vector3d::Constant(radius));
+  }
+
+  return aabb;
+}
+
+bool castCollisionCheck(const fcl::CollisionObjectd& o1,
+                        const VectorIsometry3d& poses1,
+                        const fcl::CollisionObjectd& o2,
+                        const VectorIsometry3d& poses2,
+                        ContactDistanceData& cdata)
+{
+  if (cdata.done)
+    return true;
+
+  const FCLCollisionObjectWrapper* cd1 = static_cast<const FCLCollisionObjectWrapper*>(o1.getUserData());
+  const FCLCollisionObjectWrapper* cd2 = static_cast<const FCLCollisionObjectWrapper*>(o2.getUserData());
+
+  if (!needsCollisionCheck(*cd1, *cd2, cdata))
+    return false;
+
+  if (getSignedDistanceField(o1) != nullptr || getSignedDistanceField(o2) != nullptr)
+  {
+    ROS_WARN_ONCE("Signed distance fields are not supported by the fcl cast managers");
+    return false;
+  }
+
+  // The times of all poses of both motions
+  std::vector<double> times = { 0, 1 };
+  for (std::size_t n : { poses1.size(), poses2.size() })
+    for (std::size_t i = 1; i + 1 < n; ++i)
+      times.push_back(static_cast<double>(i) / static_cast<double>(n - 1));
+
+  std::sort(times.begin(), times.end());
+  times.erase(std::unique(times.begin(), times.end(), [](double a, double b) { return b - a < 1e-12; }), times.end());
+
+  const fcl::CollisionGeometryd& g1 = *o1.collisionGeometry();
+  const fcl::CollisionGeometryd& g2 = *o2.collisionGeometry();
+  const Eigen::Isometry3d shape1 = getShapePose(o1);
+  const Eigen::Isometry3d shape2 = getShapePose(o2);
+  auto pose1 = [&](double t) { return Eigen::Isometry3d(interpolatePose(poses1, t) * shape1); };
+  auto pose2 = [&](double t) { return Eigen::Isometry3d(interpolatePose(poses2, t) * shape2); };
+
+  for (std::size_t k = 0; k + 1 < times.size(); ++k)
+  {
+    const double t0 = times[k];
+    const double t1 = times[k + 1];
+    const Eigen::Isometry3d tf1_beg = pose1(t0), tf1_end = pose1(t1);
+    const Eigen::Isometry3d tf2_beg = pose2(t0), tf2_end = pose2(t1);
+
+    double enter;
+    {
+      NarrowphaseStatisticsCollector stats(cdata.stats, g1.getNodeType(), g2.getNodeType());
+      enter = getTimeOfContact(g1, tf1_beg, tf1_end, g2, tf2_beg, tf2_end);
+    }
+
+    if (enter < 0)
+      continue;
+
+    // Only the existence of a contact was requested
+    if (!cdata.storesResults())
+    {
+      cdata.done = true;
+      return true;
+    }
+
+    // The time the shapes separate is the time of contact of the reversed motion
+    double leave;
+    {
+      NarrowphaseStatisticsCollector stats(cdata.stats, g1.getNodeType(), g2.getNodeType());
+      leave = getTimeOfContact(g1, tf1_end, tf1_beg, g2, tf2_end, tf2_beg);
+    }
+    double exit = (leave < 0) ? enter : 1 - leave;
+
+    if (k == 0 && enter <= 0)
+      return addCastContact(o1, pose1(0), o2, pose2(0), 0, ContinouseCollisionType::CCType_Time0, cdata);
+
+    if (k + 2 == times.size() && exit >= 1)
+      return addCastContact(o1, pose1(1), o2, pose2(1), 1, ContinouseCollisionType::CCType_Time1, cdata);
+
+    double t = t0 + (t1 - t0) * (enter + exit) / 2;
+    return addCastContact(o1, pose1(t), o2, pose2(t), t, ContinouseCollisionType::CCType_Between, cdata);
+  }
+
+  if (cdata.req->contact_distance <= 0)
+    return false;
+
+  // Find the closest approach within the contact distance
+  auto distance = [&](double t) {
+    NarrowphaseStatisticsCollector stats(cdata.stats, g1.getNodeType(), g2.getNodeType());
+    return getDistance(g1, pose1(t), g2, pose2(t));
+  };
+
+  std::vector<double> distances;
+  distances.reserve(times.size());
+  for (double t : times)
+    distances.push_back(distance(t));
+
+  double closest_time = -1;
+  double closest_distance = cdata.req->contact_distance;
+  for (std::size_t k = 0; k + 1 < times.size(); ++k)
+  {
+    const double t0 = times[k];
+    const double t1 = times[k + 1];
+    const Eigen::Isometry3d beg1 = interpolatePose(poses1, t0), end1 = interpolatePose(poses1, t1);
+    const Eigen::Isometry3d beg2 = interpolatePose(poses2, t0), end2 = interpolatePose(poses2, t1);
+    const double rate = (getMaxDisplacement(g1, shape1, beg1, end1) + getMaxDisplacement(g2, shape2, beg2, end2)) /
+                        (t1 - t0);
+
+    closest_distance =
+        getClosestApproach(distance, t0, distances[k], t1, distances[k + 1], rate, closest_distance, closest_time);
+  }
+
+  if (closest_time < 0)
+    return false;
+
+  // Only the existence of a contact was requested
+  if (!cdata.storesResults())
+  {
+    cdata.done = true;
+    return true;
+  }
+
+  ContinouseCollisionType cc_type = ContinouseCollisionType::CCType_Between;
+  if (closest_time <= 0)
+    cc_type = ContinouseCollisionType::CCType_Time0;
+  else if (closest_time >= 1)
+    cc_type = ContinouseCollisionType::CCType_Time1;
+
+  return addCastContact(o1, pose1(closest_time), o2, pose2(closest_time), closest_time, cc_type, cdata);
+}
+
+CollisionShapeCache<FCLCachedGeometry>& getFCLShapeCache()
+{
+  static CollisionShapeCache<FCLCachedGeometry> cache;
+  return cache;
+}
+
+FCLCachedGeometryPtr getCachedFCLShape(const shapes::ShapeConstPtr& geom,
+                                       const CollisionObjectType& collision_object_type)
+{
+  return getFCLShapeCache().get(geom, collision_object_type, [&]() {
+    FCLCollisionGeometryPtr geometry = createShapePrimitive(geom, collision_object_type);
+    if (geometry == nullptr)
+      return FCLCachedGeometryPtr();
+
+    return FCLCachedGeometryPtr(new FCLCachedGeometry(geometry));
+  });
+}
+
+bool FCLCollisionObjectWrapper::updateOcTrees(const VectorVector3d& occupied_voxels, const VectorVector3d& free_voxels)
+{
+  bool updated = false;
+  for (auto& shape : shapes_)
+  {
+    if (shape->type != shapes::OCTREE)
+      continue;
+
+    // Geometries are only created for supported shapes, so the geometry of the octomap is found by its root node
+    const octomap::OcTree& octree = *static_cast<const shapes::OcTree*>(shape.get())->octree;
+    for (std::size_t i = 0; i < collision_geometries_.size(); ++i)
+    {
+      const FCLCollisionGeometryPtr& geometry = collision_geometries_[i];
+      if (geometry->getNodeType() != fcl::GEOM_OCTREE ||
+          static_cast<const fcl::OcTreed*>(geometry.get())->getRoot() != octree.getRoot())
+        continue;
+
+      std::shared_ptr<const octomap::OcTree> updated_octree =
+          createUpdatedOcTree(octree, occupied_voxels, free_voxels);
+      shape.reset(new shapes::OcTree(updated_octree));
+      collision_geometries_[i].reset(new fcl::OcTreed(updated_octree));
+
+      FCLCollisionObjectPtr co(new fcl::CollisionObjectd(collision_geometries_[i]));
+      co->setUserData(this);
+      co->setTransform(collision_objects_[i]->getTransform());
+      co->computeAABB();
+      collision_objects_[i] = co;
+      updated = true;
+      break;
+    }
+  }
+
+  return updated;
+}
+
 FCLCollisionObjectWrapper::FCLCollisionObjectWrapper(const std::string& name,
                                                      const int& type_id,
                                                      const std::vector<shapes::ShapeConstPtr>& shapes,
@@ -319,6 +984,9 @@ FCLCollisionObjectWrapper::FCLCollisionObjectWrapper(const std::string& name,
                                                      const CollisionObjectTypeVector& collision_object_types)
   : name_(name)
   , type_id_(type_id)
+  , link_id_(-1)
+  , owner_(0)
+  , world_pose_(Eigen::Isometry3d::Identity())
   , shapes_(shapes)
   , shape_poses_(shape_poses)
   , collision_object_types_(collision_object_types)
@@ -334,12 +1002,15 @@ FCLCollisionObjectWrapper::FCLCollisionObjectWrapper(const std::string& name,
   collision_objects_.reserve(shapes_.size());
   for (std::size_t j = 0; j < shapes_.size(); ++j)
   {
-    FCLCollisionGeometryPtr subshape = createShapePrimitive(shapes_[j], collision_object_types_[j]);
-    if (subshape != NULL)
+    FCLCachedGeometryPtr cached = getCachedFCLShape(shapes_[j], collision_object_types_[j]);
+    if (cached != nullptr)
     {
-      collision_geometries_.push_back(subshape);
-      FCLCollisionObjectPtr co(new fcl::CollisionObjectd(subshape));
+      // The geometry keeps the cache entry alive, the collision object is copied to skip computing the local AABB
+      collision_geometries_.push_back(FCLCollisionGeometryPtr(cached, cached->geometry.get()));
+      FCLCollisionObjectPtr co(new fcl::CollisionObjectd(cached->prototype));
       co->setUserData(this);
+      co->setTransform(shape_poses_[j]);
+      co->computeAABB();
       collision_objects_.push_back(co);
     }
   }
@@ -354,6 +1025,8 @@ FCLCollisionObjectWrapper::FCLCollisionObjectWrapper(const std::string& name,
                                                      const std::vector<FCLCollisionObjectPtr>& collision_objects)
   : name_(name)
   , type_id_(type_id)
+  , link_id_(-1)
+  , owner_(0)
   , shapes_(shapes)
   , shape_poses_(shape_poses)
   , collision_object_types_(collision_object_types)
@@ -0,0 +1,121 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+template <typename T>
+class CollisionAllowedCollisionUnit : public testing::Test
+{
+};
+
+typedef testing::Types<tesseract::BulletDiscreteSimpleManager,
+                       tesseract::BulletDiscreteBVHManager,
+                       tesseract::FCLDiscreteBVHManager>
+    DiscreteManagerTypes;
+TYPED_TEST_CASE(CollisionAllowedCollisionUnit, DiscreteManagerTypes);
+
+/**
+ * @brief Add three spheres to a checker, placed in a row along x 0.5 apart
+ *
+ * The CLOSEST request includes every sphere and the contact distance only reaches the neighbouring spheres.
+ */
+tesseract::ContactRequest addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  tesseract::TransformMap location;
+  for (const std::string& name : { "sphere_link", "sphere1_link", "sphere2_link" })
+  {
+    std::vector<shapes::ShapeConstPtr> shapes = { shapes::ShapeConstPtr(new shapes::Sphere(0.25)) };
+    tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+    tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+    checker.addCollisionObject(name, 0, shapes, poses, types);
+
+    location[name] = Eigen::Isometry3d::Identity();
+  }
+  location["sphere1_link"].translation()(0) = 1;
+  location["sphere2_link"].translation()(0) = -1;
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.link_names.push_back("sphere1_link");
+  req.link_names.push_back("sphere2_link");
+  req.contact_distance = 0.52;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+  checker.setCollisionObjectsTransform(location);
+
+  return req;
+}
+
+/** @brief Check if a result contains a pair of links */
+bool hasPair(const tesseract::ContactResultIdMap& result, int link_id1, int link_id2)
+{
+  return result.find(tesseract::getObjectPairKey(link_id1, link_id2)) != result.end();
+}
+
+TYPED_TEST(CollisionAllowedCollisionUnit, AllowedCollisionBitMatrix)
+{
+  TypeParam checker;
+  tesseract::ContactRequest req = addCollisionObjects(checker);
+
+  tesseract::NameRegistryConstPtr registry = checker.getLinkRegistry();
+  int sphere_id = registry->find("sphere_link");
+  int sphere1_id = registry->find("sphere1_link");
+  int sphere2_id = registry->find("sphere2_link");
+  ASSERT_GE(sphere_id, 0);
+  ASSERT_GE(sphere1_id, 0);
+  ASSERT_GE(sphere2_id, 0);
+
+  ///////////////////////////////////////////////////////////////////
+  // Test only the pair allowed by the compiled matrix is skipped
+  ///////////////////////////////////////////////////////////////////
+  tesseract::AllowedCollisionBitMatrixPtr acm(new tesseract::AllowedCollisionBitMatrix());
+  acm->setCollisionAllowed(sphere_id, sphere1_id, true);
+  EXPECT_TRUE(acm->isCollisionAllowed(sphere1_id, sphere_id));
+  EXPECT_FALSE(acm->isCollisionAllowed(sphere_id, sphere2_id));
+  req.allowed_collision_matrix = acm;
+
+  // The matrix is used instead of the contact allowed function for objects with a link id
+  req.isContactAllowed = [](const std::string&, const std::string&) { return true; };
+  checker.setContactRequest(req);
+
+  tesseract::ContactResultIdMap result;
+  checker.contactTest(result);
+  EXPECT_EQ(result.size(), 1u);
+  EXPECT_TRUE(hasPair(result, sphere_id, sphere2_id));
+
+  // Changes to the matrix are seen by the next contact test
+  acm->setCollisionAllowed(sphere1_id, sphere_id, false);
+  acm->setCollisionAllowed(sphere2_id, sphere_id, true);
+
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_EQ(result.size(), 1u);
+  EXPECT_TRUE(hasPair(result, sphere_id, sphere1_id));
+
+  acm->clear();
+
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_EQ(result.size(), 2u);
+
+  ///////////////////////////////////////////////////////////////////////
+  // Test the contact allowed function is used without compiled matrix
+  ///////////////////////////////////////////////////////////////////////
+  req.allowed_collision_matrix = nullptr;
+  req.isContactAllowed = [](const std::string& name1, const std::string& name2) {
+    return (name1 == "sphere_link" && name2 == "sphere2_link") || (name1 == "sphere2_link" && name2 == "sphere_link");
+  };
+  checker.setContactRequest(req);
+
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_EQ(result.size(), 1u);
+  EXPECT_TRUE(hasPair(result, sphere_id, sphere1_id));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,315 @@
+
+#include "tesseract_collision/bullet/bullet_cast_managers.h"
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <benchmark/benchmark.h>
+#include <octomap/octomap.h>
+#include <ros/package.h>
+
+/**
+ * Benchmarks for the discrete and continuous contact managers.
+ *
+ * Each benchmark is run for a grid of n x n x n links, the shape used for the links and the request type.
+ * The results are written to stdout as JSON by default, use --benchmark_out=<file> to also write them to a file.
+ */
+
+enum BenchmarkShape
+{
+  PRIMITIVE = 0, /**< @brief Spheres */
+  CONVEX_HULL,   /**< @brief Sphere meshes converted to convex hulls */
+  BVH_MESH,      /**< @brief Sphere meshes used as triangle meshes (not supported by the continuous managers) */
+  OCTREE         /**< @brief Spheres and a static octree */
+};
+
+static const char* SHAPE_NAMES[] = { "primitive", "convex_hull", "bvh_mesh", "octree" };
+
+static const tesseract::ContactRequestType REQUEST_TYPES[] = { tesseract::ContactRequestType::FIRST,
+                                                               tesseract::ContactRequestType::CLOSEST,
+                                                               tesseract::ContactRequestType::ALL,
+                                                               tesseract::ContactRequestType::LIMITED };
+
+static const char* REQUEST_NAMES[] = { "first", "closest", "all", "limited" };
+
+/**
+ * @brief Add a grid of n x n x n links to a contact manager
+ * @param checker The contact manager
+ * @param n The number of links along each axis
+ * @param shape_type The shape used for the links
+ * @param link_names The names of the grid links are appended
+ * @param location The transform of the grid links are added
+ */
+template <typename ManagerType>
+void addCollisionObjects(ManagerType& checker,
+                         int n,
+                         BenchmarkShape shape_type,
+                         std::vector<std::string>& link_names,
+                         tesseract::TransformMap& location)
+{
+  shapes::ShapePtr sphere;
+  if (shape_type == CONVEX_HULL || shape_type == BVH_MESH)
+    sphere.reset(shapes::createMeshFromResource("package://tesseract_collision/test/sphere_p25m.stl"));
+  else
+    sphere.reset(new shapes::Sphere(0.25));
+
+  tesseract::CollisionObjectType object_type = tesseract::CollisionObjectType::UseShapeType;
+  if (shape_type == CONVEX_HULL)
+    object_type = tesseract::CollisionObjectType::ConvexHull;
+
+  double delta = 0.55;
+  for (int x = 0; x < n; ++x)
+  {
+    for (int y = 0; y < n; ++y)
+    {
+      for (int z = 0; z < n; ++z)
+      {
+        std::vector<shapes::ShapeConstPtr> obj_shapes;
+        tesseract::VectorIsometry3d obj_poses;
+        tesseract::CollisionObjectTypeVector obj_types;
+        obj_shapes.push_back(sphere);
+        obj_poses.push_back(Eigen::Isometry3d::Identity());
+        obj_types.push_back(object_type);
+
+        link_names.push_back("sphere_link_" + std::to_string(x) + "_" + std::to_string(y) + "_" + std::to_string(z));
+
+        location[link_names.back()] = Eigen::Isometry3d::Identity();
+        location[link_names.back()].translation() = Eigen::Vector3d(x * delta, y * delta, z * delta);
+        checker.addCollisionObject(link_names.back(), 0, obj_shapes, obj_poses, obj_types);
+      }
+    }
+  }
+
+  if (shape_type == OCTREE)
+  {
+    std::string path = ros::package::getPath("tesseract_collision") + "/test/blender_monkey.bt";
+    std::shared_ptr<octomap::OcTree> ot(new octomap::OcTree(path));
+
+    std::vector<shapes::ShapeConstPtr> obj_shapes;
+    tesseract::VectorIsometry3d obj_poses;
+    tesseract::CollisionObjectTypeVector obj_types;
+    obj_shapes.push_back(shapes::ShapePtr(new shapes::OcTree(ot)));
+    obj_poses.push_back(Eigen::Isometry3d::Identity());
+    obj_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+    checker.addCollisionObject("octomap_link", 0, obj_shapes, obj_poses, obj_types);
+  }
+}
+
+/**
+ * @brief Create a contact request for the grid links
+ * @param link_names The grid links
+ * @param type_index The index into REQUEST_TYPES
+ */
+tesseract::ContactRequest createContactRequest(const std::vector<std::string>& link_names, int type_index)
+{
+  tesseract::ContactRequest req;
+  req.link_names = link_names;
+  req.contact_distance = 0.1;
+  req.type = REQUEST_TYPES[type_index];
+  req.max_contacts_per_pair = 1;
+  req.max_total_contacts = 10;
+  return req;
+}
+
+void setBenchmarkLabel(benchmark::State& state)
+{
+  state.SetLabel(std::string(SHAPE_NAMES[state.range(1)]) + "/" + REQUEST_NAMES[state.range(2)]);
+}
+
+template <typename ManagerType>
+void BM_DiscreteContactTest(benchmark::State& state)
+{
+  ManagerType checker;
+  std::vector<std::string> link_names;
+  tesseract::TransformMap location;
+  addCollisionObjects(checker, static_cast<int>(state.range(0)), static_cast<BenchmarkShape>(state.range(1)),
+                      link_names, location);
+
+  checker.setContactRequest(createContactRequest(link_names, static_cast<int>(state.range(2))));
+  checker.setCollisionObjectsTransform(location);
+
+  tesseract::ContactResultMap result;
+  for (auto _ : state)
+  {
+    result.clear();
+    checker.contactTest(result);
+    benchmark::DoNotOptimize(result);
+  }
+
+  setBenchmarkLabel(state);
+  state.counters["links"] = static_cast<double>(link_names.size());
+  state.counters["contacts"] = static_cast<double>(result.size());
+}
+
+template <typename ManagerType>
+void BM_DiscreteIsCollisionFree(benchmark::State& state)
+{
+  ManagerType checker;
+  std::vector<std::string> link_names;
+  tesseract::TransformMap location;
+  addCollisionObjects(checker, static_cast<int>(state.range(0)), static_cast<BenchmarkShape>(state.range(1)),
+                      link_names, location);
+
+  checker.setContactRequest(createContactRequest(link_names, static_cast<int>(state.range(2))));
+  checker.setCollisionObjectsTransform(location);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(checker.isCollisionFree());
+
+  setBenchmarkLabel(state);
+  state.counters["links"] = static_cast<double>(link_names.size());
+}
+
+template <typename ManagerType>
+void BM_DiscreteSetTransforms(benchmark::State& state)
+{
+  ManagerType checker;
+  std::vector<std::string> link_names;
+  tesseract::TransformMap location;
+  addCollisionObjects(checker, static_cast<int>(state.range(0)), static_cast<BenchmarkShape>(state.range(1)),
+                      link_names, location);
+
+  for (auto _ : state)
+    checker.setCollisionObjectsTransform(location);
+
+  setBenchmarkLabel(state);
+  state.counters["links"] = static_cast<double>(link_names.size());
+}
+
+template <typename ManagerType>
+void BM_DiscreteClone(benchmark::State& state)
+{
+  ManagerType checker;
+  std::vector<std::string> link_names;
+  tesseract::TransformMap location;
+  addCollisionObjects(checker, static_cast<int>(state.range(0)), static_cast<BenchmarkShape>(state.range(1)),
+                      link_names, location);
+
+  checker.setContactRequest(createContactRequest(link_names, static_cast<int>(state.range(2))));
+  checker.setCollisionObjectsTransform(location);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(checker.clone());
+
+  setBenchmarkLabel(state);
+  state.counters["links"] = static_cast<double>(link_names.size());
+}
+
+template <typename ManagerType>
+void BM_ContinuousContactTest(benchmark::State& state)
+{
+  ManagerType checker;
+  std::vector<std::string> link_names;
+  tesseract::TransformMap location;
+  addCollisionObjects(checker, static_cast<int>(state.range(0)), static_cast<BenchmarkShape>(state.range(1)),
+                      link_names, location);
+
+  tesseract::TransformMap location2 = location;
+  for (auto& pose : location2)
+    pose.second.translation()(0) += 0.2;
+
+  checker.setContactRequest(createContactRequest(link_names, static_cast<int>(state.range(2))));
+  checker.setCollisionObjectsTransform(location, location2);
+
+  tesseract::ContactResultMap result;
+  for (auto _ : state)
+  {
+    result.clear();
+    checker.contactTest(result);
+    benchmark::DoNotOptimize(result);
+  }
+
+  setBenchmarkLabel(state);
+  state.counters["links"] = static_cast<double>(link_names.size());
+  state.counters["contacts"] = static_cast<double>(result.size());
+}
+
+template <typename ManagerType>
+void BM_ContinuousClone(benchmark::State& state)
+{
+  ManagerType checker;
+  std::vector<std::string> link_names;
+  tesseract::TransformMap location;
+  addCollisionObjects(checker, static_cast<int>(state.range(0)), static_cast<BenchmarkShape>(state.range(1)),
+                      link_names, location);
+
+  checker.setContactRequest(createContactRequest(link_names, static_cast<int>(state.range(2))));
+  checker.setCollisionObjectsTransform(location);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(checker.clone());
+
+  setBenchmarkLabel(state);
+  state.counters["links"] = static_cast<double>(link_names.size());
+}
+
+/** @brief Arguments are the grid size, the shape and the request type */
+void discreteArguments(benchmark::internal::Benchmark* b)
+{
+  for (int n : { 2, 5, 10 })
+    for (int shape : { PRIMITIVE, CONVEX_HULL, BVH_MESH, OCTREE })
+      for (int type = 0; type < 4; ++type)
+        b->Args({ n, shape, type });
+}
+
+/** @brief Same as discreteArguments but without triangle meshes which can not be cast */
+void continuousArguments(benchmark::internal::Benchmark* b)
+{
+  for (int n : { 2, 5, 10 })
+    for (int shape : { PRIMITIVE, CONVEX_HULL, OCTREE })
+      for (int type = 0; type < 4; ++type)
+        b->Args({ n, shape, type });
+}
+
+/** @brief Arguments for benchmarks which do not depend on the request type */
+void setupArguments(benchmark::internal::Benchmark* b)
+{
+  for (int n : { 2, 5, 10 })
+    for (int shape : { PRIMITIVE, CONVEX_HULL, BVH_MESH, OCTREE })
+      b->Args({ n, shape, 2 });
+}
+
+/** @brief Same as setupArguments but without triangle meshes which can not be cast */
+void continuousSetupArguments(benchmark::internal::Benchmark* b)
+{
+  for (int n : { 2, 5, 10 })
+    for (int shape : { PRIMITIVE, CONVEX_HULL, OCTREE })
+      b->Args({ n, shape, 2 });
+}
+
+BENCHMARK_TEMPLATE(BM_DiscreteContactTest, tesseract::BulletDiscreteSimpleManager)->Apply(discreteArguments);
+BENCHMARK_TEMPLATE(BM_DiscreteContactTest, tesseract::BulletDiscreteBVHManager)->Apply(discreteArguments);
+BENCHMARK_TEMPLATE(BM_DiscreteContactTest, tesseract::FCLDiscreteBVHManager)->Apply(discreteArguments);
+
+BENCHMARK_TEMPLATE(BM_DiscreteIsCollisionFree, tesseract::BulletDiscreteSimpleManager)->Apply(setupArguments);
+BENCHMARK_TEMPLATE(BM_DiscreteIsCollisionFree, tesseract::BulletDiscreteBVHManager)->Apply(setupArguments);
+BENCHMARK_TEMPLATE(BM_DiscreteIsCollisionFree, tesseract::FCLDiscreteBVHManager)->Apply(setupArguments);
+
+BENCHMARK_TEMPLATE(BM_DiscreteSetTransforms, tesseract::BulletDiscreteSimpleManager)->Apply(setupArguments);
+BENCHMARK_TEMPLATE(BM_DiscreteSetTransforms, tesseract::BulletDiscreteBVHManager)->Apply(setupArguments);
+BENCHMARK_TEMPLATE(BM_DiscreteSetTransforms, tesseract::FCLDiscreteBVHManager)->Apply(setupArguments);
+
+BENCHMARK_TEMPLATE(BM_DiscreteClone, tesseract::BulletDiscreteSimpleManager)->Apply(setupArguments);
+BENCHMARK_TEMPLATE(BM_DiscreteClone, tesseract::BulletDiscreteBVHManager)->Apply(setupArguments);
+BENCHMARK_TEMPLATE(BM_DiscreteClone, tesseract::FCLDiscreteBVHManager)->Apply(setupArguments);
+
+BENCHMARK_TEMPLATE(BM_ContinuousContactTest, tesseract::BulletCastSimpleManager)->Apply(continuousArguments);
+BENCHMARK_TEMPLATE(BM_ContinuousContactTest, tesseract::BulletCastBVHManager)->Apply(continuousArguments);
+
+BENCHMARK_TEMPLATE(BM_ContinuousClone, tesseract::BulletCastSimpleManager)->Apply(continuousSetupArguments);
+BENCHMARK_TEMPLATE(BM_ContinuousClone, tesseract::BulletCastBVHManager)->Apply(continuousSetupArguments);
+
+int main(int argc, char** argv)
+{
+  // Default to JSON so the results can be tracked, a --benchmark_format argument overrides it
+  std::vector<char*> args(argv, argv + argc);
+  std::string format = "--benchmark_format=json";
+  args.insert(args.begin() + 1, &format[0]);
+  int num_args = static_cast<int>(args.size());
+
+  benchmark::Initialize(&num_args, args.data());
+  if (benchmark::ReportUnrecognizedArguments(num_args, args.data()))
+    return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
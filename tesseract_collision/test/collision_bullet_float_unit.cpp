@@ -0,0 +1,178 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/bullet/bullet_cast_managers.h"
+#include <class_loader/class_loader.h>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+template <typename ContactManager>
+void addCollisionObjects(ContactManager& checker)
+{
+  ////////////////////////
+  // Add sphere to checker
+  ////////////////////////
+  shapes::ShapePtr sphere(new shapes::Sphere(0.25));
+  Eigen::Isometry3d sphere_pose;
+  sphere_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj1_shapes;
+  tesseract::VectorIsometry3d obj1_poses;
+  tesseract::CollisionObjectTypeVector obj1_types;
+  obj1_shapes.push_back(sphere);
+  obj1_poses.push_back(sphere_pose);
+  obj1_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("sphere_link", 0, obj1_shapes, obj1_poses, obj1_types);
+
+  //////////////////////////
+  // Add thin box to checker
+  //////////////////////////
+  shapes::ShapePtr box(new shapes::Box(0.1, 1, 1));
+  Eigen::Isometry3d box_pose;
+  box_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj2_shapes;
+  tesseract::VectorIsometry3d obj2_poses;
+  tesseract::CollisionObjectTypeVector obj2_types;
+  obj2_shapes.push_back(box);
+  obj2_poses.push_back(box_pose);
+  obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("box_link", 0, obj2_shapes, obj2_poses, obj2_types);
+}
+
+/** @brief The loader of the single precision bullet plugin, it must outlive the managers it creates */
+class_loader::ClassLoader& getFloatPluginLoader()
+{
+  static class_loader::ClassLoader loader(class_loader::systemLibraryFormat("tesseract_collision_bullet_float_plugin"));
+  return loader;
+}
+
+tesseract::DiscreteContactManagerBasePtr createFloatDiscreteManager(const std::string& name)
+{
+  return getFloatPluginLoader().createUniqueInstance<tesseract::DiscreteContactManagerBase>("tesseract::" + name);
+}
+
+tesseract::ContinuousContactManagerBasePtr createFloatContinuousManager(const std::string& name)
+{
+  return getFloatPluginLoader().createUniqueInstance<tesseract::ContinuousContactManagerBase>("tesseract::" + name);
+}
+
+void runDiscreteTest(tesseract::DiscreteContactManagerBase& checker)
+{
+  addCollisionObjects(checker);
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.5;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["box_link"] = Eigen::Isometry3d::Identity();
+  location["box_link"].translation()(0) = 0.4;
+  checker.setCollisionObjectsTransform(location);
+
+  // The sphere is 0.1 from the box
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+
+  tesseract::ContactResultVector result_vector;
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, 0.1, 1e-4);
+
+  // The sphere penetrates the box by 0.1
+  location["box_link"].translation()(0) = 0.2;
+  checker.setCollisionObjectsTransform(location);
+
+  result.clear();
+  result_vector.clear();
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, -0.1, 1e-4);
+
+  // A clone gives the same result
+  tesseract::DiscreteContactManagerBasePtr cloned_checker = checker.clone();
+  result.clear();
+  result_vector.clear();
+  cloned_checker->contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, -0.1, 1e-4);
+}
+
+void runCastTest(tesseract::ContinuousContactManagerBase& checker)
+{
+  addCollisionObjects(checker);
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  // The sphere moves through the box
+  Eigen::Isometry3d start_pos, end_pos;
+  start_pos.setIdentity();
+  start_pos.translation()(0) = -1;
+  end_pos.setIdentity();
+  end_pos.translation()(0) = 1;
+  checker.setCollisionObjectsTransform("sphere_link", start_pos, end_pos);
+  checker.setCollisionObjectsTransform("box_link", Eigen::Isometry3d::Identity());
+
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+
+  tesseract::ContactResultVector result_vector;
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_LT(result_vector[0].distance, 0);
+}
+
+TEST(TesseractCollisionUnit, BulletFloatDiscreteSimpleUnit)
+{
+  tesseract::DiscreteContactManagerBasePtr checker = createFloatDiscreteManager("BulletFloatDiscreteSimpleManager");
+  ASSERT_TRUE(checker != nullptr);
+  runDiscreteTest(*checker);
+}
+
+TEST(TesseractCollisionUnit, BulletFloatDiscreteBVHUnit)
+{
+  tesseract::DiscreteContactManagerBasePtr checker = createFloatDiscreteManager("BulletFloatDiscreteBVHManager");
+  ASSERT_TRUE(checker != nullptr);
+  runDiscreteTest(*checker);
+}
+
+TEST(TesseractCollisionUnit, BulletFloatCastSimpleUnit)
+{
+  tesseract::ContinuousContactManagerBasePtr checker = createFloatContinuousManager("BulletFloatCastSimpleManager");
+  ASSERT_TRUE(checker != nullptr);
+  runCastTest(*checker);
+}
+
+TEST(TesseractCollisionUnit, BulletFloatCastBVHUnit)
+{
+  tesseract::ContinuousContactManagerBasePtr checker = createFloatContinuousManager("BulletFloatCastBVHManager");
+  ASSERT_TRUE(checker != nullptr);
+  runCastTest(*checker);
+}
+
+TEST(TesseractCollisionUnit, BulletFloatWithDoubleUnit)
+{
+  // The double precision managers still work with the single precision plugin loaded into the process
+  tesseract::DiscreteContactManagerBasePtr float_checker = createFloatDiscreteManager("BulletFloatDiscreteBVHManager");
+  ASSERT_TRUE(float_checker != nullptr);
+
+  tesseract::BulletDiscreteBVHManager checker;
+  runDiscreteTest(checker);
+  runDiscreteTest(*float_checker);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,234 @@
+#include "tesseract_collision/bullet/bullet_cast_managers.h"
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+template <typename ManagerType>
+void addSphere(ManagerType& checker, const std::string& name)
+{
+  shapes::ShapePtr sphere(new shapes::Sphere(0.25));
+  Eigen::Isometry3d sphere_pose;
+  sphere_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj_shapes;
+  tesseract::VectorIsometry3d obj_poses;
+  tesseract::CollisionObjectTypeVector obj_types;
+  obj_shapes.push_back(sphere);
+  obj_poses.push_back(sphere_pose);
+  obj_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject(name, 0, obj_shapes, obj_poses, obj_types);
+}
+
+template <typename ManagerType>
+void addCollisionObjects(ManagerType& checker)
+{
+  addSphere(checker, "sphere_link");
+  addSphere(checker, "sphere1_link");
+}
+
+template <typename ManagerType>
+bool hasCollision(ManagerType& checker)
+{
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+  return !result.empty();
+}
+
+/** @brief Move an object of a discrete checker */
+void setTransform(tesseract::DiscreteContactManagerBase& checker,
+                  const std::string& name,
+                  const Eigen::Isometry3d& pose)
+{
+  checker.setCollisionObjectsTransform(name, pose);
+}
+
+/** @brief Move an object of a continuous checker without motion, active objects are only moved by a cast */
+void setTransform(tesseract::ContinuousContactManagerBase& checker,
+                  const std::string& name,
+                  const Eigen::Isometry3d& pose)
+{
+  checker.setCollisionObjectsTransform(name, pose);
+  checker.setCollisionObjectsTransform(name, pose, pose);
+}
+
+template <typename ManagerType>
+void runTest(ManagerType& checker)
+{
+  typedef decltype(checker.clone()) ManagerBasePtr;
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.link_names.push_back("sphere1_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  setTransform(checker, "sphere_link", Eigen::Isometry3d::Identity());
+  setTransform(checker, "sphere1_link", Eigen::Isometry3d(Eigen::Translation3d(0.2, 0, 0)));
+  ASSERT_TRUE(hasCollision(checker));
+
+  ////////////////////////////////////////////////////
+  // Moving an object of a clone leaves the source
+  ////////////////////////////////////////////////////
+  ManagerBasePtr clone = checker.clone();
+  EXPECT_TRUE(hasCollision(*clone));
+
+  setTransform(*clone, "sphere1_link", Eigen::Isometry3d(Eigen::Translation3d(2, 0, 0)));
+  EXPECT_FALSE(hasCollision(*clone));
+  EXPECT_TRUE(hasCollision(checker));
+
+  ////////////////////////////////////////////////////
+  // Moving an object of the source leaves the clone
+  ////////////////////////////////////////////////////
+  setTransform(checker, "sphere_link", Eigen::Isometry3d(Eigen::Translation3d(-2, 0, 0)));
+  EXPECT_FALSE(hasCollision(checker));
+  setTransform(*clone, "sphere1_link", Eigen::Isometry3d(Eigen::Translation3d(0.2, 0, 0)));
+  EXPECT_TRUE(hasCollision(*clone));
+
+  ////////////////////////////////////////////////////////
+  // Disabling and filtering objects is local to a clone
+  ////////////////////////////////////////////////////////
+  ManagerBasePtr clone2 = clone->clone();
+  clone2->disableCollisionObject("sphere_link");
+  EXPECT_FALSE(hasCollision(*clone2));
+  EXPECT_TRUE(hasCollision(*clone));
+
+  req.link_names.pop_back();
+  req.link_names.pop_back();
+  req.link_names.push_back("unknown_link");
+  clone->setContactRequest(req);
+  EXPECT_FALSE(hasCollision(*clone));
+
+  clone2->enableCollisionObject("sphere_link");
+  EXPECT_TRUE(hasCollision(*clone2));
+
+  ////////////////////////////////////////////////////////////////////////
+  // Clones of the same source and released clones leave the others alone
+  ////////////////////////////////////////////////////////////////////////
+  ManagerBasePtr clone3 = clone2->clone();
+  ManagerBasePtr clone4 = clone2->clone();
+  clone2.reset();
+
+  setTransform(*clone3, "sphere1_link", Eigen::Isometry3d(Eigen::Translation3d(2, 0, 0)));
+  EXPECT_FALSE(hasCollision(*clone3));
+  EXPECT_TRUE(hasCollision(*clone4));
+
+  clone4->disableCollisionObject("sphere1_link");
+  EXPECT_FALSE(hasCollision(*clone4));
+  setTransform(*clone3, "sphere1_link", Eigen::Isometry3d(Eigen::Translation3d(0.2, 0, 0)));
+  EXPECT_TRUE(hasCollision(*clone3));
+}
+
+template <typename ManagerType>
+void runReleasedOwnerTest(ManagerType& checker)
+{
+  typedef decltype(checker.clone()) ManagerBasePtr;
+
+  // A released manager may be followed by a clone allocated at the same address, which must not modify the
+  // objects the released manager shared with other clones
+  for (int i = 0; i < 10; ++i)
+  {
+    ManagerBasePtr source = checker.clone();
+    setTransform(*source, "sphere_link", Eigen::Isometry3d::Identity());
+    setTransform(*source, "sphere1_link", Eigen::Isometry3d(Eigen::Translation3d(0.2, 0, 0)));
+
+    ManagerBasePtr clone = source->clone();
+    source.reset();
+
+    ManagerBasePtr clone2 = clone->clone();
+    setTransform(*clone2, "sphere1_link", Eigen::Isometry3d(Eigen::Translation3d(2, 0, 0)));
+    EXPECT_FALSE(hasCollision(*clone2));
+    EXPECT_TRUE(hasCollision(*clone));
+  }
+}
+
+void runCastTest(tesseract::ContinuousContactManagerBase& checker)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere1_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  checker.setCollisionObjectsTransform("sphere_link", Eigen::Isometry3d::Identity());
+  setTransform(checker, "sphere1_link", Eigen::Isometry3d(Eigen::Translation3d(2, 0, 0)));
+  ASSERT_FALSE(hasCollision(checker));
+
+  //////////////////////////////////////////////////////////////////
+  // Casting an object of a clone leaves the cast of the source
+  //////////////////////////////////////////////////////////////////
+  tesseract::ContinuousContactManagerBasePtr clone = checker.clone();
+  EXPECT_FALSE(hasCollision(*clone));
+
+  // The cast passes through the static sphere
+  clone->setCollisionObjectsTransform("sphere1_link",
+                                      Eigen::Isometry3d(Eigen::Translation3d(2, 0, 0)),
+                                      Eigen::Isometry3d(Eigen::Translation3d(-2, 0, 0)));
+  EXPECT_TRUE(hasCollision(*clone));
+  EXPECT_FALSE(hasCollision(checker));
+
+  ////////////////////////////////////////////////////////////
+  // A clone keeps the cast, sweeping it leaves the source
+  ////////////////////////////////////////////////////////////
+  tesseract::ContinuousContactManagerBasePtr clone2 = clone->clone();
+  EXPECT_TRUE(hasCollision(*clone2));
+
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d(Eigen::Translation3d(2, 0, 0)),
+                                        Eigen::Isometry3d(Eigen::Translation3d(2, 2, 0)),
+                                        Eigen::Isometry3d(Eigen::Translation3d(-2, 2, 0)) };
+  clone2->setCollisionObjectsSweptTransform("sphere1_link", poses);
+  EXPECT_FALSE(hasCollision(*clone2));
+  EXPECT_TRUE(hasCollision(*clone));
+  EXPECT_FALSE(hasCollision(checker));
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionCloneUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+  runReleasedOwnerTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionCloneUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+  runReleasedOwnerTest(checker);
+}
+
+TEST(TesseractCollisionUnit, FCLDiscreteBVHCollisionCloneUnit)
+{
+  tesseract::FCLDiscreteBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+  runReleasedOwnerTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletCastSimpleCollisionCloneUnit)
+{
+  tesseract::BulletCastSimpleManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+  runReleasedOwnerTest(checker);
+  runCastTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletCastBVHCollisionCloneUnit)
+{
+  tesseract::BulletCastBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+  runReleasedOwnerTest(checker);
+  runCastTest(checker);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,324 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  ////////////////////////////////////////////////////////////
+  // Add a link of three spheres, each is a separate shape
+  ////////////////////////////////////////////////////////////
+  std::vector<shapes::ShapeConstPtr> obj1_shapes;
+  tesseract::VectorIsometry3d obj1_poses;
+  tesseract::CollisionObjectTypeVector obj1_types;
+  for (int i = -1; i <= 1; ++i)
+  {
+    Eigen::Isometry3d sphere_pose;
+    sphere_pose.setIdentity();
+    sphere_pose.translation()(0) = 0.5 * i;
+
+    obj1_shapes.push_back(shapes::ShapePtr(new shapes::Sphere(0.1)));
+    obj1_poses.push_back(sphere_pose);
+    obj1_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+  }
+
+  checker.addCollisionObject("multi_link", 0, obj1_shapes, obj1_poses, obj1_types);
+
+  ///////////////////////////////////////////////////
+  // Add box to checker which overlaps every sphere
+  ///////////////////////////////////////////////////
+  shapes::ShapePtr box(new shapes::Box(1.4, 0.2, 0.6));
+  Eigen::Isometry3d box_pose;
+  box_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj2_shapes;
+  tesseract::VectorIsometry3d obj2_poses;
+  tesseract::CollisionObjectTypeVector obj2_types;
+  obj2_shapes.push_back(box);
+  obj2_poses.push_back(box_pose);
+  obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("box_link", 0, obj2_shapes, obj2_poses, obj2_types);
+
+  ///////////////////////////////////////////////////////////////
+  // Add sphere to checker which is only in contact with the box
+  ///////////////////////////////////////////////////////////////
+  shapes::ShapePtr sphere(new shapes::Sphere(0.1));
+  Eigen::Isometry3d sphere_pose;
+  sphere_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj3_shapes;
+  tesseract::VectorIsometry3d obj3_poses;
+  tesseract::CollisionObjectTypeVector obj3_types;
+  obj3_shapes.push_back(sphere);
+  obj3_poses.push_back(sphere_pose);
+  obj3_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("sphere_link", 0, obj3_shapes, obj3_poses, obj3_types);
+}
+
+/** @brief The number of contacts found by a contact test, in total and for each pair of links */
+struct ContactCounts
+{
+  std::size_t total = 0;
+  std::map<std::pair<std::string, std::string>, std::size_t> pairs;
+
+  void add(const std::string& name1, const std::string& name2)
+  {
+    ++pairs[tesseract::getObjectPairKey(name1, name2)];
+    ++total;
+  }
+
+  std::size_t get(const std::string& name1, const std::string& name2) const
+  {
+    auto it = pairs.find(tesseract::getObjectPairKey(name1, name2));
+    return it == pairs.end() ? 0 : it->second;
+  }
+};
+
+ContactCounts getContactCounts(const tesseract::ContactResultMap& result, const tesseract::NameRegistry&)
+{
+  ContactCounts counts;
+  for (const auto& pair : result)
+    for (const auto& contact : pair.second)
+      counts.add(contact.link_names[0], contact.link_names[1]);
+
+  return counts;
+}
+
+ContactCounts getContactCounts(const tesseract::ContactResultIdMap& result, const tesseract::NameRegistry& registry)
+{
+  ContactCounts counts;
+  for (const auto& pair : result)
+    for (const auto& contact : pair.second)
+      counts.add(registry.getName(contact.link_ids[0]), registry.getName(contact.link_ids[1]));
+
+  return counts;
+}
+
+ContactCounts getContactCounts(const tesseract::ContactResultBuffer& result, const tesseract::NameRegistry& registry)
+{
+  ContactCounts counts;
+  for (const auto& record : result)
+    counts.add(registry.getName(record.link_ids[0]), registry.getName(record.link_ids[1]));
+
+  return counts;
+}
+
+/** @brief Run a contact test storing the contacts in a ResultType and count them */
+template <typename ResultType>
+ContactCounts runContactTest(tesseract::DiscreteContactManagerBase& checker)
+{
+  ResultType result;
+  checker.contactTest(result);
+  return getContactCounts(result, *checker.getLinkRegistry());
+}
+
+template <typename ResultType>
+void runTest(tesseract::DiscreteContactManagerBase& checker)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("multi_link");
+  req.link_names.push_back("box_link");
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+
+  // The sphere link is 0.05 from the box and 0.25 from the multi sphere link
+  tesseract::TransformMap location;
+  location["multi_link"] = Eigen::Isometry3d::Identity();
+  location["box_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"].translation()(2) = 0.45;
+  checker.setCollisionObjectsTransform(location);
+
+  ///////////////////////////////////////////////////////////
+  // Test every contact of the multi sphere link is reported
+  ///////////////////////////////////////////////////////////
+  req.type = tesseract::ContactRequestType::ALL;
+  checker.setContactRequest(req);
+
+  ContactCounts counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.get("multi_link", "box_link"), 3u);
+  EXPECT_EQ(counts.get("sphere_link", "box_link"), 1u);
+  EXPECT_EQ(counts.get("multi_link", "sphere_link"), 0u);
+  EXPECT_EQ(counts.total, 4u);
+
+  ///////////////////////////////////////////////////
+  // Test the contacts per pair of LIMITED requests
+  ///////////////////////////////////////////////////
+  req.type = tesseract::ContactRequestType::LIMITED;
+  req.max_contacts_per_pair = 2;
+  checker.setContactRequest(req);
+
+  // The limit is reached for the multi sphere link, the other pair has a single contact
+  counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.get("multi_link", "box_link"), 2u);
+  EXPECT_EQ(counts.get("sphere_link", "box_link"), 1u);
+  EXPECT_EQ(counts.total, 3u);
+
+  req.max_contacts_per_pair = 1;
+  checker.setContactRequest(req);
+
+  counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.get("multi_link", "box_link"), 1u);
+  EXPECT_EQ(counts.get("sphere_link", "box_link"), 1u);
+  EXPECT_EQ(counts.total, 2u);
+
+  // A limit above the number of contacts keeps all of them
+  req.max_contacts_per_pair = 4;
+  checker.setContactRequest(req);
+
+  counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.get("multi_link", "box_link"), 3u);
+  EXPECT_EQ(counts.total, 4u);
+
+  ///////////////////////////////////////////////////
+  // Test the total contacts of LIMITED requests
+  ///////////////////////////////////////////////////
+  req.max_contacts_per_pair = 3;
+  req.max_total_contacts = 3;
+  checker.setContactRequest(req);
+
+  counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.total, 3u);
+
+  req.max_total_contacts = 2;
+  checker.setContactRequest(req);
+
+  counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.total, 2u);
+
+  // The limit also applies within the contacts of a single pair
+  req.link_names.clear();
+  req.link_names.push_back("multi_link");
+  checker.setContactRequest(req);
+
+  location["sphere_link"].translation()(2) = 2;
+  checker.setCollisionObjectsTransform(location);
+
+  counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.get("multi_link", "box_link"), 2u);
+  EXPECT_EQ(counts.total, 2u);
+
+  req.max_total_contacts = 1;
+  checker.setContactRequest(req);
+
+  counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.total, 1u);
+
+  ///////////////////////////////////////
+  // Test FIRST stops at the first one
+  ///////////////////////////////////////
+  req.type = tesseract::ContactRequestType::FIRST;
+  req.max_total_contacts = 0;
+  checker.setContactRequest(req);
+
+  counts = runContactTest<ResultType>(checker);
+  EXPECT_EQ(counts.total, 1u);
+}
+
+template <typename T>
+class CollisionContactLimitsUnit : public testing::Test
+{
+};
+
+typedef testing::Types<tesseract::BulletDiscreteSimpleManager,
+                       tesseract::BulletDiscreteBVHManager,
+                       tesseract::FCLDiscreteBVHManager>
+    DiscreteManagerTypes;
+TYPED_TEST_CASE(CollisionContactLimitsUnit, DiscreteManagerTypes);
+
+TYPED_TEST(CollisionContactLimitsUnit, ContactLimits)
+{
+  TypeParam checker;
+  addCollisionObjects(checker);
+
+  // The limits are the same for every container of the results
+  {
+    SCOPED_TRACE("ContactResultMap");
+    runTest<tesseract::ContactResultMap>(checker);
+  }
+  {
+    SCOPED_TRACE("ContactResultIdMap");
+    runTest<tesseract::ContactResultIdMap>(checker);
+  }
+  {
+    SCOPED_TRACE("ContactResultBuffer");
+    runTest<tesseract::ContactResultBuffer>(checker);
+  }
+}
+
+/** @brief Get the name of the other link of the only contact of a result */
+std::string getFirstContactLink(const tesseract::ContactResultMap& result, const std::string& link_name)
+{
+  if (result.size() != 1 || result.begin()->second.size() != 1)
+    return "";
+
+  const tesseract::ContactResult& contact = result.begin()->second[0];
+  return (contact.link_names[0] == link_name) ? contact.link_names[1] : contact.link_names[0];
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionSweepOrderUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+
+  // A sphere penetrated by a box on each side along x
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+  std::vector<shapes::ShapeConstPtr> sphere_shapes = { shapes::ShapeConstPtr(new shapes::Sphere(0.5)) };
+  std::vector<shapes::ShapeConstPtr> box_shapes = { shapes::ShapeConstPtr(new shapes::Box(0.2, 0.2, 0.2)) };
+  checker.addCollisionObject("sphere_link", 0, sphere_shapes, poses, types);
+  checker.addCollisionObject("box_a_link", 0, box_shapes, poses, types);
+  checker.addCollisionObject("box_b_link", 0, box_shapes, poses, types);
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0;
+  req.type = tesseract::ContactRequestType::FIRST;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["box_a_link"] = Eigen::Isometry3d::Identity();
+  location["box_b_link"] = Eigen::Isometry3d::Identity();
+
+  // The pairs are visited in the order of the AABB minimum along the sweep axis, not in the order of the objects
+  for (const std::string& first_link : { "box_a_link", "box_b_link" })
+  {
+    SCOPED_TRACE(first_link);
+    for (auto& transform : location)
+    {
+      if (transform.first != "sphere_link")
+        transform.second.translation()(0) = (transform.first == first_link) ? -0.5 : 0.5;
+    }
+    checker.setCollisionObjectsTransform(location);
+
+    req.type = tesseract::ContactRequestType::FIRST;
+    checker.setContactRequest(req);
+    tesseract::ContactResultMap result;
+    checker.contactTest(result);
+    EXPECT_EQ(getFirstContactLink(result, "sphere_link"), first_link);
+
+    req.type = tesseract::ContactRequestType::LIMITED;
+    req.max_total_contacts = 1;
+    checker.setContactRequest(req);
+    result.clear();
+    checker.contactTest(result);
+    EXPECT_EQ(getFirstContactLink(result, "sphere_link"), first_link);
+
+    // Requests which are not cut short find the same contacts in any order
+    req.type = tesseract::ContactRequestType::ALL;
+    req.max_total_contacts = 0;
+    checker.setContactRequest(req);
+    result.clear();
+    checker.contactTest(result);
+    EXPECT_EQ(getContactCounts(result, *checker.getLinkRegistry()).total, 2u);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,240 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/convex_decomposition.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+/** @brief Create a U shaped prism, 0.3 x 0.3 x 0.1 with a 0.1 wide slot, which is not convex */
+shapes::ShapePtr createUShapedMesh()
+{
+  const std::vector<Eigen::Vector2d> polygon = { Eigen::Vector2d(0, 0), Eigen::Vector2d(3, 0), Eigen::Vector2d(3, 3),
+                                                 Eigen::Vector2d(2, 3), Eigen::Vector2d(2, 1), Eigen::Vector2d(1, 1),
+                                                 Eigen::Vector2d(1, 3), Eigen::Vector2d(0, 3) };
+  const std::vector<int> cap = { 0, 1, 4, 0, 4, 5, 1, 2, 3, 1, 3, 4, 0, 5, 6, 0, 6, 7 };
+
+  shapes::Mesh* mesh = new shapes::Mesh(16, 28);
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    for (unsigned int k = 0; k < 2; ++k)
+    {
+      unsigned int v = i + 8 * k;
+      mesh->vertices[3 * v] = 0.1 * polygon[i][0];
+      mesh->vertices[3 * v + 1] = 0.1 * polygon[i][1];
+      mesh->vertices[3 * v + 2] = 0.1 * (1 - k);
+    }
+  }
+
+  unsigned int t = 0;
+  for (std::size_t i = 0; i < cap.size(); i += 3)
+  {
+    // Top cap facing +z and bottom cap facing -z
+    mesh->triangles[t++] = static_cast<unsigned int>(cap[i]);
+    mesh->triangles[t++] = static_cast<unsigned int>(cap[i + 1]);
+    mesh->triangles[t++] = static_cast<unsigned int>(cap[i + 2]);
+    mesh->triangles[t++] = static_cast<unsigned int>(cap[i + 2] + 8);
+    mesh->triangles[t++] = static_cast<unsigned int>(cap[i + 1] + 8);
+    mesh->triangles[t++] = static_cast<unsigned int>(cap[i] + 8);
+  }
+
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    unsigned int j = (i + 1) % 8;
+    mesh->triangles[t++] = i;
+    mesh->triangles[t++] = j + 8;
+    mesh->triangles[t++] = j;
+    mesh->triangles[t++] = i;
+    mesh->triangles[t++] = i + 8;
+    mesh->triangles[t++] = j + 8;
+  }
+
+  mesh->computeTriangleNormals();
+  mesh->computeVertexNormals();
+  return shapes::ShapePtr(mesh);
+}
+
+void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  ////////////////////////////////////////////////////////////////////
+  // Add U shaped mesh to checker represented by a set of convex hulls
+  ////////////////////////////////////////////////////////////////////
+  shapes::ShapePtr u_mesh = createUShapedMesh();
+  Eigen::Isometry3d u_mesh_pose;
+  u_mesh_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj1_shapes;
+  tesseract::VectorIsometry3d obj1_poses;
+  tesseract::CollisionObjectTypeVector obj1_types;
+  obj1_shapes.push_back(u_mesh);
+  obj1_poses.push_back(u_mesh_pose);
+  obj1_types.push_back(tesseract::CollisionObjectType::ConvexDecomposition);
+
+  checker.addCollisionObject("decomposition_link", 0, obj1_shapes, obj1_poses, obj1_types);
+
+  /////////////////////////////
+  // Add sphere to checker
+  /////////////////////////////
+  shapes::ShapePtr sphere(new shapes::Sphere(0.03));
+  Eigen::Isometry3d sphere_pose;
+  sphere_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj2_shapes;
+  tesseract::VectorIsometry3d obj2_poses;
+  tesseract::CollisionObjectTypeVector obj2_types;
+  obj2_shapes.push_back(sphere);
+  obj2_poses.push_back(sphere_pose);
+  obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("sphere_link", 0, obj2_shapes, obj2_poses, obj2_types);
+}
+
+void runTest(tesseract::DiscreteContactManagerBase& checker)
+{
+  // The hulls may extend up to max_error beyond the mesh
+  const double tolerance = tesseract::CONVEX_DECOMPOSITION_DEFAULT_MAX_ERROR + 0.001;
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("decomposition_link");
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Test sphere inside the slot, the hulls must not fill it
+  ///////////////////////////////////////////////////////////////////////////
+  tesseract::TransformMap location;
+  location["decomposition_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"].translation() = Eigen::Vector3d(0.15, 0.2, 0.05);
+  checker.setCollisionObjectsTransform(location);
+
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+
+  tesseract::ContactResultVector result_vector;
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  ASSERT_TRUE(!result_vector.empty());
+  EXPECT_NEAR(result_vector[0].distance, 0.02, tolerance);
+
+  //////////////////////////////////////
+  // Test when object is in collision
+  //////////////////////////////////////
+  location["sphere_link"].translation() = Eigen::Vector3d(0.05, 0.05, 0.05);
+  result.clear();
+  result_vector.clear();
+  checker.setCollisionObjectsTransform(location);
+
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  ASSERT_TRUE(!result_vector.empty());
+  EXPECT_LT(result_vector[0].distance, 0);
+
+  ////////////////////////////////////////////////
+  // Test object is out side the contact distance
+  ////////////////////////////////////////////////
+  location["sphere_link"].translation() = Eigen::Vector3d(0.6, 0.15, 0.05);
+  result.clear();
+  result_vector.clear();
+  checker.setCollisionObjectsTransform(location);
+
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  EXPECT_TRUE(result_vector.empty());
+}
+
+TEST(TesseractCollisionUnit, ConvexDecompositionPointInsideMeshUnit)
+{
+  // Unit cube, vertex i is at (i & 1, (i >> 1) & 1, (i >> 2) & 1)
+  tesseract::VectorVector3d vertices;
+  for (int i = 0; i < 8; ++i)
+    vertices.push_back(Eigen::Vector3d(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+
+  const std::vector<int> triangles = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                                       2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+
+  EXPECT_TRUE(tesseract::isPointInsideMesh(Eigen::Vector3d(0.5, 0.5, 0.5), vertices, triangles));
+  EXPECT_TRUE(tesseract::isPointInsideMesh(Eigen::Vector3d(0.2, 0.3, 0.4), vertices, triangles));
+  EXPECT_TRUE(tesseract::isPointInsideMesh(Eigen::Vector3d(0.95, 0.05, 0.9), vertices, triangles));
+
+  EXPECT_FALSE(tesseract::isPointInsideMesh(Eigen::Vector3d(-1, 0.5, 0.5), vertices, triangles));
+  EXPECT_FALSE(tesseract::isPointInsideMesh(Eigen::Vector3d(2, 0.5, 0.5), vertices, triangles));
+  EXPECT_FALSE(tesseract::isPointInsideMesh(Eigen::Vector3d(0.5, 1.5, 0.5), vertices, triangles));
+  EXPECT_FALSE(tesseract::isPointInsideMesh(Eigen::Vector3d(0.5, 0.5, -0.2), vertices, triangles));
+
+  // The slot of the U shaped mesh is outside of it
+  shapes::ShapePtr u_mesh = createUShapedMesh();
+  const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(*u_mesh);
+
+  tesseract::VectorVector3d u_vertices;
+  for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+    u_vertices.push_back(Eigen::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]));
+
+  std::vector<int> u_triangles(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+  EXPECT_TRUE(tesseract::isPointInsideMesh(Eigen::Vector3d(0.05, 0.05, 0.05), u_vertices, u_triangles));
+  EXPECT_TRUE(tesseract::isPointInsideMesh(Eigen::Vector3d(0.25, 0.25, 0.05), u_vertices, u_triangles));
+  EXPECT_FALSE(tesseract::isPointInsideMesh(Eigen::Vector3d(0.15, 0.2, 0.05), u_vertices, u_triangles));
+}
+
+TEST(TesseractCollisionUnit, ConvexDecompositionUnit)
+{
+  shapes::ShapePtr u_mesh = createUShapedMesh();
+  const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(*u_mesh);
+
+  tesseract::VectorVector3d vertices;
+  for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+    vertices.push_back(Eigen::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]));
+
+  std::vector<int> triangles(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+
+  std::vector<tesseract::VectorVector3d> hulls;
+  int num_hulls = tesseract::createConvexDecomposition(hulls, vertices, triangles);
+  ASSERT_GT(num_hulls, 1);
+  EXPECT_LE(num_hulls, tesseract::CONVEX_DECOMPOSITION_DEFAULT_MAX_HULLS);
+  EXPECT_EQ(static_cast<int>(hulls.size()), num_hulls);
+
+  // No hull may fill the slot
+  const double tolerance = tesseract::CONVEX_DECOMPOSITION_DEFAULT_MAX_ERROR;
+  for (const auto& hull : hulls)
+  {
+    ASSERT_FALSE(hull.empty());
+    bool fills_slot = false;
+    for (const auto& v : hull)
+    {
+      EXPECT_GE(v.minCoeff(), -tolerance);
+      EXPECT_LE(v[0], 0.3 + tolerance);
+      EXPECT_LE(v[1], 0.3 + tolerance);
+      EXPECT_LE(v[2], 0.1 + tolerance);
+      if (v[0] > 0.1 + tolerance && v[0] < 0.2 - tolerance && v[1] > 0.1 + tolerance)
+        fills_slot = true;
+    }
+    EXPECT_FALSE(fills_slot);
+  }
+
+  // The cached variant gives the same decomposition, see collision_geometry_cache_unit for the cache itself
+  std::vector<tesseract::VectorVector3d> cached_hulls;
+  EXPECT_EQ(tesseract::createCachedConvexDecomposition(cached_hulls, vertices, triangles), num_hulls);
+  EXPECT_EQ(tesseract::createCachedConvexDecomposition(cached_hulls, vertices, triangles), num_hulls);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionConvexDecompositionUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionConvexDecompositionUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,134 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+template <typename T>
+class CollisionFreeUnit : public testing::Test
+{
+};
+
+typedef testing::Types<tesseract::BulletDiscreteSimpleManager,
+                       tesseract::BulletDiscreteBVHManager,
+                       tesseract::FCLDiscreteBVHManager>
+    DiscreteManagerTypes;
+TYPED_TEST_CASE(CollisionFreeUnit, DiscreteManagerTypes);
+
+/**
+ * @brief Add two spheres 0.5 apart, a disabled box through the first sphere and two overlapping static spheres
+ *
+ * The request only includes the two spheres, so the static spheres are not checked against each other.
+ */
+tesseract::ContactRequest addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+  std::vector<shapes::ShapeConstPtr> sphere_shapes = { shapes::ShapeConstPtr(new shapes::Sphere(0.25)) };
+  std::vector<shapes::ShapeConstPtr> box_shapes = { shapes::ShapeConstPtr(new shapes::Box(0.1, 1, 1)) };
+
+  checker.addCollisionObject("sphere_link", 0, sphere_shapes, poses, types);
+  checker.addCollisionObject("sphere1_link", 0, sphere_shapes, poses, types);
+  checker.addCollisionObject("thin_box_link", 0, box_shapes, poses, types, false);
+  checker.addCollisionObject("static_link", 0, sphere_shapes, poses, types);
+  checker.addCollisionObject("static1_link", 0, sphere_shapes, poses, types);
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.link_names.push_back("sphere1_link");
+  req.contact_distance = 0.52;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere1_link"] = Eigen::Isometry3d::Identity();
+  location["sphere1_link"].translation()(0) = 1;
+  location["thin_box_link"] = Eigen::Isometry3d::Identity();
+  location["static_link"] = Eigen::Isometry3d::Identity();
+  location["static_link"].translation()(1) = 3;
+  location["static1_link"] = location["static_link"];
+  location["static1_link"].translation()(0) = 0.2;
+  checker.setCollisionObjectsTransform(location);
+
+  return req;
+}
+
+/** @brief Check isCollisionFree() gives the same answer as a contact test */
+void checkCollisionFree(tesseract::DiscreteContactManagerBase& checker, bool expected)
+{
+  EXPECT_EQ(checker.isCollisionFree(), expected);
+
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+  EXPECT_EQ(result.empty(), expected);
+}
+
+TYPED_TEST(CollisionFreeUnit, CollisionFree)
+{
+  TypeParam checker;
+  tesseract::ContactRequest req = addCollisionObjects(checker);
+
+  // A contact within the contact distance is found, the overlapping static spheres are ignored
+  {
+    SCOPED_TRACE("within contact distance");
+    checkCollisionFree(checker, false);
+  }
+
+  req.contact_distance = 0.1;
+  checker.setContactRequest(req);
+  {
+    SCOPED_TRACE("outside contact distance");
+    checkCollisionFree(checker, true);
+  }
+
+  // The disabled box passes through the sphere
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  checker.setCollisionObjectsTransform("thin_box_link", pose);
+  {
+    SCOPED_TRACE("disabled object");
+    checkCollisionFree(checker, true);
+  }
+
+  checker.enableCollisionObject("thin_box_link");
+  {
+    SCOPED_TRACE("enabled object");
+    checkCollisionFree(checker, false);
+  }
+
+  // The sphere is inside the other one, but contact between them is allowed
+  checker.disableCollisionObject("thin_box_link");
+  pose.translation()(0) = 0.2;
+  checker.setCollisionObjectsTransform("sphere1_link", pose);
+  req.isContactAllowed = [](const std::string& name1, const std::string& name2) {
+    return (name1 == "sphere_link" && name2 == "sphere1_link") || (name1 == "sphere1_link" && name2 == "sphere_link");
+  };
+  checker.setContactRequest(req);
+  {
+    SCOPED_TRACE("allowed collision");
+    checkCollisionFree(checker, true);
+  }
+
+  req.isContactAllowed = nullptr;
+  checker.setContactRequest(req);
+  {
+    SCOPED_TRACE("in collision");
+    checkCollisionFree(checker, false);
+  }
+
+  // A link which is not part of the request is still checked against the links which are
+  pose.translation() = Eigen::Vector3d(3, 0, 0);
+  checker.setCollisionObjectsTransform("sphere1_link", pose);
+  pose.translation() = Eigen::Vector3d(0.2, 0, 0);
+  checker.setCollisionObjectsTransform("static_link", pose);
+  {
+    SCOPED_TRACE("static object");
+    checkCollisionFree(checker, false);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,209 @@
+#include "tesseract_collision/geometry_cache.h"
+#include <dirent.h>
+#include <ftw.h>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+std::string createTemporaryDirectory()
+{
+  char directory[] = "/tmp/tesseract_geometry_cache_XXXXXX";
+  return mkdtemp(directory) == nullptr ? std::string() : std::string(directory);
+}
+
+void removeDirectory(const std::string& directory)
+{
+  nftw(directory.c_str(),
+       [](const char* path, const struct stat*, int, struct FTW*) { return std::remove(path); },
+       16,
+       FTW_DEPTH | FTW_PHYS);
+}
+
+std::vector<std::string> listDirectory(const std::string& directory)
+{
+  std::vector<std::string> files;
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr)
+    return files;
+
+  while (struct dirent* entry = readdir(dir))
+  {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..")
+      files.push_back(directory + "/" + name);
+  }
+  closedir(dir);
+
+  return files;
+}
+
+std::size_t getFileSize(const std::string& path)
+{
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+}
+
+tesseract::VectorVector3d getCubeVertices()
+{
+  tesseract::VectorVector3d vertices;
+  for (int i = 0; i < 8; ++i)
+    vertices.push_back(Eigen::Vector3d(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+
+  // An interior point which is not part of the hull
+  vertices.push_back(Eigen::Vector3d(0.5, 0.5, 0.5));
+  return vertices;
+}
+
+TEST(TesseractCollisionUnit, GeometryCacheDisabledUnit)
+{
+  // The cache is disabled unless it is enabled explicitly
+  if (std::getenv("TESSERACT_GEOMETRY_CACHE_DIR") == nullptr)
+  {
+    EXPECT_TRUE(tesseract::getGeometryCacheDirectory().empty());
+  }
+
+  tesseract::setGeometryCacheDirectory("");
+  EXPECT_TRUE(tesseract::getGeometryCacheDirectory().empty());
+
+  tesseract::GeometryCacheKey key;
+  double data[2] = { 1, 2 };
+  key.add(data, sizeof(data));
+  EXPECT_TRUE(tesseract::getGeometryCacheFilePath("test", key).empty());
+  EXPECT_FALSE(tesseract::writeGeometryCacheFile("", key, 1, data, sizeof(data)));
+
+  std::size_t size;
+  EXPECT_TRUE(tesseract::mapGeometryCacheFile("", key, 1, size) == nullptr);
+  EXPECT_EQ(size, 0u);
+
+  // The cached functions still create the result
+  tesseract::VectorVector3d vertices, cached_vertices;
+  std::vector<int> faces, cached_faces;
+  int num_faces = tesseract::createConvexHull(vertices, faces, getCubeVertices());
+  EXPECT_EQ(tesseract::createCachedConvexHull(cached_vertices, cached_faces, getCubeVertices()), num_faces);
+  EXPECT_EQ(cached_vertices.size(), vertices.size());
+  EXPECT_EQ(cached_faces, faces);
+}
+
+TEST(TesseractCollisionUnit, GeometryCacheRoundTripUnit)
+{
+  std::string directory = createTemporaryDirectory();
+  ASSERT_FALSE(directory.empty());
+  tesseract::setGeometryCacheDirectory(directory);
+  std::string cache_directory = directory + "/v" + std::to_string(tesseract::GEOMETRY_CACHE_VERSION);
+  EXPECT_EQ(tesseract::getGeometryCacheDirectory(), cache_directory);
+
+  std::vector<double> input = { 1, 2, 3 };
+  tesseract::GeometryCacheKey key;
+  key.add(input.data(), input.size() * sizeof(double));
+  EXPECT_EQ(key.size, input.size() * sizeof(double));
+
+  std::string path = tesseract::getGeometryCacheFilePath("test", key);
+  EXPECT_EQ(path.find(cache_directory + "/test_"), 0u);
+
+  std::vector<double> payload = { 4, 5, 6, 7, 8 };
+  ASSERT_TRUE(tesseract::writeGeometryCacheFile(path, key, 1, payload.data(), payload.size() * sizeof(double)));
+
+  // The temporary file was renamed
+  EXPECT_EQ(listDirectory(cache_directory).size(), 1u);
+
+  std::size_t size;
+  std::shared_ptr<char> mapping = tesseract::mapGeometryCacheFile(path, key, 1, size);
+  ASSERT_TRUE(mapping != nullptr);
+  ASSERT_EQ(size, payload.size() * sizeof(double));
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(mapping.get()) % 16, 0u);
+  EXPECT_EQ(std::memcmp(mapping.get(), payload.data(), size), 0);
+
+  // A different format or different input data with the same hash is not used
+  EXPECT_TRUE(tesseract::mapGeometryCacheFile(path, key, 2, size) == nullptr);
+
+  tesseract::GeometryCacheKey other_key = key;
+  other_key.digest ^= 1;
+  EXPECT_TRUE(tesseract::mapGeometryCacheFile(path, other_key, 1, size) == nullptr);
+
+  other_key = key;
+  other_key.size += 1;
+  EXPECT_TRUE(tesseract::mapGeometryCacheFile(path, other_key, 1, size) == nullptr);
+
+  // Different input data has a different digest
+  std::vector<double> other_input = { 1, 2, 4 };
+  other_key = tesseract::GeometryCacheKey();
+  other_key.add(other_input.data(), other_input.size() * sizeof(double));
+  EXPECT_NE(other_key.hash, key.hash);
+  EXPECT_NE(other_key.digest, key.digest);
+
+  // A convex hull is read back from the cache
+  tesseract::VectorVector3d vertices, cached_vertices;
+  std::vector<int> faces, cached_faces;
+  int num_faces = tesseract::createCachedConvexHull(vertices, faces, getCubeVertices());
+  EXPECT_EQ(listDirectory(cache_directory).size(), 2u);
+  EXPECT_EQ(tesseract::createCachedConvexHull(cached_vertices, cached_faces, getCubeVertices()), num_faces);
+  ASSERT_EQ(cached_vertices.size(), vertices.size());
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+    EXPECT_TRUE(cached_vertices[i].isApprox(vertices[i]));
+  EXPECT_EQ(cached_faces, faces);
+
+  tesseract::setGeometryCacheDirectory("");
+  removeDirectory(directory);
+}
+
+TEST(TesseractCollisionUnit, GeometryCacheCorruptFileUnit)
+{
+  std::string directory = createTemporaryDirectory();
+  ASSERT_FALSE(directory.empty());
+  tesseract::setGeometryCacheDirectory(directory);
+  std::string cache_directory = tesseract::getGeometryCacheDirectory();
+
+  tesseract::GeometryCacheKey key;
+  std::vector<double> payload = { 4, 5, 6, 7, 8 };
+  key.add(payload.data(), payload.size() * sizeof(double));
+  std::string path = tesseract::getGeometryCacheFilePath("test", key);
+  ASSERT_TRUE(tesseract::writeGeometryCacheFile(path, key, 1, payload.data(), payload.size() * sizeof(double)));
+  std::size_t file_size = getFileSize(path);
+  EXPECT_EQ(file_size, sizeof(tesseract::GeometryCacheFileHeader) + payload.size() * sizeof(double));
+
+  // A truncated payload
+  std::size_t size;
+  ASSERT_EQ(truncate(path.c_str(), static_cast<off_t>(file_size - 1)), 0);
+  EXPECT_TRUE(tesseract::mapGeometryCacheFile(path, key, 1, size) == nullptr);
+
+  // A truncated header
+  ASSERT_EQ(truncate(path.c_str(), 4), 0);
+  EXPECT_TRUE(tesseract::mapGeometryCacheFile(path, key, 1, size) == nullptr);
+
+  // A file which is not a cache file
+  FILE* file = std::fopen(path.c_str(), "wb");
+  ASSERT_TRUE(file != nullptr);
+  std::vector<char> garbage(file_size, 'x');
+  std::fwrite(garbage.data(), 1, garbage.size(), file);
+  std::fclose(file);
+  EXPECT_TRUE(tesseract::mapGeometryCacheFile(path, key, 1, size) == nullptr);
+
+  // A corrupt convex hull file is replaced
+  tesseract::VectorVector3d vertices, cached_vertices;
+  std::vector<int> faces, cached_faces;
+  int num_faces = tesseract::createCachedConvexHull(vertices, faces, getCubeVertices());
+
+  std::string hull_path;
+  for (const auto& file_path : listDirectory(cache_directory))
+  {
+    if (file_path.find("/convex_hull_") != std::string::npos)
+      hull_path = file_path;
+  }
+  ASSERT_FALSE(hull_path.empty());
+  std::size_t hull_file_size = getFileSize(hull_path);
+  ASSERT_EQ(truncate(hull_path.c_str(), static_cast<off_t>(hull_file_size / 2)), 0);
+
+  EXPECT_EQ(tesseract::createCachedConvexHull(cached_vertices, cached_faces, getCubeVertices()), num_faces);
+  EXPECT_EQ(cached_vertices.size(), vertices.size());
+  EXPECT_EQ(cached_faces, faces);
+  EXPECT_EQ(getFileSize(hull_path), hull_file_size);
+
+  tesseract::setGeometryCacheDirectory("");
+  removeDirectory(directory);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -4,7 +4,11 @@
 #include <gtest/gtest.h>
 #include <ros/ros.h>
 
-void runTest(tesseract::DiscreteContactManagerBase& checker, bool use_convex_mesh = false)
+/** @brief Add a grid of spheres to the checker, each sphere is within the contact distance of its neighbors */
+void addSphereGrid(tesseract::DiscreteContactManagerBase& checker,
+                   std::vector<std::string>& link_names,
+                   tesseract::TransformMap& location,
+                   bool use_convex_mesh)
 {
   // Add Meshed Sphere to checker
   shapes::ShapePtr sphere;
@@ -16,8 +20,6 @@ void runTest(tesseract::DiscreteContactManagerBase& checker, bool use_convex_mes
   double delta = 0.55;
 
   std::size_t t = 10;
-  std::vector<std::string> link_names;
-  tesseract::TransformMap location;
   for (std::size_t x = 0; x < t; ++x)
   {
     for (std::size_t y = 0; y < t; ++y)
@@ -46,6 +48,13 @@ void runTest(tesseract::DiscreteContactManagerBase& checker, bool use_convex_mes
       }
     }
   }
+}
+
+void runTest(tesseract::DiscreteContactManagerBase& checker, bool use_convex_mesh = false)
+{
+  std::vector<std::string> link_names;
+  tesseract::TransformMap location;
+  addSphereGrid(checker, link_names, location, use_convex_mesh);
 
   // Check if they are in collision
   tesseract::ContactRequest req;
@@ -74,6 +83,77 @@ void runTest(tesseract::DiscreteContactManagerBase& checker, bool use_convex_mes
   //  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
 }
 
+/** @brief Check that the parallel narrowphase stores the same contacts for each pair as the serial narrowphase */
+void runParallelTest(tesseract::ContactRequestType type,
+                     std::size_t max_contacts_per_pair = 1,
+                     bool use_convex_mesh = false)
+{
+  tesseract::BulletDiscreteBVHManager serial_checker;
+  tesseract::BulletDiscreteBVHManager parallel_checker;
+  parallel_checker.setNarrowphaseThreads(4);
+
+  std::vector<std::string> link_names, parallel_link_names;
+  tesseract::TransformMap location, parallel_location;
+  addSphereGrid(serial_checker, link_names, location, use_convex_mesh);
+  addSphereGrid(parallel_checker, parallel_link_names, parallel_location, use_convex_mesh);
+
+  tesseract::ContactRequest req;
+  req.link_names = link_names;
+  req.contact_distance = 0.1;
+  req.type = type;
+  req.max_contacts_per_pair = max_contacts_per_pair;
+  serial_checker.setContactRequest(req);
+  serial_checker.setCollisionObjectsTransform(location);
+  parallel_checker.setContactRequest(req);
+  parallel_checker.setCollisionObjectsTransform(parallel_location);
+
+  tesseract::ContactResultMap serial_result, parallel_result;
+  serial_checker.contactTest(serial_result);
+
+  // The second query runs on the threads kept by the manager, with the narrowphase state cached by the first
+  parallel_checker.contactTest(parallel_result);
+  parallel_result.clear();
+  parallel_checker.contactTest(parallel_result);
+
+  if (type == tesseract::ContactRequestType::FIRST)
+  {
+    // The contact which ends the query is the first one found by any thread, it is only known to be a valid contact
+    ASSERT_EQ(serial_result.size(), 1u);
+    ASSERT_EQ(parallel_result.size(), 1u);
+    ASSERT_EQ(parallel_result.begin()->second.size(), 1u);
+
+    req.type = tesseract::ContactRequestType::ALL;
+    serial_checker.setContactRequest(req);
+    serial_result.clear();
+    serial_checker.contactTest(serial_result);
+
+    const auto& contact = parallel_result.begin()->second[0];
+    EXPECT_TRUE(serial_result.find(parallel_result.begin()->first) != serial_result.end());
+    EXPECT_LE(contact.distance, req.contact_distance);
+    return;
+  }
+
+  // Every pair is checked by a single thread, so the contacts of each pair match the serial results
+  ASSERT_EQ(parallel_result.size(), serial_result.size());
+  for (const auto& pair : serial_result)
+  {
+    auto it = parallel_result.find(pair.first);
+    ASSERT_TRUE(it != parallel_result.end());
+    ASSERT_EQ(it->second.size(), pair.second.size());
+    for (std::size_t i = 0; i < pair.second.size(); ++i)
+    {
+      const tesseract::ContactResult& expected = pair.second[i];
+      const tesseract::ContactResult& contact = it->second[i];
+      EXPECT_EQ(contact.link_names[0], expected.link_names[0]);
+      EXPECT_EQ(contact.link_names[1], expected.link_names[1]);
+      EXPECT_NEAR(contact.distance, expected.distance, 1e-9);
+      EXPECT_LT((contact.nearest_points[0] - expected.nearest_points[0]).norm(), 1e-9);
+      EXPECT_LT((contact.nearest_points[1] - expected.nearest_points[1]).norm(), 1e-9);
+      EXPECT_LT((contact.normal - expected.normal).norm(), 1e-9);
+    }
+  }
+}
+
 TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteSimpleCollisionLargeDataSetConvexHullUnit)
 {
   tesseract::BulletDiscreteSimpleManager checker;
@@ -98,6 +178,48 @@ TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteBVHCollisionLargeDataSetU
   runTest(checker);
 }
 
+TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteBVHCollisionLargeDataSetParallelConvexHullUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  checker.setNarrowphaseThreads(4);
+  runTest(checker, true);
+}
+
+TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteBVHCollisionLargeDataSetParallelUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  checker.setNarrowphaseThreads(4);
+  runTest(checker);
+
+  // The first contact found by any thread ends the query
+  EXPECT_FALSE(checker.isCollisionFree());
+}
+
+TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteBVHCollisionLargeDataSetParallelClosestUnit)
+{
+  runParallelTest(tesseract::ContactRequestType::CLOSEST);
+}
+
+TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteBVHCollisionLargeDataSetParallelAllUnit)
+{
+  runParallelTest(tesseract::ContactRequestType::ALL);
+}
+
+TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteBVHCollisionLargeDataSetParallelAllConvexHullUnit)
+{
+  runParallelTest(tesseract::ContactRequestType::ALL, 1, true);
+}
+
+TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteBVHCollisionLargeDataSetParallelLimitedUnit)
+{
+  runParallelTest(tesseract::ContactRequestType::LIMITED, 2, true);
+}
+
+TEST(TesseractCollisionLargeDataSetUnit, BulletDiscreteBVHCollisionLargeDataSetParallelFirstUnit)
+{
+  runParallelTest(tesseract::ContactRequestType::FIRST);
+}
+
 TEST(TesseractCollisionLargeDataSetUnit, FCLDiscreteBVHCollisionLargeDataSetConvexHullUnit)
 {
   tesseract::FCLDiscreteBVHManager checker;
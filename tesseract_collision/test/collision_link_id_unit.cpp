@@ -0,0 +1,199 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+template <typename T>
+class CollisionLinkIdUnit : public testing::Test
+{
+};
+
+typedef testing::Types<tesseract::BulletDiscreteSimpleManager,
+                       tesseract::BulletDiscreteBVHManager,
+                       tesseract::FCLDiscreteBVHManager>
+    DiscreteManagerTypes;
+TYPED_TEST_CASE(CollisionLinkIdUnit, DiscreteManagerTypes);
+
+void addSphere(tesseract::DiscreteContactManagerBase& checker, const std::string& name)
+{
+  std::vector<shapes::ShapeConstPtr> shapes = { shapes::ShapeConstPtr(new shapes::Sphere(0.25)) };
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+  checker.addCollisionObject(name, 0, shapes, poses, types);
+}
+
+/**
+ * @brief Add three spheres to a checker using a registry which already has a link without collision object
+ *
+ * The spheres are placed in a row along x, 0.5 apart. The CLOSEST request includes every sphere and the contact
+ * distance only reaches the neighbouring spheres.
+ */
+tesseract::NameRegistryPtr addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  tesseract::NameRegistryPtr registry(new tesseract::NameRegistry());
+  registry->intern("unmanaged_link");
+  checker.setLinkRegistry(registry);
+
+  addSphere(checker, "sphere_link");
+  addSphere(checker, "sphere1_link");
+  addSphere(checker, "sphere2_link");
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.link_names.push_back("sphere1_link");
+  req.link_names.push_back("sphere2_link");
+  req.contact_distance = 0.52;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere1_link"] = Eigen::Isometry3d::Identity();
+  location["sphere1_link"].translation()(0) = 1;
+  location["sphere2_link"] = Eigen::Isometry3d::Identity();
+  location["sphere2_link"].translation()(0) = -1;
+  checker.setCollisionObjectsTransform(location);
+
+  return registry;
+}
+
+/** @brief Check the only contact of a result is between two links and 0.5 apart */
+void checkSingleContact(const tesseract::ContactResultIdMap& result, int link_id1, int link_id2)
+{
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_TRUE(result.begin()->first == tesseract::getObjectPairKey(link_id1, link_id2));
+  ASSERT_EQ(result.begin()->second.size(), 1u);
+
+  const tesseract::ContactResult& contact = result.begin()->second.front();
+  EXPECT_NEAR(contact.distance, 0.5, 0.0001);
+  EXPECT_TRUE((contact.link_ids[0] == link_id1 && contact.link_ids[1] == link_id2) ||
+              (contact.link_ids[0] == link_id2 && contact.link_ids[1] == link_id1));
+}
+
+TYPED_TEST(CollisionLinkIdUnit, LinkIds)
+{
+  TypeParam checker;
+  tesseract::NameRegistryPtr registry = addCollisionObjects(checker);
+
+  ///////////////////////////////////////////////////////////////
+  // Test the ids are assigned by the registry set on the checker
+  ///////////////////////////////////////////////////////////////
+  EXPECT_TRUE(checker.getLinkRegistry() == registry);
+  EXPECT_TRUE(checker.clone()->getLinkRegistry() == registry);
+
+  int unmanaged_id = registry->find("unmanaged_link");
+  int sphere_id = registry->find("sphere_link");
+  int sphere1_id = registry->find("sphere1_link");
+  int sphere2_id = registry->find("sphere2_link");
+  EXPECT_EQ(unmanaged_id, 0);
+  ASSERT_GE(sphere_id, 0);
+  ASSERT_GE(sphere1_id, 0);
+  ASSERT_GE(sphere2_id, 0);
+  EXPECT_EQ(registry->size(), 4u);
+
+  // Both neighbours are within the contact distance
+  tesseract::ContactResultIdMap result;
+  checker.contactTest(result);
+  EXPECT_EQ(result.size(), 2u);
+  EXPECT_TRUE(result.find(tesseract::getObjectPairKey(sphere_id, sphere1_id)) != result.end());
+  EXPECT_TRUE(result.find(tesseract::getObjectPairKey(sphere_id, sphere2_id)) != result.end());
+
+  ///////////////////////////////////////////////////////////
+  // Test moving a single object by link id
+  ///////////////////////////////////////////////////////////
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation()(0) = 3;
+  checker.setCollisionObjectsTransform(sphere1_id, pose);
+
+  result.clear();
+  checker.contactTest(result);
+  checkSingleContact(result, sphere_id, sphere2_id);
+
+  ///////////////////////////////////////////////////////////
+  // Test moving several objects by link id
+  ///////////////////////////////////////////////////////////
+  std::vector<int> link_ids = { sphere1_id, sphere2_id };
+  tesseract::VectorIsometry3d poses(2, Eigen::Isometry3d::Identity());
+  poses[0].translation()(0) = 1;
+  poses[1].translation()(0) = -3;
+  checker.setCollisionObjectsTransform(link_ids, poses);
+
+  result.clear();
+  checker.contactTest(result);
+  checkSingleContact(result, sphere_id, sphere1_id);
+
+  ///////////////////////////////////////////////////////////////////////
+  // Test ids without collision object in this checker are ignored
+  ///////////////////////////////////////////////////////////////////////
+  pose = Eigen::Isometry3d::Identity();
+  checker.setCollisionObjectsTransform(-1, pose);
+  checker.setCollisionObjectsTransform(unmanaged_id, pose);
+  checker.setCollisionObjectsTransform(static_cast<int>(registry->size()), pose);
+
+  result.clear();
+  checker.contactTest(result);
+  checkSingleContact(result, sphere_id, sphere1_id);
+
+  // Moving by name is the same as moving by link id
+  pose.translation()(0) = -1;
+  checker.setCollisionObjectsTransform("sphere2_link", pose);
+  pose.translation()(0) = 3;
+  checker.setCollisionObjectsTransform(sphere1_id, pose);
+
+  result.clear();
+  checker.contactTest(result);
+  checkSingleContact(result, sphere_id, sphere2_id);
+}
+
+TYPED_TEST(CollisionLinkIdUnit, DenseTransforms)
+{
+  TypeParam checker;
+  tesseract::NameRegistryPtr registry = addCollisionObjects(checker);
+
+  int sphere_id = registry->find("sphere_link");
+  int sphere1_id = registry->find("sphere1_link");
+  int sphere2_id = registry->find("sphere2_link");
+  ASSERT_GT(sphere2_id, sphere1_id);
+  ASSERT_GT(sphere2_id, sphere_id);
+
+  //////////////////////////////////////////////////////////////////////
+  // Test objects whose link id is not covered by the vector are kept
+  //////////////////////////////////////////////////////////////////////
+  // The entry of the link without collision object is ignored
+  tesseract::VectorIsometry3d link_transforms(static_cast<std::size_t>(sphere2_id), Eigen::Isometry3d::Identity());
+  link_transforms[static_cast<std::size_t>(sphere1_id)].translation() = Eigen::Vector3d(3, 0, 0);
+  checker.setCollisionObjectsTransform(link_transforms);
+
+  // Only sphere2_link left at its pose is within the contact distance of sphere_link
+  tesseract::ContactResultIdMap result;
+  checker.contactTest(result);
+  checkSingleContact(result, sphere_id, sphere2_id);
+
+  ///////////////////////////////////////////////////////////
+  // Test every object covered by the vector is moved
+  ///////////////////////////////////////////////////////////
+  link_transforms.resize(registry->size(), Eigen::Isometry3d::Identity());
+  link_transforms[static_cast<std::size_t>(sphere1_id)].translation() = Eigen::Vector3d(1, 0, 0);
+  link_transforms[static_cast<std::size_t>(sphere2_id)].translation() = Eigen::Vector3d(0, 3, 0);
+  checker.setCollisionObjectsTransform(link_transforms);
+
+  result.clear();
+  checker.contactTest(result);
+  checkSingleContact(result, sphere_id, sphere1_id);
+
+  // Entries beyond the ids of the registry are ignored
+  link_transforms.resize(registry->size() + 4, Eigen::Isometry3d::Identity());
+  link_transforms[static_cast<std::size_t>(sphere_id)].translation() = Eigen::Vector3d(0, 2, 0);
+  checker.setCollisionObjectsTransform(link_transforms);
+
+  result.clear();
+  checker.contactTest(result);
+  checkSingleContact(result, sphere_id, sphere2_id);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,156 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/sphere_decomposition.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  ///////////////////////////////////////////////////////////
+  // Add sphere mesh to checker represented by a sphere tree
+  ///////////////////////////////////////////////////////////
+  shapes::ShapePtr sphere_mesh(shapes::createMeshFromResource("package://tesseract_collision/test/sphere_p25m.stl"));
+  Eigen::Isometry3d sphere_mesh_pose;
+  sphere_mesh_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj1_shapes;
+  tesseract::VectorIsometry3d obj1_poses;
+  tesseract::CollisionObjectTypeVector obj1_types;
+  obj1_shapes.push_back(sphere_mesh);
+  obj1_poses.push_back(sphere_mesh_pose);
+  obj1_types.push_back(tesseract::CollisionObjectType::MultiSphere);
+
+  checker.addCollisionObject("multi_sphere_link", 0, obj1_shapes, obj1_poses, obj1_types);
+
+  /////////////////////////////
+  // Add sphere to checker
+  /////////////////////////////
+  shapes::ShapePtr sphere(new shapes::Sphere(0.25));
+  Eigen::Isometry3d sphere_pose;
+  sphere_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj2_shapes;
+  tesseract::VectorIsometry3d obj2_poses;
+  tesseract::CollisionObjectTypeVector obj2_types;
+  obj2_shapes.push_back(sphere);
+  obj2_poses.push_back(sphere_pose);
+  obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("sphere_link", 0, obj2_shapes, obj2_poses, obj2_types);
+}
+
+void runTest(tesseract::DiscreteContactManagerBase& checker)
+{
+  // The spheres may extend up to max_error beyond the mesh which is inscribed in the sphere
+  const double tolerance = 0.02;
+
+  //////////////////////////////////////
+  // Test when object is in collision
+  //////////////////////////////////////
+  tesseract::ContactRequest req;
+  req.link_names.push_back("multi_sphere_link");
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  // Set the collision object transforms
+  tesseract::TransformMap location;
+  location["multi_sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"].translation()(0) = 0.2;
+  checker.setCollisionObjectsTransform(location);
+
+  // Perform collision check
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+
+  tesseract::ContactResultVector result_vector;
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  ASSERT_TRUE(!result_vector.empty());
+  EXPECT_NEAR(result_vector[0].distance, -0.3, tolerance);
+
+  ////////////////////////////////////////////////
+  // Test object is out side the contact distance
+  ////////////////////////////////////////////////
+  location["sphere_link"].translation() = Eigen::Vector3d(1, 0, 0);
+  result.clear();
+  result_vector.clear();
+  checker.setCollisionObjectsTransform(location);
+
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  EXPECT_TRUE(result_vector.empty());
+
+  /////////////////////////////////////////////
+  // Test object inside the contact distance
+  /////////////////////////////////////////////
+  result.clear();
+  result_vector.clear();
+  req.contact_distance = 0.55;
+  checker.setContactRequest(req);
+
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  ASSERT_TRUE(!result_vector.empty());
+  EXPECT_NEAR(result_vector[0].distance, 0.5, tolerance);
+
+  int idx = result_vector[0].link_names[0] == "multi_sphere_link" ? 1 : -1;
+  EXPECT_NEAR(result_vector[0].normal[0], idx * 1.0, 0.001);
+  EXPECT_NEAR(result_vector[0].normal[1], idx * 0.0, 0.001);
+  EXPECT_NEAR(result_vector[0].normal[2], idx * 0.0, 0.001);
+}
+
+TEST(TesseractCollisionUnit, SphereDecompositionUnit)
+{
+  shapes::ShapePtr sphere_mesh(shapes::createMeshFromResource("package://tesseract_collision/test/sphere_p25m.stl"));
+  const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(*sphere_mesh);
+
+  tesseract::VectorVector3d vertices;
+  for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+    vertices.push_back(Eigen::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]));
+
+  std::vector<int> triangles(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+
+  tesseract::VectorVector3d centers;
+  std::vector<double> radii;
+  int num_spheres = tesseract::createSphereDecomposition(centers, radii, vertices, triangles, 0.01, 100);
+  ASSERT_GT(num_spheres, 0);
+  EXPECT_LE(num_spheres, 100);
+
+  // Every vertex is covered and no sphere extends further than the error beyond the sphere
+  for (const auto& v : vertices)
+  {
+    bool covered = false;
+    for (std::size_t i = 0; i < centers.size(); ++i)
+      covered = covered || (v - centers[i]).norm() <= radii[i];
+
+    EXPECT_TRUE(covered);
+  }
+
+  for (std::size_t i = 0; i < centers.size(); ++i)
+    EXPECT_LE(centers[i].norm() + radii[i], 0.25 + 0.01 + 1e-6);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionMultiSphereSphereUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionMultiSphereSphereUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -5,11 +5,8 @@
 #include <gtest/gtest.h>
 #include <ros/ros.h>
 
-void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker, bool use_convex_mesh = false)
+void addOctomap(tesseract::DiscreteContactManagerBase& checker)
 {
-  /////////////////////////////////////////////////////////////////
-  // Add Octomap
-  /////////////////////////////////////////////////////////////////
   std::string path = ros::package::getPath("tesseract_collision") + "/test/blender_monkey.bt";
   std::shared_ptr<octomap::OcTree> ot(new octomap::OcTree(path));
   shapes::ShapePtr dense_octomap(new shapes::OcTree(ot));
@@ -24,11 +21,10 @@ void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker, bool us
   obj1_types.push_back(tesseract::CollisionObjectType::UseShapeType);
 
   checker.addCollisionObject("octomap_link", 0, obj1_shapes, obj1_poses, obj1_types);
+}
 
-  /////////////////////////////////////////////////////////////////
-  // Add sphere to checker. If use_convex_mesh = true then this
-  // sphere will be added as a convex hull mesh.
-  /////////////////////////////////////////////////////////////////
+void addSphere(tesseract::DiscreteContactManagerBase& checker, bool use_convex_mesh)
+{
   shapes::ShapePtr sphere;
   if (use_convex_mesh)
     sphere.reset(shapes::createMeshFromResource("package://tesseract_collision/test/sphere_p25m.stl"));
@@ -52,6 +48,27 @@ void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker, bool us
   checker.addCollisionObject("sphere_link", 0, obj2_shapes, obj2_poses, obj2_types);
 }
 
+void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker,
+                         bool use_convex_mesh = false,
+                         bool add_octomap_last = false)
+{
+  /////////////////////////////////////////////////////////////////
+  // Add Octomap and sphere to checker. If use_convex_mesh = true
+  // then the sphere will be added as a convex hull mesh. The order
+  // changes which object comes first in the narrowphase.
+  /////////////////////////////////////////////////////////////////
+  if (add_octomap_last)
+  {
+    addSphere(checker, use_convex_mesh);
+    addOctomap(checker);
+  }
+  else
+  {
+    addOctomap(checker);
+    addSphere(checker, use_convex_mesh);
+  }
+}
+
 void runTest(tesseract::DiscreteContactManagerBase& checker)
 {
   //////////////////////////////////////
@@ -85,8 +102,13 @@ void runTest(tesseract::DiscreteContactManagerBase& checker)
   tesseract::ContactResultVector result_vector;
   tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
 
-  EXPECT_TRUE(!result_vector.empty());
+  ASSERT_TRUE(!result_vector.empty());
   EXPECT_NEAR(result_vector[0].distance, -0.25, 0.001);
+
+  // The contact is between the two objects whichever order they were added in
+  const auto& names = result_vector[0].link_names;
+  EXPECT_TRUE((names[0] == "octomap_link" && names[1] == "sphere_link") ||
+              (names[0] == "sphere_link" && names[1] == "octomap_link"));
 }
 
 TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionOctomapSphereUnit)
@@ -103,6 +125,13 @@ TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionOctomapSphereUnit)
 //  runTest(checker);
 //}
 
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionSphereOctomapUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  addCollisionObjects(checker, false, true);
+  runTest(checker);
+}
+
 TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionOctomapSphereUnit)
 {
   tesseract::BulletDiscreteBVHManager checker;
@@ -110,6 +139,13 @@ TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionOctomapSphereUnit)
   runTest(checker);
 }
 
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionSphereOctomapUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  addCollisionObjects(checker, false, true);
+  runTest(checker);
+}
+
 //TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionBoxSphereConvexHullUnit)
 //{
 //  tesseract::BulletDiscreteBVHManager checker;
@@ -0,0 +1,252 @@
+#include "tesseract_collision/bullet/bullet_cast_managers.h"
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_cast_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <octomap/octomap.h>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+template <class T>
+std::shared_ptr<const octomap::OcTree> addCollisionObjects(T& checker)
+{
+  /////////////////////////////////////////////////////////////////
+  // Add Octomap with a single occupied voxel at the origin
+  /////////////////////////////////////////////////////////////////
+  std::shared_ptr<octomap::OcTree> ot(new octomap::OcTree(0.1));
+  ot->updateNode(octomap::point3d(0, 0, 0), true);
+  shapes::ShapePtr octomap(new shapes::OcTree(ot));
+  Eigen::Isometry3d octomap_pose;
+  octomap_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj1_shapes;
+  tesseract::VectorIsometry3d obj1_poses;
+  tesseract::CollisionObjectTypeVector obj1_types;
+  obj1_shapes.push_back(octomap);
+  obj1_poses.push_back(octomap_pose);
+  obj1_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("octomap_link", 0, obj1_shapes, obj1_poses, obj1_types);
+
+  /////////////////////////////
+  // Add sphere to checker
+  /////////////////////////////
+  shapes::ShapePtr sphere(new shapes::Sphere(0.25));
+  Eigen::Isometry3d sphere_pose;
+  sphere_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj2_shapes;
+  tesseract::VectorIsometry3d obj2_poses;
+  tesseract::CollisionObjectTypeVector obj2_types;
+  obj2_shapes.push_back(sphere);
+  obj2_poses.push_back(sphere_pose);
+  obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("sphere_link", 0, obj2_shapes, obj2_poses, obj2_types);
+
+  return ot;
+}
+
+void runTest(tesseract::DiscreteContactManagerBase& checker, const octomap::OcTree& ot)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("octomap_link");
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  // Set the collision object transforms
+  tesseract::TransformMap location;
+  location["octomap_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"].translation() = Eigen::Vector3d(2, 0, 0);
+  checker.setCollisionObjectsTransform(location);
+
+  //////////////////////////////////////
+  // Test object is far from the map
+  //////////////////////////////////////
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+
+  tesseract::ContactResultVector result_vector;
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  EXPECT_TRUE(result_vector.empty());
+
+  //////////////////////////////////////
+  // Insert a voxel at the sphere
+  //////////////////////////////////////
+  tesseract::VectorVector3d voxels;
+  voxels.push_back(Eigen::Vector3d(2.05, 0.05, 0.05));
+  EXPECT_TRUE(checker.updateCollisionObjectOcTree("octomap_link", voxels, tesseract::VectorVector3d()));
+  EXPECT_FALSE(checker.updateCollisionObjectOcTree("sphere_link", voxels, tesseract::VectorVector3d()));
+
+  // The manager uses an updated copy of the octomap
+  EXPECT_EQ(ot.search(2.05, 0.05, 0.05), nullptr);
+
+  result.clear();
+  result_vector.clear();
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  ASSERT_TRUE(!result_vector.empty());
+  EXPECT_LT(result_vector[0].distance, 0);
+
+  //////////////////////////////////////
+  // Clear the voxel again
+  //////////////////////////////////////
+  EXPECT_TRUE(checker.updateCollisionObjectOcTree("octomap_link", tesseract::VectorVector3d(), voxels));
+
+  result.clear();
+  result_vector.clear();
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  EXPECT_TRUE(result_vector.empty());
+}
+
+void runCloneTest(tesseract::DiscreteContactManagerBase& checker, const octomap::OcTree& ot)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("octomap_link");
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["octomap_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"].translation() = Eigen::Vector3d(2, 0, 0);
+  checker.setCollisionObjectsTransform(location);
+
+  tesseract::DiscreteContactManagerBasePtr clone = checker.clone();
+  EXPECT_TRUE(checker.isCollisionFree());
+  EXPECT_TRUE(clone->isCollisionFree());
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Insert a voxel at the sphere, a clone keeps the octomap until it is updated
+  //////////////////////////////////////////////////////////////////////////////
+  tesseract::VectorVector3d voxels;
+  voxels.push_back(Eigen::Vector3d(2.05, 0.05, 0.05));
+
+  EXPECT_TRUE(checker.updateCollisionObjectOcTree("octomap_link", voxels, tesseract::VectorVector3d()));
+  EXPECT_FALSE(checker.isCollisionFree());
+  EXPECT_TRUE(clone->isCollisionFree());
+
+  EXPECT_TRUE(clone->updateCollisionObjectOcTree("octomap_link", voxels, tesseract::VectorVector3d()));
+  EXPECT_FALSE(clone->isCollisionFree());
+  EXPECT_EQ(ot.search(2.05, 0.05, 0.05), nullptr);
+
+  //////////////////////////////////////
+  // Clear the voxel again
+  //////////////////////////////////////
+  EXPECT_TRUE(clone->updateCollisionObjectOcTree("octomap_link", tesseract::VectorVector3d(), voxels));
+  EXPECT_TRUE(clone->isCollisionFree());
+  EXPECT_FALSE(checker.isCollisionFree());
+
+  EXPECT_TRUE(checker.updateCollisionObjectOcTree("octomap_link", tesseract::VectorVector3d(), voxels));
+  EXPECT_TRUE(checker.isCollisionFree());
+}
+
+void runCastTest(tesseract::ContinuousContactManagerBase& checker, const octomap::OcTree& ot)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  // The sphere passes by the map
+  checker.setCollisionObjectsTransform("octomap_link", Eigen::Isometry3d::Identity());
+  checker.setCollisionObjectsTransform("sphere_link",
+                                       Eigen::Isometry3d(Eigen::Translation3d(2, -1, 0)),
+                                       Eigen::Isometry3d(Eigen::Translation3d(2, 1, 0)));
+  EXPECT_TRUE(checker.isCollisionFree());
+
+  //////////////////////////////////////
+  // Insert a voxel on the path
+  //////////////////////////////////////
+  tesseract::VectorVector3d voxels;
+  voxels.push_back(Eigen::Vector3d(2.05, 0.05, 0.05));
+  tesseract::ContinuousContactManagerBasePtr clone = checker.clone();
+  EXPECT_TRUE(checker.updateCollisionObjectOcTree("octomap_link", voxels, tesseract::VectorVector3d()));
+  EXPECT_FALSE(checker.isCollisionFree());
+  EXPECT_TRUE(clone->isCollisionFree());
+  EXPECT_EQ(ot.search(2.05, 0.05, 0.05), nullptr);
+
+  //////////////////////////////////////
+  // Clear the voxel again
+  //////////////////////////////////////
+  EXPECT_TRUE(checker.updateCollisionObjectOcTree("octomap_link", tesseract::VectorVector3d(), voxels));
+  EXPECT_TRUE(checker.isCollisionFree());
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionOctomapUpdateUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runTest(checker, *ot);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionOctomapUpdateUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runTest(checker, *ot);
+}
+
+TEST(TesseractCollisionUnit, FCLDiscreteBVHCollisionOctomapUpdateUnit)
+{
+  tesseract::FCLDiscreteBVHManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runTest(checker, *ot);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionOctomapUpdateCloneUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runCloneTest(checker, *ot);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionOctomapUpdateCloneUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runCloneTest(checker, *ot);
+}
+
+TEST(TesseractCollisionUnit, FCLDiscreteBVHCollisionOctomapUpdateCloneUnit)
+{
+  tesseract::FCLDiscreteBVHManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runCloneTest(checker, *ot);
+}
+
+TEST(TesseractCollisionUnit, BulletCastSimpleCollisionOctomapUpdateUnit)
+{
+  tesseract::BulletCastSimpleManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runCastTest(checker, *ot);
+}
+
+TEST(TesseractCollisionUnit, BulletCastBVHCollisionOctomapUpdateUnit)
+{
+  tesseract::BulletCastBVHManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runCastTest(checker, *ot);
+}
+
+TEST(TesseractCollisionUnit, FCLCastBVHCollisionOctomapUpdateUnit)
+{
+  tesseract::FCLCastBVHManager checker;
+  std::shared_ptr<const octomap::OcTree> ot = addCollisionObjects(checker);
+  runCastTest(checker, *ot);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,198 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/bullet/bullet_utils.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+/** @brief Records the smallest distance reported by the narrowphase */
+struct ClosestDistanceResult : public btManifoldResult
+{
+  double distance;
+
+  ClosestDistanceResult(const btCollisionObjectWrapper* obj0Wrap, const btCollisionObjectWrapper* obj1Wrap)
+    : btManifoldResult(obj0Wrap, obj1Wrap), distance(std::numeric_limits<double>::max())
+  {
+    m_closestPointDistanceThreshold = 1;
+  }
+
+  void addContactPoint(const btVector3& /*normalOnBInWorld*/,
+                       const btVector3& /*pointInWorld*/,
+                       btScalar depth) override
+  {
+    distance = std::min(distance, static_cast<double>(depth));
+  }
+};
+
+tesseract::COWPtr createObject(const std::string& name, const shapes::ShapeConstPtr& shape, double x)
+{
+  std::vector<shapes::ShapeConstPtr> shapes = { shape };
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+
+  tesseract::COWPtr cow(new tesseract::COW(name, 0, shapes, poses, types));
+  cow->setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(static_cast<btScalar>(x), 0, 0)));
+  return cow;
+}
+
+double checkPair(tesseract::NarrowphaseWorker& worker, const tesseract::COW& cow1, const tesseract::COW& cow2)
+{
+  btCollisionObjectWrapper obj0Wrap(0, cow1.getCollisionShape(), &cow1, cow1.getWorldTransform(), -1, -1);
+  btCollisionObjectWrapper obj1Wrap(0, cow2.getCollisionShape(), &cow2, cow2.getWorldTransform(), -1, -1);
+
+  ClosestDistanceResult result(&obj0Wrap, &obj1Wrap);
+  btDispatcherInfo dispatch_info;
+  worker.pair_cache->processCollision(&obj0Wrap, &obj1Wrap, dispatch_info, &result);
+  return result.distance;
+}
+
+TEST(TesseractCollisionUnit, PairCacheWarmStartUnit)
+{
+  tesseract::COWPtr box1 = createObject("box1", shapes::ShapeConstPtr(new shapes::Box(1, 1, 1)), 0);
+  tesseract::COWPtr box2 = createObject("box2", shapes::ShapeConstPtr(new shapes::Box(1, 1, 1)), 1.5);
+
+  // The entry of the pair is reused by the following queries and gives the same distances as a new entry
+  tesseract::NarrowphaseWorker worker;
+  for (double x : { 1.5, 1.45, 1.2, 1.0, 0.9, 1.3 })
+  {
+    box2->setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(static_cast<btScalar>(x), 0, 0)));
+
+    tesseract::NarrowphaseWorker cold_worker;
+    double distance = checkPair(worker, *box1, *box2);
+    EXPECT_NEAR(distance, x - 1, 1e-4);
+    EXPECT_NEAR(distance, checkPair(cold_worker, *box1, *box2), 1e-4);
+
+    worker.pair_cache->evict();
+    EXPECT_EQ(worker.pair_cache->size(), 1u);
+  }
+
+  // Pairs which do not use GJK directly keep their collision algorithm
+  tesseract::COWPtr sphere1 = createObject("sphere1", shapes::ShapeConstPtr(new shapes::Sphere(0.25)), 0);
+  tesseract::COWPtr sphere2 = createObject("sphere2", shapes::ShapeConstPtr(new shapes::Sphere(0.25)), 0.75);
+  EXPECT_NEAR(checkPair(worker, *sphere1, *sphere2), 0.25, 1e-6);
+  EXPECT_NEAR(checkPair(worker, *sphere1, *sphere2), 0.25, 1e-6);
+  EXPECT_EQ(worker.pair_cache->size(), 2u);
+}
+
+TEST(TesseractCollisionUnit, PairCacheEvictUnit)
+{
+  shapes::ShapeConstPtr box(new shapes::Box(1, 1, 1));
+  tesseract::COWPtr box1 = createObject("box1", box, 0);
+  tesseract::COWPtr box2 = createObject("box2", box, 1.5);
+  tesseract::COWPtr box3 = createObject("box3", box, -1.5);
+
+  tesseract::NarrowphaseWorker worker;
+  checkPair(worker, *box1, *box2);
+  checkPair(worker, *box1, *box3);
+  worker.pair_cache->evict();
+  EXPECT_EQ(worker.pair_cache->size(), 2u);
+
+  // Only the pairs processed since the previous call are kept
+  checkPair(worker, *box1, *box2);
+  worker.pair_cache->evict();
+  EXPECT_EQ(worker.pair_cache->size(), 1u);
+
+  worker.pair_cache->evict();
+  EXPECT_EQ(worker.pair_cache->size(), 0u);
+}
+
+TEST(TesseractCollisionUnit, PairCacheInvalidationUnit)
+{
+  shapes::ShapeConstPtr box(new shapes::Box(1, 1, 1));
+  tesseract::COWPtr box1 = createObject("box1", box, 0);
+  tesseract::COWPtr box2 = createObject("box2", box, 1.5);
+  tesseract::COWPtr box3 = createObject("box3", box, -1.5);
+
+  tesseract::NarrowphaseWorker worker;
+  checkPair(worker, *box1, *box2);
+  checkPair(worker, *box1, *box3);
+  checkPair(worker, *box2, *box3);
+  EXPECT_EQ(worker.pair_cache->size(), 3u);
+
+  // All pairs of a removed object are released
+  worker.pair_cache->remove(box3.get());
+  EXPECT_EQ(worker.pair_cache->size(), 1u);
+
+  worker.pair_cache->clear();
+  EXPECT_EQ(worker.pair_cache->size(), 0u);
+}
+
+void runReplaceObjectTest(tesseract::DiscreteContactManagerBase& checker)
+{
+  std::vector<shapes::ShapeConstPtr> box_shapes = { shapes::ShapeConstPtr(new shapes::Box(1, 1, 1)) };
+  std::vector<shapes::ShapeConstPtr> sphere_shapes = { shapes::ShapeConstPtr(new shapes::Sphere(0.25)) };
+  std::vector<shapes::ShapeConstPtr> small_box_shapes = { shapes::ShapeConstPtr(new shapes::Box(0.2, 0.2, 0.2)) };
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+
+  checker.addCollisionObject("box_link", 0, box_shapes, poses, types);
+  checker.addCollisionObject("other_link", 0, sphere_shapes, poses, types);
+
+  tesseract::ContactRequest req;
+  req.link_names = { "box_link", "other_link" };
+  req.contact_distance = 0.5;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["box_link"] = Eigen::Isometry3d::Identity();
+  location["other_link"] = Eigen::Isometry3d::Identity();
+  location["other_link"].translation()(0) = 1;
+  checker.setCollisionObjectsTransform(location);
+
+  tesseract::ContactResultVector result_vector;
+  for (int i = 0; i < 2; ++i)
+  {
+    tesseract::ContactResultMap result;
+    result_vector.clear();
+    checker.contactTest(result);
+    tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+    ASSERT_EQ(result_vector.size(), 1u);
+    EXPECT_NEAR(result_vector[0].distance, 0.25, 1e-4);
+  }
+
+  // The state of the pair is not reused for the object replacing the sphere
+  checker.addCollisionObject("other_link", 0, small_box_shapes, poses, types);
+  checker.setContactRequest(req);
+  checker.setCollisionObjectsTransform(location);
+
+  tesseract::ContactResultMap result;
+  result_vector.clear();
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, 0.4, 1e-4);
+
+  // The pair is checked again after it stopped overlapping in the broadphase
+  location["other_link"].translation()(0) = 3;
+  checker.setCollisionObjectsTransform(location);
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_TRUE(result.empty());
+
+  location["other_link"].translation()(0) = 0.8;
+  checker.setCollisionObjectsTransform(location);
+  result.clear();
+  result_vector.clear();
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, 0.2, 1e-4);
+}
+
+TEST(TesseractCollisionUnit, PairCacheReplaceObjectSimpleUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  runReplaceObjectTest(checker);
+}
+
+TEST(TesseractCollisionUnit, PairCacheReplaceObjectBVHUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  runReplaceObjectTest(checker);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
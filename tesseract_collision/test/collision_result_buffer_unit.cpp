@@ -0,0 +1,148 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+template <typename T>
+class CollisionResultBufferUnit : public testing::Test
+{
+};
+
+typedef testing::Types<tesseract::BulletDiscreteSimpleManager,
+                       tesseract::BulletDiscreteBVHManager,
+                       tesseract::FCLDiscreteBVHManager>
+    DiscreteManagerTypes;
+TYPED_TEST_CASE(CollisionResultBufferUnit, DiscreteManagerTypes);
+
+/**
+ * @brief Add a link of three spheres inside a box and a single sphere above the box
+ *
+ * The multi sphere link has a contact with the box for each of its spheres, the single sphere is 0.05 from the box.
+ */
+void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+
+  std::vector<shapes::ShapeConstPtr> multi_shapes;
+  tesseract::VectorIsometry3d multi_poses;
+  tesseract::CollisionObjectTypeVector multi_types;
+  for (int i = -1; i <= 1; ++i)
+  {
+    Eigen::Isometry3d sphere_pose = Eigen::Isometry3d::Identity();
+    sphere_pose.translation()(0) = 0.5 * i;
+
+    multi_shapes.push_back(shapes::ShapePtr(new shapes::Sphere(0.1)));
+    multi_poses.push_back(sphere_pose);
+    multi_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+  }
+  checker.addCollisionObject("multi_link", 0, multi_shapes, multi_poses, multi_types);
+
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  std::vector<shapes::ShapeConstPtr> box_shapes = { shapes::ShapeConstPtr(new shapes::Box(1.4, 0.2, 0.6)) };
+  checker.addCollisionObject("box_link", 0, box_shapes, poses, types);
+
+  std::vector<shapes::ShapeConstPtr> sphere_shapes = { shapes::ShapeConstPtr(new shapes::Sphere(0.1)) };
+  checker.addCollisionObject("sphere_link", 0, sphere_shapes, poses, types);
+
+  tesseract::TransformMap location;
+  location["multi_link"] = Eigen::Isometry3d::Identity();
+  location["box_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"].translation()(2) = 0.45;
+  checker.setCollisionObjectsTransform(location);
+}
+
+/** @brief Count the records chained from the first record of a pair, each must belong to that pair */
+std::size_t countPairRecords(const tesseract::ContactResultBuffer& buffer, int link_id1, int link_id2)
+{
+  std::size_t count = 0;
+  for (const tesseract::ContactRecord* record = buffer.find(link_id1, link_id2); record != nullptr;
+       record = (record->next < 0) ? nullptr : &buffer[static_cast<std::size_t>(record->next)])
+  {
+    EXPECT_TRUE((record->link_ids[0] == link_id1 && record->link_ids[1] == link_id2) ||
+                (record->link_ids[0] == link_id2 && record->link_ids[1] == link_id1));
+    ++count;
+  }
+
+  return count;
+}
+
+TYPED_TEST(CollisionResultBufferUnit, ResultBuffer)
+{
+  TypeParam checker;
+  addCollisionObjects(checker);
+
+  tesseract::NameRegistryConstPtr registry = checker.getLinkRegistry();
+  int multi_id = registry->find("multi_link");
+  int box_id = registry->find("box_link");
+  int sphere_id = registry->find("sphere_link");
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("multi_link");
+  req.link_names.push_back("box_link");
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::ALL;
+  checker.setContactRequest(req);
+
+  ///////////////////////////////////////////////////////////////
+  // Test every contact is stored and chained to its pair
+  ///////////////////////////////////////////////////////////////
+  tesseract::ContactResultBuffer buffer;
+  checker.contactTest(buffer);
+
+  ASSERT_EQ(buffer.size(), 4u);
+  ASSERT_EQ(buffer.getPairCount(), 2u);
+  EXPECT_EQ(buffer.getPairContactCount(multi_id, box_id), 3u);
+  EXPECT_EQ(buffer.getPairContactCount(box_id, sphere_id), 1u);
+  EXPECT_EQ(buffer.getPairContactCount(multi_id, sphere_id), 0u);
+  EXPECT_EQ(countPairRecords(buffer, box_id, multi_id), 3u);
+  EXPECT_EQ(countPairRecords(buffer, sphere_id, box_id), 1u);
+  EXPECT_TRUE(buffer.find(multi_id, sphere_id) == nullptr);
+  EXPECT_NEAR(buffer.find(box_id, sphere_id)->distance, 0.05, 0.0001);
+
+  // The buffer holds the same contacts as a result map
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+  std::size_t num_contacts = 0;
+  for (const auto& pair : result)
+    num_contacts += pair.second.size();
+  EXPECT_EQ(num_contacts, buffer.size());
+
+  double closest = std::numeric_limits<double>::max();
+  for (const tesseract::ContactRecord& record : buffer)
+  {
+    if (record.link_ids[0] == multi_id || record.link_ids[1] == multi_id)
+      closest = std::min(closest, record.distance);
+  }
+
+  ///////////////////////////////////////////////////////////////
+  // Test a cleared buffer is reused without keeping old records
+  ///////////////////////////////////////////////////////////////
+  buffer.clear();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.getPairCount(), 0u);
+  EXPECT_TRUE(buffer.find(multi_id, box_id) == nullptr);
+
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+  checker.contactTest(buffer);
+
+  // Only the closest contact of each pair is kept
+  ASSERT_EQ(buffer.size(), 2u);
+  ASSERT_EQ(buffer.getPairCount(), 2u);
+  EXPECT_EQ(buffer.getPairContactCount(multi_id, box_id), 1u);
+  EXPECT_NEAR(buffer.find(multi_id, box_id)->distance, closest, 0.0001);
+  EXPECT_EQ(buffer.find(multi_id, box_id)->next, -1);
+
+  buffer.clear();
+  checker.contactTest(buffer);
+  EXPECT_EQ(buffer.size(), 2u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
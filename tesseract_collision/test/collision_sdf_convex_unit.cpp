@@ -0,0 +1,198 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <geometric_shapes/mesh_operations.h>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker, bool use_convex_mesh = false)
+{
+  ////////////////////////////////////////////////////////////
+  // Add box mesh to checker represented by a distance field
+  ////////////////////////////////////////////////////////////
+  shapes::ShapePtr box(shapes::createMeshFromShape(shapes::Box(1, 1, 1)));
+  Eigen::Isometry3d box_pose;
+  box_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj1_shapes;
+  tesseract::VectorIsometry3d obj1_poses;
+  tesseract::CollisionObjectTypeVector obj1_types;
+  obj1_shapes.push_back(box);
+  obj1_poses.push_back(box_pose);
+  obj1_types.push_back(tesseract::CollisionObjectType::SDF);
+
+  checker.addCollisionObject("sdf_link", 0, obj1_shapes, obj1_poses, obj1_types);
+
+  //////////////////////////////////////////////////////////////////
+  // Add plate to checker whose corners are further away than its
+  // faces. If use_convex_mesh = true it is added as a convex hull.
+  //////////////////////////////////////////////////////////////////
+  shapes::ShapePtr plate;
+  if (use_convex_mesh)
+    plate.reset(shapes::createMeshFromShape(shapes::Box(0.1, 1.2, 1.2)));
+  else
+    plate.reset(new shapes::Box(0.1, 1.2, 1.2));
+
+  Eigen::Isometry3d plate_pose;
+  plate_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj2_shapes;
+  tesseract::VectorIsometry3d obj2_poses;
+  tesseract::CollisionObjectTypeVector obj2_types;
+  obj2_shapes.push_back(plate);
+  obj2_poses.push_back(plate_pose);
+
+  if (use_convex_mesh)
+    obj2_types.push_back(tesseract::CollisionObjectType::ConvexHull);
+  else
+    obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("plate_link", 0, obj2_shapes, obj2_poses, obj2_types);
+}
+
+void runTest(tesseract::DiscreteContactManagerBase& checker)
+{
+  // The samples cover the faces at the resolution of the field and never overestimate the distance
+  const double tolerance = 2 * tesseract::SDF_DEFAULT_RESOLUTION;
+
+  ////////////////////////////////////////////////////////////////////
+  // Test the face of the plate is found although its corners are
+  // further away than the contact distance
+  ////////////////////////////////////////////////////////////////////
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sdf_link");
+  req.link_names.push_back("plate_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["sdf_link"] = Eigen::Isometry3d::Identity();
+  location["plate_link"] = Eigen::Isometry3d::Identity();
+  location["plate_link"].translation()(0) = 0.6;
+  checker.setCollisionObjectsTransform(location);
+
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+
+  tesseract::ContactResultVector result_vector;
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, 0.05, tolerance);
+  EXPECT_LE(result_vector[0].distance, 0.05 + 0.001);
+
+  int idx = result_vector[0].link_names[0] == "sdf_link" ? 1 : -1;
+  EXPECT_NEAR(result_vector[0].normal[0], idx * 1.0, 0.01);
+
+  //////////////////////////////////////
+  // Test when object is in collision
+  //////////////////////////////////////
+  location["plate_link"].translation()(0) = 0.5;
+  result.clear();
+  result_vector.clear();
+  checker.setCollisionObjectsTransform(location);
+
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, -0.05, tolerance);
+  EXPECT_LE(result_vector[0].distance, -0.05 + 0.001);
+
+  ///////////////////////////////////////////////////////////////
+  // Test the plate rotated so only an edge is close to the box
+  ///////////////////////////////////////////////////////////////
+  location["plate_link"] = Eigen::Isometry3d::Identity();
+  location["plate_link"].rotate(Eigen::AngleAxisd(M_PI_4, Eigen::Vector3d::UnitY()));
+  location["plate_link"].translation()(2) = 0.55 + 0.6 * std::sqrt(0.5) + 0.05 * std::sqrt(0.5);
+  result.clear();
+  result_vector.clear();
+  checker.setCollisionObjectsTransform(location);
+
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, 0.05, tolerance);
+  EXPECT_LE(result_vector[0].distance, 0.05 + 0.001);
+
+  ////////////////////////////////////////////////
+  // Test object is out side the contact distance
+  ////////////////////////////////////////////////
+  location["plate_link"] = Eigen::Isometry3d::Identity();
+  location["plate_link"].translation()(0) = 0.7;
+  result.clear();
+  result_vector.clear();
+  checker.setCollisionObjectsTransform(location);
+
+  checker.contactTest(result);
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+
+  EXPECT_TRUE(result_vector.empty());
+}
+
+TEST(TesseractCollisionUnit, SignedDistanceFieldOpenMeshUnit)
+{
+  shapes::ShapePtr box(shapes::createMeshFromShape(shapes::Box(1, 1, 1)));
+  const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(*box);
+
+  tesseract::VectorVector3d vertices;
+  for (unsigned int i = 0; i < mesh.vertex_count; ++i)
+    vertices.push_back(Eigen::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]));
+
+  std::vector<int> triangles(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+  EXPECT_TRUE(tesseract::createSignedDistanceField(vertices, triangles) != nullptr);
+
+  // Without its last triangle the box is open, the inside is unknown
+  triangles.resize(triangles.size() - 3);
+  EXPECT_TRUE(tesseract::createSignedDistanceField(vertices, triangles) == nullptr);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionSDFBoxUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionSDFConvexHullUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  addCollisionObjects(checker, true);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionSDFBoxUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionSDFConvexHullUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  addCollisionObjects(checker, true);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, FCLDiscreteBVHCollisionSDFBoxUnit)
+{
+  tesseract::FCLDiscreteBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, FCLDiscreteBVHCollisionSDFConvexHullUnit)
+{
+  tesseract::FCLDiscreteBVHManager checker;
+  addCollisionObjects(checker, true);
+  runTest(checker);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
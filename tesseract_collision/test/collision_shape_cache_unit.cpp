@@ -0,0 +1,205 @@
+#include "tesseract_collision/bullet/bullet_utils.h"
+#include "tesseract_collision/fcl/fcl_utils.h"
+#include "tesseract_collision/sphere_decomposition.h"
+#include <geometric_shapes/mesh_operations.h>
+#include <octomap/octomap.h>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+TEST(TesseractCollisionUnit, ShapeCacheHashUnit)
+{
+  shapes::Box box1(1, 2, 3), box2(1, 2, 3), box3(1, 2, 4);
+  EXPECT_EQ(tesseract::hashShapeData(box1, tesseract::CollisionObjectType::UseShapeType),
+            tesseract::hashShapeData(box2, tesseract::CollisionObjectType::UseShapeType));
+  EXPECT_NE(tesseract::hashShapeData(box1, tesseract::CollisionObjectType::UseShapeType),
+            tesseract::hashShapeData(box3, tesseract::CollisionObjectType::UseShapeType));
+  EXPECT_NE(tesseract::hashShapeData(box1, tesseract::CollisionObjectType::UseShapeType),
+            tesseract::hashShapeData(box1, tesseract::CollisionObjectType::ConvexHull));
+  EXPECT_TRUE(tesseract::isShapeDataEqual(box1, box2));
+  EXPECT_FALSE(tesseract::isShapeDataEqual(box1, box3));
+
+  // A sphere and a box with the same leading value are different shapes
+  shapes::Sphere sphere(1);
+  EXPECT_FALSE(tesseract::isShapeDataEqual(box1, sphere));
+
+  std::unique_ptr<shapes::Mesh> mesh1(shapes::createMeshFromShape(box1));
+  std::unique_ptr<shapes::Mesh> mesh2(shapes::createMeshFromShape(box2));
+  std::unique_ptr<shapes::Mesh> mesh3(shapes::createMeshFromShape(box3));
+  EXPECT_EQ(tesseract::hashShapeData(*mesh1, tesseract::CollisionObjectType::UseShapeType),
+            tesseract::hashShapeData(*mesh2, tesseract::CollisionObjectType::UseShapeType));
+  EXPECT_TRUE(tesseract::isShapeDataEqual(*mesh1, *mesh2));
+  EXPECT_FALSE(tesseract::isShapeDataEqual(*mesh1, *mesh3));
+
+  EXPECT_TRUE(tesseract::isShapeCacheable(box1));
+  EXPECT_TRUE(tesseract::isShapeCacheable(*mesh1));
+  shapes::OcTree octree(std::shared_ptr<const octomap::OcTree>(new octomap::OcTree(0.1)));
+  EXPECT_FALSE(tesseract::isShapeCacheable(octree));
+}
+
+TEST(TesseractCollisionUnit, ShapeCacheWeakReferenceUnit)
+{
+  tesseract::CollisionShapeCache<int> cache;
+  int num_created = 0;
+  auto create = [&num_created]() {
+    ++num_created;
+    return std::make_shared<int>(num_created);
+  };
+
+  shapes::ShapeConstPtr box1(new shapes::Box(1, 2, 3));
+  shapes::ShapeConstPtr box2(new shapes::Box(1, 2, 3));
+
+  // Equal shapes share the geometry
+  std::shared_ptr<int> geometry1 = cache.get(box1, tesseract::CollisionObjectType::UseShapeType, create);
+  std::shared_ptr<int> geometry2 = cache.get(box2, tesseract::CollisionObjectType::UseShapeType, create);
+  EXPECT_EQ(geometry1, geometry2);
+  EXPECT_EQ(num_created, 1);
+  EXPECT_EQ(cache.size(), 1u);
+
+  // The collision object type is part of the key
+  std::shared_ptr<int> geometry3 = cache.get(box1, tesseract::CollisionObjectType::ConvexHull, create);
+  EXPECT_NE(geometry1, geometry3);
+  EXPECT_EQ(num_created, 2);
+
+  // The cache does not keep the geometry alive
+  std::weak_ptr<int> weak = geometry1;
+  geometry1.reset();
+  geometry2.reset();
+  EXPECT_TRUE(weak.expired());
+
+  geometry1 = cache.get(box1, tesseract::CollisionObjectType::UseShapeType, create);
+  EXPECT_EQ(*geometry1, 3);
+  EXPECT_EQ(num_created, 3);
+
+  // Failed creations are not cached
+  shapes::ShapeConstPtr box4(new shapes::Box(4, 5, 6));
+  EXPECT_TRUE(cache.get(box4, tesseract::CollisionObjectType::UseShapeType, []() { return std::shared_ptr<int>(); }) ==
+              nullptr);
+  EXPECT_EQ(cache.size(), 2u);
+
+  // Shapes which are not cacheable are created every time
+  shapes::ShapeConstPtr octree(new shapes::OcTree(std::shared_ptr<const octomap::OcTree>(new octomap::OcTree(0.1))));
+  geometry2 = cache.get(octree, tesseract::CollisionObjectType::UseShapeType, create);
+  geometry3 = cache.get(octree, tesseract::CollisionObjectType::UseShapeType, create);
+  EXPECT_NE(geometry2, geometry3);
+  EXPECT_EQ(num_created, 5);
+}
+
+TEST(TesseractCollisionUnit, ShapeCacheSettingsUnit)
+{
+  tesseract::CollisionShapeCache<int> cache;
+  int num_created = 0;
+  auto create = [&num_created]() {
+    ++num_created;
+    return std::make_shared<int>(num_created);
+  };
+
+  // The settings the geometry is created with are part of the key
+  shapes::ShapeConstPtr box(new shapes::Box(1, 2, 3));
+  std::shared_ptr<int> geometry1 = cache.get(box, tesseract::CollisionObjectType::MultiSphere, { 0.01, 100 }, create);
+  std::shared_ptr<int> geometry2 = cache.get(box, tesseract::CollisionObjectType::MultiSphere, { 0.1, 100 }, create);
+  std::shared_ptr<int> geometry3 = cache.get(box, tesseract::CollisionObjectType::MultiSphere, { 0.01, 100 }, create);
+  EXPECT_NE(geometry1, geometry2);
+  EXPECT_EQ(geometry1, geometry3);
+  EXPECT_EQ(num_created, 2);
+
+  // Bullet collision objects only share a sphere decomposition created with the same settings
+  std::shared_ptr<shapes::Mesh> mesh(shapes::createMeshFromShape(shapes::Box(1, 1, 1)));
+  std::vector<shapes::ShapeConstPtr> shapes = { mesh };
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::MultiSphere };
+
+  tesseract::SphereDecompositionSettings default_settings = tesseract::getSphereDecompositionSettings();
+  tesseract::COWPtr cow1(new tesseract::COW("link1", 0, shapes, poses, types));
+
+  tesseract::SphereDecompositionSettings settings = default_settings;
+  settings.max_error = 0.1;
+  tesseract::setSphereDecompositionSettings(settings);
+  tesseract::COWPtr cow2(new tesseract::COW("link2", 0, shapes, poses, types));
+  tesseract::COWPtr cow3(new tesseract::COW("link3", 0, shapes, poses, types));
+  tesseract::setSphereDecompositionSettings(default_settings);
+
+  EXPECT_NE(cow1->getCollisionShape(), cow2->getCollisionShape());
+  EXPECT_EQ(cow2->getCollisionShape(), cow3->getCollisionShape());
+}
+
+TEST(TesseractCollisionUnit, ShapeCacheConcurrentUnit)
+{
+  tesseract::CollisionShapeCache<int> cache;
+  std::atomic<int> num_created(0);
+  auto create = [&num_created]() {
+    ++num_created;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return std::make_shared<int>(0);
+  };
+
+  // Threads asking for the same shape wait for the first one to create it
+  const std::size_t num_threads = 8;
+  std::vector<std::shared_ptr<int>> geometries(num_threads);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < num_threads; ++i)
+    threads.emplace_back([&, i]() {
+      shapes::ShapeConstPtr box(new shapes::Box(1, 2, 3));
+      geometries[i] = cache.get(box, tesseract::CollisionObjectType::UseShapeType, create);
+    });
+
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_EQ(num_created.load(), 1);
+  for (const auto& geometry : geometries)
+    EXPECT_EQ(geometry, geometries[0]);
+
+  // Different shapes are created in parallel
+  threads.clear();
+  for (std::size_t i = 0; i < num_threads; ++i)
+    threads.emplace_back([&, i]() {
+      shapes::ShapeConstPtr box(new shapes::Box(1, 2, 4 + static_cast<double>(i)));
+      geometries[i] = cache.get(box, tesseract::CollisionObjectType::UseShapeType, create);
+    });
+
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_EQ(num_created.load(), 1 + static_cast<int>(num_threads));
+  EXPECT_EQ(cache.size(), 1 + num_threads);
+}
+
+TEST(TesseractCollisionUnit, ShapeCacheCollisionObjectUnit)
+{
+  std::vector<shapes::ShapeConstPtr> shapes1 = { shapes::ShapeConstPtr(new shapes::Box(1, 2, 3)) };
+  std::vector<shapes::ShapeConstPtr> shapes2 = { shapes::ShapeConstPtr(new shapes::Box(1, 2, 3)) };
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+
+  // Bullet collision objects share the collision shape
+  tesseract::COWPtr cow1(new tesseract::COW("link1", 0, shapes1, poses, types));
+  tesseract::COWPtr cow2(new tesseract::COW("link2", 0, shapes2, poses, types));
+  EXPECT_EQ(cow1->getCollisionShape(), cow2->getCollisionShape());
+
+  // FCL collision objects share the collision geometry, its local AABB is computed by the cached prototype
+  tesseract::FCLCOWPtr fcl_cow1(new tesseract::FCLCOW("link1", 0, shapes1, poses, types));
+  tesseract::FCLCOWPtr fcl_cow2(new tesseract::FCLCOW("link2", 0, shapes2, poses, types));
+  ASSERT_EQ(fcl_cow1->getCollisionObjects().size(), 1u);
+  ASSERT_EQ(fcl_cow2->getCollisionObjects().size(), 1u);
+  EXPECT_EQ(fcl_cow1->getCollisionObjects()[0]->collisionGeometry(),
+            fcl_cow2->getCollisionObjects()[0]->collisionGeometry());
+  EXPECT_NE(fcl_cow1->getCollisionObjects()[0], fcl_cow2->getCollisionObjects()[0]);
+  EXPECT_NEAR(fcl_cow1->getCollisionObjects()[0]->getAABB().max_[2], 1.5, 1e-6);
+
+  // The cache entry is released with the last collision object
+  std::weak_ptr<const fcl::CollisionGeometryd> geometry = fcl_cow1->getCollisionObjects()[0]->collisionGeometry();
+  fcl_cow1.reset();
+  EXPECT_FALSE(geometry.expired());
+  fcl_cow2.reset();
+  EXPECT_TRUE(geometry.expired());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,167 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+void addBox(tesseract::DiscreteContactManagerBase& checker, const std::string& name)
+{
+  shapes::ShapePtr box(new shapes::Box(1, 1, 1));
+  Eigen::Isometry3d box_pose;
+  box_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj_shapes;
+  tesseract::VectorIsometry3d obj_poses;
+  tesseract::CollisionObjectTypeVector obj_types;
+  obj_shapes.push_back(box);
+  obj_poses.push_back(box_pose);
+  obj_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject(name, 0, obj_shapes, obj_poses, obj_types);
+}
+
+void addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  ///////////////////////////////////////////////////
+  // Add two overlapping static boxes to the checker
+  ///////////////////////////////////////////////////
+  addBox(checker, "static_a_link");
+  addBox(checker, "static_b_link");
+
+  /////////////////////////////
+  // Add sphere to checker
+  /////////////////////////////
+  shapes::ShapePtr sphere(new shapes::Sphere(0.25));
+  Eigen::Isometry3d sphere_pose;
+  sphere_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj_shapes;
+  tesseract::VectorIsometry3d obj_poses;
+  tesseract::CollisionObjectTypeVector obj_types;
+  obj_shapes.push_back(sphere);
+  obj_poses.push_back(sphere_pose);
+  obj_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("sphere_link", 0, obj_shapes, obj_poses, obj_types);
+}
+
+bool hasContact(const tesseract::ContactResultMap& result, const std::string& name1, const std::string& name2)
+{
+  return result.find(tesseract::getObjectPairKey(name1, name2)) != result.end();
+}
+
+void runTest(tesseract::DiscreteContactManagerBase& checker)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::ALL;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["static_a_link"] = Eigen::Isometry3d::Identity();
+  location["static_b_link"] = Eigen::Isometry3d::Identity();
+  location["static_b_link"].translation()(0) = 0.5;
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere_link"].translation()(0) = 3;
+  checker.setCollisionObjectsTransform(location);
+
+  ////////////////////////////////////////////////////////
+  // Static objects are never checked against each other
+  ////////////////////////////////////////////////////////
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+  EXPECT_TRUE(result.empty());
+
+  //////////////////////////////////////////
+  // Test the sphere against a static box
+  //////////////////////////////////////////
+  checker.setCollisionObjectsTransform("sphere_link", Eigen::Isometry3d(Eigen::Translation3d(1.2, 0, 0)));
+  result.clear();
+  checker.contactTest(result);
+  ASSERT_EQ(result.size(), 1u);
+  ASSERT_TRUE(hasContact(result, "sphere_link", "static_b_link"));
+  EXPECT_NEAR(result[tesseract::getObjectPairKey("sphere_link", "static_b_link")][0].distance, -0.05, 0.001);
+
+  ///////////////////////////////////////////////
+  // Moving a static box updates its AABB
+  ///////////////////////////////////////////////
+  checker.setCollisionObjectsTransform("static_b_link", Eigen::Isometry3d(Eigen::Translation3d(5, 0, 0)));
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_TRUE(result.empty());
+
+  ////////////////////////////////////////////////////////////////
+  // A static box moving on every query keeps its AABB up to date
+  ////////////////////////////////////////////////////////////////
+  for (int i = 0; i < 5; ++i)
+  {
+    checker.setCollisionObjectsTransform("static_b_link", Eigen::Isometry3d(Eigen::Translation3d(0.5, 0, 0)));
+    result.clear();
+    checker.contactTest(result);
+    EXPECT_TRUE(hasContact(result, "sphere_link", "static_b_link"));
+
+    checker.setCollisionObjectsTransform("static_b_link", Eigen::Isometry3d(Eigen::Translation3d(5, 0, 0)));
+    result.clear();
+    checker.contactTest(result);
+    EXPECT_TRUE(result.empty());
+  }
+
+  //////////////////////////////////////////////////////
+  // A static box which becomes kinematic is checked
+  //////////////////////////////////////////////////////
+  req.link_names.push_back("static_a_link");
+  checker.setContactRequest(req);
+  checker.setCollisionObjectsTransform("static_b_link", Eigen::Isometry3d(Eigen::Translation3d(0.5, 0, 0)));
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_EQ(result.size(), 2u);
+  EXPECT_TRUE(hasContact(result, "sphere_link", "static_b_link"));
+  EXPECT_TRUE(hasContact(result, "static_a_link", "static_b_link"));
+
+  /////////////////////////////////////
+  // Removed objects are not checked
+  /////////////////////////////////////
+  EXPECT_TRUE(checker.removeCollisionObject("static_b_link"));
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_TRUE(result.empty());
+
+  //////////////////////////////////////////////////
+  // The kinematic box becomes static again
+  //////////////////////////////////////////////////
+  addBox(checker, "static_b_link");
+  req.link_names.pop_back();
+  checker.setContactRequest(req);
+  checker.setCollisionObjectsTransform("static_b_link", Eigen::Isometry3d(Eigen::Translation3d(0.5, 0, 0)));
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_EQ(result.size(), 1u);
+  EXPECT_TRUE(hasContact(result, "sphere_link", "static_b_link"));
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteSimpleCollisionStaticWorldUnit)
+{
+  tesseract::BulletDiscreteSimpleManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionStaticWorldUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletDiscreteBVHCollisionStaticWorldCloneUnit)
+{
+  tesseract::BulletDiscreteBVHManager checker;
+  addCollisionObjects(checker);
+  runTest(*checker.clone());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
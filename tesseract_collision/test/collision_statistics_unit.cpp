@@ -0,0 +1,174 @@
+#include "tesseract_collision/bullet/bullet_discrete_managers.h"
+#include "tesseract_collision/fcl/fcl_discrete_managers.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+template <typename T>
+class CollisionStatisticsUnit : public testing::Test
+{
+};
+
+typedef testing::Types<tesseract::BulletDiscreteSimpleManager,
+                       tesseract::BulletDiscreteBVHManager,
+                       tesseract::FCLDiscreteBVHManager>
+    DiscreteManagerTypes;
+TYPED_TEST_CASE(CollisionStatisticsUnit, DiscreteManagerTypes);
+
+/**
+ * @brief Add three spheres in a row along x 0.5 apart and a disabled box through the middle sphere
+ *
+ * The CLOSEST request includes every sphere and the contact distance only reaches the neighbouring spheres. Contact
+ * between the middle sphere and sphere2_link is allowed by the returned matrix.
+ */
+tesseract::ContactRequest addCollisionObjects(tesseract::DiscreteContactManagerBase& checker)
+{
+  tesseract::VectorIsometry3d poses = { Eigen::Isometry3d::Identity() };
+  tesseract::CollisionObjectTypeVector types = { tesseract::CollisionObjectType::UseShapeType };
+  std::vector<shapes::ShapeConstPtr> sphere_shapes = { shapes::ShapeConstPtr(new shapes::Sphere(0.25)) };
+  std::vector<shapes::ShapeConstPtr> box_shapes = { shapes::ShapeConstPtr(new shapes::Box(0.1, 1, 1)) };
+
+  checker.addCollisionObject("sphere_link", 0, sphere_shapes, poses, types);
+  checker.addCollisionObject("sphere1_link", 0, sphere_shapes, poses, types);
+  checker.addCollisionObject("sphere2_link", 0, sphere_shapes, poses, types);
+  checker.addCollisionObject("thin_box_link", 0, box_shapes, poses, types, false);
+
+  tesseract::NameRegistryConstPtr registry = checker.getLinkRegistry();
+  tesseract::AllowedCollisionBitMatrixPtr acm(new tesseract::AllowedCollisionBitMatrix());
+  acm->setCollisionAllowed(registry->find("sphere_link"), registry->find("sphere2_link"), true);
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.link_names.push_back("sphere1_link");
+  req.link_names.push_back("sphere2_link");
+  req.contact_distance = 0.52;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  req.allowed_collision_matrix = acm;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["sphere_link"] = Eigen::Isometry3d::Identity();
+  location["sphere1_link"] = Eigen::Isometry3d::Identity();
+  location["sphere1_link"].translation()(0) = 1;
+  location["sphere2_link"] = Eigen::Isometry3d::Identity();
+  location["sphere2_link"].translation()(0) = -1;
+  location["thin_box_link"] = Eigen::Isometry3d::Identity();
+  checker.setCollisionObjectsTransform(location);
+
+  return req;
+}
+
+/** @brief Check every pair reported by the broadphase is rejected or checked by the narrowphase */
+void checkPairCounts(const tesseract::ContactTestStatistics& stats)
+{
+  EXPECT_EQ(stats.num_broadphase_pairs, stats.num_filter_rejected + stats.num_acm_rejected + stats.num_narrowphase);
+  EXPECT_GE(stats.num_narrowphase, stats.num_results);
+
+  std::size_t num_narrowphase = 0;
+  for (const auto& shape_types : stats.narrowphase_shape_types)
+    num_narrowphase += shape_types.second;
+  EXPECT_EQ(num_narrowphase, stats.num_narrowphase);
+}
+
+TYPED_TEST(CollisionStatisticsUnit, Statistics)
+{
+  TypeParam checker;
+  tesseract::ContactRequest req = addCollisionObjects(checker);
+
+  ////////////////////////////////////////////////
+  // Test statistics are only collected if enabled
+  ////////////////////////////////////////////////
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+  EXPECT_FALSE(checker.isStatisticsEnabled());
+  EXPECT_EQ(checker.getStatistics().num_contact_tests, 0u);
+  EXPECT_EQ(checker.getStatistics().num_broadphase_pairs, 0u);
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Test the counters with a pair allowed in collision and a disabled object
+  ////////////////////////////////////////////////////////////////////////////
+  checker.setStatisticsEnabled(true);
+  EXPECT_TRUE(checker.isStatisticsEnabled());
+
+  result.clear();
+  checker.contactTest(result);
+  const tesseract::ContactTestStatistics first = checker.getStatistics();
+  {
+    SCOPED_TRACE("allowed pair and disabled object");
+    EXPECT_EQ(first.num_contact_tests, 1u);
+    EXPECT_EQ(first.num_acm_rejected, 1u);
+    EXPECT_EQ(first.num_results, 1u);
+    EXPECT_GE(first.num_narrowphase, 1u);
+    checkPairCounts(first);
+  }
+
+  // The counters accumulate until they are cleared
+  result.clear();
+  checker.contactTest(result);
+  {
+    SCOPED_TRACE("accumulated");
+    const tesseract::ContactTestStatistics& stats = checker.getStatistics();
+    EXPECT_EQ(stats.num_contact_tests, 2u);
+    EXPECT_EQ(stats.num_broadphase_pairs, 2 * first.num_broadphase_pairs);
+    EXPECT_EQ(stats.num_filter_rejected, 2 * first.num_filter_rejected);
+    EXPECT_EQ(stats.num_acm_rejected, 2u);
+    EXPECT_EQ(stats.num_narrowphase, 2 * first.num_narrowphase);
+    EXPECT_EQ(stats.num_results, 2u);
+  }
+
+  ///////////////////////////////////////////////////////////////////////
+  // Test the pair which is no longer allowed goes to the narrowphase
+  ///////////////////////////////////////////////////////////////////////
+  req.allowed_collision_matrix = nullptr;
+  checker.setContactRequest(req);
+  checker.clearStatistics();
+  EXPECT_EQ(checker.getStatistics().num_contact_tests, 0u);
+
+  result.clear();
+  checker.contactTest(result);
+  {
+    SCOPED_TRACE("no allowed pair");
+    const tesseract::ContactTestStatistics& stats = checker.getStatistics();
+    EXPECT_EQ(stats.num_contact_tests, 1u);
+    EXPECT_EQ(stats.num_broadphase_pairs, first.num_broadphase_pairs);
+    EXPECT_EQ(stats.num_filter_rejected, first.num_filter_rejected);
+    EXPECT_EQ(stats.num_acm_rejected, 0u);
+    EXPECT_EQ(stats.num_narrowphase, first.num_narrowphase + 1);
+    EXPECT_EQ(stats.num_results, 2u);
+    checkPairCounts(stats);
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+  // Test the pairs of the enabled box are no longer rejected by the filter
+  //////////////////////////////////////////////////////////////////////////
+  checker.enableCollisionObject("thin_box_link");
+  checker.clearStatistics();
+
+  result.clear();
+  checker.contactTest(result);
+  {
+    SCOPED_TRACE("enabled object");
+    const tesseract::ContactTestStatistics& stats = checker.getStatistics();
+    EXPECT_EQ(stats.num_filter_rejected, 0u);
+    EXPECT_EQ(stats.num_acm_rejected, 0u);
+    EXPECT_GE(stats.num_narrowphase, first.num_narrowphase + 2);
+    EXPECT_EQ(stats.num_results, 3u);
+    checkPairCounts(stats);
+  }
+
+  ////////////////////////////////////////////////
+  // Test nothing is counted once disabled again
+  ////////////////////////////////////////////////
+  checker.clearStatistics();
+  checker.setStatisticsEnabled(false);
+  result.clear();
+  checker.contactTest(result);
+  EXPECT_EQ(checker.getStatistics().num_contact_tests, 0u);
+  EXPECT_EQ(checker.getStatistics().num_narrowphase, 0u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
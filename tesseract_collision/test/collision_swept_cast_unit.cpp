@@ -0,0 +1,385 @@
+#include "tesseract_collision/bullet/bullet_cast_managers.h"
+#include "tesseract_collision/fcl/fcl_cast_managers.h"
+#include <octomap/octomap.h>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+void addCollisionObjects(tesseract::ContinuousContactManagerBase& checker, bool use_compound)
+{
+  /////////////////////////////
+  // Add static box to checker
+  /////////////////////////////
+  shapes::ShapePtr box(new shapes::Box(1, 1, 1));
+  Eigen::Isometry3d box_pose;
+  box_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj1_shapes;
+  tesseract::VectorIsometry3d obj1_poses;
+  tesseract::CollisionObjectTypeVector obj1_types;
+  obj1_shapes.push_back(box);
+  obj1_poses.push_back(box_pose);
+  obj1_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("box_link", 0, obj1_shapes, obj1_poses, obj1_types);
+
+  /////////////////////////////////////////////////////////////////
+  // Add moving sphere to checker, two spheres make it a compound
+  /////////////////////////////////////////////////////////////////
+  shapes::ShapePtr sphere(new shapes::Sphere(0.25));
+  Eigen::Isometry3d sphere_pose;
+  sphere_pose.setIdentity();
+
+  std::vector<shapes::ShapeConstPtr> obj2_shapes;
+  tesseract::VectorIsometry3d obj2_poses;
+  tesseract::CollisionObjectTypeVector obj2_types;
+  obj2_shapes.push_back(sphere);
+  obj2_poses.push_back(sphere_pose);
+  obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  if (use_compound)
+  {
+    sphere_pose.translation()(2) = 0.1;
+    obj2_shapes.push_back(sphere);
+    obj2_poses.push_back(sphere_pose);
+    obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+  }
+
+  checker.addCollisionObject("sphere_link", 0, obj2_shapes, obj2_poses, obj2_types);
+}
+
+tesseract::VectorIsometry3d createWindow(const std::vector<Eigen::Vector3d>& positions)
+{
+  tesseract::VectorIsometry3d poses;
+  for (const auto& position : positions)
+  {
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translation() = position;
+    poses.push_back(pose);
+  }
+  return poses;
+}
+
+void runTest(tesseract::ContinuousContactManagerBase& checker)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  tesseract::TransformMap location;
+  location["box_link"] = Eigen::Isometry3d::Identity();
+  checker.setCollisionObjectsTransform(location);
+
+  //////////////////////////////////////////////////////
+  // Test window which passes by the box on one side
+  //////////////////////////////////////////////////////
+  tesseract::VectorIsometry3d poses = createWindow(
+      { Eigen::Vector3d(-2, 2, 0), Eigen::Vector3d(0, 2, 0), Eigen::Vector3d(2, 2, 0), Eigen::Vector3d(2, 4, 0) });
+  checker.setCollisionObjectsSweptTransform("sphere_link", poses);
+  EXPECT_TRUE(checker.isCollisionFree());
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Test window whose first and last poses are free but which passes the box
+  //////////////////////////////////////////////////////////////////////////////
+  poses = createWindow({ Eigen::Vector3d(-2, 2, 0), Eigen::Vector3d(0, 0.6, 0), Eigen::Vector3d(2, 2, 0) });
+  checker.setCollisionObjectsSweptTransform("sphere_link", poses);
+  EXPECT_FALSE(checker.isCollisionFree());
+
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+
+  tesseract::ContactResultVector result_vector;
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  ASSERT_TRUE(!result_vector.empty());
+  EXPECT_LT(result_vector[0].distance, 0);
+
+  ////////////////////////////////////////////////////////////////
+  // Test a segment of the window, the window poses are dropped
+  ////////////////////////////////////////////////////////////////
+  checker.setCollisionObjectsTransform("sphere_link", poses.front(), poses.back());
+  EXPECT_TRUE(checker.isCollisionFree());
+
+  checker.setCollisionObjectsTransform("sphere_link", poses[0], poses[1]);
+  EXPECT_FALSE(checker.isCollisionFree());
+}
+
+void runTimeOfContactTest(tesseract::ContinuousContactManagerBase& checker, double cc_time_tolerance)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+  checker.setCollisionObjectsTransform("box_link", Eigen::Isometry3d::Identity());
+
+  auto getContact = [&checker](const Eigen::Vector3d& start, const Eigen::Vector3d& end) {
+    checker.setCollisionObjectsTransform(
+        "sphere_link", Eigen::Isometry3d(Eigen::Translation3d(start)), Eigen::Isometry3d(Eigen::Translation3d(end)));
+
+    tesseract::ContactResultMap result;
+    checker.contactTest(result);
+
+    tesseract::ContactResultVector result_vector;
+    tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+    return result_vector;
+  };
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Test motion through the box, it is entered at 0.3125 and left at 0.6875
+  ///////////////////////////////////////////////////////////////////////////
+  tesseract::ContactResultVector result_vector = getContact(Eigen::Vector3d(-2, 0, 0), Eigen::Vector3d(2, 0, 0));
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_EQ(result_vector[0].cc_type, tesseract::ContinouseCollisionType::CCType_Between);
+  EXPECT_NEAR(result_vector[0].cc_time, 0.5, cc_time_tolerance);
+  EXPECT_NEAR(result_vector[0].distance, -0.75, 0.01);
+
+  //////////////////////////////////////////////
+  // Test motion starting in collision
+  //////////////////////////////////////////////
+  result_vector = getContact(Eigen::Vector3d(0.5, 0, 0), Eigen::Vector3d(2, 0, 0));
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_EQ(result_vector[0].cc_type, tesseract::ContinouseCollisionType::CCType_Time0);
+  EXPECT_NEAR(result_vector[0].cc_time, 0, 1e-6);
+  EXPECT_NEAR(result_vector[0].distance, -0.25, 0.01);
+
+  //////////////////////////////////////////////
+  // Test motion ending in collision
+  //////////////////////////////////////////////
+  result_vector = getContact(Eigen::Vector3d(-2, 0, 0), Eigen::Vector3d(-0.5, 0, 0));
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_EQ(result_vector[0].cc_type, tesseract::ContinouseCollisionType::CCType_Time1);
+  EXPECT_NEAR(result_vector[0].cc_time, 1, 1e-6);
+  EXPECT_NEAR(result_vector[0].distance, -0.25, 0.01);
+
+  ///////////////////////////////////////////////////////////////
+  // Test motion ending within the contact distance of the box
+  ///////////////////////////////////////////////////////////////
+  result_vector = getContact(Eigen::Vector3d(-2, 0, 0), Eigen::Vector3d(-0.8, 0, 0));
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_EQ(result_vector[0].cc_type, tesseract::ContinouseCollisionType::CCType_Time1);
+  EXPECT_NEAR(result_vector[0].distance, 0.05, 0.001);
+
+  EXPECT_TRUE(getContact(Eigen::Vector3d(-2, 0, 0), Eigen::Vector3d(-1, 0, 0)).empty());
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Test motion passing the box within the contact distance between poses
+  ////////////////////////////////////////////////////////////////////////////
+  result_vector = getContact(Eigen::Vector3d(-2, 0.8, 0), Eigen::Vector3d(2, 0.8, 0));
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_EQ(result_vector[0].cc_type, tesseract::ContinouseCollisionType::CCType_Between);
+  EXPECT_NEAR(result_vector[0].distance, 0.05, 0.001);
+  EXPECT_GE(result_vector[0].cc_time, 0.375 - 0.001);
+  EXPECT_LE(result_vector[0].cc_time, 0.625 + 0.001);
+
+  EXPECT_TRUE(getContact(Eigen::Vector3d(-2, 0.9, 0), Eigen::Vector3d(2, 0.9, 0)).empty());
+}
+
+TEST(TesseractCollisionUnit, BulletCastSimpleCollisionSweptUnit)
+{
+  tesseract::BulletCastSimpleManager checker;
+  addCollisionObjects(checker, false);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletCastSimpleCollisionSweptCompoundUnit)
+{
+  tesseract::BulletCastSimpleManager checker;
+  addCollisionObjects(checker, true);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletCastBVHCollisionSweptUnit)
+{
+  tesseract::BulletCastBVHManager checker;
+  addCollisionObjects(checker, false);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletCastBVHCollisionSweptCompoundUnit)
+{
+  tesseract::BulletCastBVHManager checker;
+  addCollisionObjects(checker, true);
+  runTest(checker);
+}
+
+void runOcTreeTest(tesseract::ContinuousContactManagerBase& checker)
+{
+  ////////////////////////////////////////////////////
+  // Add a wall of a single layer of voxels to checker
+  ////////////////////////////////////////////////////
+  std::shared_ptr<octomap::OcTree> ot(new octomap::OcTree(0.1));
+  for (double y = -0.45; y < 0.5; y += 0.1)
+    for (double z = -0.45; z < 0.5; z += 0.1)
+      ot->updateNode(octomap::point3d(0.05f, static_cast<float>(y), static_cast<float>(z)), true);
+
+  std::vector<shapes::ShapeConstPtr> obj1_shapes;
+  tesseract::VectorIsometry3d obj1_poses;
+  tesseract::CollisionObjectTypeVector obj1_types;
+  obj1_shapes.push_back(shapes::ShapePtr(new shapes::OcTree(ot)));
+  obj1_poses.push_back(Eigen::Isometry3d::Identity());
+  obj1_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("octomap_link", 0, obj1_shapes, obj1_poses, obj1_types);
+
+  /////////////////////////////////////
+  // Add small moving sphere to checker
+  /////////////////////////////////////
+  std::vector<shapes::ShapeConstPtr> obj2_shapes;
+  tesseract::VectorIsometry3d obj2_poses;
+  tesseract::CollisionObjectTypeVector obj2_types;
+  obj2_shapes.push_back(shapes::ShapePtr(new shapes::Sphere(0.01)));
+  obj2_poses.push_back(Eigen::Isometry3d::Identity());
+  obj2_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+
+  checker.addCollisionObject("sphere_link", 0, obj2_shapes, obj2_poses, obj2_types);
+
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+  checker.setCollisionObjectsTransform("octomap_link", Eigen::Isometry3d::Identity());
+
+  // The wall is thin compared to the motion, FCL_CAST_MAX_ITERATIONS uniformly spread poses of it all miss the wall
+  Eigen::Isometry3d start_pos, end_pos;
+  start_pos.setIdentity();
+  start_pos.translation()(0) = -1.95;
+  end_pos.setIdentity();
+  end_pos.translation()(0) = 2.05;
+  checker.setCollisionObjectsTransform("sphere_link", start_pos, end_pos);
+  EXPECT_FALSE(checker.isCollisionFree());
+
+  end_pos.translation()(1) = 1;
+  start_pos.translation()(1) = 1;
+  checker.setCollisionObjectsTransform("sphere_link", start_pos, end_pos);
+  EXPECT_TRUE(checker.isCollisionFree());
+}
+
+void runStaticTransformTest(tesseract::ContinuousContactManagerBase& checker)
+{
+  tesseract::ContactRequest req;
+  req.link_names.push_back("sphere_link");
+  req.contact_distance = 0.1;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  checker.setContactRequest(req);
+
+  // The sphere moves next to the box, far enough to be collision free
+  Eigen::Isometry3d start_pos, end_pos;
+  start_pos.setIdentity();
+  start_pos.translation()(0) = 2;
+  end_pos = start_pos;
+  end_pos.translation()(1) = 0.1;
+  checker.setCollisionObjectsTransform("sphere_link", start_pos, end_pos);
+  checker.setCollisionObjectsTransform("box_link", Eigen::Isometry3d::Identity());
+  EXPECT_TRUE(checker.isCollisionFree());
+
+  tesseract::NameRegistryConstPtr registry = checker.getLinkRegistry();
+  int box_id = registry->find("box_link");
+  int sphere_id = registry->find("sphere_link");
+  ASSERT_GE(box_id, 0);
+  ASSERT_GE(sphere_id, 0);
+
+  // The box is moved onto the path of the sphere by link id
+  Eigen::Isometry3d box_pose = Eigen::Isometry3d::Identity();
+  box_pose.translation()(0) = 1.5;
+  checker.setCollisionObjectsTransform(box_id, box_pose);
+  EXPECT_FALSE(checker.isCollisionFree());
+
+  // The dense update moves the box back, the sphere keeps its cast motion
+  tesseract::VectorIsometry3d link_transforms(registry->size(), Eigen::Isometry3d::Identity());
+  link_transforms[static_cast<std::size_t>(sphere_id)] = start_pos;
+  checker.setCollisionObjectsTransform(link_transforms);
+  EXPECT_TRUE(checker.isCollisionFree());
+
+  tesseract::ContactResultMap result;
+  checker.contactTest(result);
+  EXPECT_TRUE(result.empty());
+
+  // Setting the same poses again keeps the box in place, changed ones move it in the broadphase
+  checker.setCollisionObjectsTransform(link_transforms);
+  EXPECT_TRUE(checker.isCollisionFree());
+
+  link_transforms[static_cast<std::size_t>(box_id)] = box_pose;
+  checker.setCollisionObjectsTransform(link_transforms);
+
+  result.clear();
+  checker.contactTest(result);
+  tesseract::ContactResultVector result_vector;
+  tesseract::moveContactResultsMapToContactResultsVector(result, result_vector);
+  ASSERT_EQ(result_vector.size(), 1u);
+  EXPECT_NEAR(result_vector[0].distance, -0.25, 1e-4);
+
+  // A clone has the same poses
+  EXPECT_FALSE(checker.clone()->isCollisionFree());
+}
+
+TEST(TesseractCollisionUnit, BulletCastSimpleCollisionStaticTransformUnit)
+{
+  tesseract::BulletCastSimpleManager checker;
+  addCollisionObjects(checker, false);
+  runStaticTransformTest(checker);
+}
+
+TEST(TesseractCollisionUnit, BulletCastBVHCollisionStaticTransformUnit)
+{
+  tesseract::BulletCastBVHManager checker;
+  addCollisionObjects(checker, false);
+  runStaticTransformTest(checker);
+}
+
+// The Bullet cast managers evaluate the contact on the hull swept by the sphere, it may be anywhere on the hull the
+// box penetrates evenly, so the time of a motion through the box is only known to be between entering and leaving it
+TEST(TesseractCollisionUnit, BulletCastSimpleCollisionTimeOfContactUnit)
+{
+  tesseract::BulletCastSimpleManager checker;
+  addCollisionObjects(checker, false);
+  runTimeOfContactTest(checker, 0.1875);
+}
+
+TEST(TesseractCollisionUnit, BulletCastBVHCollisionTimeOfContactUnit)
+{
+  tesseract::BulletCastBVHManager checker;
+  addCollisionObjects(checker, false);
+  runTimeOfContactTest(checker, 0.1875);
+}
+
+TEST(TesseractCollisionUnit, FCLCastBVHCollisionSweptUnit)
+{
+  tesseract::FCLCastBVHManager checker;
+  addCollisionObjects(checker, false);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, FCLCastBVHCollisionSweptCompoundUnit)
+{
+  tesseract::FCLCastBVHManager checker;
+  addCollisionObjects(checker, true);
+  runTest(checker);
+}
+
+TEST(TesseractCollisionUnit, FCLCastBVHCollisionOcTreeUnit)
+{
+  tesseract::FCLCastBVHManager checker;
+  runOcTreeTest(checker);
+}
+
+TEST(TesseractCollisionUnit, FCLCastBVHCollisionTimeOfContactUnit)
+{
+  tesseract::FCLCastBVHManager checker;
+  addCollisionObjects(checker, false);
+  runTimeOfContactTest(*checker.clone(), 0.01);
+}
+
+TEST(TesseractCollisionUnit, FCLCastBVHCollisionStaticTransformUnit)
+{
+  tesseract::FCLCastBVHManager checker;
+  addCollisionObjects(checker, false);
+  runStaticTransformTest(checker);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
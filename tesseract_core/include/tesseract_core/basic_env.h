@@ -28,10 +28,15 @@
 
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 #include <tesseract_core/basic_types.h>
 #include <tesseract_core/basic_kin.h>
 #include <tesseract_core/discrete_contact_manager_base.h>
 #include <tesseract_core/continuous_contact_manager_base.h>
+#include <tesseract_core/worker_threads.h>
 
 namespace tesseract
 {
@@ -57,6 +62,13 @@ public:
   virtual void setState(const std::vector<std::string>& joint_names,
                         const Eigen::Ref<const Eigen::VectorXd>& joint_values) = 0;
 
+  /**
+   * @brief Set the current state of the environment using joint ids
+   * @param joint_ids The joint ids (see getJointRegistry())
+   * @param joint_values The joint values, same order as joint_ids
+   */
+  virtual void setState(const std::vector<int>& joint_ids, const Eigen::Ref<const Eigen::VectorXd>& joint_values) = 0;
+
   /** @brief Get the current state of the environment */
   virtual EnvStateConstPtr getState() const = 0;
 
@@ -74,6 +86,51 @@ public:
   virtual EnvStatePtr getState(const std::vector<std::string>& joint_names,
                                const Eigen::Ref<const Eigen::VectorXd>& joint_values) const = 0;
 
+  /**
+   * @brief Get the state of the environment for a given set or subset of joint ids.
+   *
+   * This does not change the internal state of the environment. Only the id
+   * indexed members of the returned state (joint_values and link_transforms)
+   * are populated.
+   *
+   * @param joint_ids The joint ids (see getJointRegistry())
+   * @param joint_values The joint values, same order as joint_ids
+   * @return A the state of the environment
+   */
+  virtual EnvStatePtr getState(const std::vector<int>& joint_ids,
+                               const Eigen::Ref<const Eigen::VectorXd>& joint_values) const = 0;
+
+  /**
+   * @brief Same as above but the state is calculated in place.
+   *
+   * Reusing the state across calls avoids allocating a new state for every call.
+   *
+   * @param state (Output) The state of the environment, only joint_values and link_transforms are updated
+   * @param joint_ids The joint ids (see getJointRegistry())
+   * @param joint_values The joint values, same order as joint_ids
+   */
+  virtual void getState(EnvState& state,
+                        const std::vector<int>& joint_ids,
+                        const Eigen::Ref<const Eigen::VectorXd>& joint_values) const = 0;
+
+  /**
+   * @brief Get the registry of link names
+   *
+   * The ids index EnvState::link_transforms and are shared with the environments contact managers.
+   *
+   * @return The link registry
+   */
+  virtual NameRegistryConstPtr getLinkRegistry() const = 0;
+
+  /**
+   * @brief Get the registry of joint names
+   *
+   * The ids index EnvState::joint_values.
+   *
+   * @return The joint registry
+   */
+  virtual NameRegistryConstPtr getJointRegistry() const = 0;
+
   /**
    * @brief hasManipulator Check if a manipulator exist in the environment
    * @param manipulator_name Name of the manipulator
@@ -237,10 +294,30 @@ public:
   /** @brief Set the active function for determining if two links are allowed to be in collision */
   virtual void setIsContactAllowedFn(IsContactAllowedFn fn) = 0;
 
-  /** @brief Get a copy of the environments discrete contact manager */
+  /**
+   * @brief Get the allowed collision matrix and attached body touch links compiled into a bit matrix indexed by link id
+   *
+   * This is what the default contact allowed function decides, so it should only be put in a
+   * ContactRequest when that function is active and the manager shares the link registry.
+   * It is kept up to date when bodies are attached or detached. Call this again after modifying
+   * the allowed collision matrix to update it.
+   */
+  virtual AllowedCollisionBitMatrixConstPtr getAllowedCollisionBitMatrix() const = 0;
+
+  /**
+   * @brief Get a copy of the environments discrete contact manager
+   *
+   * While the default contact allowed function is active the request of the copy already contains
+   * it and the compiled allowed collision bit matrix, as of the time of the call. Start from
+   * getContactRequest() to keep them.
+   */
   virtual DiscreteContactManagerBasePtr getDiscreteContactManager() const = 0;
 
-  /** @brief Get a copy of the environments continuous contact manager */
+  /**
+   * @brief Get a copy of the environments continuous contact manager
+   *
+   * The request of the copy is set up the same way as for getDiscreteContactManager().
+   */
   virtual ContinuousContactManagerBasePtr getContinuousContactManager() const = 0;
 
 };  // class BasicEnvBase
@@ -248,9 +325,133 @@ public:
 typedef std::shared_ptr<BasicEnv> BasicEnvPtr;
 typedef std::shared_ptr<const BasicEnv> BasicEnvConstPtr;
 
+/**
+ * @brief Get the link and joint ids of a kinematic object if the manager shares the environments link registry
+ * @param env The environment
+ * @param kin The kinematic object
+ * @param manager_link_registry The link registry of the contact manager
+ * @param joint_ids (Output) The joint ids, same order as kin.getJointNames()
+ * @param link_ids (Output) The link ids, same order as kin.getLinkNames()
+ * @return True if the ids can be used, otherwise the names have to be used
+ */
+inline bool getTrajectoryIds(const BasicEnv& env,
+                             const BasicKin& kin,
+                             const NameRegistryConstPtr& manager_link_registry,
+                             std::vector<int>& joint_ids,
+                             std::vector<int>& link_ids)
+{
+  NameRegistryConstPtr link_registry = env.getLinkRegistry();
+  if (link_registry == nullptr || manager_link_registry != link_registry)
+    return false;
+
+  NameRegistryConstPtr joint_registry = env.getJointRegistry();
+  joint_ids.reserve(kin.getJointNames().size());
+  for (const auto& joint_name : kin.getJointNames())
+    joint_ids.push_back(joint_registry->find(joint_name));
+
+  link_ids.reserve(kin.getLinkNames().size());
+  for (const auto& link_name : kin.getLinkNames())
+    link_ids.push_back(link_registry->find(link_name));
+
+  return true;
+}
+
+/**
+ * @brief Calculate the state of the environment at a trajectory waypoint
+ * @param env The environment
+ * @param kin The kinematic object the trajectory belongs to
+ * @param use_ids If true only the id indexed members of the state are calculated (see getTrajectoryIds)
+ * @param joint_ids The joint ids, only used if use_ids is true
+ * @param joint_values The joint values of the waypoint
+ * @return The state of the environment
+ */
+inline EnvStatePtr getTrajectoryState(const BasicEnv& env,
+                                      const BasicKin& kin,
+                                      bool use_ids,
+                                      const std::vector<int>& joint_ids,
+                                      const Eigen::Ref<const Eigen::VectorXd>& joint_values)
+{
+  if (use_ids)
+    return env.getState(joint_ids, joint_values);
+
+  return env.getState(kin.getJointNames(), joint_values);
+}
+
+/**
+ * @brief Set the start and end transforms of the links for a trajectory segment
+ * @param manager A continuous contact manager
+ * @param kin The kinematic object the trajectory belongs to
+ * @param use_ids If true the links are identified by link_ids, otherwise by name
+ * @param link_ids The link ids, only used if use_ids is true
+ * @param state0 The state at the start of the segment
+ * @param state1 The state at the end of the segment
+ */
+inline void setTrajectorySegmentTransforms(ContinuousContactManagerBase& manager,
+                                           const BasicKin& kin,
+                                           bool use_ids,
+                                           const std::vector<int>& link_ids,
+                                           const EnvState& state0,
+                                           const EnvState& state1)
+{
+  if (use_ids)
+  {
+    for (const auto& link_id : link_ids)
+      manager.setCollisionObjectsTransform(link_id,
+                                           state0.link_transforms[static_cast<std::size_t>(link_id)],
+                                           state1.link_transforms[static_cast<std::size_t>(link_id)]);
+  }
+  else
+  {
+    for (const auto& link_name : kin.getLinkNames())
+      manager.setCollisionObjectsTransform(link_name, state0.transforms.at(link_name), state1.transforms.at(link_name));
+  }
+}
+
+/**
+ * @brief Set the transforms of the links swept over a window of consecutive trajectory waypoints
+ * @param manager A continuous contact manager
+ * @param kin The kinematic object the trajectory belongs to
+ * @param use_ids If true the links are identified by link_ids, otherwise by name
+ * @param link_ids The link ids, only used if use_ids is true
+ * @param states The states at the waypoints of the window, at least two
+ */
+inline void setTrajectoryWindowTransforms(ContinuousContactManagerBase& manager,
+                                          const BasicKin& kin,
+                                          bool use_ids,
+                                          const std::vector<int>& link_ids,
+                                          const std::vector<EnvStatePtr>& states)
+{
+  VectorIsometry3d poses(states.size());
+  if (use_ids)
+  {
+    for (const auto& link_id : link_ids)
+    {
+      for (std::size_t i = 0; i < states.size(); ++i)
+        poses[i] = states[i]->link_transforms[static_cast<std::size_t>(link_id)];
+
+      manager.setCollisionObjectsSweptTransform(link_id, poses);
+    }
+  }
+  else
+  {
+    for (const auto& link_name : kin.getLinkNames())
+    {
+      for (std::size_t i = 0; i < states.size(); ++i)
+        poses[i] = states[i]->transforms.at(link_name);
+
+      manager.setCollisionObjectsSweptTransform(link_name, poses);
+    }
+  }
+}
+
 /**
  * @brief continuousCollisionCheckTrajectory Should perform a continuous collision check over the trajectory
  * and stop on first collision.
+ *
+ * If window_size is larger than one the links are first swept over windows of that many segments, only the
+ * segments of windows which are not collision free as a whole are checked one by one. The results are the same,
+ * mostly collision free trajectories need fewer contact tests.
+ *
  * @param manager A continuous contact manager
  * @param env The environment
  * @param joint_names JointNames corresponding to the values in traj (must be in same order)
@@ -258,6 +459,7 @@ typedef std::shared_ptr<const BasicEnv> BasicEnvConstPtr;
  * @param traj The joint values at each time step
  * @param contacts A vector of vector of ContactMap where each indicie corrisponds to a timestep
  * @param first_only Indicates if it should return on first contact
+ * @param window_size The number of segments checked at once before they are checked one by one
  * @return True if collision was found, otherwise false.
  */
 inline bool continuousCollisionCheckTrajectory(ContinuousContactManagerBase& manager,
@@ -265,35 +467,279 @@ inline bool continuousCollisionCheckTrajectory(ContinuousContactManagerBase& man
                                                const BasicKin& kin,
                                                const Eigen::Ref<const TrajArray>& traj,
                                                std::vector<ContactResultMap>& contacts,
-                                               bool first_only = true)
+                                               bool first_only = true,
+                                               long window_size = 1)
 {
   bool found = false;
-  const std::vector<std::string>& joint_names = kin.getJointNames();
-  const std::vector<std::string>& link_names = kin.getLinkNames();
 
-  contacts.reserve(traj.rows() - 1);
-  for (int iStep = 0; iStep < traj.rows() - 1; ++iStep)
+  // Use the dense ids when the manager shares the environments link registry
+  std::vector<int> joint_ids;
+  std::vector<int> link_ids;
+  bool use_ids = getTrajectoryIds(env, kin, manager.getLinkRegistry(), joint_ids, link_ids);
+
+  if (traj.rows() < 2)
+    return found;
+
+  const long num_segments = static_cast<long>(traj.rows()) - 1;
+  contacts.reserve(static_cast<std::size_t>(num_segments));
+
+  // The states of the waypoints of the current window, the last one is the first one of the next window
+  std::vector<EnvStatePtr> states(1, getTrajectoryState(env, kin, use_ids, joint_ids, traj.row(0)));
+  for (long begin = 0, end = 0; begin < num_segments; begin = end)
   {
-    ContactResultMap collisions;
+    end = std::min(begin + std::max(window_size, 1L), num_segments);
+    states.erase(states.begin(), states.end() - 1);
+    for (long iStep = begin; iStep < end; ++iStep)
+      states.push_back(getTrajectoryState(env, kin, use_ids, joint_ids, traj.row(iStep + 1)));
+
+    // The segments of a window which is collision free as a whole have no contacts
+    if (end - begin > 1)
+    {
+      setTrajectoryWindowTransforms(manager, kin, use_ids, link_ids, states);
+      if (manager.isCollisionFree())
+      {
+        contacts.resize(contacts.size() + static_cast<std::size_t>(end - begin));
+        continue;
+      }
+    }
+
+    for (long iStep = begin; iStep < end; ++iStep)
+    {
+      ContactResultMap collisions;
+
+      const std::size_t i = static_cast<std::size_t>(iStep - begin);
+      setTrajectorySegmentTransforms(manager, kin, use_ids, link_ids, *states[i], *states[i + 1]);
+
+      manager.contactTest(collisions);
+
+      if (collisions.size() > 0)
+        found = true;
+
+      contacts.push_back(collisions);
+
+      if (found && first_only)
+        return found;
+    }
+  }
 
-    EnvStatePtr state0 = env.getState(joint_names, traj.row(iStep));
-    EnvStatePtr state1 = env.getState(joint_names, traj.row(iStep + 1));
+  return found;
+}
 
-    for (const auto& link_name : link_names)
-      manager.setCollisionObjectsTransform(link_name, state0->transforms[link_name], state1->transforms[link_name]);
+/**
+ * @brief Perform a continuous collision check over the trajectory with the segments split across threads
+ *
+ * Each thread checks a contiguous range of segments with its own clone of the manager,
+ * so the state at the end of a segment is reused as the start of the next. When only the
+ * first contact is requested the threads stop checking segments after the first segment
+ * found in collision, and the results match continuousCollisionCheckTrajectory.
+ *
+ * @param manager A continuous contact manager, it is cloned for each thread and not modified
+ * @param env The environment
+ * @param kin The kinematic object the trajectory belongs to
+ * @param traj The joint values at each time step
+ * @param contacts A vector of ContactMap where each indicie corrisponds to a segment. If first_only
+ *                 it ends at the first segment in collision, otherwise it has an entry for each segment.
+ * @param first_only Indicates if it should return on first contact
+ * @param num_threads The number of threads to use, zero uses the number of hardware threads
+ * @return True if collision was found, otherwise false.
+ */
+inline bool checkTrajectory(const ContinuousContactManagerBase& manager,
+                            const BasicEnv& env,
+                            const BasicKin& kin,
+                            const Eigen::Ref<const TrajArray>& traj,
+                            std::vector<ContactResultMap>& contacts,
+                            bool first_only = true,
+                            unsigned num_threads = 0)
+{
+  contacts.clear();
+  const long num_segments = static_cast<long>(traj.rows()) - 1;
+  if (num_segments < 1)
+    return false;
+
+  std::vector<int> joint_ids;
+  std::vector<int> link_ids;
+  bool use_ids = getTrajectoryIds(env, kin, manager.getLinkRegistry(), joint_ids, link_ids);
+
+  const long num_workers = getNumWorkerThreads(num_segments, num_threads);
+  std::vector<ContinuousContactManagerBasePtr> managers;
+  managers.reserve(static_cast<std::size_t>(num_workers));
+  for (long i = 0; i < num_workers; ++i)
+    managers.push_back(manager.clone());
+
+  contacts.resize(static_cast<std::size_t>(num_segments));
+  std::atomic<long> first_found(num_segments);
+
+  runWorkerThreads(num_segments, num_workers, [&](long worker_index, long begin, long end) {
+    if (begin >= end)
+      return;
+
+    ContinuousContactManagerBase& worker_manager = *managers[static_cast<std::size_t>(worker_index)];
+    EnvStatePtr state1 = getTrajectoryState(env, kin, use_ids, joint_ids, traj.row(begin));
+    for (long iStep = begin; iStep < end; ++iStep)
+    {
+      // Segments after a known collision are not needed when only the first contact is requested
+      if (first_only && iStep > first_found.load())
+        return;
+
+      EnvStatePtr state0 = state1;
+      state1 = getTrajectoryState(env, kin, use_ids, joint_ids, traj.row(iStep + 1));
+      setTrajectorySegmentTransforms(worker_manager, kin, use_ids, link_ids, *state0, *state1);
+
+      ContactResultMap& collisions = contacts[static_cast<std::size_t>(iStep)];
+      worker_manager.contactTest(collisions);
+
+      if (!collisions.empty())
+      {
+        long current = first_found.load();
+        while (iStep < current && !first_found.compare_exchange_weak(current, iStep))
+        {
+        }
+
+        if (first_only)
+          return;
+      }
+    }
+  });
+
+  bool found = (first_found.load() < num_segments);
+  if (found && first_only)
+    contacts.resize(static_cast<std::size_t>(first_found.load() + 1));
 
-    manager.contactTest(collisions);
+  return found;
+}
 
-    if (collisions.size() > 0)
-      found = true;
+/**
+ * @brief Run a discrete contact test for each state in a batch of states of a kinematic object
+ *
+ * Each thread checks a contiguous range of states with its own clone of the manager, which is
+ * reused for all of its states so manager side caches stay warm. When the manager shares the
+ * environments link registry the state is calculated in place by id, so no state is allocated
+ * per waypoint.
+ *
+ * @param manager A discrete contact manager, it is cloned for each thread and not modified
+ * @param env The environment
+ * @param kin The kinematic object the states belong to
+ * @param states The joint values of each state, one state per row
+ * @param fn The function called as fn(manager, state_index) once the manager is updated to a state
+ * @param num_threads The number of threads to use, zero uses the number of hardware threads
+ */
+template <typename StateFn>
+inline void forEachState(const DiscreteContactManagerBase& manager,
+                         const BasicEnv& env,
+                         const BasicKin& kin,
+                         const Eigen::Ref<const TrajArray>& states,
+                         const StateFn& fn,
+                         unsigned num_threads = 0)
+{
+  const long num_states = static_cast<long>(states.rows());
+  if (num_states < 1)
+    return;
+
+  std::vector<int> joint_ids;
+  std::vector<int> link_ids;
+  bool use_ids = getTrajectoryIds(env, kin, manager.getLinkRegistry(), joint_ids, link_ids);
+
+  const long num_workers = getNumWorkerThreads(num_states, num_threads);
+  std::vector<DiscreteContactManagerBasePtr> managers;
+  managers.reserve(static_cast<std::size_t>(num_workers));
+  for (long i = 0; i < num_workers; ++i)
+    managers.push_back(manager.clone());
+
+  runWorkerThreads(num_states, num_workers, [&](long worker_index, long begin, long end) {
+    DiscreteContactManagerBase& worker_manager = *managers[static_cast<std::size_t>(worker_index)];
+    EnvState state;
+    for (long i = begin; i < end; ++i)
+    {
+      if (use_ids)
+      {
+        env.getState(state, joint_ids, states.row(i));
+        for (const auto& link_id : link_ids)
+        {
+          const Eigen::Isometry3d& pose = state.link_transforms[static_cast<std::size_t>(link_id)];
+          worker_manager.setCollisionObjectsTransform(link_id, pose);
+        }
+      }
+      else
+      {
+        EnvStatePtr named_state = env.getState(kin.getJointNames(), states.row(i));
+        for (const auto& link_name : kin.getLinkNames())
+          worker_manager.setCollisionObjectsTransform(link_name, named_state->transforms.at(link_name));
+      }
+
+      fn(worker_manager, i);
+    }
+  });
+}
 
-    contacts.push_back(collisions);
+/**
+ * @brief Check which states in a batch of states of a kinematic object are collision free
+ *
+ * This uses DiscreteContactManagerBase::isCollisionFree, so no contact data is computed.
+ *
+ * @param manager A discrete contact manager, it is cloned for each thread and not modified
+ * @param env The environment
+ * @param kin The kinematic object the states belong to
+ * @param states The joint values of each state, one state per row
+ * @param collision_free (Output) True for each state without contacts, same order as the states
+ * @param num_threads The number of threads to use, zero uses the number of hardware threads
+ * @return True if all states are collision free, otherwise false.
+ */
+inline bool checkStatesCollisionFree(const DiscreteContactManagerBase& manager,
+                                     const BasicEnv& env,
+                                     const BasicKin& kin,
+                                     const Eigen::Ref<const TrajArray>& states,
+                                     std::vector<bool>& collision_free,
+                                     unsigned num_threads = 0)
+{
+  // std::vector<bool> can not be written from several threads
+  std::vector<char> results(static_cast<std::size_t>(states.rows()), 0);
+  forEachState(manager,
+               env,
+               kin,
+               states,
+               [&](DiscreteContactManagerBase& state_manager, long i) {
+                 results[static_cast<std::size_t>(i)] = state_manager.isCollisionFree();
+               },
+               num_threads);
+
+  collision_free.assign(results.begin(), results.end());
+  return std::find(results.begin(), results.end(), 0) == results.end();
+}
 
-    if (found && first_only)
-      break;
+/**
+ * @brief Run a discrete contact test for each state in a batch of states of a kinematic object
+ * @param manager A discrete contact manager, it is cloned for each thread and not modified
+ * @param env The environment
+ * @param kin The kinematic object the states belong to
+ * @param states The joint values of each state, one state per row
+ * @param contacts (Output) The contact results of each state, same order as the states
+ * @param num_threads The number of threads to use, zero uses the number of hardware threads
+ * @return True if collision was found, otherwise false.
+ */
+inline bool checkStates(const DiscreteContactManagerBase& manager,
+                        const BasicEnv& env,
+                        const BasicKin& kin,
+                        const Eigen::Ref<const TrajArray>& states,
+                        std::vector<ContactResultMap>& contacts,
+                        unsigned num_threads = 0)
+{
+  contacts.clear();
+  contacts.resize(static_cast<std::size_t>(states.rows()));
+  forEachState(manager,
+               env,
+               kin,
+               states,
+               [&](DiscreteContactManagerBase& state_manager, long i) {
+                 state_manager.contactTest(contacts[static_cast<std::size_t>(i)]);
+               },
+               num_threads);
+
+  for (const auto& state_contacts : contacts)
+  {
+    if (!state_contacts.empty())
+      return true;
   }
-
-  return found;
+  return false;
 }
 
 }  // namespace tesseract
@@ -31,10 +31,15 @@
 #include <Eigen/StdVector>
 #include <geometric_shapes/shapes.h>
 #include <unordered_map>
+#include <deque>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <functional>
 #include <map>
+#include <mutex>
 
 
 namespace tesseract
@@ -52,8 +57,85 @@ using TransformMap = AlignedMap<std::string, Eigen::Isometry3d>;
 
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> TrajArray;
 
+/**
+ * @brief Interns names (links, joints, ...) and hands out stable dense integer ids.
+ *
+ * Ids start at zero, are assigned in the order names are first seen and are never
+ * reused, so they can be used to index flat arrays instead of looking up strings.
+ * The registry is shared between an environment and its contact managers, so
+ * access is guarded by a mutex. It is meant to be used when objects are added,
+ * the hot paths should cache the ids and index their own arrays.
+ */
+class NameRegistry
+{
+public:
+  NameRegistry() = default;
+  NameRegistry(const NameRegistry&) = delete;
+  NameRegistry& operator=(const NameRegistry&) = delete;
+
+  /**
+   * @brief Get the id of a name, adding it to the registry if it does not exist
+   * @param name The name to intern
+   * @return The id of the name
+   */
+  int intern(const std::string& name)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = name_to_id_.find(name);
+    if (it != name_to_id_.end())
+      return it->second;
+
+    int id = static_cast<int>(names_.size());
+    names_.push_back(name);
+    name_to_id_[name] = id;
+    return id;
+  }
+
+  /**
+   * @brief Get the id of a name
+   * @param name The name to search for
+   * @return The id of the name, or -1 if the name is not in the registry
+   */
+  int find(const std::string& name) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = name_to_id_.find(name);
+    return (it != name_to_id_.end()) ? it->second : -1;
+  }
+
+  /**
+   * @brief Get the name associated with an id
+   * @param id The id returned by intern()
+   * @return The name
+   */
+  const std::string& getName(int id) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(id >= 0 && static_cast<std::size_t>(id) < names_.size());
+    return names_[static_cast<std::size_t>(id)];
+  }
+
+  /** @brief Get the number of ids handed out so far */
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_.size();
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::deque<std::string> names_; /**< @brief Names indexed by id (deque keeps references stable on growth) */
+  std::unordered_map<std::string, int> name_to_id_;
+};
+typedef std::shared_ptr<NameRegistry> NameRegistryPtr;
+typedef std::shared_ptr<const NameRegistry> NameRegistryConstPtr;
+
+/** @brief The allowed collision pairs, entries[link_name1][link_name2] = reason (stored in both orders) */
+typedef std::unordered_map<std::string, std::unordered_map<std::string, std::string>> AllowedCollisionEntries;
+
 struct AllowedCollisionMatrix
 {
+  AllowedCollisionMatrix() : revision_(0) {}
   virtual ~AllowedCollisionMatrix() {}
 
   /**
@@ -66,8 +148,9 @@ struct AllowedCollisionMatrix
                                    const std::string& link_name2,
                                    const std::string& reason)
   {
-    lookup_table_[link_name1 + link_name2] = reason;
-    lookup_table_[link_name2 + link_name1] = reason;
+    lookup_table_[link_name1][link_name2] = reason;
+    lookup_table_[link_name2][link_name1] = reason;
+    ++revision_;
   }
 
   /**
@@ -77,8 +160,9 @@ struct AllowedCollisionMatrix
    */
   virtual void removeAllowedCollision(const std::string& link_name1, const std::string& link_name2)
   {
-    lookup_table_.erase(link_name1 + link_name2);
-    lookup_table_.erase(link_name2 + link_name1);
+    removeEntry(link_name1, link_name2);
+    removeEntry(link_name2, link_name1);
+    ++revision_;
   }
 
   /**
@@ -89,15 +173,134 @@ struct AllowedCollisionMatrix
    */
   virtual bool isCollisionAllowed(const std::string& link_name1, const std::string& link_name2) const
   {
-    return (lookup_table_.find(link_name1 + link_name2) != lookup_table_.end());
+    auto it = lookup_table_.find(link_name1);
+    return (it != lookup_table_.end() && it->second.find(link_name2) != it->second.end());
   }
 
+  /** @brief Get all of the allowed collision pairs */
+  const AllowedCollisionEntries& getAllAllowedCollisions() const { return lookup_table_; }
+
+  /** @brief Get a counter which is incremented every time the matrix is modified */
+  unsigned long getRevision() const { return revision_; }
+
 private:
-  std::unordered_map<std::string, std::string> lookup_table_;
+  AllowedCollisionEntries lookup_table_;
+  unsigned long revision_;
+
+  void removeEntry(const std::string& link_name1, const std::string& link_name2)
+  {
+    auto it = lookup_table_.find(link_name1);
+    if (it == lookup_table_.end())
+      return;
+
+    it->second.erase(link_name2);
+    if (it->second.empty())
+      lookup_table_.erase(it);
+  }
 };
 typedef std::shared_ptr<AllowedCollisionMatrix> AllowedCollisionMatrixPtr;
 typedef std::shared_ptr<const AllowedCollisionMatrix> AllowedCollisionMatrixConstPtr;
 
+/**
+ * @brief An allowed collision matrix compiled into a packed symmetric bit matrix indexed by link id.
+ *
+ * Only the lower triangle is stored, so growing the matrix keeps the existing
+ * entries. Lookups do not allocate or hash, which makes it suitable for the
+ * per pair checks done during the broadphase.
+ */
+class AllowedCollisionBitMatrix
+{
+public:
+  AllowedCollisionBitMatrix() : size_(0) {}
+
+  /**
+   * @brief Resize the matrix, new entries are not allowed in collision
+   * @param size The number of link ids
+   */
+  void resize(std::size_t size)
+  {
+    if (size < size_)
+    {
+      for (std::size_t i = size; i < size_; ++i)
+        clearCollisionsAllowed(static_cast<int>(i));
+    }
+
+    size_ = size;
+    bits_.resize((bitIndex(size_, 0) + 63) / 64, 0);
+  }
+
+  /** @brief Get the number of link ids */
+  std::size_t size() const { return size_; }
+
+  /** @brief Set all entries to not allowed in collision */
+  void clear() { std::fill(bits_.begin(), bits_.end(), 0); }
+
+  /**
+   * @brief Set if two links are allowed to be in collision, the matrix grows if needed
+   * @param id1 First link id
+   * @param id2 Second link id
+   * @param allowed True if allowed to be in collision
+   */
+  void setCollisionAllowed(int id1, int id2, bool allowed)
+  {
+    assert(id1 >= 0 && id2 >= 0);
+    std::size_t required = static_cast<std::size_t>(std::max(id1, id2)) + 1;
+    if (required > size_)
+      resize(required);
+
+    std::size_t idx = bitIndex(static_cast<std::size_t>(id1), static_cast<std::size_t>(id2));
+    if (allowed)
+      bits_[idx >> 6] |= (std::uint64_t(1) << (idx & 63));
+    else
+      bits_[idx >> 6] &= ~(std::uint64_t(1) << (idx & 63));
+  }
+
+  /**
+   * @brief Set all of the entries of a link to not allowed in collision
+   * @param id The link id
+   */
+  void clearCollisionsAllowed(int id)
+  {
+    if (id < 0 || static_cast<std::size_t>(id) >= size_)
+      return;
+
+    for (std::size_t i = 0; i < size_; ++i)
+    {
+      std::size_t idx = bitIndex(static_cast<std::size_t>(id), i);
+      bits_[idx >> 6] &= ~(std::uint64_t(1) << (idx & 63));
+    }
+  }
+
+  /**
+   * @brief This checks if two links are allowed to be in collision
+   * @param id1 First link id
+   * @param id2 Second link id
+   * @return True if allowed to be in collision, otherwise false (also for ids outside the matrix)
+   */
+  bool isCollisionAllowed(int id1, int id2) const
+  {
+    if (id1 < 0 || id2 < 0 || static_cast<std::size_t>(id1) >= size_ || static_cast<std::size_t>(id2) >= size_)
+      return false;
+
+    std::size_t idx = bitIndex(static_cast<std::size_t>(id1), static_cast<std::size_t>(id2));
+    return (bits_[idx >> 6] >> (idx & 63)) & 1;
+  }
+
+private:
+  std::size_t size_;               /**< @brief The number of link ids */
+  std::vector<std::uint64_t> bits_; /**< @brief The packed lower triangle (including the diagonal) */
+
+  static std::size_t bitIndex(std::size_t i, std::size_t j)
+  {
+    if (i < j)
+      std::swap(i, j);
+
+    return (i * (i + 1)) / 2 + j;
+  }
+};
+typedef std::shared_ptr<AllowedCollisionBitMatrix> AllowedCollisionBitMatrixPtr;
+typedef std::shared_ptr<const AllowedCollisionBitMatrix> AllowedCollisionBitMatrixConstPtr;
+
 /**
  * @brief Should return true if contact allowed, otherwise false.
  *
@@ -115,8 +318,9 @@ enum CollisionObjectType
   ConvexHull =
       1, /**< @brief Use the mesh in shapes::Shape but make it a convex hulls collision object. (if not convex it will
             be converted) */
-  MultiSphere = 2, /**< @brief Use the mesh and represent it by multiple spheres collision object */
-  SDF = 3          /**< @brief Use the mesh and rpresent it by a signed distance fields collision object */
+  MultiSphere = 2,        /**< @brief Use the mesh and represent it by multiple spheres collision object */
+  SDF = 3,                /**< @brief Use the mesh and rpresent it by a signed distance fields collision object */
+  ConvexDecomposition = 4 /**< @brief Use the mesh and represent it by multiple convex hulls collision object */
 };
 }
 typedef CollisionObjectTypes::CollisionObjectType CollisionObjectType;
@@ -164,7 +368,21 @@ struct ContactRequest
   std::vector<std::string> link_names; /**< Name of the links to calculate distance data for. */
   IsContactAllowedFn isContactAllowed; /**< The allowed collision matrix */
 
-  ContactRequest() : type(ContactRequestType::CLOSEST), contact_distance(0.0) {}
+  /**
+   * @brief Optional compiled allowed collision matrix indexed by link id (see BasicEnv::getAllowedCollisionBitMatrix)
+   *
+   * When set it is used instead of isContactAllowed for objects which have a link id, so it must
+   * use the same link registry as the contact manager.
+   */
+  AllowedCollisionBitMatrixConstPtr allowed_collision_matrix;
+
+  std::size_t max_contacts_per_pair; /**< The maximum number of contacts stored for a pair of objects (LIMITED only) */
+  std::size_t max_total_contacts; /**< The maximum number of contacts stored, zero for no limit (LIMITED only) */
+
+  ContactRequest()
+    : type(ContactRequestType::CLOSEST), contact_distance(0.0), max_contacts_per_pair(1), max_total_contacts(0)
+  {
+  }
 };
 
 struct ContactResult
@@ -172,6 +390,7 @@ struct ContactResult
   double distance;
   int type_id[2];
   std::string link_names[2];
+  int link_ids[2]; /**< @brief The link ids from the managers link registry (-1 if unknown) */
   Eigen::Vector3d nearest_points[2];
   Eigen::Vector3d normal;
   Eigen::Vector3d cc_nearest_points[2];
@@ -187,6 +406,8 @@ struct ContactResult
     nearest_points[1].setZero();
     link_names[0] = "";
     link_names[1] = "";
+    link_ids[0] = -1;
+    link_ids[1] = -1;
     type_id[0] = 0;
     type_id[1] = 0;
     normal.setZero();
@@ -199,18 +420,309 @@ struct ContactResult
 typedef std::vector<ContactResult> ContactResultVector;
 typedef std::map<std::pair<std::string, std::string>, ContactResultVector> ContactResultMap;
 
+/**
+ * @brief Contact results keyed by the (ordered) pair of link ids
+ *
+ * The link_names of the contained results are not populated, use the link registry to look them up.
+ */
+typedef std::map<std::pair<int, int>, ContactResultVector> ContactResultIdMap;
+
+/**
+ * @brief A compact contact result stored in a ContactResultBuffer
+ *
+ * The links are identified by the link ids from the managers link registry.
+ */
+struct ContactRecord
+{
+  double distance;
+  int type_id[2];
+  int link_ids[2];
+  Eigen::Vector3d nearest_points[2];
+  Eigen::Vector3d normal;
+  Eigen::Vector3d cc_nearest_points[2];
+  double cc_time;
+  ContinouseCollisionType cc_type;
+  int next; /**< @brief Index of the next record of the same pair of links (-1 if this is the last) */
+
+  /** @brief Copy the data of a contact result, the link names are dropped */
+  void assign(const ContactResult& contact)
+  {
+    distance = contact.distance;
+    type_id[0] = contact.type_id[0];
+    type_id[1] = contact.type_id[1];
+    link_ids[0] = contact.link_ids[0];
+    link_ids[1] = contact.link_ids[1];
+    nearest_points[0] = contact.nearest_points[0];
+    nearest_points[1] = contact.nearest_points[1];
+    normal = contact.normal;
+    cc_nearest_points[0] = contact.cc_nearest_points[0];
+    cc_nearest_points[1] = contact.cc_nearest_points[1];
+    cc_time = contact.cc_time;
+    cc_type = contact.cc_type;
+  }
+};
+
+/**
+ * @brief Contact results stored in a flat array of compact records
+ *
+ * Unlike ContactResultMap this does not allocate per pair or per contact once
+ * it has grown to the size of the typical query. Clearing the buffer keeps
+ * its capacity, so it is intended to be reused across contact tests. The
+ * records of each pair of links are chained through ContactRecord::next and
+ * can be reached through the pair index.
+ */
+class ContactResultBuffer
+{
+public:
+  /** @brief Remove all results, the capacity is kept */
+  void clear()
+  {
+    records_.clear();
+    pair_first_.clear();
+    pair_last_.clear();
+    pair_count_.clear();
+    std::fill(table_.begin(), table_.end(), -1);
+  }
+
+  /**
+   * @brief Reserve space for a number of records
+   * @param size The number of records
+   */
+  void reserve(std::size_t size) { records_.reserve(size); }
+
+  /** @brief Get the number of records */
+  std::size_t size() const { return records_.size(); }
+
+  /** @brief Check if the buffer contains no records */
+  bool empty() const { return records_.empty(); }
+
+  const ContactRecord& operator[](std::size_t i) const { return records_[i]; }
+  std::vector<ContactRecord>::const_iterator begin() const { return records_.begin(); }
+  std::vector<ContactRecord>::const_iterator end() const { return records_.end(); }
+
+  /** @brief Get the number of pairs of links which have records */
+  std::size_t getPairCount() const { return pair_first_.size(); }
+
+  /**
+   * @brief Get the first record of a pair of links, the others are found following ContactRecord::next
+   * @param pair_index The index of the pair in the order they were first stored
+   */
+  const ContactRecord& getPairRecord(std::size_t pair_index) const { return records_[pair_first_[pair_index]]; }
+
+  /**
+   * @brief Find the first record of a pair of links
+   * @param id1 The first link id
+   * @param id2 The second link id
+   * @return The first record of the pair, nullptr if the pair has no records
+   */
+  const ContactRecord* find(int id1, int id2) const
+  {
+    if (table_.empty())
+      return nullptr;
+
+    int pair = table_[findSlot(id1, id2)];
+    return (pair < 0) ? nullptr : &records_[pair_first_[pair]];
+  }
+
+  /**
+   * @brief Get the number of records of a pair of links
+   * @param id1 The first link id
+   * @param id2 The second link id
+   * @return The number of records
+   */
+  std::size_t getPairContactCount(int id1, int id2) const
+  {
+    if (table_.empty())
+      return 0;
+
+    int pair = table_[findSlot(id1, id2)];
+    return (pair < 0) ? 0 : pair_count_[pair];
+  }
+
+  /**
+   * @brief Store a contact according to the request type
+   *
+   * The first contact of a pair is always stored. Later contacts are appended for
+   * ALL requests, appended up to the max_contacts_per_pair for LIMITED requests and
+   * replace the stored one if closer for CLOSEST requests.
+   *
+   * @param contact The contact, it must have its link ids populated
+   * @param req The contact request
+   * @return True if the contact was stored, otherwise false
+   */
+  bool add(const ContactResult& contact, const ContactRequest& req)
+  {
+    ContactRequestType type = req.type;
+    if ((pair_first_.size() + 1) * 2 > table_.size())
+      rehash(std::max<std::size_t>(16, table_.size() * 2));
+
+    std::size_t slot = findSlot(contact.link_ids[0], contact.link_ids[1]);
+    int pair = table_[slot];
+    if (pair < 0)
+    {
+      table_[slot] = static_cast<int>(pair_first_.size());
+      pair_first_.push_back(static_cast<int>(records_.size()));
+      pair_last_.push_back(static_cast<int>(records_.size()));
+      pair_count_.push_back(1);
+      push(contact);
+      return true;
+    }
+
+    if (type == ContactRequestType::ALL ||
+        (type == ContactRequestType::LIMITED && pair_count_[pair] < req.max_contacts_per_pair))
+    {
+      records_[pair_last_[pair]].next = static_cast<int>(records_.size());
+      pair_last_[pair] = static_cast<int>(records_.size());
+      ++pair_count_[pair];
+      push(contact);
+      return true;
+    }
+
+    if (type == ContactRequestType::CLOSEST)
+    {
+      ContactRecord& record = records_[pair_first_[pair]];
+      if (contact.distance < record.distance)
+      {
+        record.assign(contact);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+private:
+  std::vector<ContactRecord> records_; /**< @brief The records in the order they were stored */
+  std::vector<int> pair_first_;        /**< @brief The index of the first record of each pair */
+  std::vector<int> pair_last_;         /**< @brief The index of the last record of each pair */
+  std::vector<std::size_t> pair_count_; /**< @brief The number of records of each pair */
+  std::vector<int> table_; /**< @brief Open addressing hash table from a pair of link ids to the pair index */
+
+  void push(const ContactResult& contact)
+  {
+    records_.emplace_back();
+    records_.back().assign(contact);
+    records_.back().next = -1;
+  }
+
+  static std::uint64_t pairKey(int id1, int id2)
+  {
+    std::uint32_t a = static_cast<std::uint32_t>(std::min(id1, id2));
+    std::uint32_t b = static_cast<std::uint32_t>(std::max(id1, id2));
+    return (static_cast<std::uint64_t>(a) << 32) | b;
+  }
+
+  std::size_t findSlot(int id1, int id2) const
+  {
+    std::uint64_t key = pairKey(id1, id2);
+    std::size_t mask = table_.size() - 1;
+    std::size_t slot = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (table_[slot] >= 0)
+    {
+      const ContactRecord& record = records_[pair_first_[table_[slot]]];
+      if (pairKey(record.link_ids[0], record.link_ids[1]) == key)
+        break;
+
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  void rehash(std::size_t size)
+  {
+    table_.assign(size, -1);
+    for (std::size_t i = 0; i < pair_first_.size(); ++i)
+    {
+      const ContactRecord& record = records_[pair_first_[i]];
+      table_[findSlot(record.link_ids[0], record.link_ids[1])] = static_cast<int>(i);
+    }
+  }
+};
+typedef std::shared_ptr<ContactResultBuffer> ContactResultBufferPtr;
+
+/**
+ * @brief Statistics collected by a contact manager during its contact tests
+ *
+ * The broadphase time is all of the time spent outside of the narrowphase, which
+ * includes the broadphase traversal, the filtering of pairs and storing results.
+ */
+struct ContactTestStatistics
+{
+  std::size_t num_contact_tests;    /**< @brief The number of contact tests */
+  std::size_t num_broadphase_pairs; /**< @brief The number of pairs found by the broadphase */
+  std::size_t num_filter_rejected;  /**< @brief Pairs rejected because they are disabled or by the filter masks */
+  std::size_t num_acm_rejected;     /**< @brief Pairs rejected because they are allowed in collision */
+  std::size_t num_narrowphase;      /**< @brief The number of narrowphase algorithm invocations */
+  std::size_t num_results;          /**< @brief The number of contact results stored */
+  double total_time;                /**< @brief The wall time spent in contact tests (seconds) */
+  double broadphase_time;           /**< @brief The wall time spent outside of the narrowphase (seconds) */
+  double narrowphase_time;          /**< @brief The wall time spent in the narrowphase (seconds) */
+
+  /** @brief The number of narrowphase invocations per (ordered) pair of backend specific shape types */
+  std::map<std::pair<int, int>, std::size_t> narrowphase_shape_types;
+
+  ContactTestStatistics() { clear(); }
+
+  /** @brief Reset all of the counters and times */
+  void clear()
+  {
+    num_contact_tests = 0;
+    num_broadphase_pairs = 0;
+    num_filter_rejected = 0;
+    num_acm_rejected = 0;
+    num_narrowphase = 0;
+    num_results = 0;
+    total_time = 0;
+    broadphase_time = 0;
+    narrowphase_time = 0;
+    narrowphase_shape_types.clear();
+  }
+};
+
 /// Destance query results information
 struct ContactDistanceData
 {
-  ContactDistanceData(const ContactRequest* req, ContactResultMap* res) : req(req), res(res), done(false) {}
+  /** @brief Only determine if there is any contact, no results are stored and the search stops at the first contact */
+  explicit ContactDistanceData(const ContactRequest* req)
+    : req(req), res(nullptr), id_res(nullptr), buffer_res(nullptr), num_contacts(0), stats(nullptr), done(false)
+  {
+  }
+  ContactDistanceData(const ContactRequest* req, ContactResultMap* res)
+    : req(req), res(res), id_res(nullptr), buffer_res(nullptr), num_contacts(0), stats(nullptr), done(false)
+  {
+  }
+  ContactDistanceData(const ContactRequest* req, ContactResultIdMap* id_res)
+    : req(req), res(nullptr), id_res(id_res), buffer_res(nullptr), num_contacts(0), stats(nullptr), done(false)
+  {
+  }
+  ContactDistanceData(const ContactRequest* req, ContactResultBuffer* buffer_res)
+    : req(req), res(nullptr), id_res(nullptr), buffer_res(buffer_res), num_contacts(0), stats(nullptr), done(false)
+  {
+  }
+
   /// Distance query request information
   const ContactRequest* req;
 
-  /// Destance query results information
+  /// Destance query results information (keyed by link names)
   ContactResultMap* res;
 
+  /// Destance query results information (keyed by link ids), only one of res, id_res and buffer_res is set
+  ContactResultIdMap* id_res;
+
+  /// Destance query results information (compact records identified by link ids)
+  ContactResultBuffer* buffer_res;
+
+  /// The number of contacts stored by this query
+  std::size_t num_contacts;
+
+  /// The statistics to update, nullptr if they are not collected
+  ContactTestStatistics* stats;
+
   /// Indicate if search is finished
   bool done;
+
+  /** @brief Check if the contacts are stored, if not the contact data does not need to be computed */
+  bool storesResults() const { return res != nullptr || id_res != nullptr || buffer_res != nullptr; }
 };
 
 static inline void moveContactResultsMapToContactResultsVector(ContactResultMap& contact_map,
@@ -225,11 +737,60 @@ static inline void moveContactResultsMapToContactResultsVector(ContactResultMap&
     std::move(contact.second.begin(), contact.second.end(), std::back_inserter(contact_vector));
 }
 
+static inline void moveContactResultsMapToContactResultsVector(ContactResultIdMap& contact_map,
+                                                               ContactResultVector& contact_vector)
+{
+  std::size_t size = 0;
+  for (const auto& contact : contact_map)
+    size += contact.second.size();
+
+  contact_vector.reserve(size);
+  for (auto& contact : contact_map)
+    std::move(contact.second.begin(), contact.second.end(), std::back_inserter(contact_vector));
+}
+
+/**
+ * @brief Copy the records of a contact result buffer to contact results
+ *
+ * The vector is resized to the number of records and its elements are overwritten,
+ * so reusing it across calls avoids reallocating the link name strings.
+ *
+ * @param buffer The contact result buffer
+ * @param link_registry The link registry used to assign the link ids
+ * @param contact_vector The contact results
+ */
+inline void copyContactResultBufferToContactResultsVector(const ContactResultBuffer& buffer,
+                                                          const NameRegistry& link_registry,
+                                                          ContactResultVector& contact_vector)
+{
+  contact_vector.resize(buffer.size());
+  for (std::size_t i = 0; i < buffer.size(); ++i)
+  {
+    const ContactRecord& record = buffer[i];
+    ContactResult& contact = contact_vector[i];
+    contact.distance = record.distance;
+    for (int j = 0; j < 2; ++j)
+    {
+      contact.type_id[j] = record.type_id[j];
+      contact.link_ids[j] = record.link_ids[j];
+      contact.link_names[j] = (record.link_ids[j] >= 0) ? link_registry.getName(record.link_ids[j]) : "";
+      contact.nearest_points[j] = record.nearest_points[j];
+      contact.cc_nearest_points[j] = record.cc_nearest_points[j];
+    }
+    contact.normal = record.normal;
+    contact.cc_time = record.cc_time;
+    contact.cc_type = record.cc_type;
+  }
+}
+
 /** @brief This holds a state of the environment */
 struct EnvState
 {
   std::unordered_map<std::string, double> joints;
   TransformMap transforms;
+
+  std::vector<double> joint_values;  /**< @brief Joint values indexed by the environments joint id */
+  VectorIsometry3d link_transforms;  /**< @brief Link transforms indexed by the environments link id */
 };
 typedef std::shared_ptr<EnvState> EnvStatePtr;
 typedef std::shared_ptr<const EnvState> EnvStateConstPtr;
@@ -99,6 +99,22 @@ public:
    */
   virtual bool disableCollisionObject(const std::string& name) = 0;
 
+  /**
+   * @brief Mark voxels of the octomaps of an object occupied or free
+   *
+   * The octomaps of the object are never modified. The manager replaces them by updated copies, which only it uses,
+   * so contact tests of clones running on other threads keep a consistent view of the previous octomaps. Only the
+   * changed voxels are processed to update the collision geometry, instead of removing and adding the object.
+   *
+   * @param name The name of the object
+   * @param occupied_voxels The centers of the voxels to mark occupied, in the frame of the octomap
+   * @param free_voxels The centers of the voxels to mark free, in the frame of the octomap
+   * @return true if the object has an octomap which was updated, otherwise false.
+   */
+  virtual bool updateCollisionObjectOcTree(const std::string& name,
+                                           const VectorVector3d& occupied_voxels,
+                                           const VectorVector3d& free_voxels) = 0;
+
   /**
    * @brief Set a single static collision object's tansforms
    * @param name The name of the object
@@ -120,6 +136,29 @@ public:
    */
   virtual void setCollisionObjectsTransform(const TransformMap& transforms) = 0;
 
+  /**
+   * @brief Set a single static collision object's tansforms
+   * @param link_id The link id of the object (see getLinkRegistry())
+   * @param pose The tranformation in world
+   */
+  virtual void setCollisionObjectsTransform(int link_id, const Eigen::Isometry3d& pose) = 0;
+
+  /**
+   * @brief Set a series of static collision object's tranforms
+   * @param link_ids The link ids of the objects (see getLinkRegistry())
+   * @param poses The tranformation in world
+   */
+  virtual void setCollisionObjectsTransform(const std::vector<int>& link_ids, const VectorIsometry3d& poses) = 0;
+
+  /**
+   * @brief Set the tranforms of all static collision objects from a vector indexed by link id
+   *
+   * This avoids looking up every object. Objects whose link id is not covered by the vector keep their transform.
+   *
+   * @param link_transforms The tranformations in world indexed by link id (see getLinkRegistry())
+   */
+  virtual void setCollisionObjectsTransform(const VectorIsometry3d& link_transforms) = 0;
+
   /**
    * @brief Set a single cast(moving) collision object's tansforms
    *
@@ -159,6 +198,53 @@ public:
    */
   virtual void setCollisionObjectsTransform(const TransformMap& pose1, const TransformMap& pose2) = 0;
 
+  /**
+   * @brief Set a single cast(moving) collision object's tansforms
+   *
+   * This should only be used for moving objects. Use the base
+   * class methods for static objects.
+   *
+   * @param link_id The link id of the object (see getLinkRegistry())
+   * @param pose1 The start tranformation in world
+   * @param pose2 The end tranformation in world
+   */
+  virtual void setCollisionObjectsTransform(int link_id,
+                                            const Eigen::Isometry3d& pose1,
+                                            const Eigen::Isometry3d& pose2) = 0;
+
+  /**
+   * @brief Set a series of cast(moving) collision object's tranforms
+   *
+   * This should only be used for moving objects. Use the base
+   * class methods for static objects.
+   *
+   * @param link_ids The link ids of the objects (see getLinkRegistry())
+   * @param pose1 The start tranformations in world
+   * @param pose2 The end tranformations in world
+   */
+  virtual void setCollisionObjectsTransform(const std::vector<int>& link_ids,
+                                            const VectorIsometry3d& pose1,
+                                            const VectorIsometry3d& pose2) = 0;
+
+  /**
+   * @brief Set a single cast(moving) collision object's tranforms over a window of consecutive poses
+   *
+   * The object is swept over the convex hull of all poses, which contains its motion along every segment of the
+   * window, so a single contact test shows the whole window is collision free. Contacts found this way only tell
+   * that the window may be in collision, the segments of such a window should be checked one by one.
+   *
+   * @param name The name of the object
+   * @param poses The tranformations in world, at least two
+   */
+  virtual void setCollisionObjectsSweptTransform(const std::string& name, const VectorIsometry3d& poses) = 0;
+
+  /**
+   * @brief Set a single cast(moving) collision object's tranforms over a window of consecutive poses
+   * @param link_id The link id of the object (see getLinkRegistry())
+   * @param poses The tranformations in world, at least two
+   */
+  virtual void setCollisionObjectsSweptTransform(int link_id, const VectorIsometry3d& poses) = 0;
+
   /**
    * @brief Set the active contact request information
    * @param req ContactRequest information
@@ -176,6 +262,68 @@ public:
    * @param collisions The Contact results data
    */
   virtual void contactTest(ContactResultMap& collisions) = 0;
+
+  /**
+   * @brief Perform a contact test for all objects based
+   *
+   * Same as above but the results are keyed by link id which avoids string
+   * comparisons and copies while collecting results.
+   *
+   * @param collisions The Contact results data
+   */
+  virtual void contactTest(ContactResultIdMap& collisions) = 0;
+
+  /**
+   * @brief Perform a contact test for all objects based
+   *
+   * Same as above but the results are stored as compact records in a buffer
+   * which keeps its capacity, so reusing it avoids allocations per contact.
+   * The results are added to the buffer, call clear() on it first to reuse it.
+   *
+   * @param collisions The Contact results data
+   */
+  virtual void contactTest(ContactResultBuffer& collisions) = 0;
+
+  /**
+   * @brief Check if there are no contacts for the current request
+   *
+   * This gives the same answer as checking if the results of contactTest are empty,
+   * but it stops at the first contact and does not compute or store any contact data.
+   *
+   * @return True if there are no contacts, otherwise false
+   */
+  virtual bool isCollisionFree() = 0;
+
+  /**
+   * @brief Enable or disable collecting statistics during contact tests, disabled by default
+   * @param enabled True to collect statistics
+   */
+  virtual void setStatisticsEnabled(bool enabled) = 0;
+
+  /** @brief Check if statistics are collected during contact tests */
+  virtual bool isStatisticsEnabled() const = 0;
+
+  /** @brief Get the statistics collected since they were last cleared */
+  virtual const ContactTestStatistics& getStatistics() const = 0;
+
+  /** @brief Reset the collected statistics */
+  virtual void clearStatistics() = 0;
+
+  /**
+   * @brief Set the registry used to assign link ids to the collision objects
+   *
+   * By default a manager owns its own registry. Objects already added are
+   * re-indexed. The registry is shared with clones of this manager.
+   *
+   * @param registry The link registry, usually the one owned by the environment
+   */
+  virtual void setLinkRegistry(NameRegistryPtr registry) = 0;
+
+  /**
+   * @brief Get the registry used to assign link ids to the collision objects
+   * @return The link registry
+   */
+  virtual NameRegistryConstPtr getLinkRegistry() const = 0;
 };
 typedef std::shared_ptr<ContinuousContactManagerBase> ContinuousContactManagerBasePtr;
 typedef std::shared_ptr<const ContinuousContactManagerBase> ContinuousContactManagerBaseConstPtr;
@@ -0,0 +1,230 @@
+/**
+ * @file worker_threads.h
+ * @brief Helpers splitting a batch of work across threads.
+ *
+ * @date Oct 16, 2018
+ * @version TODO
+ * @bug No known bugs
+ *
+ * @copyright Copyright (c) 2017, Southwest Research Institute
+ *
+ * @par License
+ * Software License Agreement (Apache License)
+ * @par
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * @par
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TESSERACT_CORE_WORKER_THREADS_H
+#define TESSERACT_CORE_WORKER_THREADS_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tesseract
+{
+/**
+ * @brief Get the number of worker threads to use for a batch of work
+ * @param size The number of work items
+ * @param num_threads The requested number of threads, zero uses the number of hardware threads
+ * @return The number of worker threads, at least one and at most size
+ */
+inline long getNumWorkerThreads(long size, unsigned num_threads)
+{
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  return std::max(1l, std::min(static_cast<long>(num_threads), size));
+}
+
+/**
+ * @brief Split a range of work items into contiguous chunks and process each on its own thread
+ *
+ * A single worker runs on the calling thread. Exceptions thrown by a worker are rethrown
+ * once all workers have finished.
+ *
+ * @param size The number of work items
+ * @param num_workers The number of workers (see getNumWorkerThreads)
+ * @param fn The function called as fn(worker_index, begin, end) for each chunk
+ */
+template <typename WorkerFn>
+inline void runWorkerThreads(long size, long num_workers, const WorkerFn& fn)
+{
+  if (num_workers <= 1)
+  {
+    fn(0, 0, size);
+    return;
+  }
+
+  const long chunk = (size + num_workers - 1) / num_workers;
+  std::vector<std::exception_ptr> errors(static_cast<std::size_t>(num_workers));
+  std::vector<std::thread> threads;
+  threads.reserve(static_cast<std::size_t>(num_workers));
+  for (long i = 0; i < num_workers; ++i)
+  {
+    threads.emplace_back([&, i]() {
+      try
+      {
+        fn(i, std::min(i * chunk, size), std::min((i + 1) * chunk, size));
+      }
+      catch (...)
+      {
+        errors[static_cast<std::size_t>(i)] = std::current_exception();
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  for (const auto& error : errors)
+  {
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
+
+/**
+ * @brief Threads which are kept alive to run short batches of work with little start up cost
+ *
+ * A batch is split into workers by the caller. The first worker runs on the calling thread and the others on
+ * threads of the pool, which are created when a batch needs more of them than were created before and wait for the
+ * next batch afterwards. Only one batch may run at a time.
+ */
+class WorkerThreadPool
+{
+public:
+  WorkerThreadPool() : generation_(0), num_workers_(0), pending_(0), stop_(false) {}
+
+  ~WorkerThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+
+    for (auto& thread : threads_)
+      thread.join();
+  }
+
+  WorkerThreadPool(const WorkerThreadPool&) = delete;
+  WorkerThreadPool& operator=(const WorkerThreadPool&) = delete;
+
+  /**
+   * @brief Run a batch of workers and wait for all of them to finish
+   *
+   * Exceptions thrown by a worker are rethrown once all workers have finished.
+   *
+   * @param num_workers The number of workers
+   * @param fn The function called as fn(worker_index) for each worker
+   */
+  template <typename WorkerFn>
+  void run(long num_workers, const WorkerFn& fn)
+  {
+    if (num_workers <= 1)
+    {
+      fn(0);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      while (static_cast<long>(threads_.size()) < num_workers - 1)
+        threads_.emplace_back(&WorkerThreadPool::loop, this, static_cast<long>(threads_.size()) + 1, generation_);
+
+      task_ = [&fn](long worker_index) { fn(worker_index); };
+      errors_.assign(static_cast<std::size_t>(num_workers), nullptr);
+      num_workers_ = num_workers;
+      pending_ = num_workers - 1;
+      ++generation_;
+    }
+    start_cv_.notify_all();
+
+    try
+    {
+      fn(0);
+    }
+    catch (...)
+    {
+      errors_[0] = std::current_exception();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_cv_.wait(lock, [this]() { return pending_ == 0; });
+      task_ = nullptr;
+    }
+
+    for (const auto& error : errors_)
+    {
+      if (error)
+        std::rethrow_exception(error);
+    }
+  }
+
+  /** @brief Get the number of threads of the pool, the calling thread is not counted */
+  std::size_t size() const { return threads_.size(); }
+
+private:
+  std::vector<std::thread> threads_;          /**< @brief The threads running the workers after the first */
+  std::mutex mutex_;                          /**< @brief Guards the state of the current batch */
+  std::condition_variable start_cv_;          /**< @brief Signals the threads that a batch started */
+  std::condition_variable done_cv_;           /**< @brief Signals the caller that the last thread finished */
+  std::function<void(long)> task_;            /**< @brief The worker function of the current batch */
+  std::vector<std::exception_ptr> errors_;    /**< @brief The exception thrown by each worker of the batch */
+  unsigned long generation_;                  /**< @brief Incremented for every batch */
+  long num_workers_;                          /**< @brief The number of workers of the current batch */
+  long pending_;                              /**< @brief The threads of the batch which did not finish yet */
+  bool stop_;                                 /**< @brief Indicate if the threads must exit */
+
+  /**
+   * @brief Run the worker of a thread for every batch
+   * @param worker_index The index of the worker run by the thread
+   * @param generation The generation of the last batch started before the thread was created
+   */
+  void loop(long worker_index, unsigned long generation)
+  {
+    for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_cv_.wait(lock, [&]() { return stop_ || generation_ != generation; });
+        if (stop_)
+          return;
+
+        generation = generation_;
+        if (worker_index >= num_workers_)
+          continue;
+      }
+
+      try
+      {
+        task_(worker_index);
+      }
+      catch (...)
+      {
+        errors_[static_cast<std::size_t>(worker_index)] = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pending_ == 0)
+        done_cv_.notify_one();
+    }
+  }
+};
+}
+
+#endif  // TESSERACT_CORE_WORKER_THREADS_H
@@ -22,7 +22,8 @@ ros::Subscriber joint_states_sub;
 ros::Publisher contact_results_pub;
 ros::Publisher environment_pub;
 ros::ServiceServer modify_env_service;
-ContactResultMap contacts;
+ContactResultBuffer contacts;
+ContactResultVector contacts_vector;
 tesseract_msgs::ContactResultVector contacts_msg;
 bool publish_environment;
 boost::mutex modify_mutex;
@@ -36,7 +37,12 @@ void callbackJointState(const sensor_msgs::JointState::ConstPtr& msg)
   env->setState(msg->name, msg->position);
   EnvStateConstPtr state = env->getState();
 
-  manager->setCollisionObjectsTransform(state->transforms);
+  // The link transforms of the state are indexed by link id, so they can be used if the manager shares the link ids
+  if (manager->getLinkRegistry() == env->getLinkRegistry())
+    manager->setCollisionObjectsTransform(state->link_transforms);
+  else
+    manager->setCollisionObjectsTransform(state->transforms);
+
   manager->contactTest(contacts);
 
   if (publish_environment)
@@ -46,8 +52,7 @@ void callbackJointState(const sensor_msgs::JointState::ConstPtr& msg)
     environment_pub.publish(state_msg);
   }
 
-  ContactResultVector contacts_vector;
-  tesseract::moveContactResultsMapToContactResultsVector(contacts, contacts_vector);
+  tesseract::copyContactResultBufferToContactResultsVector(contacts, *manager->getLinkRegistry(), contacts_vector);
   contacts_msg.constacts.reserve(contacts_vector.size());
   for (const auto& contact : contacts_vector)
   {
@@ -64,10 +69,20 @@ bool callbackModifyTesseractEnv(tesseract_msgs::ModifyTesseractEnvRequest& reque
   boost::mutex::scoped_lock(modify_mutex);
   response.success = processTesseractStateMsg(*env, request.state);
 
-  // Create a new manager
-  ContactRequest req = manager->getContactRequest();
-  manager = env->getDiscreteContactManager();
-  manager->setContactRequest(req);
+  // Create a new manager, its request has the allowed collision setup of the modified environment
+  const ContactRequest& old_req = manager->getContactRequest();
+  DiscreteContactManagerBasePtr new_manager = env->getDiscreteContactManager();
+  ContactRequest req = new_manager->getContactRequest();
+  req.type = old_req.type;
+  req.contact_distance = old_req.contact_distance;
+  req.link_names = old_req.link_names;
+  req.max_contacts_per_pair = old_req.max_contacts_per_pair;
+  req.max_total_contacts = old_req.max_total_contacts;
+  if (!req.isContactAllowed)
+    req.isContactAllowed = env->getIsContactAllowedFn();
+
+  new_manager->setContactRequest(req);
+  manager = new_manager;
 
   return true;
 }
@@ -124,9 +139,12 @@ int main(int argc, char** argv)
     return -1;
   }
 
-  // Setup request information
-  ContactRequest req;
-  req.isContactAllowed = env->getIsContactAllowedFn();
+  // Setup request information, starting from the request of the environment to keep its allowed collision setup
+  manager = env->getDiscreteContactManager();
+  ContactRequest req = manager->getContactRequest();
+  if (!req.isContactAllowed)
+    req.isContactAllowed = env->getIsContactAllowedFn();
+
   pnh.param<double>("contact_distance", req.contact_distance, DEFAULT_CONTACT_DISTANCE);
 
   req.link_names = env->getLinkNames();
@@ -147,7 +165,15 @@ int main(int argc, char** argv)
   }
 
   req.type = (tesseract::ContactRequestType)type;
-  manager = env->getDiscreteContactManager();
+
+  if (req.type == tesseract::ContactRequestType::LIMITED)
+  {
+    int max_contacts_per_pair = 1, max_total_contacts = 0;
+    pnh.param<int>("max_contacts_per_pair", max_contacts_per_pair, max_contacts_per_pair);
+    pnh.param<int>("max_total_contacts", max_total_contacts, max_total_contacts);
+    req.max_contacts_per_pair = static_cast<std::size_t>(std::max(1, max_contacts_per_pair));
+    req.max_total_contacts = static_cast<std::size_t>(std::max(0, max_total_contacts));
+  }
   manager->setContactRequest(req);
 
   joint_states_sub = nh.subscribe("joint_states", 1, &callbackJointState);
@@ -31,18 +31,20 @@ public:
     ss_->getSpaceInformation()->setMotionValidator(std::move(mv));
   }
 
+  /** @brief Get the contact manager used to check the states */
+  tesseract::DiscreteContactManagerBaseConstPtr getContactManager() const { return contact_manager_; }
+
 private:
   bool isStateValid(const ompl::base::State* state) const;
 
-  bool isContactAllowed(const std::string& a, const std::string& b) const;
-
 private:
   ompl::geometric::SimpleSetupPtr ss_;
   tesseract::BasicEnvConstPtr env_;
   tesseract::DiscreteContactManagerBasePtr contact_manager_;
-  tesseract::IsContactAllowedFn contact_fn_;
   std::vector<std::string> joint_names_;
   std::vector<std::string> link_names_;
+  std::vector<int> joint_ids_;
+  std::vector<int> link_ids_;
 };
 }
 }
@@ -26,14 +26,8 @@ public:
 private:
   bool continuousCollisionCheck(const ompl::base::State* s1, const ompl::base::State* s2) const;
 
-  bool isContactAllowed(const std::string& a, const std::string& b) const
-  {
-    return env_->getAllowedCollisionMatrix()->isCollisionAllowed(a, b);
-  }
-
   tesseract::BasicEnvConstPtr env_;
   tesseract::ContinuousContactManagerBasePtr contact_manager_;
-  tesseract::IsContactAllowedFn is_allowed_cb_;
   std::vector<std::string> links_;
   std::vector<std::string> joints_;
 };
@@ -30,16 +30,30 @@ ChainOmplInterface::ChainOmplInterface(tesseract::BasicEnvConstPtr environment,
 
   // Setup state checking functionality
   ss_->setStateValidityChecker(std::bind(&ChainOmplInterface::isStateValid, this, std::placeholders::_1));
-  contact_fn_ = std::bind(&ChainOmplInterface::isContactAllowed, this, std::placeholders::_1, std::placeholders::_2);
 
-  tesseract::ContactRequest req;
+  // Start from the request of the environment to keep its contact allowed function and compiled allowed collision
+  // matrix
+  contact_manager_ = env_->getDiscreteContactManager();
+  tesseract::ContactRequest req = contact_manager_->getContactRequest();
   req.link_names = link_names_;
-  req.isContactAllowed = contact_fn_;
   req.type = tesseract::ContactRequestTypes::FIRST;
+  if (!req.isContactAllowed)
+    req.isContactAllowed = env_->getIsContactAllowedFn();
 
-  contact_manager_ = env_->getDiscreteContactManager();
   contact_manager_->setContactRequest(req);
 
+  // Use the dense ids to avoid string lookups when checking states
+  NameRegistryConstPtr link_registry = env_->getLinkRegistry();
+  if (link_registry != nullptr && contact_manager_->getLinkRegistry() == link_registry)
+  {
+    NameRegistryConstPtr joint_registry = env_->getJointRegistry();
+    for (const auto& joint_name : joint_names_)
+      joint_ids_.push_back(joint_registry->find(joint_name));
+
+    for (const auto& link_name : link_names_)
+      link_ids_.push_back(link_registry->find(link_name));
+  }
+
   // We need to set the planner and call setup before it can run
 }
 
@@ -87,20 +101,25 @@ bool ChainOmplInterface::isStateValid(const ompl::base::State* state) const
   const auto dof = joint_names_.size();
 
   Eigen::Map<Eigen::VectorXd> joint_angles(s->values, dof);
+  if (!joint_ids_.empty())
+  {
+    // The state of each thread is calculated in place, so no state is allocated for every check
+    thread_local tesseract::EnvState env_state;
+    env_->getState(env_state, joint_ids_, joint_angles);
+
+    for (const auto& link_id : link_ids_)
+      contact_manager_->setCollisionObjectsTransform(link_id,
+                                                     env_state.link_transforms[static_cast<std::size_t>(link_id)]);
+
+    return contact_manager_->isCollisionFree();
+  }
+
   tesseract::EnvStatePtr env_state = env_->getState(joint_names_, joint_angles);
 
   for (const auto& link_name : link_names_)
     contact_manager_->setCollisionObjectsTransform(link_name, env_state->transforms[link_name]);
 
-  tesseract::ContactResultMap contact_map;
-  contact_manager_->contactTest(contact_map);
-
-  return contact_map.empty();
-}
-
-bool ChainOmplInterface::isContactAllowed(const std::string& a, const std::string& b) const
-{
-  return env_->getAllowedCollisionMatrix()->isCollisionAllowed(a, b);
+  return contact_manager_->isCollisionFree();
 }
 }
 }
@@ -12,15 +12,16 @@ ContinuousMotionValidator::ContinuousMotionValidator(ompl::base::SpaceInformatio
 {
   joints_ = env_->getManipulator(manipulator)->getJointNames();
   links_ = env_->getManipulator(manipulator)->getLinkNames();
-  is_allowed_cb_ =
-      std::bind(&ContinuousMotionValidator::isContactAllowed, this, std::placeholders::_1, std::placeholders::_2);
 
-  tesseract::ContactRequest req;
+  // Start from the request of the environment to keep its contact allowed function and compiled allowed collision
+  // matrix
+  contact_manager_ = env_->getContinuousContactManager();
+  tesseract::ContactRequest req = contact_manager_->getContactRequest();
   req.link_names = links_;
-  req.isContactAllowed = is_allowed_cb_;
   req.type = tesseract::ContactRequestTypes::FIRST;
+  if (!req.isContactAllowed)
+    req.isContactAllowed = env_->getIsContactAllowedFn();
 
-  contact_manager_ = env_->getContinuousContactManager();
   contact_manager_->setContactRequest(req);
 }
 
@@ -83,10 +84,7 @@ bool ContinuousMotionValidator::continuousCollisionCheck(const ompl::base::State
     contact_manager_->setCollisionObjectsTransform(
         link_name, state0->transforms[link_name], state1->transforms[link_name]);
 
-  tesseract::ContactResultMap contact_map;
-  contact_manager_->contactTest(contact_map);
-
-  return contact_map.empty();
+  return contact_manager_->isCollisionFree();
 }
 }
 }
@@ -67,7 +67,7 @@ bool TrajoptPlanner::solve(PlannerResponse&)
   ContinuousContactManagerBasePtr manager = prob->GetEnv()->getContinuousContactManager();
 
   collisions.clear();
-  bool found = tesseract::continuousCollisionCheckTrajectory(
+  bool found = tesseract::checkTrajectory(
       *manager, *prob->GetEnv(), *prob->GetKin(), getTraj(opt.x(), prob->GetVars()), collisions);
 
   if (found)
@@ -0,0 +1,112 @@
+#include "tesseract_planning/ompl/chain_ompl_interface.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <urdf_parser/urdf_parser.h>
+#include <ompl/base/ScopedState.h>
+
+/**
+ * A sphere moved in the plane by two prismatic joints and a box fixed to the base at x = 1.
+ * Only primitive shapes are used so the test does not depend on any mesh package.
+ */
+const std::string URDF_XML = R"(<?xml version="1.0"?>
+<robot name="planar_sphere">
+  <link name="base_link"/>
+  <link name="obstacle">
+    <collision>
+      <geometry>
+        <box size="0.2 0.2 0.2"/>
+      </geometry>
+    </collision>
+  </link>
+  <link name="link_1"/>
+  <link name="link_2">
+    <collision>
+      <geometry>
+        <sphere radius="0.1"/>
+      </geometry>
+    </collision>
+  </link>
+  <joint name="obstacle_joint" type="fixed">
+    <parent link="base_link"/>
+    <child link="obstacle"/>
+    <origin xyz="1 0 0" rpy="0 0 0"/>
+  </joint>
+  <joint name="joint_1" type="prismatic">
+    <parent link="base_link"/>
+    <child link="link_1"/>
+    <axis xyz="1 0 0"/>
+    <limit lower="-5" upper="5" effort="1" velocity="1"/>
+  </joint>
+  <joint name="joint_2" type="prismatic">
+    <parent link="link_1"/>
+    <child link="link_2"/>
+    <axis xyz="0 1 0"/>
+    <limit lower="-5" upper="5" effort="1" velocity="1"/>
+  </joint>
+</robot>
+)";
+
+std::shared_ptr<tesseract::tesseract_ros::KDLEnv> createEnv()
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env(new tesseract::tesseract_ros::KDLEnv());
+  EXPECT_TRUE(env->init(urdf::parseURDF(URDF_XML)));
+  EXPECT_TRUE(env->addManipulator("base_link", "link_2", "manip"));
+  return env;
+}
+
+/** @brief Check if the state with the sphere at (x, y) is valid */
+bool isStateValid(tesseract::tesseract_planning::ChainOmplInterface& ompl_interface, double x, double y)
+{
+  ompl::base::SpaceInformationPtr space_info = ompl_interface.spaceInformation();
+  ompl::base::ScopedState<> state(space_info->getStateSpace());
+  state[0] = x;
+  state[1] = y;
+  return space_info->isValid(state.get());
+}
+
+TEST(TesseractPlanningUnit, ChainOmplInterfaceContactRequestUnit)
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env = createEnv();
+  env->getAllowedCollisionMatrixNonConst()->addAllowedCollision("link_2", "obstacle", "Test");
+
+  tesseract::tesseract_planning::ChainOmplInterface ompl_interface(env, "manip");
+
+  // The request is the one of the environment with the links of the manipulator
+  const tesseract::ContactRequest& req = ompl_interface.getContactManager()->getContactRequest();
+  EXPECT_TRUE(req.link_names == env->getManipulator("manip")->getLinkNames());
+  EXPECT_EQ(req.type, tesseract::ContactRequestType::FIRST);
+  EXPECT_TRUE(static_cast<bool>(req.isContactAllowed));
+  ASSERT_TRUE(req.allowed_collision_matrix != nullptr);
+  EXPECT_TRUE(req.allowed_collision_matrix == env->getAllowedCollisionBitMatrix());
+
+  int link_id = env->getLinkRegistry()->find("link_2");
+  int obstacle_id = env->getLinkRegistry()->find("obstacle");
+  EXPECT_TRUE(req.allowed_collision_matrix->isCollisionAllowed(link_id, obstacle_id));
+
+  // The sphere inside the box is allowed in collision
+  EXPECT_TRUE(isStateValid(ompl_interface, 1, 0));
+  EXPECT_TRUE(isStateValid(ompl_interface, 0, 0));
+}
+
+TEST(TesseractPlanningUnit, ChainOmplInterfaceStateValidUnit)
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env = createEnv();
+
+  tesseract::tesseract_planning::ChainOmplInterface ompl_interface(env, "manip");
+  const tesseract::ContactRequest& req = ompl_interface.getContactManager()->getContactRequest();
+  ASSERT_TRUE(req.allowed_collision_matrix != nullptr);
+
+  int link_id = env->getLinkRegistry()->find("link_2");
+  int obstacle_id = env->getLinkRegistry()->find("obstacle");
+  EXPECT_FALSE(req.allowed_collision_matrix->isCollisionAllowed(link_id, obstacle_id));
+
+  EXPECT_FALSE(isStateValid(ompl_interface, 1, 0));
+  EXPECT_TRUE(isStateValid(ompl_interface, 0, 0));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -54,6 +54,7 @@
 #include <urdf/model.h>
 #include <srdfdom/model.h>
 #include <pluginlib/class_loader.hpp>
+#include <mutex>
 
 namespace tesseract
 {
@@ -69,7 +70,17 @@ class KDLEnv : public ROSBasicEnv
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  KDLEnv() : ROSBasicEnv(), initialized_(false), allowed_collision_matrix_(new AllowedCollisionMatrix())
+  KDLEnv()
+    : ROSBasicEnv()
+    , initialized_(false)
+    , link_registry_(new NameRegistry())
+    , link_ids_(new std::unordered_map<std::string, int>())
+    , num_link_ids_(0)
+    , joint_registry_(new NameRegistry())
+    , allowed_collision_matrix_(new AllowedCollisionMatrix())
+    , allowed_collision_bit_matrix_(new AllowedCollisionBitMatrix())
+    , allowed_collision_bit_matrix_revision_(0)
+    , default_is_contact_allowed_fn_(true)
   {
     is_contact_allowed_fn_ = std::bind(&tesseract::tesseract_ros::KDLEnv::defaultIsContactAllowedFn,
                                        this,
@@ -95,12 +106,18 @@ public:
   void setState(const std::vector<std::string>& joint_names, const std::vector<double>& joint_values) override;
   void setState(const std::vector<std::string>& joint_names,
                 const Eigen::Ref<const Eigen::VectorXd>& joint_values) override;
+  void setState(const std::vector<int>& joint_ids, const Eigen::Ref<const Eigen::VectorXd>& joint_values) override;
 
   EnvStatePtr getState(const std::unordered_map<std::string, double>& joints) const override;
   EnvStatePtr getState(const std::vector<std::string>& joint_names,
                        const std::vector<double>& joint_values) const override;
   EnvStatePtr getState(const std::vector<std::string>& joint_names,
                        const Eigen::Ref<const Eigen::VectorXd>& joint_values) const override;
+  EnvStatePtr getState(const std::vector<int>& joint_ids,
+                       const Eigen::Ref<const Eigen::VectorXd>& joint_values) const override;
+  void getState(EnvState& state,
+                const std::vector<int>& joint_ids,
+                const Eigen::Ref<const Eigen::VectorXd>& joint_values) const override;
 
   std::vector<std::string> getJointNames() const override { return joint_names_; }
   Eigen::VectorXd getCurrentJointValues() const override;
@@ -114,6 +131,9 @@ public:
 
   const Eigen::Isometry3d& getLinkTransform(const std::string& link_name) const override;
 
+  NameRegistryConstPtr getLinkRegistry() const override { return link_registry_; }
+  NameRegistryConstPtr getJointRegistry() const override { return joint_registry_; }
+
   bool hasManipulator(const std::string& manipulator_name) const override;
 
   BasicKinConstPtr getManipulator(const std::string& manipulator_name) const override;
@@ -147,9 +167,14 @@ public:
   AllowedCollisionMatrixConstPtr getAllowedCollisionMatrix() const override { return allowed_collision_matrix_; }
   AllowedCollisionMatrixPtr getAllowedCollisionMatrixNonConst() override { return allowed_collision_matrix_; }
   IsContactAllowedFn getIsContactAllowedFn() const override { return is_contact_allowed_fn_; }
-  void setIsContactAllowedFn(IsContactAllowedFn fn) override { is_contact_allowed_fn_ = fn; }
-  DiscreteContactManagerBasePtr getDiscreteContactManager() const override { return discrete_manager_->clone(); }
-  ContinuousContactManagerBasePtr getContinuousContactManager() const override { return continuous_manager_->clone(); }
+  void setIsContactAllowedFn(IsContactAllowedFn fn) override
+  {
+    is_contact_allowed_fn_ = fn;
+    default_is_contact_allowed_fn_ = false;
+  }
+  AllowedCollisionBitMatrixConstPtr getAllowedCollisionBitMatrix() const override;
+  DiscreteContactManagerBasePtr getDiscreteContactManager() const override;
+  ContinuousContactManagerBasePtr getContinuousContactManager() const override;
   void loadDiscreteContactManagerPlugin(const std::string& plugin) override;
   void loadContinuousContactManagerPlugin(const std::string& plugin) override;
 
@@ -161,8 +186,21 @@ private:
   std::shared_ptr<const KDL::Tree> kdl_tree_;                  /**< KDL tree object */
   EnvStatePtr current_state_;                                  /**< Current state of the robot */
   std::unordered_map<std::string, unsigned int> joint_to_qnr_; /**< Map between joint name and kdl q index */
+  NameRegistryPtr link_registry_;                              /**< Assigns the link ids (shared with the managers) */
+  std::shared_ptr<const std::unordered_map<std::string, int>>
+      link_ids_; /**< The ids of the links and attachable objects, replaced instead of modified */
+  std::size_t num_link_ids_; /**< The size of link_registry_ once the links and attachable objects were added */
+  NameRegistryPtr joint_registry_;                             /**< Assigns the joint ids */
+  std::vector<unsigned int> joint_id_to_qnr_;                  /**< Map between joint id and kdl q index */
+  std::vector<KDL::SegmentMap::const_iterator> segment_order_; /**< The kdl tree segments, parents before children */
+  std::vector<int> segment_link_id_;                           /**< The link id of each segment in segment_order_ */
+  std::vector<int> segment_parent_link_id_; /**< The link id of the parent of each segment (-1 for the root) */
+  std::vector<int> segment_joint_id_;       /**< The joint id of each segment (-1 for fixed joints) */
   KDL::JntArray kdl_jnt_array_;                                /**< The kdl joint array */
   AttachedBodyInfoMap attached_bodies_;                        /**< A map of attached bodies */
+  std::vector<const AttachedBodyInfo*> attached_body_order_;   /**< The attached bodies with valid link ids */
+  std::vector<int> attached_link_id_;                          /**< The link id of each body in attached_body_order_ */
+  std::vector<int> attached_parent_link_id_;                   /**< The link id of the parent of each attached body */
   AttachableObjectConstPtrMap
       attachable_objects_; /**< A map of objects that can be attached/detached from environment */
   std::unordered_map<std::string, BasicKinPtr> manipulators_; /**< A map of manipulator names to kinematics object */
@@ -174,25 +212,78 @@ private:
       allowed_collision_matrix_; /**< The allowed collision matrix used during collision checking */
   IsContactAllowedFn
       is_contact_allowed_fn_; /**< The function used to determine if two objects are allowed in collision */
+  mutable AllowedCollisionBitMatrixPtr
+      allowed_collision_bit_matrix_; /**< The allowed collision matrix and touch links indexed by link id */
+  mutable unsigned long
+      allowed_collision_bit_matrix_revision_; /**< The allowed collision matrix revision compiled into the bit matrix */
+  mutable std::mutex allowed_collision_bit_matrix_mutex_; /**< Guards replacing the bit matrix and its revision */
+  bool default_is_contact_allowed_fn_; /**< Indicate if is_contact_allowed_fn_ is defaultIsContactAllowedFn() */
   DiscreteContactManagerBasePtr discrete_manager_;                        /**< The discrete contact manager object */
   ContinuousContactManagerBasePtr continuous_manager_;                    /**< The continuous contact manager object */
   DiscreteContactManagerBasePluginLoaderPtr discrete_manager_loader_;     /**< The discrete contact manager loader */
   ContinuousContactManagerBasePluginLoaderPtr continuous_manager_loader_; /**< The continuous contact manager loader */
 
+  /**
+   * @brief The default contact allowed function, it looks up the links in the compiled allowed collision bit matrix
+   *
+   * Only names without link id fall back to the allowed collision matrix.
+   */
   bool defaultIsContactAllowedFn(const std::string& link_name1, const std::string& link_name2) const;
 
-  void calculateTransforms(TransformMap& transforms,
-                           const KDL::JntArray& q_in,
-                           const KDL::SegmentMap::const_iterator& it,
-                           const Eigen::Isometry3d& parent_frame) const;
+  /** @brief Rebuild the link id map, this must be called when names are added to the link registry */
+  void updateLinkIds();
+
+  /**
+   * @brief Put the compiled allowed collision bit matrix in the contact request of a manager handed out
+   *
+   * This is only done while the default contact allowed function is active and the manager uses the link ids of
+   * this environment, since the bit matrix is what that function decides. The contact allowed function of the
+   * request keeps the bit matrix and link id map of the moment it is built, so it does not lock anything.
+   *
+   * @param req The contact request of the manager
+   * @param registry The link registry of the manager
+   * @return True if the request was changed
+   */
+  bool setDefaultAllowedCollision(ContactRequest& req, const NameRegistryConstPtr& registry) const;
+
+  /** @brief Build a new allowed collision bit matrix from the allowed collision matrix and attached bodies */
+  AllowedCollisionBitMatrixPtr compileAllowedCollisionBitMatrix() const;
 
-  void calculateTransformsHelper(TransformMap& transforms,
-                                 const KDL::JntArray& q_in,
-                                 const KDL::SegmentMap::const_iterator& it,
-                                 const Eigen::Isometry3d& parent_frame) const;
+  /**
+   * @brief Replace the allowed collision bit matrix by a copy with the entries of a link or attached object updated
+   *
+   * Matrices returned by getAllowedCollisionBitMatrix() may still be used by contact requests, so they are never
+   * modified.
+   *
+   * @param name The name of the link or attached object
+   */
+  void updateAllowedCollisionBitMatrix(const std::string& name);
+
+  /** @brief Look up the link ids of the attached bodies, this must be called when bodies are attached or detached */
+  void updateAttachedLinkIds();
+
+  /**
+   * @brief Calculate the link transforms and joint values of a state
+   * @param state The state to update
+   * @param q_in The kdl joint array
+   * @param update_names If false only the id indexed members of the state are updated
+   */
+  void calculateTransforms(EnvState& state, const KDL::JntArray& q_in, bool update_names = true) const;
+
+  /**
+   * @brief Calculate the link transforms of a state from the joint values of the state
+   * @param state The state to update, its joint values must be set for every joint id
+   * @param update_names If false only the id indexed members of the state are updated
+   */
+  void calculateLinkTransforms(EnvState& state, bool update_names) const;
+
+  /** @brief Update the contact managers with the link transforms of the current state */
+  void updateContactManagerTransforms();
 
   bool setJointValuesHelper(KDL::JntArray& q, const std::string& joint_name, const double& joint_value) const;
 
+  bool setJointValuesHelper(KDL::JntArray& q, int joint_id, const double& joint_value) const;
+
   std::string getManipulatorName(const std::vector<std::string>& joint_names) const;
 };
 typedef std::shared_ptr<KDLEnv> KDLEnvPtr;
@@ -108,14 +108,41 @@ bool KDLEnv::init(urdf::ModelInterfaceConstSharedPtr urdf_model, srdf::ModelCons
         continue;
       joint_names_[j] = jnt.getName();
       joint_to_qnr_.insert(std::make_pair(jnt.getName(), seg.second.q_nr));
+
+      std::size_t joint_id = static_cast<std::size_t>(joint_registry_->intern(jnt.getName()));
+      if (joint_id >= joint_id_to_qnr_.size())
+        joint_id_to_qnr_.resize(joint_id + 1);
+      joint_id_to_qnr_[joint_id] = seg.second.q_nr;
+
       kdl_jnt_array_(seg.second.q_nr) = 0.0;
       current_state_->joints.insert(std::make_pair(jnt.getName(), 0.0));
 
       j++;
     }
 
-    calculateTransforms(
-        current_state_->transforms, kdl_jnt_array_, kdl_tree_->getRootSegment(), Eigen::Isometry3d::Identity());
+    // Flatten the kdl tree (parents before children) so transforms can be calculated without recursion
+    std::vector<std::pair<KDL::SegmentMap::const_iterator, int>> segments;
+    segments.push_back(std::make_pair(kdl_tree_->getRootSegment(), -1));
+    while (!segments.empty())
+    {
+      KDL::SegmentMap::const_iterator it = segments.back().first;
+      int parent_link_id = segments.back().second;
+      segments.pop_back();
+
+      int link_id = link_registry_->intern(it->second.segment.getName());
+      const KDL::Joint& jnt = it->second.segment.getJoint();
+      segment_order_.push_back(it);
+      segment_link_id_.push_back(link_id);
+      segment_parent_link_id_.push_back(parent_link_id);
+      segment_joint_id_.push_back(jnt.getType() == KDL::Joint::None ? -1 : joint_registry_->find(jnt.getName()));
+
+      for (const auto& child : it->second.children)
+        segments.push_back(std::make_pair(child, link_id));
+    }
+    num_link_ids_ = link_registry_->size();
+    updateLinkIds();
+
+    calculateTransforms(*current_state_, kdl_jnt_array_);
   }
 
   if (srdf_model != nullptr)
@@ -175,10 +202,8 @@ void KDLEnv::setState(const std::unordered_map<std::string, double>& joints)
     }
   }
 
-  calculateTransforms(
-      current_state_->transforms, kdl_jnt_array_, kdl_tree_->getRootSegment(), Eigen::Isometry3d::Identity());
-  discrete_manager_->setCollisionObjectsTransform(current_state_->transforms);
-  continuous_manager_->setCollisionObjectsTransform(current_state_->transforms);
+  calculateTransforms(*current_state_, kdl_jnt_array_);
+  updateContactManagerTransforms();
 }
 
 void KDLEnv::setState(const std::vector<std::string>& joint_names, const std::vector<double>& joint_values)
@@ -191,10 +216,8 @@ void KDLEnv::setState(const std::vector<std::string>& joint_names, const std::ve
     }
   }
 
-  calculateTransforms(
-      current_state_->transforms, kdl_jnt_array_, kdl_tree_->getRootSegment(), Eigen::Isometry3d::Identity());
-  discrete_manager_->setCollisionObjectsTransform(current_state_->transforms);
-  continuous_manager_->setCollisionObjectsTransform(current_state_->transforms);
+  calculateTransforms(*current_state_, kdl_jnt_array_);
+  updateContactManagerTransforms();
 }
 
 void KDLEnv::setState(const std::vector<std::string>& joint_names,
@@ -208,10 +231,22 @@ void KDLEnv::setState(const std::vector<std::string>& joint_names,
     }
   }
 
-  calculateTransforms(
-      current_state_->transforms, kdl_jnt_array_, kdl_tree_->getRootSegment(), Eigen::Isometry3d::Identity());
-  discrete_manager_->setCollisionObjectsTransform(current_state_->transforms);
-  continuous_manager_->setCollisionObjectsTransform(current_state_->transforms);
+  calculateTransforms(*current_state_, kdl_jnt_array_);
+  updateContactManagerTransforms();
+}
+
+void KDLEnv::setState(const std::vector<int>& joint_ids, const Eigen::Ref<const Eigen::VectorXd>& joint_values)
+{
+  for (auto i = 0u; i < joint_ids.size(); ++i)
+  {
+    if (setJointValuesHelper(kdl_jnt_array_, joint_ids[i], joint_values[i]))
+    {
+      current_state_->joints[joint_registry_->getName(joint_ids[i])] = joint_values[i];
+    }
+  }
+
+  calculateTransforms(*current_state_, kdl_jnt_array_);
+  updateContactManagerTransforms();
 }
 
 EnvStatePtr KDLEnv::getState(const std::unordered_map<std::string, double>& joints) const
@@ -227,7 +262,7 @@ EnvStatePtr KDLEnv::getState(const std::unordered_map<std::string, double>& join
     }
   }
 
-  calculateTransforms(state->transforms, jnt_array, kdl_tree_->getRootSegment(), Eigen::Isometry3d::Identity());
+  calculateTransforms(*state, jnt_array);
 
   return state;
 }
@@ -245,7 +280,7 @@ EnvStatePtr KDLEnv::getState(const std::vector<std::string>& joint_names, const
     }
   }
 
-  calculateTransforms(state->transforms, jnt_array, kdl_tree_->getRootSegment(), Eigen::Isometry3d::Identity());
+  calculateTransforms(*state, jnt_array);
 
   return state;
 }
@@ -264,11 +299,40 @@ EnvStatePtr KDLEnv::getState(const std::vector<std::string>& joint_names,
     }
   }
 
-  calculateTransforms(state->transforms, jnt_array, kdl_tree_->getRootSegment(), Eigen::Isometry3d::Identity());
+  calculateTransforms(*state, jnt_array);
+
+  return state;
+}
 
+EnvStatePtr KDLEnv::getState(const std::vector<int>& joint_ids,
+                             const Eigen::Ref<const Eigen::VectorXd>& joint_values) const
+{
+  EnvStatePtr state(new EnvState());
+  getState(*state, joint_ids, joint_values);
   return state;
 }
 
+void KDLEnv::getState(EnvState& state,
+                      const std::vector<int>& joint_ids,
+                      const Eigen::Ref<const Eigen::VectorXd>& joint_values) const
+{
+  // The joint values are gathered in the state, so no joint array is copied for every call
+  state.joint_values.resize(joint_id_to_qnr_.size());
+  for (std::size_t i = 0; i < joint_id_to_qnr_.size(); ++i)
+    state.joint_values[i] = kdl_jnt_array_(joint_id_to_qnr_[i]);
+
+  for (auto i = 0u; i < joint_ids.size(); ++i)
+  {
+    int joint_id = joint_ids[i];
+    if (joint_id >= 0 && static_cast<std::size_t>(joint_id) < state.joint_values.size())
+      state.joint_values[static_cast<std::size_t>(joint_id)] = joint_values[i];
+    else
+      ROS_ERROR("Tried to set joint id %d which does not exist!", joint_id);
+  }
+
+  calculateLinkTransforms(state, false);
+}
+
 Eigen::VectorXd KDLEnv::getCurrentJointValues() const
 {
   Eigen::VectorXd jv;
@@ -387,6 +451,10 @@ void KDLEnv::addAttachableObject(const AttachableObjectConstPtr attachable_objec
   }
 
   attachable_objects_[attachable_object->name] = attachable_object;
+  link_registry_->intern(attachable_object->name);
+  num_link_ids_ = link_registry_->size();
+  updateLinkIds();
+  updateAllowedCollisionBitMatrix(attachable_object->name);
 
   // Add the object to the contact checker
   discrete_manager_->addCollisionObject(attachable_object->name,
@@ -465,11 +533,12 @@ void KDLEnv::attachBody(const AttachedBodyInfo& attached_body_info)
   }
 
   attached_bodies_.insert(std::make_pair(attached_body_info.object_name, attached_body_info));
+  updateAttachedLinkIds();
+  updateAllowedCollisionBitMatrix(attached_body_info.object_name);
   discrete_manager_->enableCollisionObject(attached_body_info.object_name);
   continuous_manager_->enableCollisionObject(attached_body_info.object_name);
 
-  calculateTransforms(
-      current_state_->transforms, kdl_jnt_array_, kdl_tree_->getRootSegment(), Eigen::Isometry3d::Identity());
+  calculateTransforms(*current_state_, kdl_jnt_array_);
 
   // Update manipulators
   for (auto& manip : manipulators_)
@@ -488,6 +557,8 @@ void KDLEnv::detachBody(const std::string& name)
   if (attached_bodies_.find(name) != attached_bodies_.end())
   {
     attached_bodies_.erase(name);
+    updateAttachedLinkIds();
+    updateAllowedCollisionBitMatrix(name);
     discrete_manager_->disableCollisionObject(name);
     continuous_manager_->disableCollisionObject(name);
     link_names_.erase(std::remove(link_names_.begin(), link_names_.end(), name), link_names_.end());
@@ -509,6 +580,8 @@ void KDLEnv::detachBody(const std::string& name)
 
 void KDLEnv::clearAttachedBodies()
 {
+  std::vector<std::string> names;
+  names.reserve(attached_bodies_.size());
   for (const auto& body : attached_bodies_)
   {
     std::string name = body.second.object_name;
@@ -518,8 +591,13 @@ void KDLEnv::clearAttachedBodies()
     active_link_names_.erase(std::remove(active_link_names_.begin(), active_link_names_.end(), name),
                              active_link_names_.end());
     current_state_->transforms.erase(name);
+    names.push_back(name);
   }
   attached_bodies_.clear();
+  updateAttachedLinkIds();
+
+  for (const auto& name : names)
+    updateAllowedCollisionBitMatrix(name);
 
   // Update manipulators
   for (auto& manip : manipulators_)
@@ -541,67 +619,264 @@ bool KDLEnv::setJointValuesHelper(KDL::JntArray& q, const std::string& joint_nam
   }
 }
 
-void KDLEnv::calculateTransformsHelper(TransformMap& transforms,
-                                       const KDL::JntArray& q_in,
-                                       const KDL::SegmentMap::const_iterator& it,
-                                       const Eigen::Isometry3d& parent_frame) const
+bool KDLEnv::setJointValuesHelper(KDL::JntArray& q, int joint_id, const double& joint_value) const
 {
-  if (it != kdl_tree_->getSegments().end())
+  if (joint_id >= 0 && static_cast<std::size_t>(joint_id) < joint_id_to_qnr_.size())
+  {
+    q(joint_id_to_qnr_[static_cast<std::size_t>(joint_id)]) = joint_value;
+    return true;
+  }
+  else
   {
-    const KDL::TreeElementType& current_element = it->second;
-    KDL::Frame current_frame = GetTreeElementSegment(current_element).pose(q_in(GetTreeElementQNr(current_element)));
+    ROS_ERROR("Tried to set joint id %d which does not exist!", joint_id);
+    return false;
+  }
+}
 
-    Eigen::Isometry3d local_frame, global_frame;
-    KDLToEigen(current_frame, local_frame);
-    global_frame = parent_frame * local_frame;
-    transforms[current_element.segment.getName()] = global_frame;
+void KDLEnv::calculateTransforms(EnvState& state, const KDL::JntArray& q_in, bool update_names) const
+{
+  state.joint_values.resize(joint_id_to_qnr_.size());
+  for (std::size_t i = 0; i < joint_id_to_qnr_.size(); ++i)
+    state.joint_values[i] = q_in(joint_id_to_qnr_[i]);
 
-    for (auto& child : current_element.children)
-    {
-      calculateTransformsHelper(transforms, q_in, child, global_frame);
-    }
-  }
+  calculateLinkTransforms(state, update_names);
 }
 
-void KDLEnv::calculateTransforms(TransformMap& transforms,
-                                 const KDL::JntArray& q_in,
-                                 const KDL::SegmentMap::const_iterator& it,
-                                 const Eigen::Isometry3d& parent_frame) const
+void KDLEnv::calculateLinkTransforms(EnvState& state, bool update_names) const
 {
-  calculateTransformsHelper(transforms, q_in, it, parent_frame);
+  // The registry is only locked when links are added, not for every state
+  state.link_transforms.resize(num_link_ids_, Eigen::Isometry3d::Identity());
+  for (std::size_t i = 0; i < segment_order_.size(); ++i)
+  {
+    const KDL::TreeElementType& current_element = segment_order_[i]->second;
+    int joint_id = segment_joint_id_[i];
+    double joint_value = (joint_id < 0) ? 0.0 : state.joint_values[static_cast<std::size_t>(joint_id)];
+    KDL::Frame current_frame = GetTreeElementSegment(current_element).pose(joint_value);
+
+    Eigen::Isometry3d local_frame;
+    KDLToEigen(current_frame, local_frame);
+
+    Eigen::Isometry3d& global_frame = state.link_transforms[static_cast<std::size_t>(segment_link_id_[i])];
+    if (segment_parent_link_id_[i] < 0)
+      global_frame = local_frame;
+    else
+      global_frame = state.link_transforms[static_cast<std::size_t>(segment_parent_link_id_[i])] * local_frame;
+
+    if (update_names)
+      state.transforms[current_element.segment.getName()] = global_frame;
+  }
 
   // update attached objects location
+  for (std::size_t i = 0; i < attached_body_order_.size(); ++i)
+  {
+    const AttachedBodyInfo& attached = *attached_body_order_[i];
+    Eigen::Isometry3d& global_frame = state.link_transforms[static_cast<std::size_t>(attached_link_id_[i])];
+    global_frame = state.link_transforms[static_cast<std::size_t>(attached_parent_link_id_[i])] * attached.transform;
+
+    if (update_names)
+      state.transforms[attached.object_name] = global_frame;
+  }
+}
+
+void KDLEnv::updateAttachedLinkIds()
+{
+  attached_body_order_.clear();
+  attached_link_id_.clear();
+  attached_parent_link_id_.clear();
   for (const auto& attached : attached_bodies_)
   {
-    transforms[attached.first] = transforms[attached.second.parent_link_name] * attached.second.transform;
+    int link_id = link_registry_->find(attached.first);
+    int parent_link_id = link_registry_->find(attached.second.parent_link_name);
+    if (link_id < 0 || parent_link_id < 0)
+      continue;
+
+    attached_body_order_.push_back(&attached.second);
+    attached_link_id_.push_back(link_id);
+    attached_parent_link_id_.push_back(parent_link_id);
   }
 }
 
+void KDLEnv::updateContactManagerTransforms()
+{
+  // The link transforms of the state are indexed by link id, the attached bodies included
+  discrete_manager_->setCollisionObjectsTransform(current_state_->link_transforms);
+  continuous_manager_->setCollisionObjectsTransform(current_state_->link_transforms);
+}
+
 bool KDLEnv::defaultIsContactAllowedFn(const std::string& link_name1, const std::string& link_name2) const
 {
-  if (allowed_collision_matrix_ != nullptr && allowed_collision_matrix_->isCollisionAllowed(link_name1, link_name2))
-    return true;
+  // The allowed collision matrix and the touch links of the attached bodies are compiled into the bit matrix
+  auto it1 = link_ids_->find(link_name1);
+  auto it2 = link_ids_->find(link_name2);
+  if (it1 != link_ids_->end() && it2 != link_ids_->end())
+    return getAllowedCollisionBitMatrix()->isCollisionAllowed(it1->second, it2->second);
 
-  auto it1 = attached_bodies_.find(link_name1);
-  auto it2 = attached_bodies_.find(link_name2);
-  if (it1 == attached_bodies_.end() && it2 == attached_bodies_.end())
-  {
+  return allowed_collision_matrix_ != nullptr && allowed_collision_matrix_->isCollisionAllowed(link_name1, link_name2);
+}
+
+void KDLEnv::updateLinkIds()
+{
+  std::shared_ptr<std::unordered_map<std::string, int>> link_ids(new std::unordered_map<std::string, int>());
+  std::size_t num_ids = link_registry_->size();
+  link_ids->reserve(num_ids);
+  for (std::size_t i = 0; i < num_ids; ++i)
+    (*link_ids)[link_registry_->getName(static_cast<int>(i))] = static_cast<int>(i);
+
+  link_ids_ = link_ids;
+}
+
+bool KDLEnv::setDefaultAllowedCollision(ContactRequest& req, const NameRegistryConstPtr& registry) const
+{
+  if (!default_is_contact_allowed_fn_ || registry != link_registry_)
     return false;
+
+  // The request keeps the bit matrix and link ids it was built with, so a check does not lock the registry or the
+  // bit matrix. Modifying the allowed collision matrix requires a new request, like for allowed_collision_matrix.
+  AllowedCollisionBitMatrixConstPtr bits = getAllowedCollisionBitMatrix();
+  std::shared_ptr<const std::unordered_map<std::string, int>> link_ids = link_ids_;
+  AllowedCollisionMatrixConstPtr acm = allowed_collision_matrix_;
+  req.isContactAllowed = [bits, link_ids, acm](const std::string& link_name1, const std::string& link_name2) {
+    auto it1 = link_ids->find(link_name1);
+    auto it2 = link_ids->find(link_name2);
+    if (it1 != link_ids->end() && it2 != link_ids->end())
+      return bits->isCollisionAllowed(it1->second, it2->second);
+
+    return acm != nullptr && acm->isCollisionAllowed(link_name1, link_name2);
+  };
+  req.allowed_collision_matrix = bits;
+  return true;
+}
+
+DiscreteContactManagerBasePtr KDLEnv::getDiscreteContactManager() const
+{
+  DiscreteContactManagerBasePtr manager = discrete_manager_->clone();
+
+  ContactRequest req = manager->getContactRequest();
+  if (setDefaultAllowedCollision(req, manager->getLinkRegistry()))
+    manager->setContactRequest(req);
+
+  return manager;
+}
+
+ContinuousContactManagerBasePtr KDLEnv::getContinuousContactManager() const
+{
+  ContinuousContactManagerBasePtr manager = continuous_manager_->clone();
+
+  ContactRequest req = manager->getContactRequest();
+  if (setDefaultAllowedCollision(req, manager->getLinkRegistry()))
+    manager->setContactRequest(req);
+
+  return manager;
+}
+
+AllowedCollisionBitMatrixConstPtr KDLEnv::getAllowedCollisionBitMatrix() const
+{
+  // The allowed collision matrix may be modified through its pointer, so it is compiled again once its revision
+  // changed. The compiled matrix is replaced instead of modified.
+  std::lock_guard<std::mutex> lock(allowed_collision_bit_matrix_mutex_);
+  unsigned long revision = allowed_collision_matrix_->getRevision();
+  if (allowed_collision_bit_matrix_revision_ != revision)
+  {
+    allowed_collision_bit_matrix_ = compileAllowedCollisionBitMatrix();
+    allowed_collision_bit_matrix_revision_ = revision;
   }
-  else if (it1 == attached_bodies_.end())
+
+  return allowed_collision_bit_matrix_;
+}
+
+AllowedCollisionBitMatrixPtr KDLEnv::compileAllowedCollisionBitMatrix() const
+{
+  AllowedCollisionBitMatrixPtr bits_ptr(new AllowedCollisionBitMatrix());
+  AllowedCollisionBitMatrix& bits = *bits_ptr;
+  bits.resize(link_registry_->size());
+
+  // The allowed collision matrix stores each pair in both orders so only the first link needs to be handled
+  for (const auto& entry : allowed_collision_matrix_->getAllAllowedCollisions())
   {
-    const std::vector<std::string>& tl = it2->second.touch_links;
-    if (std::find(tl.begin(), tl.end(), link_name1) != tl.end() || link_name1 == it2->second.parent_link_name)
-      return true;
+    int id1 = link_registry_->find(entry.first);
+    if (id1 < 0)
+      continue;
+
+    for (const auto& pair : entry.second)
+    {
+      int id2 = link_registry_->find(pair.first);
+      if (id2 >= 0)
+        bits.setCollisionAllowed(id1, id2, true);
+    }
   }
-  else
+
+  for (const auto& body : attached_bodies_)
   {
-    const std::vector<std::string>& tl = it1->second.touch_links;
-    if (std::find(tl.begin(), tl.end(), link_name2) != tl.end() || link_name2 == it1->second.parent_link_name)
-      return true;
+    int id1 = link_registry_->find(body.first);
+    if (id1 < 0)
+      continue;
+
+    int parent_id = link_registry_->find(body.second.parent_link_name);
+    if (parent_id >= 0)
+      bits.setCollisionAllowed(id1, parent_id, true);
+
+    for (const auto& touch_link : body.second.touch_links)
+    {
+      int id2 = link_registry_->find(touch_link);
+      if (id2 >= 0)
+        bits.setCollisionAllowed(id1, id2, true);
+    }
   }
 
-  return false;
+  return bits_ptr;
+}
+
+void KDLEnv::updateAllowedCollisionBitMatrix(const std::string& name)
+{
+  int id = link_registry_->find(name);
+  if (id < 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(allowed_collision_bit_matrix_mutex_);
+  AllowedCollisionBitMatrixPtr bits_ptr(new AllowedCollisionBitMatrix(*allowed_collision_bit_matrix_));
+  AllowedCollisionBitMatrix& bits = *bits_ptr;
+  if (bits.size() < link_registry_->size())
+    bits.resize(link_registry_->size());
+
+  bits.clearCollisionsAllowed(id);
+
+  const AllowedCollisionEntries& entries = allowed_collision_matrix_->getAllAllowedCollisions();
+  auto entry = entries.find(name);
+  if (entry != entries.end())
+  {
+    for (const auto& pair : entry->second)
+    {
+      int other_id = link_registry_->find(pair.first);
+      if (other_id >= 0)
+        bits.setCollisionAllowed(id, other_id, true);
+    }
+  }
+
+  for (const auto& body : attached_bodies_)
+  {
+    const std::vector<std::string>& tl = body.second.touch_links;
+    if (body.first == name)
+    {
+      int parent_id = link_registry_->find(body.second.parent_link_name);
+      if (parent_id >= 0)
+        bits.setCollisionAllowed(id, parent_id, true);
+
+      for (const auto& touch_link : tl)
+      {
+        int other_id = link_registry_->find(touch_link);
+        if (other_id >= 0)
+          bits.setCollisionAllowed(id, other_id, true);
+      }
+    }
+    else if (body.second.parent_link_name == name || std::find(tl.begin(), tl.end(), name) != tl.end())
+    {
+      int other_id = link_registry_->find(body.first);
+      if (other_id >= 0)
+        bits.setCollisionAllowed(id, other_id, true);
+    }
+  }
+
+  allowed_collision_bit_matrix_ = bits_ptr;
 }
 
 void KDLEnv::loadDiscreteContactManagerPlugin(const std::string& plugin)
@@ -610,6 +885,7 @@ void KDLEnv::loadDiscreteContactManagerPlugin(const std::string& plugin)
   if (temp != nullptr)
   {
     discrete_manager_ = temp;
+    discrete_manager_->setLinkRegistry(link_registry_);
   }
   else
   {
@@ -676,6 +952,7 @@ void KDLEnv::loadContinuousContactManagerPlugin(const std::string& plugin)
   if (temp != nullptr)
   {
     continuous_manager_ = temp;
+    continuous_manager_->setLinkRegistry(link_registry_);
   }
   else
   {
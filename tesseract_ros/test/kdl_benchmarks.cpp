@@ -0,0 +1,236 @@
+
+#include "tesseract_ros/kdl/kdl_chain_kin.h"
+#include "tesseract_ros/kdl/kdl_env.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <ros/package.h>
+#include <urdf_parser/urdf_parser.h>
+
+/**
+ * Benchmarks for the KDL environment and kinematics using the lbr_iiwa_14_r820 robot.
+ *
+ * The collision meshes of the robot are resolved from the trajopt_examples package.
+ * The results are written to stdout as JSON by default, use --benchmark_out=<file> to also write them to a file.
+ */
+
+urdf::ModelInterfaceSharedPtr getURDFModel()
+{
+  std::string path = ros::package::getPath("tesseract_ros") + "/test/urdf/lbr_iiwa_14_r820.urdf";
+  std::ifstream ifs(path);
+  std::string urdf_xml_string((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
+
+  return urdf::parseURDF(urdf_xml_string);
+}
+
+/** @brief The environment is only created once since loading the collision meshes is slow */
+tesseract::tesseract_ros::KDLEnv& getEnv()
+{
+  static std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env;
+  if (env == nullptr)
+  {
+    env.reset(new tesseract::tesseract_ros::KDLEnv());
+    env->init(getURDFModel());
+  }
+  return *env;
+}
+
+const std::vector<std::string> JOINT_NAMES = { "joint_a1", "joint_a2", "joint_a3", "joint_a4",
+                                               "joint_a5", "joint_a6", "joint_a7" };
+
+/** @brief A fixed set of random joint values so every run uses the same states */
+const std::vector<Eigen::VectorXd>& getJointValues()
+{
+  static std::vector<Eigen::VectorXd> values;
+  if (values.empty())
+  {
+    std::srand(0);
+    for (int i = 0; i < 100; ++i)
+      values.push_back(Eigen::VectorXd::Random(static_cast<long>(JOINT_NAMES.size())));
+  }
+  return values;
+}
+
+std::vector<int> getJointIds(const tesseract::BasicEnv& env)
+{
+  std::vector<int> joint_ids;
+  for (const auto& name : JOINT_NAMES)
+    joint_ids.push_back(env.getJointRegistry()->find(name));
+
+  return joint_ids;
+}
+
+void BM_KDLEnvSetStateMap(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLEnv& env = getEnv();
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+
+  std::vector<std::unordered_map<std::string, double>> joints(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i)
+    for (std::size_t j = 0; j < JOINT_NAMES.size(); ++j)
+      joints[i][JOINT_NAMES[j]] = values[i](static_cast<long>(j));
+
+  std::size_t i = 0;
+  for (auto _ : state)
+    env.setState(joints[i++ % joints.size()]);
+}
+BENCHMARK(BM_KDLEnvSetStateMap);
+
+void BM_KDLEnvSetStateNames(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLEnv& env = getEnv();
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+
+  std::size_t i = 0;
+  for (auto _ : state)
+    env.setState(JOINT_NAMES, values[i++ % values.size()]);
+}
+BENCHMARK(BM_KDLEnvSetStateNames);
+
+void BM_KDLEnvSetStateIds(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLEnv& env = getEnv();
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+  std::vector<int> joint_ids = getJointIds(env);
+
+  std::size_t i = 0;
+  for (auto _ : state)
+    env.setState(joint_ids, values[i++ % values.size()]);
+}
+BENCHMARK(BM_KDLEnvSetStateIds);
+
+void BM_KDLEnvGetStateNames(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLEnv& env = getEnv();
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+
+  std::size_t i = 0;
+  for (auto _ : state)
+    benchmark::DoNotOptimize(env.getState(JOINT_NAMES, values[i++ % values.size()]));
+}
+BENCHMARK(BM_KDLEnvGetStateNames);
+
+void BM_KDLEnvGetStateIds(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLEnv& env = getEnv();
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+  std::vector<int> joint_ids = getJointIds(env);
+
+  std::size_t i = 0;
+  for (auto _ : state)
+    benchmark::DoNotOptimize(env.getState(joint_ids, values[i++ % values.size()]));
+}
+BENCHMARK(BM_KDLEnvGetStateIds);
+
+void BM_KDLEnvGetStateInPlace(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLEnv& env = getEnv();
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+  std::vector<int> joint_ids = getJointIds(env);
+  tesseract::EnvState env_state;
+
+  std::size_t i = 0;
+  for (auto _ : state)
+  {
+    env.getState(env_state, joint_ids, values[i++ % values.size()]);
+    benchmark::DoNotOptimize(env_state);
+  }
+}
+BENCHMARK(BM_KDLEnvGetStateInPlace);
+
+void BM_KDLEnvDiscreteManagerClone(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLEnv& env = getEnv();
+  for (auto _ : state)
+    benchmark::DoNotOptimize(env.getDiscreteContactManager());
+}
+BENCHMARK(BM_KDLEnvDiscreteManagerClone);
+
+void BM_KDLEnvContinuousManagerClone(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLEnv& env = getEnv();
+  for (auto _ : state)
+    benchmark::DoNotOptimize(env.getContinuousContactManager());
+}
+BENCHMARK(BM_KDLEnvContinuousManagerClone);
+
+void BM_KDLChainKinCalcFwdKin(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLChainKin kin;
+  kin.init(getURDFModel(), "base_link", "tool0", "manip");
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+  Eigen::Isometry3d pose;
+
+  std::size_t i = 0;
+  for (auto _ : state)
+  {
+    kin.calcFwdKin(pose, Eigen::Isometry3d::Identity(), values[i++ % values.size()]);
+    benchmark::DoNotOptimize(pose);
+  }
+}
+BENCHMARK(BM_KDLChainKinCalcFwdKin);
+
+void BM_KDLChainKinCalcFwdKinLink(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLChainKin kin;
+  kin.init(getURDFModel(), "base_link", "tool0", "manip");
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+  tesseract::EnvStateConstPtr env_state = getEnv().getState();
+  Eigen::Isometry3d pose;
+
+  std::size_t i = 0;
+  for (auto _ : state)
+  {
+    kin.calcFwdKin(pose, Eigen::Isometry3d::Identity(), values[i++ % values.size()], "link_4", *env_state);
+    benchmark::DoNotOptimize(pose);
+  }
+}
+BENCHMARK(BM_KDLChainKinCalcFwdKinLink);
+
+void BM_KDLChainKinCalcJacobian(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLChainKin kin;
+  kin.init(getURDFModel(), "base_link", "tool0", "manip");
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+  Eigen::MatrixXd jacobian(6, kin.numJoints());
+
+  std::size_t i = 0;
+  for (auto _ : state)
+  {
+    kin.calcJacobian(jacobian, Eigen::Isometry3d::Identity(), values[i++ % values.size()]);
+    benchmark::DoNotOptimize(jacobian.data());
+  }
+}
+BENCHMARK(BM_KDLChainKinCalcJacobian);
+
+void BM_KDLChainKinCalcJacobianLink(benchmark::State& state)
+{
+  tesseract::tesseract_ros::KDLChainKin kin;
+  kin.init(getURDFModel(), "base_link", "tool0", "manip");
+  const std::vector<Eigen::VectorXd>& values = getJointValues();
+  tesseract::EnvStateConstPtr env_state = getEnv().getState();
+  Eigen::MatrixXd jacobian(6, kin.numJoints());
+
+  std::size_t i = 0;
+  for (auto _ : state)
+  {
+    kin.calcJacobian(jacobian, Eigen::Isometry3d::Identity(), values[i++ % values.size()], "link_4", *env_state);
+    benchmark::DoNotOptimize(jacobian.data());
+  }
+}
+BENCHMARK(BM_KDLChainKinCalcJacobianLink);
+
+int main(int argc, char** argv)
+{
+  // Default to JSON so the results can be tracked, a --benchmark_format argument overrides it
+  std::vector<char*> args(argv, argv + argc);
+  std::string format = "--benchmark_format=json";
+  args.insert(args.begin() + 1, &format[0]);
+  int num_args = static_cast<int>(args.size());
+
+  benchmark::Initialize(&num_args, args.data());
+  if (benchmark::ReportUnrecognizedArguments(num_args, args.data()))
+    return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
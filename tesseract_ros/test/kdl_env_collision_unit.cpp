@@ -0,0 +1,357 @@
+#include "tesseract_ros/kdl/kdl_env.h"
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <urdf_parser/urdf_parser.h>
+#include <atomic>
+
+/**
+ * A sphere moved in the plane by two prismatic joints and a box fixed to the base at x = 1.
+ * Only primitive shapes are used so the test does not depend on any mesh package.
+ */
+const std::string URDF_XML = R"(<?xml version="1.0"?>
+<robot name="planar_sphere">
+  <link name="base_link"/>
+  <link name="obstacle">
+    <collision>
+      <geometry>
+        <box size="0.2 0.2 0.2"/>
+      </geometry>
+    </collision>
+  </link>
+  <link name="link_1"/>
+  <link name="link_2">
+    <collision>
+      <geometry>
+        <sphere radius="0.1"/>
+      </geometry>
+    </collision>
+  </link>
+  <joint name="obstacle_joint" type="fixed">
+    <parent link="base_link"/>
+    <child link="obstacle"/>
+    <origin xyz="1 0 0" rpy="0 0 0"/>
+  </joint>
+  <joint name="joint_1" type="prismatic">
+    <parent link="base_link"/>
+    <child link="link_1"/>
+    <axis xyz="1 0 0"/>
+    <limit lower="-5" upper="5" effort="1" velocity="1"/>
+  </joint>
+  <joint name="joint_2" type="prismatic">
+    <parent link="link_1"/>
+    <child link="link_2"/>
+    <axis xyz="0 1 0"/>
+    <limit lower="-5" upper="5" effort="1" velocity="1"/>
+  </joint>
+</robot>
+)";
+
+std::shared_ptr<tesseract::tesseract_ros::KDLEnv> createEnv()
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env(new tesseract::tesseract_ros::KDLEnv());
+  EXPECT_TRUE(env->init(urdf::parseURDF(URDF_XML)));
+  EXPECT_TRUE(env->addManipulator("base_link", "link_2", "manip"));
+  return env;
+}
+
+/** @brief Start from the request of a manager handed out by the environment to keep its allowed collision setup */
+tesseract::ContactRequest createContactRequest(const tesseract::ContactRequest& env_req, const tesseract::BasicKin& kin)
+{
+  tesseract::ContactRequest req = env_req;
+  req.link_names = kin.getLinkNames();
+  req.contact_distance = 0;
+  req.type = tesseract::ContactRequestType::CLOSEST;
+  return req;
+}
+
+/** @brief The sphere passes through the box in segments 3, 4, 9 and 10 and is free everywhere else */
+tesseract::TrajArray createTrajectory()
+{
+  const std::vector<double> y = { -2.1, -1.6, -1.1, -0.6, -0.1, 0.4, 0.9, 1.4, 0.9, 0.4, -0.1, -0.6 };
+  tesseract::TrajArray traj(static_cast<long>(y.size()), 2);
+  for (std::size_t i = 0; i < y.size(); ++i)
+  {
+    traj(static_cast<long>(i), 0) = 1;
+    traj(static_cast<long>(i), 1) = y[i];
+  }
+  return traj;
+}
+
+void expectSameContacts(const std::vector<tesseract::ContactResultMap>& contacts,
+                        const std::vector<tesseract::ContactResultMap>& expected_contacts)
+{
+  ASSERT_EQ(contacts.size(), expected_contacts.size());
+  for (std::size_t i = 0; i < contacts.size(); ++i)
+  {
+    ASSERT_EQ(contacts[i].size(), expected_contacts[i].size()) << "segment " << i;
+    for (const auto& pair : expected_contacts[i])
+    {
+      auto it = contacts[i].find(pair.first);
+      ASSERT_TRUE(it != contacts[i].end()) << "segment " << i;
+      ASSERT_EQ(it->second.size(), pair.second.size()) << "segment " << i;
+      for (std::size_t j = 0; j < pair.second.size(); ++j)
+      {
+        EXPECT_NEAR(it->second[j].distance, pair.second[j].distance, 1e-6) << "segment " << i;
+        EXPECT_NEAR(it->second[j].cc_time, pair.second[j].cc_time, 1e-6) << "segment " << i;
+      }
+    }
+  }
+}
+
+TEST(TesseractROSUnit, KDLEnvContinuousCollisionCheckTrajectoryWindowUnit)
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env = createEnv();
+  tesseract::BasicKinConstPtr kin = env->getManipulator("manip");
+  ASSERT_TRUE(kin != nullptr);
+
+  tesseract::ContinuousContactManagerBasePtr manager = env->getContinuousContactManager();
+  manager->setContactRequest(createContactRequest(manager->getContactRequest(), *kin));
+  tesseract::TrajArray traj = createTrajectory();
+
+  // Every segment is checked on its own
+  std::vector<tesseract::ContactResultMap> all_contacts, first_contacts;
+  EXPECT_TRUE(tesseract::continuousCollisionCheckTrajectory(*manager, *env, *kin, traj, all_contacts, false, 1));
+  EXPECT_TRUE(tesseract::continuousCollisionCheckTrajectory(*manager, *env, *kin, traj, first_contacts, true, 1));
+
+  ASSERT_EQ(all_contacts.size(), 11u);
+  for (std::size_t i = 0; i < all_contacts.size(); ++i)
+    EXPECT_EQ(all_contacts[i].empty(), !(i == 3 || i == 4 || i == 9 || i == 10)) << "segment " << i;
+
+  ASSERT_EQ(first_contacts.size(), 4u);
+  EXPECT_FALSE(first_contacts.back().empty());
+
+  // Windows give the same contacts for each segment, windows which are collision free as a whole are skipped
+  for (long window_size : { 2, 3, 4, 5, 11, 20 })
+  {
+    SCOPED_TRACE("window_size " + std::to_string(window_size));
+
+    std::vector<tesseract::ContactResultMap> contacts;
+    EXPECT_TRUE(
+        tesseract::continuousCollisionCheckTrajectory(*manager, *env, *kin, traj, contacts, false, window_size));
+    expectSameContacts(contacts, all_contacts);
+
+    contacts.clear();
+    EXPECT_TRUE(
+        tesseract::continuousCollisionCheckTrajectory(*manager, *env, *kin, traj, contacts, true, window_size));
+    expectSameContacts(contacts, first_contacts);
+  }
+
+  // A trajectory which stays clear of the box
+  tesseract::TrajArray free_traj = traj;
+  free_traj.col(0).setConstant(2);
+  for (long window_size : { 1, 3, 20 })
+  {
+    std::vector<tesseract::ContactResultMap> contacts;
+    EXPECT_FALSE(
+        tesseract::continuousCollisionCheckTrajectory(*manager, *env, *kin, free_traj, contacts, false, window_size));
+    ASSERT_EQ(contacts.size(), 11u);
+    for (const auto& collisions : contacts)
+      EXPECT_TRUE(collisions.empty());
+  }
+}
+
+TEST(TesseractROSUnit, KDLEnvCheckTrajectoryUnit)
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env = createEnv();
+  tesseract::BasicKinConstPtr kin = env->getManipulator("manip");
+  ASSERT_TRUE(kin != nullptr);
+
+  tesseract::ContinuousContactManagerBasePtr manager = env->getContinuousContactManager();
+  manager->setContactRequest(createContactRequest(manager->getContactRequest(), *kin));
+  tesseract::TrajArray traj = createTrajectory();
+
+  std::vector<tesseract::ContactResultMap> all_contacts, first_contacts;
+  EXPECT_TRUE(tesseract::continuousCollisionCheckTrajectory(*manager, *env, *kin, traj, all_contacts, false));
+  EXPECT_TRUE(tesseract::continuousCollisionCheckTrajectory(*manager, *env, *kin, traj, first_contacts, true));
+
+  // The threaded check gives the same contacts for any number of threads
+  for (unsigned num_threads : { 1u, 2u, 3u, 4u, 16u, 0u })
+  {
+    SCOPED_TRACE("num_threads " + std::to_string(num_threads));
+
+    std::vector<tesseract::ContactResultMap> contacts;
+    EXPECT_TRUE(tesseract::checkTrajectory(*manager, *env, *kin, traj, contacts, false, num_threads));
+    expectSameContacts(contacts, all_contacts);
+
+    EXPECT_TRUE(tesseract::checkTrajectory(*manager, *env, *kin, traj, contacts, true, num_threads));
+    expectSameContacts(contacts, first_contacts);
+  }
+
+  // A trajectory which stays clear of the box, and one without segments
+  tesseract::TrajArray free_traj = traj;
+  free_traj.col(0).setConstant(2);
+  std::vector<tesseract::ContactResultMap> contacts;
+  EXPECT_FALSE(tesseract::checkTrajectory(*manager, *env, *kin, free_traj, contacts, true, 4));
+  EXPECT_EQ(contacts.size(), 11u);
+
+  EXPECT_FALSE(tesseract::checkTrajectory(*manager, *env, *kin, traj.topRows(1), contacts, true, 4));
+  EXPECT_TRUE(contacts.empty());
+}
+
+TEST(TesseractROSUnit, KDLEnvCheckStatesUnit)
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env = createEnv();
+  tesseract::BasicKinConstPtr kin = env->getManipulator("manip");
+  ASSERT_TRUE(kin != nullptr);
+
+  tesseract::DiscreteContactManagerBasePtr manager = env->getDiscreteContactManager();
+  manager->setContactRequest(createContactRequest(manager->getContactRequest(), *kin));
+
+  // Only the states at y = -0.1 are in collision with the box
+  tesseract::TrajArray states = createTrajectory();
+  std::vector<bool> expected_free;
+  for (long i = 0; i < states.rows(); ++i)
+    expected_free.push_back(std::abs(states(i, 1) + 0.1) > 1e-6);
+
+  for (unsigned num_threads : { 1u, 2u, 5u, 0u })
+  {
+    SCOPED_TRACE("num_threads " + std::to_string(num_threads));
+
+    std::vector<bool> collision_free;
+    EXPECT_FALSE(tesseract::checkStatesCollisionFree(*manager, *env, *kin, states, collision_free, num_threads));
+    EXPECT_EQ(collision_free, expected_free);
+
+    std::vector<tesseract::ContactResultMap> contacts;
+    EXPECT_TRUE(tesseract::checkStates(*manager, *env, *kin, states, contacts, num_threads));
+    ASSERT_EQ(contacts.size(), expected_free.size());
+    for (std::size_t i = 0; i < contacts.size(); ++i)
+    {
+      EXPECT_EQ(contacts[i].empty(), expected_free[i]) << "state " << i;
+      for (const auto& pair : contacts[i])
+        EXPECT_NEAR(pair.second[0].distance, -0.1, 1e-3) << "state " << i;
+    }
+
+    // Every state is visited once with the manager updated to its link transforms
+    std::vector<std::atomic<int>> visits(static_cast<std::size_t>(states.rows()));
+    std::vector<char> state_free(static_cast<std::size_t>(states.rows()), 0);
+    tesseract::forEachState(*manager,
+                            *env,
+                            *kin,
+                            states,
+                            [&](tesseract::DiscreteContactManagerBase& state_manager, long i) {
+                              ++visits[static_cast<std::size_t>(i)];
+                              state_free[static_cast<std::size_t>(i)] = state_manager.isCollisionFree();
+                            },
+                            num_threads);
+
+    for (std::size_t i = 0; i < visits.size(); ++i)
+    {
+      EXPECT_EQ(visits[i].load(), 1) << "state " << i;
+      EXPECT_EQ(state_free[i] != 0, expected_free[i]) << "state " << i;
+    }
+  }
+
+  // All states of a trajectory which stays clear of the box are collision free
+  states.col(0).setConstant(2);
+  std::vector<bool> collision_free;
+  EXPECT_TRUE(tesseract::checkStatesCollisionFree(*manager, *env, *kin, states, collision_free));
+  EXPECT_EQ(collision_free, std::vector<bool>(static_cast<std::size_t>(states.rows()), true));
+}
+
+TEST(TesseractROSUnit, KDLEnvGetStateInPlaceUnit)
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env = createEnv();
+  tesseract::BasicKinConstPtr kin = env->getManipulator("manip");
+  ASSERT_TRUE(kin != nullptr);
+
+  std::vector<int> joint_ids;
+  for (const auto& joint_name : kin->getJointNames())
+    joint_ids.push_back(env->getJointRegistry()->find(joint_name));
+
+  // The state calculated in place is reused and matches the state calculated by name
+  tesseract::EnvState state;
+  tesseract::TrajArray traj = createTrajectory();
+  for (long i = 0; i < traj.rows(); ++i)
+  {
+    Eigen::VectorXd joint_values = traj.row(i).transpose();
+    env->getState(state, joint_ids, joint_values);
+    tesseract::EnvStatePtr named_state = env->getState(kin->getJointNames(), joint_values);
+
+    for (const auto& link_name : env->getLinkNames())
+    {
+      int link_id = env->getLinkRegistry()->find(link_name);
+      ASSERT_GE(link_id, 0);
+      EXPECT_TRUE(state.link_transforms[static_cast<std::size_t>(link_id)].isApprox(named_state->transforms[link_name]))
+          << link_name;
+    }
+
+    for (std::size_t j = 0; j < joint_ids.size(); ++j)
+      EXPECT_EQ(state.joint_values[static_cast<std::size_t>(joint_ids[j])], joint_values[static_cast<long>(j)]);
+  }
+
+  // The current state of the environment is not changed
+  EXPECT_EQ(env->getState()->joints.at("joint_1"), 0);
+  EXPECT_EQ(env->getState()->joints.at("joint_2"), 0);
+
+  // The link ids of attachable objects added later are covered by the state
+  tesseract::AttachableObjectPtr object(new tesseract::AttachableObject());
+  object->name = "attached_box";
+  object->collision.shapes.push_back(shapes::ShapeConstPtr(new shapes::Box(0.1, 0.1, 0.1)));
+  object->collision.shape_poses.push_back(Eigen::Isometry3d::Identity());
+  object->collision.collision_object_types.push_back(tesseract::CollisionObjectType::UseShapeType);
+  env->addAttachableObject(object);
+
+  tesseract::AttachedBodyInfo attached_body;
+  attached_body.object_name = "attached_box";
+  attached_body.parent_link_name = "link_2";
+  attached_body.transform.translation()(2) = 0.5;
+  env->attachBody(attached_body);
+
+  int attached_id = env->getLinkRegistry()->find("attached_box");
+  int parent_id = env->getLinkRegistry()->find("link_2");
+  ASSERT_GE(attached_id, 0);
+
+  Eigen::VectorXd joint_values = traj.row(0).transpose();
+  env->getState(state, joint_ids, joint_values);
+  ASSERT_GT(state.link_transforms.size(), static_cast<std::size_t>(attached_id));
+  EXPECT_TRUE(state.link_transforms[static_cast<std::size_t>(attached_id)].isApprox(
+      state.link_transforms[static_cast<std::size_t>(parent_id)] * attached_body.transform));
+}
+
+TEST(TesseractROSUnit, KDLEnvAllowedCollisionUnit)
+{
+  std::shared_ptr<tesseract::tesseract_ros::KDLEnv> env = createEnv();
+
+  // The sphere is inside the box
+  env->setState({ "joint_1", "joint_2" }, { 1.0, 0.0 });
+  env->getAllowedCollisionMatrixNonConst()->addAllowedCollision("link_2", "obstacle", "Test");
+
+  // The default contact allowed function uses the compiled matrix, which is put in the requests of the managers
+  tesseract::IsContactAllowedFn fn = env->getIsContactAllowedFn();
+  EXPECT_TRUE(fn("obstacle", "link_2"));
+  EXPECT_FALSE(fn("obstacle", "base_link"));
+
+  tesseract::DiscreteContactManagerBasePtr manager = env->getDiscreteContactManager();
+  tesseract::ContactRequest req = manager->getContactRequest();
+  EXPECT_TRUE(req.allowed_collision_matrix == env->getAllowedCollisionBitMatrix());
+  EXPECT_TRUE(env->getContinuousContactManager()->getContactRequest().allowed_collision_matrix ==
+              env->getAllowedCollisionBitMatrix());
+  ASSERT_TRUE(static_cast<bool>(req.isContactAllowed));
+  EXPECT_TRUE(req.isContactAllowed("obstacle", "link_2"));
+  EXPECT_FALSE(req.isContactAllowed("obstacle", "base_link"));
+
+  tesseract::ContactResultMap result;
+  manager->contactTest(result);
+  EXPECT_TRUE(result.empty());
+
+  // The function of the environment follows the allowed collision matrix, the request keeps what it was built with
+  env->getAllowedCollisionMatrixNonConst()->removeAllowedCollision("link_2", "obstacle");
+  EXPECT_FALSE(fn("obstacle", "link_2"));
+  EXPECT_TRUE(req.isContactAllowed("obstacle", "link_2"));
+
+  manager = env->getDiscreteContactManager();
+  manager->contactTest(result);
+  EXPECT_EQ(result.size(), 1u);
+
+  // Other contact allowed functions are not replaced by the compiled matrix
+  env->setIsContactAllowedFn([](const std::string&, const std::string&) { return true; });
+  req = env->getDiscreteContactManager()->getContactRequest();
+  EXPECT_TRUE(req.allowed_collision_matrix == nullptr);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}